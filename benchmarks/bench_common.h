@@ -0,0 +1,269 @@
+#ifndef MCP_MQTT_BENCH_COMMON_H
+#define MCP_MQTT_BENCH_COMMON_H
+
+/**
+ * @file bench_common.h
+ * @brief Helpers shared by the benchmark programs
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#if defined(__linux__)
+#include <unistd.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Resident set size of this process in KiB
+ *
+ * Current RSS on Linux; elsewhere the peak RSS, which only grows.
+ */
+inline size_t residentKb() {
+#if defined(__linux__)
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    int fields = std::fscanf(file, "%lu %lu", &size, &resident);
+    std::fclose(file);
+    return fields == 2 ? resident * static_cast<size_t>(sysconf(_SC_PAGESIZE)) / 1024 : 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss) / 1024;     // Bytes on macOS
+#else
+    return static_cast<size_t>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+/**
+ * @brief Latency samples with percentile lookup
+ */
+class Latencies {
+public:
+    void add(Clock::duration latency) {
+        samples_.push_back(std::chrono::duration<double, std::micro>(latency).count());
+        sorted_ = false;
+    }
+
+    void merge(const Latencies& other) {
+        samples_.insert(samples_.end(), other.samples_.begin(), other.samples_.end());
+        sorted_ = false;
+    }
+
+    size_t count() const { return samples_.size(); }
+
+    /**
+     * @brief Percentile in microseconds (p in [0, 100]), 0 without samples
+     */
+    double percentile(double p) {
+        if (samples_.empty()) return 0.0;
+        if (!sorted_) {
+            std::sort(samples_.begin(), samples_.end());
+            sorted_ = true;
+        }
+        size_t index = static_cast<size_t>(p / 100.0 * static_cast<double>(samples_.size() - 1) + 0.5);
+        return samples_[std::min(index, samples_.size() - 1)];
+    }
+
+private:
+    std::vector<double> samples_;   // Microseconds
+    bool sorted_ = true;
+};
+
+/**
+ * @brief Fixed-size latency histogram with about 3% resolution
+ *
+ * Unlike Latencies it allocates nothing per sample, so recording millions of
+ * operations does not disturb a memory measurement. Buckets are powers of
+ * two of nanoseconds, each split into 32 linear sub-buckets.
+ */
+class Histogram {
+public:
+    void add(Clock::duration latency) {
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+        ++buckets_[bucketOf(static_cast<uint64_t>(std::max<int64_t>(ns, 0)))];
+        ++count_;
+    }
+
+    uint64_t count() const { return count_; }
+
+    void reset() {
+        buckets_.fill(0);
+        count_ = 0;
+    }
+
+    /**
+     * @brief Percentile in microseconds (p in [0, 100]), 0 without samples
+     */
+    double percentile(double p) const {
+        if (count_ == 0) return 0.0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(count_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) {
+                return static_cast<double>(upperBound(i)) / 1000.0;
+            }
+        }
+        return static_cast<double>(upperBound(buckets_.size() - 1)) / 1000.0;
+    }
+
+private:
+    static constexpr int SUB_BITS = 5;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+
+    std::array<uint64_t, 64 * SUB_BUCKETS> buckets_{};
+    uint64_t count_ = 0;
+
+    static size_t bucketOf(uint64_t ns) {
+        if (ns < SUB_BUCKETS) return static_cast<size_t>(ns);
+        int log2 = 63;
+        while (!(ns >> log2)) --log2;
+        int shift = log2 - SUB_BITS;
+        size_t sub = static_cast<size_t>(ns >> shift) & (SUB_BUCKETS - 1);
+        return static_cast<size_t>(shift + 1) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t upperBound(size_t bucket) {
+        if (bucket < SUB_BUCKETS) return bucket;
+        int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+        uint64_t sub = bucket % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+    }
+};
+
+/**
+ * @brief Named results of a benchmark run, written as JSON and checked
+ *        against a stored baseline
+ *
+ * File format:
+ *   {"benchmark": "soak", "buildType": "Release", "metrics": {"name":
+ *    {"value": 1.5, "unit": "us", "better": "lower", "tolerance": 0.25}}}
+ * "tolerance" is optional in a baseline and overrides the default one.
+ * "buildType" is the CMAKE_BUILD_TYPE of the run; reports from different
+ * build types are not compared.
+ */
+class Report {
+public:
+    explicit Report(std::string benchmark) : benchmark_(std::move(benchmark)) {}
+
+    /**
+     * @param tolerance Stored with the metric when set, so a baseline written
+     *        from this report keeps it
+     */
+    void add(const std::string& metric, double value, const std::string& unit, bool lowerIsBetter = true,
+             std::optional<double> tolerance = std::nullopt) {
+        metrics_[metric] = {{"value", value}, {"unit", unit}, {"better", lowerIsBetter ? "lower" : "higher"}};
+        if (tolerance) {
+            metrics_[metric]["tolerance"] = *tolerance;
+        }
+    }
+
+    nlohmann::json toJson() const {
+        return {{"benchmark", benchmark_}, {"buildType", BENCH_BUILD_TYPE}, {"metrics", metrics_}};
+    }
+
+    bool writeJson(const std::string& path) const {
+        std::ofstream out(path);
+        out << toJson().dump(2) << "\n";
+        if (!out) {
+            std::fprintf(stderr, "Failed to write %s\n", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Compare with a baseline file; prints every metric that regressed
+     * @param tolerance Allowed relative change in the worse direction
+     * @return false if a metric regressed beyond its tolerance or the
+     *         baseline cannot be read
+     */
+    bool checkBaseline(const std::string& path, double tolerance) const {
+        std::ifstream in(path);
+        nlohmann::json baseline = nlohmann::json::parse(in, nullptr, false);
+        if (!baseline.is_object() || !baseline.contains("metrics")) {
+            std::fprintf(stderr, "Cannot read baseline %s\n", path.c_str());
+            return false;
+        }
+        return compare(baseline, toJson(), tolerance);
+    }
+
+    /**
+     * @brief Whether two reports come from the same build type; prints a
+     *        warning if not
+     *
+     * A baseline without "buildType" matches any report.
+     */
+    static bool comparable(const nlohmann::json& baseline, const nlohmann::json& current) {
+        if (!baseline.contains("buildType")) {
+            return true;
+        }
+        std::string expected = baseline.value("buildType", "");
+        std::string actual = current.value("buildType", "");
+        if (expected == actual) {
+            return true;
+        }
+        std::printf("  warning: baseline is a %s build, this is a %s build; comparison skipped\n",
+                    expected.c_str(), actual.empty() ? "unknown" : actual.c_str());
+        return false;
+    }
+
+    /**
+     * @brief Compare two reports, e.g. a baseline file and this run
+     *
+     * Reports from different build types pass without comparing any metric.
+     */
+    static bool compare(const nlohmann::json& baseline, const nlohmann::json& current, double tolerance) {
+        if (!comparable(baseline, current)) {
+            return true;
+        }
+        bool ok = true;
+        for (const auto& [name, base] : baseline["metrics"].items()) {
+            if (!current["metrics"].contains(name)) {
+                std::printf("  %-36s missing from the results\n", name.c_str());
+                ok = false;
+                continue;
+            }
+            double expected = base.value("value", 0.0);
+            double actual = current["metrics"][name].value("value", 0.0);
+            double allowed = base.value("tolerance", tolerance);
+            bool lower = base.value("better", "lower") == "lower";
+            // From a zero baseline any increase is a regression, e.g. leaked objects
+            double change = expected != 0.0 ? (actual - expected) / std::abs(expected)
+                                            : (actual == 0.0 ? 0.0 : std::copysign(HUGE_VAL, actual));
+            bool regressed = lower ? change > allowed : change < -allowed;
+            std::printf("  %-36s %12.2f -> %12.2f %-6s %+7.1f%%%s\n", name.c_str(), expected, actual,
+                        base.value("unit", "").c_str(), change * 100.0, regressed ? "  REGRESSION" : "");
+            ok = ok && !regressed;
+        }
+        return ok;
+    }
+
+private:
+    std::string benchmark_;
+    nlohmann::json metrics_ = nlohmann::json::object();
+};
+
+} // namespace bench
+
+#endif // MCP_MQTT_BENCH_COMMON_H
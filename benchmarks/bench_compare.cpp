@@ -0,0 +1,57 @@
+/**
+ * @file bench_compare.cpp
+ * @brief Compare a benchmark report with a stored baseline
+ *
+ * Both files are JSON reports as written by the benchmarks' --json option.
+ * Every baseline metric must be present in the current report and must not
+ * have got worse by more than its tolerance: the baseline's per-metric
+ * "tolerance" if set, otherwise --tolerance. Exits with 1 on a regression.
+ * A report from another build type than the baseline's (e.g. a build without
+ * CMAKE_BUILD_TYPE against a Release baseline) is not compared; that is
+ * reported as skipped, with exit status 0.
+ *
+ * Usage: bench_compare BASELINE CURRENT [--tolerance F]
+ */
+
+#include <cstdlib>
+
+#include "bench_common.h"
+
+static nlohmann::json readReport(const char* path) {
+    std::ifstream in(path);
+    nlohmann::json report = nlohmann::json::parse(in, nullptr, false);
+    if (!report.is_object() || !report.contains("metrics")) {
+        std::fprintf(stderr, "Cannot read report %s\n", path);
+        return nullptr;
+    }
+    return report;
+}
+
+int main(int argc, char* argv[]) {
+    double tolerance = 0.2;
+    if (argc == 5 && std::string(argv[3]) == "--tolerance") {
+        tolerance = std::atof(argv[4]);
+    } else if (argc != 3) {
+        std::fprintf(stderr, "Usage: bench_compare BASELINE CURRENT [--tolerance F]\n");
+        return 2;
+    }
+
+    nlohmann::json baseline = readReport(argv[1]);
+    nlohmann::json current = readReport(argv[2]);
+    if (baseline.is_null() || current.is_null()) {
+        return 2;
+    }
+
+    std::printf("%s: %s vs %s\n", baseline.value("benchmark", "").c_str(), argv[2], argv[1]);
+    if (!bench::Report::comparable(baseline, current)) {
+        std::printf("SKIPPED: build the benchmarks with CMAKE_BUILD_TYPE=%s to compare\n",
+                    baseline.value("buildType", "").c_str());
+        return 0;
+    }
+    if (!bench::Report::compare(baseline, current, tolerance)) {
+        std::printf("FAILED: regression against the baseline\n");
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
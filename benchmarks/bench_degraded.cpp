@@ -0,0 +1,221 @@
+/**
+ * @file bench_degraded.cpp
+ * @brief Server throughput and memory over a slow or lossy transport
+ *
+ * Runs the same tools/call workload against an McpServer whose MQTT client is
+ * wrapped in a FaultInjectingMqttClient, once per transport scenario: healthy,
+ * slow broker, stalling broker, failing publishes, lost subscriptions and a
+ * flapping connection. The clients and the server share a synchronous
+ * LoopbackBroker, so a request that has no response when its publish returns
+ * was lost. A client re-initializes after three losses in a row, which is how
+ * sessions recover from lost subscriptions.
+ *
+ * Usage: bench_degraded [--threads N] [--duration-ms N] [--scenario NAME]
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+#include <mcp_mqtt.h>
+#include "bench_common.h"
+
+using namespace mcp_mqtt;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+struct Scenario {
+    const char* name;
+    FaultInjectionOptions faults;
+    bool flapConnection = false;    // Lose the connection for 20 ms every 200 ms
+};
+
+static std::vector<Scenario> scenarios() {
+    std::vector<Scenario> list;
+    list.push_back({"healthy", {}});
+
+    Scenario slow{"slow-broker", {}};
+    slow.faults.publishLatency = microseconds(100);
+    slow.faults.publishJitter = microseconds(100);
+    list.push_back(slow);
+
+    Scenario stalls{"broker-stalls", {}};
+    stalls.faults.publishTailRate = 0.01;
+    stalls.faults.publishTailLatency = microseconds(5000);
+    list.push_back(stalls);
+
+    Scenario lossy{"failing-publishes", {}};
+    lossy.faults.publishFailureRate = 0.02;
+    list.push_back(lossy);
+
+    Scenario subscriptions{"lost-subscriptions", {}};
+    subscriptions.faults.subscriptionDropRate = 0.2;
+    list.push_back(subscriptions);
+
+    Scenario flapping{"flapping-connection", {}};
+    flapping.flapConnection = true;
+    list.push_back(flapping);
+    return list;
+}
+
+struct Result {
+    uint64_t answered = 0;
+    uint64_t lost = 0;
+    uint64_t initializations = 0;
+    bench::Latencies latencies;
+};
+
+/**
+ * @brief One MCP client calling a tool in a loop on its own thread
+ */
+static void runClient(LoopbackBroker& broker, int index, const McpServerConfig& config,
+                      const std::atomic<bool>& stop, Result& result) {
+    std::string clientId = "bench-" + std::to_string(index);
+    std::string rpcTopic = "$mcp-rpc/" + clientId + "/" + config.serverId + "/" + config.serverName;
+    std::string controlTopic = "$mcp-server/" + config.serverId + "/" + config.serverName;
+    auto mqtt = broker.createClient(clientId);
+
+    // Delivery is synchronous: the response, if any, arrives inside publish()
+    bool answered = false;
+    mqtt->setMessageHandler([&](const MqttIncomingMessage& message) {
+        if (message.payload.find("\"id\"") != std::string::npos) answered = true;
+    });
+    mqtt->subscribe(rpcTopic, 1, true);
+
+    std::string initialize = nlohmann::json{
+        {"jsonrpc", "2.0"}, {"id", 0}, {"method", "initialize"},
+        {"params", {{"protocolVersion", MCP_PROTOCOL_VERSION},
+                    {"clientInfo", {{"name", "bench"}, {"version", "1.0"}}},
+                    {"capabilities", nlohmann::json::object()}}}}.dump();
+    std::string initialized = R"({"jsonrpc":"2.0","method":"notifications/initialized"})";
+
+    int64_t nextId = 1;
+    int consecutiveLosses = 3;      // Start by initializing
+    while (!stop) {
+        if (consecutiveLosses >= 3) {
+            answered = false;
+            mqtt->publish(controlTopic, initialize, 1, false, {{USER_PROP_MQTT_CLIENT_ID, clientId}});
+            ++result.initializations;
+            if (!answered) {
+                std::this_thread::sleep_for(milliseconds(1));
+                continue;
+            }
+            mqtt->publish(rpcTopic, initialized, 1, false);
+            consecutiveLosses = 0;
+        }
+
+        std::string request = "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(nextId++) +
+                              ",\"method\":\"tools/call\",\"params\":{\"name\":\"add\","
+                              "\"arguments\":{\"a\":1,\"b\":2}}}";
+        answered = false;
+        auto start = bench::Clock::now();
+        mqtt->publish(rpcTopic, request, 1, false);
+        if (answered) {
+            result.latencies.add(bench::Clock::now() - start);
+            ++result.answered;
+            consecutiveLosses = 0;
+        } else {
+            ++result.lost;
+            ++consecutiveLosses;
+        }
+    }
+}
+
+static void runScenario(const Scenario& scenario, int threads, milliseconds duration) {
+    LoopbackBroker broker;
+    auto serverMqtt = broker.createClient("bench-server");
+    FaultInjectingMqttClient faulty(serverMqtt.get(), scenario.faults, 42);
+
+    McpServer server;
+    server.configure({"BenchServer", "1.0.0"}, ServerCapabilities{});
+    Tool add;
+    add.name = "add";
+    add.description = "Add two numbers";
+    server.registerTool(add, [](const nlohmann::json& args) {
+        return ToolCallResult::success(std::to_string(args.value("a", 0) + args.value("b", 0)));
+    });
+    McpServerConfig config;
+    config.serverId = "bench-server";
+    config.serverName = "bench/degraded";
+    server.start(&faulty, config);
+
+    size_t rssBefore = bench::residentKb();
+    std::atomic<bool> stop{false};
+    std::vector<Result> results(threads);
+    std::vector<std::thread> clients;
+    auto start = bench::Clock::now();
+    for (int i = 0; i < threads; ++i) {
+        clients.emplace_back(runClient, std::ref(broker), i, std::cref(config), std::cref(stop),
+                             std::ref(results[i]));
+    }
+
+    while (bench::Clock::now() - start < duration) {
+        if (scenario.flapConnection) {
+            std::this_thread::sleep_for(milliseconds(180));
+            faulty.injectConnectionLost("Flapping connection");
+            std::this_thread::sleep_for(milliseconds(20));
+            faulty.restoreConnection();
+        } else {
+            std::this_thread::sleep_for(milliseconds(10));
+        }
+    }
+    stop = true;
+    for (auto& client : clients) {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(bench::Clock::now() - start).count();
+    size_t rssAfter = bench::residentKb();
+
+    Result total;
+    for (auto& result : results) {
+        total.answered += result.answered;
+        total.lost += result.lost;
+        total.initializations += result.initializations;
+        total.latencies.merge(result.latencies);
+    }
+    auto stats = faulty.getStats();
+    uint64_t attempts = total.answered + total.lost;
+
+    std::printf("%-20s %10.0f %9.1f %9.1f %9.1f %7.2f%% %7llu %9lld %8zu\n",
+                scenario.name, total.answered / seconds,
+                total.latencies.percentile(50), total.latencies.percentile(99), total.latencies.percentile(99.9),
+                attempts ? 100.0 * total.lost / attempts : 0.0,
+                static_cast<unsigned long long>(total.initializations),
+                static_cast<long long>(rssAfter) - static_cast<long long>(rssBefore),
+                server.getConnectedClients().size());
+    std::printf("%-20s injected: %llu failed publishes, %llu delayed (%.1f ms), %llu dropped "
+                "subscriptions, %llu connection losses\n", "",
+                static_cast<unsigned long long>(stats.failedPublishes),
+                static_cast<unsigned long long>(stats.delayedPublishes),
+                stats.injectedDelay.count() / 1000.0,
+                static_cast<unsigned long long>(stats.droppedSubscriptions),
+                static_cast<unsigned long long>(stats.connectionLosses));
+
+    server.stop();
+}
+
+int main(int argc, char* argv[]) {
+    int threads = 4;
+    milliseconds duration(2000);
+    std::string only;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--threads") threads = std::max(1, std::atoi(argv[i + 1]));
+        else if (arg == "--duration-ms") duration = milliseconds(std::atoi(argv[i + 1]));
+        else if (arg == "--scenario") only = argv[i + 1];
+        else {
+            std::fprintf(stderr, "Usage: bench_degraded [--threads N] [--duration-ms N] [--scenario NAME]\n");
+            return 2;
+        }
+    }
+    Logger::setLevel(LogLevel::OFF);
+
+    std::printf("%-20s %10s %9s %9s %9s %8s %7s %9s %8s\n", "scenario", "calls/s", "p50 us", "p99 us",
+                "p99.9 us", "lost", "inits", "rss KiB", "sessions");
+    for (const auto& scenario : scenarios()) {
+        if (only.empty() || only == scenario.name) {
+            runScenario(scenario, threads, duration);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file bench_micro.cpp
+ * @brief Microbenchmarks of the server's request path
+ *
+ * Measures throughput and heap allocations per operation for:
+ * - JSON-RPC parsing and serialization
+ * - ToolManager::callTool
+ * - McpServer's RPC handling (ping, tools/list, tools/call), fed through a
+ *   broker-less mock IMqttClient
+ *
+ * Each case runs several times and reports the median throughput. Allocations
+ * are counted by replacing the global scalar and array operator new, so they
+ * are exact and the same in every run. The aligned forms are left to the
+ * library, which pairs them with its own aligned delete. With --json the
+ * results are written for bench_compare.
+ *
+ * Usage: bench_micro [--iterations N] [--runs N] [--case NAME] [--json PATH]
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+#include <mcp_mqtt.h>
+#include "bench_common.h"
+#include "mock_mqtt_client.h"
+
+using namespace mcp_mqtt;
+
+static std::atomic<uint64_t> allocationCount{0};
+
+static void* countedAlloc(std::size_t size) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+// Out of line, so GCC does not see free() applied to an operator new result
+// once a delete below is inlined into its caller
+[[gnu::noinline]] static void freeAllocation(void* p) noexcept {
+    std::free(p);
+}
+
+// Every form that allocates with malloc() frees with free(), so replace them all
+void* operator new(std::size_t size) {
+    if (void* p = countedAlloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* p = countedAlloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept {
+    freeAllocation(p);
+}
+
+void operator delete[](void* p) noexcept {
+    freeAllocation(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    freeAllocation(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    freeAllocation(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    freeAllocation(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    freeAllocation(p);
+}
+
+// Results are folded in here so the compiler cannot drop the work
+static volatile size_t sink = 0;
+
+struct Options {
+    uint64_t iterations = 50000;
+    int runs = 5;
+    std::string only;
+    std::string jsonPath;
+};
+
+static void measure(bench::Report& report, const Options& options, const std::string& name,
+                    const std::function<void()>& op) {
+    if (!options.only.empty() && options.only != name) {
+        return;
+    }
+    for (uint64_t i = 0; i < options.iterations / 10; ++i) {
+        op();   // Warm up
+    }
+
+    std::vector<double> throughputs;
+    uint64_t allocations = 0;
+    for (int run = 0; run < options.runs; ++run) {
+        uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        auto start = bench::Clock::now();
+        for (uint64_t i = 0; i < options.iterations; ++i) {
+            op();
+        }
+        double seconds = std::chrono::duration<double>(bench::Clock::now() - start).count();
+        allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+        throughputs.push_back(options.iterations / seconds);
+    }
+    std::sort(throughputs.begin(), throughputs.end());
+    double opsPerSecond = throughputs[throughputs.size() / 2];
+    double allocationsPerOp = static_cast<double>(allocations) / options.iterations;
+
+    std::printf("%-28s %12.0f %10.3f %10.1f\n", name.c_str(), opsPerSecond, 1e6 / opsPerSecond,
+                allocationsPerOp);
+    report.add(name + "_ops_per_s", opsPerSecond, "ops/s", false);
+    report.add(name + "_allocs_per_op", allocationsPerOp, "allocs", true, 0.0);   // Exact: no increase
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--iterations") options.iterations = std::max<uint64_t>(10, std::strtoull(argv[i + 1], nullptr, 10));
+        else if (arg == "--runs") options.runs = std::max(1, std::atoi(argv[i + 1]));
+        else if (arg == "--case") options.only = argv[i + 1];
+        else if (arg == "--json") options.jsonPath = argv[i + 1];
+        else {
+            std::fprintf(stderr, "Usage: bench_micro [--iterations N] [--runs N] [--case NAME] [--json PATH]\n");
+            return 2;
+        }
+    }
+    Logger::setLevel(LogLevel::OFF);
+
+    Tool add;
+    add.name = "add";
+    add.description = "Add two numbers";
+    add.inputSchema.properties = {{"a", {{"type", "number"}}}, {"b", {{"type", "number"}}}};
+    add.inputSchema.required = {"a", "b"};
+    ToolHandler addHandler = [](const nlohmann::json& args) {
+        return ToolCallResult::success(std::to_string(args.value("a", 0) + args.value("b", 0)));
+    };
+
+    const std::string callRequest =
+        R"({"jsonrpc":"2.0","id":42,"method":"tools/call","params":{"name":"add","arguments":{"a":1,"b":2}}})";
+    const nlohmann::json arguments = {{"a", 1}, {"b", 2}};
+    const nlohmann::json callResult = ToolCallResult::success("3").toJson();
+
+    bench::Report report("micro");
+    std::printf("%-28s %12s %10s %10s\n", "case", "ops/s", "us/op", "allocs/op");
+
+    // Serialization
+    measure(report, options, "parse_request", [&] {
+        auto json = JsonRpc::parse(callRequest);
+        auto request = JsonRpcRequest::fromJson(*json);
+        sink = sink + request->method.size();
+    });
+    measure(report, options, "serialize_response", [&] {
+        std::string text = JsonRpc::serialize(JsonRpcResponse::success(int64_t(42), callResult).toJson());
+        sink = sink + text.size();
+    });
+
+    // Tool dispatch
+    ToolManager tools;
+    tools.registerTool(add, addHandler);
+    measure(report, options, "call_tool", [&] {
+        auto result = tools.callTool("add", arguments);
+        sink = sink + result.content.size();
+    });
+
+    // Whole RPC path on the server's message handler
+    bench::MockMqttClient mqtt;
+    McpServer server;
+    server.configure({"BenchServer", "1.0.0"}, ServerCapabilities{});
+    server.registerTool(add, addHandler);
+    McpServerConfig config;
+    config.serverId = "bench-server";
+    config.serverName = "bench/micro";
+    server.start(&mqtt, config);
+
+    const std::string clientId = "bench-client";
+    const std::string rpcTopic = "$mcp-rpc/" + clientId + "/" + config.serverId + "/" + config.serverName;
+    std::string initialize = nlohmann::json{
+        {"jsonrpc", "2.0"}, {"id", 0}, {"method", "initialize"},
+        {"params", {{"protocolVersion", MCP_PROTOCOL_VERSION},
+                    {"clientInfo", {{"name", "bench"}, {"version", "1.0"}}},
+                    {"capabilities", nlohmann::json::object()}}}}.dump();
+    mqtt.deliver("$mcp-server/" + config.serverId + "/" + config.serverName, initialize,
+                 {{USER_PROP_MQTT_CLIENT_ID, clientId}});
+    mqtt.deliver(rpcTopic, R"({"jsonrpc":"2.0","method":"notifications/initialized"})");
+
+    const std::string pingRequest = R"({"jsonrpc":"2.0","id":42,"method":"ping"})";
+    const std::string listRequest = R"({"jsonrpc":"2.0","id":42,"method":"tools/list"})";
+    measure(report, options, "handle_rpc_ping", [&] { mqtt.deliver(rpcTopic, pingRequest); });
+    measure(report, options, "handle_rpc_tools_list", [&] { mqtt.deliver(rpcTopic, listRequest); });
+    measure(report, options, "handle_rpc_tools_call", [&] { mqtt.deliver(rpcTopic, callRequest); });
+    server.stop();
+
+    if (!options.jsonPath.empty() && !report.writeJson(options.jsonPath)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,210 @@
+/**
+ * @file bench_soak.cpp
+ * @brief Session scalability and leak soak for McpServer
+ *
+ * Drives an McpServer through a mock IMqttClient, with no broker in between:
+ * - Grow: initialize sessions up to the target count. At every tenth, report
+ *   RSS, bytes per session and initialize/tools/call latency at that size.
+ * - Churn: repeatedly disconnect and re-initialize a share of the sessions.
+ *   RSS must stay flat at a constant session count.
+ * - Stop: time stop() with all sessions open.
+ * - Leak checks: after stop() no session and no subscription may be left.
+ *
+ * Results can be written as JSON (--json) and compared with a stored baseline
+ * (--baseline); the program exits with 1 on a leak or a regression.
+ *
+ * Usage: bench_soak [--sessions N] [--calls N] [--churn-rounds N]
+ *                   [--churn-fraction F] [--seed N] [--json PATH]
+ *                   [--baseline PATH] [--tolerance F]
+ */
+
+#include <cstdlib>
+#include <random>
+
+#include <mcp_mqtt.h>
+#include "bench_common.h"
+#include "mock_mqtt_client.h"
+
+using namespace mcp_mqtt;
+
+struct Options {
+    size_t sessions = 100000;
+    size_t calls = 20000;           // tools/call per checkpoint
+    int churnRounds = 5;
+    double churnFraction = 0.2;
+    uint64_t seed = 1;
+    std::string jsonPath;
+    std::string baselinePath;
+    double tolerance = 0.25;
+};
+
+static bool parseArgs(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        const char* value = argv[i + 1];
+        if (arg == "--sessions") options.sessions = std::strtoull(value, nullptr, 10);
+        else if (arg == "--calls") options.calls = std::strtoull(value, nullptr, 10);
+        else if (arg == "--churn-rounds") options.churnRounds = std::atoi(value);
+        else if (arg == "--churn-fraction") options.churnFraction = std::atof(value);
+        else if (arg == "--seed") options.seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--json") options.jsonPath = value;
+        else if (arg == "--baseline") options.baselinePath = value;
+        else if (arg == "--tolerance") options.tolerance = std::atof(value);
+        else return false;
+    }
+    return argc % 2 == 1 && options.sessions >= 10;
+}
+
+class Soak {
+public:
+    explicit Soak(const Options& options) : options_(options), random_(options.seed) {
+        server_.configure({"SoakServer", "1.0.0"}, ServerCapabilities{});
+        Tool echo;
+        echo.name = "echo";
+        echo.description = "Echo the input";
+        server_.registerTool(echo, [](const nlohmann::json&) { return ToolCallResult::success("ok"); });
+
+        McpServerConfig config;
+        config.serverId = "soak";
+        config.serverName = "bench/soak";
+        server_.start(&mqtt_, config);
+        controlTopic_ = "$mcp-server/" + config.serverId + "/" + config.serverName;
+        rpcSuffix_ = "/" + config.serverId + "/" + config.serverName;
+    }
+
+    int run() {
+        bench::Report report("soak");
+        size_t rssStart = bench::residentKb();
+
+        // Grow, measuring at every tenth of the target
+        std::printf("%10s %10s %12s %9s %9s %9s %9s\n", "sessions", "rss MiB", "bytes/sess",
+                    "init p50", "init p99", "call p50", "call p99");
+        bench::Histogram initialize;
+        bench::Histogram call;
+        size_t step = options_.sessions / 10;
+        for (size_t i = 0; i < options_.sessions; ++i) {
+            initializeSession(i, initialize);
+            if ((i + 1) % step == 0) {
+                call.reset();
+                for (size_t c = 0; c < options_.calls; ++c) {
+                    callTool(random_() % (i + 1), call);
+                }
+                size_t rss = bench::residentKb();
+                std::printf("%10zu %10.1f %12.0f %9.2f %9.2f %9.2f %9.2f\n", i + 1, rss / 1024.0,
+                            (rss - rssStart) * 1024.0 / (i + 1), initialize.percentile(50),
+                            initialize.percentile(99), call.percentile(50), call.percentile(99));
+                if (i + 1 < options_.sessions) initialize.reset();
+            }
+        }
+        size_t rssGrown = bench::residentKb();
+        report.add("bytes_per_session", (rssGrown - rssStart) * 1024.0 / options_.sessions, "B");
+        report.add("initialize_p50_us", initialize.percentile(50), "us");
+        report.add("initialize_p99_us", initialize.percentile(99), "us");
+        report.add("call_p50_us", call.percentile(50), "us");
+        report.add("call_p99_us", call.percentile(99), "us");
+
+        // Churn at a constant session count
+        bench::Histogram disconnect;
+        size_t perRound = static_cast<size_t>(options_.sessions * options_.churnFraction);
+        for (int round = 1; round <= options_.churnRounds; ++round) {
+            for (size_t n = 0; n < perRound; ++n) {
+                size_t index = random_() % options_.sessions;
+                auto start = bench::Clock::now();
+                mqtt_.deliver(rpcTopic(index), R"({"jsonrpc":"2.0","method":"notifications/disconnected"})");
+                disconnect.add(bench::Clock::now() - start);
+                initializeSession(index, initialize);
+            }
+            std::printf("churn round %d: %zu sessions re-initialized, rss %.1f MiB\n", round, perRound,
+                        bench::residentKb() / 1024.0);
+        }
+        size_t rssChurned = bench::residentKb();
+        double churnGrowth = rssGrown > rssStart
+            ? 100.0 * (static_cast<double>(rssChurned) - rssGrown) / (rssGrown - rssStart) : 0.0;
+        report.add("disconnect_p99_us", disconnect.percentile(99), "us");
+        report.add("churn_rss_growth_pct", std::max(churnGrowth, 0.0), "%");
+
+        // Stop with every session open
+        size_t open = server_.getConnectedClients().size();
+        auto stopStart = bench::Clock::now();
+        server_.stop();
+        double stopMs = std::chrono::duration<double, std::milli>(bench::Clock::now() - stopStart).count();
+        report.add("stop_ms_per_100k_sessions", stopMs * 100000.0 / std::max<size_t>(open, 1), "ms");
+
+        // Leak checks
+        size_t leakedSessions = server_.getConnectedClients().size();
+        int64_t leakedSubscriptions = mqtt_.subscriptions;
+        report.add("leaked_sessions", static_cast<double>(leakedSessions), "", true, 0.0);
+        report.add("leaked_subscriptions", static_cast<double>(leakedSubscriptions), "", true, 0.0);
+
+        std::printf("stop(): %.1f ms for %zu sessions\n", stopMs, open);
+        std::printf("churn RSS growth: %.2f%% of the grown footprint\n", churnGrowth);
+        std::printf("leak check: %zu sessions, %lld subscriptions left after stop()\n",
+                    leakedSessions, static_cast<long long>(leakedSubscriptions));
+
+        bool ok = leakedSessions == 0 && leakedSubscriptions == 0;
+        if (!ok) {
+            std::printf("FAILED: leak detected\n");
+        }
+        if (!options_.jsonPath.empty()) {
+            report.writeJson(options_.jsonPath);
+        }
+        if (!options_.baselinePath.empty()) {
+            std::printf("Baseline %s:\n", options_.baselinePath.c_str());
+            if (!report.checkBaseline(options_.baselinePath, options_.tolerance)) {
+                std::printf("FAILED: regression against the baseline\n");
+                ok = false;
+            }
+        }
+        return ok ? 0 : 1;
+    }
+
+private:
+    const Options& options_;
+    std::mt19937_64 random_;
+    bench::MockMqttClient mqtt_;
+    McpServer server_;
+    std::string controlTopic_;
+    std::string rpcSuffix_;
+    uint64_t nextRequestId_ = 1;
+
+    static std::string clientId(size_t index) {
+        return "soak-" + std::to_string(index);
+    }
+
+    std::string rpcTopic(size_t index) const {
+        return "$mcp-rpc/" + clientId(index) + rpcSuffix_;
+    }
+
+    void initializeSession(size_t index, bench::Histogram& latency) {
+        std::string request = "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(nextRequestId_++) +
+            ",\"method\":\"initialize\",\"params\":{\"protocolVersion\":\"" + MCP_PROTOCOL_VERSION +
+            "\",\"clientInfo\":{\"name\":\"soak\",\"version\":\"1.0\"},\"capabilities\":{}}}";
+        auto start = bench::Clock::now();
+        mqtt_.deliver(controlTopic_, request, {{USER_PROP_MQTT_CLIENT_ID, clientId(index)}});
+        latency.add(bench::Clock::now() - start);
+        mqtt_.deliver(rpcTopic(index), R"({"jsonrpc":"2.0","method":"notifications/initialized"})");
+    }
+
+    void callTool(size_t index, bench::Histogram& latency) {
+        std::string request = "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(nextRequestId_++) +
+            ",\"method\":\"tools/call\",\"params\":{\"name\":\"echo\",\"arguments\":{}}}";
+        std::string topic = rpcTopic(index);
+        auto start = bench::Clock::now();
+        mqtt_.deliver(topic, request);
+        latency.add(bench::Clock::now() - start);
+    }
+};
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: bench_soak [--sessions N] [--calls N] [--churn-rounds N]\n"
+                             "                  [--churn-fraction F] [--seed N] [--json PATH]\n"
+                             "                  [--baseline PATH] [--tolerance F]\n");
+        return 2;
+    }
+    Logger::setLevel(LogLevel::OFF);
+
+    Soak soak(options);
+    return soak.run();
+}
@@ -0,0 +1,58 @@
+#ifndef MCP_MQTT_BENCH_MOCK_MQTT_CLIENT_H
+#define MCP_MQTT_BENCH_MOCK_MQTT_CLIENT_H
+
+/**
+ * @file mock_mqtt_client.h
+ * @brief Broker-less IMqttClient for benchmarking the server alone
+ */
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include <mcp_mqtt/mqtt_interface.h>
+
+namespace bench {
+
+/**
+ * @brief IMqttClient that only counts; messages are injected with deliver()
+ *
+ * Keeps no per-topic state, so it adds nothing to a memory measurement.
+ * Not thread-safe: deliver() runs the server's handler on the calling thread.
+ */
+class MockMqttClient : public mcp_mqtt::IMqttClient {
+public:
+    int64_t subscriptions = 0;      // Subscribes minus unsubscribes
+    uint64_t publishes = 0;
+
+    bool isConnected() const override { return true; }
+    bool subscribe(const std::string&, int, bool) override { ++subscriptions; return true; }
+    bool unsubscribe(const std::string&) override { --subscriptions; return true; }
+    bool publish(const std::string&, const std::string&, int, bool,
+                 const std::map<std::string, std::string>&) override {
+        ++publishes;
+        return true;
+    }
+    std::string getClientId() const override { return "bench-server"; }
+    void setMessageHandler(mcp_mqtt::MqttMessageHandler handler) override { handler_ = std::move(handler); }
+    void setConnectionLostCallback(std::function<void(const std::string&)>) override {}
+    void setConnectProperties(uint32_t, const std::map<std::string, std::string>&) override {}
+    void setWill(const std::string&, const std::string&, int, bool) override {}
+
+    void deliver(const std::string& topic, const std::string& payload,
+                 const std::map<std::string, std::string>& userProperties = {}) {
+        mcp_mqtt::MqttIncomingMessage message;
+        message.topic = topic;
+        message.payload = payload;
+        message.qos = 1;
+        message.userProperties = userProperties;
+        handler_(message);
+    }
+
+private:
+    mcp_mqtt::MqttMessageHandler handler_;
+};
+
+} // namespace bench
+
+#endif // MCP_MQTT_BENCH_MOCK_MQTT_CLIENT_H
@@ -0,0 +1,306 @@
+/**
+ * @file sim_churn.cpp
+ * @brief Deterministic session-churn simulation in virtual time
+ *
+ * Drives an McpServer with many simulated MCP clients over a LoopbackBroker
+ * whose link adds latency, jitter, reordering and loss, all scheduled on a
+ * VirtualClock. Clients initialize, call tools with random think times, give
+ * up on requests after a timeout and retry, disconnect and come back. Hours of
+ * simulated time run in seconds, and the same seed gives the same run: the
+ * printed trace hash covers every response and timeout with its virtual time.
+ *
+ * Usage: sim_churn [--clients N] [--duration-s S] [--seed N] [--latency-us N]
+ *                  [--jitter-us N] [--reorder RATE] [--drop RATE] [--think-ms N]
+ *                  [--session-s N] [--offline-s N] [--timeout-ms N]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <mcp_mqtt.h>
+
+using namespace mcp_mqtt;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+struct Options {
+    size_t clients = 10000;
+    int64_t durationSeconds = 3600;
+    uint64_t seed = 1;
+    LoopbackLinkOptions link;
+    int64_t thinkMs = 30000;        // Mean time between requests
+    int64_t sessionSeconds = 600;   // Mean session length
+    int64_t offlineSeconds = 60;    // Mean time before reconnecting
+    int64_t timeoutMs = 5000;
+};
+
+static bool parseArgs(int argc, char* argv[], Options& options) {
+    options.link.latency = microseconds(2000);
+    options.link.jitter = microseconds(1000);
+    options.link.reorderRate = 0.01;
+    options.link.dropRate = 0.001;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        const char* value = argv[i + 1];
+        if (arg == "--clients") options.clients = std::strtoull(value, nullptr, 10);
+        else if (arg == "--duration-s") options.durationSeconds = std::atoll(value);
+        else if (arg == "--seed") options.seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--latency-us") options.link.latency = microseconds(std::atoll(value));
+        else if (arg == "--jitter-us") options.link.jitter = microseconds(std::atoll(value));
+        else if (arg == "--reorder") options.link.reorderRate = std::atof(value);
+        else if (arg == "--drop") options.link.dropRate = std::atof(value);
+        else if (arg == "--think-ms") options.thinkMs = std::atoll(value);
+        else if (arg == "--session-s") options.sessionSeconds = std::atoll(value);
+        else if (arg == "--offline-s") options.offlineSeconds = std::atoll(value);
+        else if (arg == "--timeout-ms") options.timeoutMs = std::atoll(value);
+        else return false;
+    }
+    return argc % 2 == 1 && options.clients > 0;
+}
+
+/**
+ * @brief All simulated clients, sharing one MQTT connection to the broker
+ */
+class Simulation {
+public:
+    Simulation(const Options& options, VirtualClock& clock, IMqttClient& mqtt,
+               const std::string& serverId, const std::string& serverName)
+        : options_(options), clock_(clock), mqtt_(mqtt), random_(options.seed + 1),
+          serverSuffix_("/" + serverId + "/" + serverName),
+          controlTopic_("$mcp-server/" + serverId + "/" + serverName),
+          clients_(options.clients) {
+        for (size_t i = 0; i < clients_.size(); ++i) {
+            clients_[i].id = "c" + std::to_string(i);
+            clients_[i].rpcTopic = "$mcp-rpc/" + clients_[i].id + serverSuffix_;
+        }
+        mqtt_.setMessageHandler([this](const MqttIncomingMessage& message) { onMessage(message); });
+        mqtt_.subscribe("$mcp-rpc/+" + serverSuffix_, 1, true);
+    }
+
+    void start() {
+        // Spread the first connections over the first think interval
+        for (size_t i = 0; i < clients_.size(); ++i) {
+            clock_.scheduleAfter(randomDuration(options_.thinkMs * 1000.0), [this, i]() { connect(i); });
+        }
+    }
+
+    void report(double wallSeconds, size_t serverSessions) {
+        std::sort(latencies_.begin(), latencies_.end());
+        auto percentile = [this](double p) {
+            if (latencies_.empty()) return 0.0;
+            return latencies_[static_cast<size_t>(p / 100.0 * (latencies_.size() - 1))] / 1000.0;
+        };
+        std::printf("Simulated  %llds with %zu clients in %.2fs wall time (%.0fx)\n",
+                    static_cast<long long>(options_.durationSeconds), clients_.size(), wallSeconds,
+                    options_.durationSeconds / std::max(wallSeconds, 1e-9));
+        std::printf("Sessions   %llu opened, %llu closed, %zu open on the server\n",
+                    ull(sessionsOpened_), ull(sessionsClosed_), serverSessions);
+        std::printf("Requests   %llu sent, %llu answered (%llu errors), %llu timed out\n",
+                    ull(requests_), ull(responses_), ull(errors_), ull(timeouts_));
+        std::printf("Latency    p50=%.2fms p99=%.2fms p99.9=%.2fms max=%.2fms (virtual)\n",
+                    percentile(50), percentile(99), percentile(99.9), percentile(100));
+        std::printf("Trace hash %016llx (seed %llu)\n", ull(traceHash_), ull(options_.seed));
+    }
+
+private:
+    enum class State { OFFLINE, INITIALIZING, ACTIVE };
+
+    struct Client {
+        std::string id;
+        std::string rpcTopic;
+        State state = State::OFFLINE;
+        int64_t nextRequestId = 1;
+        int64_t pendingId = 0;      // Outstanding request, 0 = none
+        IClock::TimePoint sentAt;
+        IClock::TimerId timeoutTimer = 0;
+        IClock::TimePoint sessionEnd;
+    };
+
+    const Options& options_;
+    VirtualClock& clock_;
+    IMqttClient& mqtt_;
+    std::mt19937_64 random_;
+    std::string serverSuffix_;
+    std::string controlTopic_;
+    std::vector<Client> clients_;
+
+    uint64_t sessionsOpened_ = 0;
+    uint64_t sessionsClosed_ = 0;
+    uint64_t requests_ = 0;
+    uint64_t responses_ = 0;
+    uint64_t errors_ = 0;
+    uint64_t timeouts_ = 0;
+    uint64_t traceHash_ = 14695981039346656037ull;
+    std::vector<int64_t> latencies_;    // Microseconds
+
+    static unsigned long long ull(uint64_t value) { return static_cast<unsigned long long>(value); }
+
+    // Exponentially distributed, from the generator's top 53 bits so the
+    // sequence is the same with every standard library
+    microseconds randomDuration(double meanMicros) {
+        double u = static_cast<double>(random_() >> 11) * (1.0 / 9007199254740992.0);
+        return microseconds(static_cast<int64_t>(-meanMicros * std::log(1.0 - u)));
+    }
+
+    void trace(size_t index, uint64_t event) {
+        uint64_t values[3] = {
+            static_cast<uint64_t>(clock_.now().time_since_epoch().count()), index, event};
+        for (uint64_t value : values) {
+            traceHash_ = (traceHash_ ^ value) * 1099511628211ull;
+        }
+    }
+
+    void send(size_t index, const std::string& method, const nlohmann::json& params) {
+        Client& client = clients_[index];
+        client.pendingId = client.nextRequestId++;
+        client.sentAt = clock_.now();
+        ++requests_;
+
+        nlohmann::json request = {{"jsonrpc", "2.0"}, {"id", client.pendingId}, {"method", method}};
+        if (!params.is_null()) request["params"] = params;
+        if (method == "initialize") {
+            mqtt_.publish(controlTopic_, request.dump(), 1, false, {{USER_PROP_MQTT_CLIENT_ID, client.id}});
+        } else {
+            mqtt_.publish(client.rpcTopic, request.dump(), 1, false);
+        }
+        client.timeoutTimer = clock_.scheduleAfter(milliseconds(options_.timeoutMs),
+                                                   [this, index]() { onTimeout(index); });
+    }
+
+    void notify(size_t index, const std::string& method) {
+        mqtt_.publish(clients_[index].rpcTopic, nlohmann::json{{"jsonrpc", "2.0"}, {"method", method}}.dump(),
+                      1, false);
+    }
+
+    void connect(size_t index) {
+        clients_[index].state = State::INITIALIZING;
+        send(index, "initialize", {
+            {"protocolVersion", MCP_PROTOCOL_VERSION},
+            {"clientInfo", {{"name", "sim"}, {"version", "1.0"}}},
+            {"capabilities", nlohmann::json::object()}
+        });
+    }
+
+    void think(size_t index) {
+        clock_.scheduleAfter(randomDuration(options_.thinkMs * 1000.0), [this, index]() { act(index); });
+    }
+
+    void act(size_t index) {
+        Client& client = clients_[index];
+        if (client.state != State::ACTIVE) {
+            return;
+        }
+        if (clock_.now() >= client.sessionEnd) {
+            notify(index, "notifications/disconnected");
+            client.state = State::OFFLINE;
+            ++sessionsClosed_;
+            clock_.scheduleAfter(randomDuration(options_.offlineSeconds * 1e6), [this, index]() { connect(index); });
+            return;
+        }
+
+        uint64_t pick = random_() % 10;
+        if (pick == 0) {
+            send(index, "ping", nullptr);
+        } else if (pick == 1) {
+            send(index, "tools/list", nullptr);
+        } else {
+            send(index, "tools/call", {{"name", "add"}, {"arguments", {{"a", pick}, {"b", index}}}});
+        }
+    }
+
+    void onMessage(const MqttIncomingMessage& message) {
+        // "$mcp-rpc/c<index>/..."
+        size_t begin = message.topic.find('/') + 2;
+        size_t index = std::strtoull(message.topic.c_str() + begin, nullptr, 10);
+        if (index >= clients_.size()) return;
+        Client& client = clients_[index];
+
+        auto json = nlohmann::json::parse(message.payload, nullptr, false);
+        if (!json.is_object() || !json.contains("id") || !json["id"].is_number_integer() ||
+            json["id"].get<int64_t>() != client.pendingId) {
+            return;     // Notification, or the answer to a request we gave up on
+        }
+
+        clock_.cancel(client.timeoutTimer);
+        client.pendingId = 0;
+        ++responses_;
+        if (json.contains("error")) ++errors_;
+        latencies_.push_back(std::chrono::duration_cast<microseconds>(clock_.now() - client.sentAt).count());
+        trace(index, 1);
+
+        if (client.state == State::INITIALIZING) {
+            notify(index, "notifications/initialized");
+            client.state = State::ACTIVE;
+            client.sessionEnd = clock_.now() + randomDuration(options_.sessionSeconds * 1e6);
+            ++sessionsOpened_;
+        }
+        think(index);
+    }
+
+    void onTimeout(size_t index) {
+        Client& client = clients_[index];
+        client.pendingId = 0;
+        ++timeouts_;
+        trace(index, 2);
+        if (client.state == State::INITIALIZING) {
+            connect(index);
+        } else {
+            think(index);
+        }
+    }
+};
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: sim_churn [--clients N] [--duration-s S] [--seed N] [--latency-us N]\n"
+                             "                 [--jitter-us N] [--reorder RATE] [--drop RATE] [--think-ms N]\n"
+                             "                 [--session-s N] [--offline-s N] [--timeout-ms N]\n");
+        return 2;
+    }
+    Logger::setLevel(LogLevel::ERROR);
+
+    VirtualClock clock;
+    LoopbackBroker broker;
+    broker.setLink(&clock, options.link, options.seed);
+    auto serverClient = broker.createClient("sim-server");
+    auto driverClient = broker.createClient("sim-clients");
+
+    McpServer server;
+    server.setClock(&clock);
+    server.configure({"SimServer", "1.0.0"}, ServerCapabilities{});
+    Tool add;
+    add.name = "add";
+    add.description = "Add two numbers";
+    server.registerTool(add, [](const nlohmann::json& args) {
+        return ToolCallResult::success(std::to_string(args.value("a", 0) + args.value("b", 0)));
+    });
+
+    McpServerConfig config;
+    config.serverId = "sim-server";
+    config.serverName = "sim/churn";
+    server.start(serverClient.get(), config);
+
+    Simulation simulation(options, clock, *driverClient, config.serverId, config.serverName);
+    simulation.start();
+
+    auto wallStart = std::chrono::steady_clock::now();
+    clock.runFor(seconds(options.durationSeconds));
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    simulation.report(wallSeconds, server.getConnectedClients().size());
+    std::printf("Link       %llu deliveries, %llu dropped\n",
+                static_cast<unsigned long long>(broker.getDeliveredCount()),
+                static_cast<unsigned long long>(broker.getDroppedCount()));
+
+    server.stop();
+    return 0;
+}
@@ -3,13 +3,10 @@
 #include <chrono>
 #include <csignal>
 #include <atomic>
-#include <mutex>
-
-// Paho MQTT C++ headers
-#include <mqtt/async_client.h>
 
 // MCP SDK headers
 #include <mcp_mqtt.h>
+#include <mcp_mqtt/paho_mqtt_client.h>
 
 using namespace mcp_mqtt;
 
@@ -21,241 +18,6 @@ void signalHandler(int signum) {
     g_running = false;
 }
 
-/**
- * @brief Example implementation of IMqttClient using Paho MQTT C++
- *
- * This demonstrates how users implement the IMqttClient interface
- * using their preferred MQTT library. Users have full control over
- * the MQTT client and can use it for any purpose.
- */
-class PahoMqttClientAdapter : public IMqttClient, public mqtt::callback {
-public:
-    PahoMqttClientAdapter(const std::string& brokerAddress, const std::string& clientId)
-        : clientId_(clientId), brokerAddress_(brokerAddress) {
-        // Create MQTT 5.0 client
-        mqtt::create_options createOpts(MQTTVERSION_5);
-        client_ = std::make_unique<mqtt::async_client>(brokerAddress, clientId, createOpts);
-        client_->set_callback(*this);
-    }
-
-    ~PahoMqttClientAdapter() override {
-        if (client_->is_connected()) {
-            client_->disconnect()->wait();
-        }
-    }
-
-    // Connect to broker (user manages this)
-    bool connect(const std::string& username = "", const std::string& password = "") {
-        try {
-            auto connBuilder = mqtt::connect_options_builder()
-                .mqtt_version(MQTTVERSION_5)
-                .clean_start(true)
-                .keep_alive_interval(std::chrono::seconds(60));
-
-            if (!username.empty()) {
-                connBuilder.user_name(username);
-                if (!password.empty()) {
-                    connBuilder.password(password);
-                }
-            }
-
-            // Set will message if configured via setWill()
-            if (!willTopic_.empty()) {
-                mqtt::message willMsg(willTopic_, willPayload_, willQos_, willRetained_);
-                connBuilder.will(willMsg);
-            }
-
-            // Set MQTT 5.0 CONNECT properties if configured via setConnectProperties()
-            if (connectPropsSet_) {
-                mqtt::properties props;
-                props.add(mqtt::property(mqtt::property::SESSION_EXPIRY_INTERVAL,
-                    sessionExpiryInterval_));
-                for (const auto& [key, value] : connectUserProperties_) {
-                    props.add(mqtt::property(mqtt::property::USER_PROPERTY, key, value));
-                }
-                connBuilder.properties(props);
-            }
-
-            // Enable SSL/TLS if the broker address uses a secure scheme
-            if (brokerAddress_.substr(0, 6) == "ssl://" ||
-                brokerAddress_.substr(0, 6) == "wss://" ||
-                brokerAddress_.substr(0, 7) == "mqtts://") {
-                auto sslOpts = mqtt::ssl_options_builder()
-                    .enable_server_cert_auth(true)
-                    .verify(true)
-                    .finalize();
-                connBuilder.ssl(sslOpts);
-            }
-
-            auto connOpts = connBuilder.finalize();
-            client_->connect(connOpts)->wait();
-            return true;
-        } catch (const mqtt::exception& e) {
-            std::cerr << "Connect error: " << e.what() << std::endl;
-            return false;
-        }
-    }
-
-    // IMqttClient interface implementation
-    bool isConnected() const override {
-        return client_->is_connected();
-    }
-
-    bool subscribe(const std::string& topic, int qos, bool noLocal) override {
-        try {
-            mqtt::subscribe_options subOpts;
-            subOpts.set_no_local(noLocal);
-            // Do NOT use ->wait() here: subscribe() may be called from within
-            // a Paho callback (message_arrived), and ->wait() would deadlock
-            // because the SUBACK is processed on the same (blocked) thread.
-            client_->subscribe(topic, qos, subOpts);
-            return true;
-        } catch (const mqtt::exception& e) {
-            std::cerr << "Subscribe error: " << e.what() << std::endl;
-            return false;
-        }
-    }
-
-    bool unsubscribe(const std::string& topic) override {
-        try {
-            // Do NOT use ->wait() here for the same deadlock reason as subscribe().
-            client_->unsubscribe(topic);
-            return true;
-        } catch (const mqtt::exception& e) {
-            std::cerr << "Unsubscribe error: " << e.what() << std::endl;
-            return false;
-        }
-    }
-
-    bool publish(const std::string& topic, const std::string& payload,
-                 int qos, bool retained,
-                 const std::map<std::string, std::string>& userProps) override {
-        try {
-            auto msg = mqtt::make_message(topic, payload, qos, retained);
-
-            // Add user properties
-            mqtt::properties props;
-            for (const auto& [key, value] : userProps) {
-                props.add(mqtt::property(mqtt::property::USER_PROPERTY, key, value));
-            }
-            msg->set_properties(props);
-
-            client_->publish(msg);
-            return true;
-        } catch (const mqtt::exception& e) {
-            std::cerr << "Publish error: " << e.what() << std::endl;
-            return false;
-        }
-    }
-
-    std::string getClientId() const override {
-        return clientId_;
-    }
-
-    void setMessageHandler(MqttMessageHandler handler) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        messageHandler_ = handler;
-    }
-
-    void setConnectionLostCallback(std::function<void(const std::string&)> callback) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        connectionLostCallback_ = callback;
-    }
-
-    void setConnectProperties(uint32_t sessionExpiryInterval,
-                               const std::map<std::string, std::string>& userProperties) override {
-        sessionExpiryInterval_ = sessionExpiryInterval;
-        connectUserProperties_ = userProperties;
-        connectPropsSet_ = true;
-    }
-
-    void setWill(const std::string& topic, const std::string& payload,
-                 int qos, bool retained) override {
-        willTopic_ = topic;
-        willPayload_ = payload;
-        willQos_ = qos;
-        willRetained_ = retained;
-
-        // If already connected, reconnect with the new Will message
-        if (client_->is_connected()) {
-            try {
-                client_->disconnect()->wait();
-                connect();
-            } catch (const mqtt::exception& e) {
-                std::cerr << "Reconnect with Will error: " << e.what() << std::endl;
-            }
-        }
-    }
-
-    // mqtt::callback overrides
-    void message_arrived(mqtt::const_message_ptr msg) override {
-        MqttMessageHandler handler;
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            handler = messageHandler_;
-        }
-
-        if (handler) {
-            MqttIncomingMessage inMsg;
-            inMsg.topic = msg->get_topic();
-            inMsg.payload = msg->to_string();
-            inMsg.qos = msg->get_qos();
-            inMsg.retained = msg->is_retained();
-
-            // Extract user properties using C-level API for cross-version compatibility
-            const auto& props = msg->get_properties();
-            const auto& cProps = props.c_struct();
-            for (int i = 0; i < cProps.count; ++i) {
-                if (cProps.array[i].identifier == MQTTPROPERTY_CODE_USER_PROPERTY) {
-                    std::string key(cProps.array[i].value.data.data,
-                                    cProps.array[i].value.data.len);
-                    std::string val(cProps.array[i].value.value.data,
-                                    cProps.array[i].value.value.len);
-                    inMsg.userProperties[key] = val;
-                }
-            }
-
-            handler(inMsg);
-        }
-    }
-
-    void connection_lost(const std::string& cause) override {
-        std::function<void(const std::string&)> callback;
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            callback = connectionLostCallback_;
-        }
-        if (callback) {
-            callback(cause);
-        }
-    }
-
-    void connected(const std::string&) override {}
-    void delivery_complete(mqtt::delivery_token_ptr) override {}
-
-    // User can access the underlying client for non-MCP operations
-    mqtt::async_client* getUnderlyingClient() {
-        return client_.get();
-    }
-
-private:
-    std::unique_ptr<mqtt::async_client> client_;
-    std::string clientId_;
-    std::string brokerAddress_;
-    std::mutex mutex_;
-    MqttMessageHandler messageHandler_;
-    std::function<void(const std::string&)> connectionLostCallback_;
-    // Will message configuration (set by SDK via setWill())
-    std::string willTopic_;
-    std::string willPayload_;
-    int willQos_ = 1;
-    bool willRetained_ = true;
-    // CONNECT properties (set by SDK via setConnectProperties())
-    uint32_t sessionExpiryInterval_ = 0;
-    std::map<std::string, std::string> connectUserProperties_;
-    bool connectPropsSet_ = false;
-};
-
 int main(int argc, char* argv[]) {
     // Parse command line arguments
     std::string brokerAddress = "tcp://localhost:1883";
@@ -280,7 +42,8 @@ int main(int argc, char* argv[]) {
     std::signal(SIGTERM, signalHandler);
 
     // Step 1: Create and configure YOUR OWN MQTT client
-    PahoMqttClientAdapter mqttClient(brokerAddress, serverId);
+    // (PahoMqttClient ships in the mcp_mqtt_paho library; any IMqttClient works)
+    PahoMqttClient mqttClient(brokerAddress, serverId);
 
     if (!mqttClient.connect()) {
         std::cerr << "Failed to connect to MQTT broker" << std::endl;
@@ -13,13 +13,29 @@
  * 3. Create McpServer, configure it, register tools
  * 4. Call McpServer::start() with your MQTT client
  * 5. The SDK handles all MCP-related messaging automatically
+ *
+ * The client side works the same way: start an McpClient on another MQTT
+ * client, pick a server from getServers(), then create and initialize a
+ * session to it.
  */
 
 #include "mcp_mqtt/types.h"
 #include "mcp_mqtt/logger.h"
 #include "mcp_mqtt/json_rpc.h"
 #include "mcp_mqtt/mqtt_interface.h"
+#include "mcp_mqtt/session_transport.h"
+#include "mcp_mqtt/shm_channel.h"
+#include "mcp_mqtt/execution_journal.h"
+#include "mcp_mqtt/clock.h"
 #include "mcp_mqtt/tool_manager.h"
 #include "mcp_mqtt/mcp_server.h"
+#include "mcp_mqtt/server_directory.h"
+#include "mcp_mqtt/mcp_client.h"
+#include "mcp_mqtt/load_balancer.h"
+#include "mcp_mqtt/mcp_server_host.h"
+#include "mcp_mqtt/local_listener.h"
+#include "mcp_mqtt/loopback_broker.h"
+#include "mcp_mqtt/traffic_recorder.h"
+#include "mcp_mqtt/fault_injector.h"
 
 #endif // MCP_MQTT_H
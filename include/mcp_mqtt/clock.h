@@ -0,0 +1,159 @@
+#ifndef MCP_MQTT_CLOCK_H
+#define MCP_MQTT_CLOCK_H
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Source of time and timers for the SDK
+ *
+ * McpServer and LoopbackBroker read the time and schedule their timers
+ * through this interface, so a simulation can swap the system clock for a
+ * VirtualClock. Time points are steady_clock time points.
+ */
+class IClock {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+    using Duration = std::chrono::steady_clock::duration;
+    using TimerId = uint64_t;       // 0 is never a valid timer
+    using Callback = std::function<void()>;
+
+    virtual ~IClock() = default;
+
+    /**
+     * @brief Current time
+     */
+    virtual TimePoint now() const = 0;
+
+    /**
+     * @brief Run a callback once at (or after) a point in time
+     * @return Timer ID for cancel()
+     */
+    virtual TimerId schedule(TimePoint at, Callback callback) = 0;
+
+    /**
+     * @brief Cancel a timer that has not fired yet
+     *
+     * Does not wait for a callback that is already running: it returns false
+     * and the callback runs to completion, possibly on another thread. Owners
+     * whose callbacks capture them must wait for that themselves before they
+     * go away.
+     *
+     * @return true if the timer was pending
+     */
+    virtual bool cancel(TimerId id) = 0;
+
+    /**
+     * @brief Run a callback after a delay
+     */
+    TimerId scheduleAfter(Duration delay, Callback callback) {
+        return schedule(now() + delay, std::move(callback));
+    }
+};
+
+/**
+ * @brief The steady system clock, with timers fired by one background thread
+ *
+ * The thread starts with the first schedule() call. Callbacks run on it one
+ * at a time and should be short.
+ */
+class SystemClock : public IClock {
+public:
+    SystemClock() = default;
+    ~SystemClock() override;
+
+    SystemClock(const SystemClock&) = delete;
+    SystemClock& operator=(const SystemClock&) = delete;
+
+    /**
+     * @brief Process-wide instance, the default clock of the SDK
+     */
+    static SystemClock& instance();
+
+    TimePoint now() const override;
+    TimerId schedule(TimePoint at, Callback callback) override;
+    bool cancel(TimerId id) override;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    bool stopping_ = false;
+    TimerId nextId_ = 1;
+    std::map<std::pair<TimePoint, TimerId>, Callback> timers_;
+    std::unordered_map<TimerId, TimePoint> timerIndex_;
+
+    void timerLoop();
+};
+
+/**
+ * @brief Manually advanced clock for deterministic simulations.
+ *
+ * Time only moves when the owner runs the clock: runUntil() and runFor() fire
+ * due timers in time order (ties in scheduling order) on the calling thread,
+ * setting now() to each timer's time before its callback runs. Callbacks may
+ * schedule further timers. A scenario driven from one thread, with random
+ * choices from a seeded generator, therefore replays identically, and hours
+ * of simulated time take only as long as the work done in them.
+ *
+ * schedule() and cancel() are thread-safe; the run methods must not be called
+ * concurrently.
+ */
+class VirtualClock : public IClock {
+public:
+    /**
+     * @param start Initial time
+     */
+    explicit VirtualClock(TimePoint start = TimePoint{} + std::chrono::hours(1));
+
+    VirtualClock(const VirtualClock&) = delete;
+    VirtualClock& operator=(const VirtualClock&) = delete;
+
+    TimePoint now() const override;
+    TimerId schedule(TimePoint at, Callback callback) override;
+    bool cancel(TimerId id) override;
+
+    /**
+     * @brief Fire all timers due up to a point in time, then move now() there
+     * @return Number of timers fired
+     */
+    size_t runUntil(TimePoint until);
+
+    /**
+     * @brief runUntil(now() + duration)
+     */
+    size_t runFor(Duration duration);
+
+    /**
+     * @brief Fire timers until none are left, however far in the future
+     * @param maxTimers Stop after this many (guards against endless rescheduling)
+     * @return Number of timers fired
+     */
+    size_t runUntilIdle(size_t maxTimers = SIZE_MAX);
+
+    /**
+     * @brief Number of pending timers
+     */
+    size_t getPendingCount() const;
+
+private:
+    mutable std::mutex mutex_;
+    TimePoint now_;
+    TimerId nextId_ = 1;
+    std::map<std::pair<TimePoint, TimerId>, Callback> timers_;
+    std::unordered_map<TimerId, TimePoint> timerIndex_;
+
+    bool runNext(TimePoint until);
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_CLOCK_H
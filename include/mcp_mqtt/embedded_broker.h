@@ -0,0 +1,187 @@
+#ifndef MCP_MQTT_EMBEDDED_BROKER_H
+#define MCP_MQTT_EMBEDDED_BROKER_H
+
+#include <string>
+#include <map>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include "mqtt_interface.h"
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Options for EmbeddedBroker
+ */
+struct EmbeddedBrokerOptions {
+    bool listenTcp = true;
+    std::string listenHost = "127.0.0.1";
+    uint16_t port = 1883;                   // 0 = any free port (see getPort())
+    std::string unixSocketPath;             // Also listen on a Unix domain socket if set
+    uint16_t topicAliasMaximum = 16;        // Aliases remote clients may use towards the broker
+    size_t maxPacketSize = 1 << 20;         // Larger packets close the connection
+    size_t maxQueuedBytes = 8 << 20;        // Unsent data after which a slow client is dropped
+    std::chrono::seconds connectTimeout{10};
+};
+
+/**
+ * @brief In-process MQTT 5.0 broker for single-gateway edge deployments (Linux).
+ *
+ * Covers what MCP over MQTT needs from a broker, so the server and its
+ * clients can run without a separate broker process:
+ * - Subscriptions with '+' and '#' wildcards and the No Local option
+ * - Retained messages (presence), cleared by an empty retained payload
+ * - Will messages, published when a remote client goes away without a normal
+ *   DISCONNECT, misses its keep-alive or is taken over by a new connection
+ *   with the same client ID
+ * - MQTT 5.0 publish properties (user properties, message expiry, request/
+ *   response metadata) and topic aliases from clients
+ *
+ * In-process clients come from createClient() and implement IMqttClient, so
+ * an McpServer uses the broker without any socket. Remote clients connect over
+ * TCP or a Unix domain socket. One I/O thread runs an epoll loop over the
+ * listeners and connections. Message handlers of in-process clients run on a
+ * separate delivery thread, one message at a time and in order, like those of
+ * a network client; a slow handler (an McpServer running a tool) delays other
+ * in-process deliveries but never the network clients.
+ *
+ * Not supported: persistent sessions (every connection starts clean),
+ * outgoing QoS 2 (granted as QoS 1), retransmission and shared subscriptions.
+ */
+class EmbeddedBroker {
+public:
+    explicit EmbeddedBroker(const EmbeddedBrokerOptions& options = {});
+    ~EmbeddedBroker();
+
+    EmbeddedBroker(const EmbeddedBroker&) = delete;
+    EmbeddedBroker& operator=(const EmbeddedBroker&) = delete;
+
+    /**
+     * @brief Open the listeners and start the I/O thread
+     * @return true on success
+     */
+    bool start();
+
+    /**
+     * @brief Close all connections and listeners and stop the I/O thread
+     *
+     * In-process clients stay registered but report disconnected, and their
+     * connection-lost callbacks run.
+     */
+    void stop();
+
+    bool isRunning() const;
+
+    /**
+     * @brief TCP port the broker listens on (useful with port 0)
+     */
+    uint16_t getPort() const;
+
+    /**
+     * @brief Create an in-process client
+     *
+     * The broker must outlive the client. Destroying the client ends its
+     * session and removes its subscriptions.
+     *
+     * @param clientId Client ID, unique among all connected clients
+     * @return The client, or nullptr if the ID is in use
+     */
+    std::unique_ptr<IMqttClient> createClient(const std::string& clientId);
+
+    /**
+     * @brief Number of connected clients, in-process and remote
+     */
+    size_t getSessionCount() const;
+
+    /**
+     * @brief Number of retained messages held
+     */
+    size_t getRetainedCount() const;
+
+private:
+    struct Message;
+    struct Session;
+    class LocalClient;
+
+    struct Subscriber {
+        std::shared_ptr<Session> session;
+        int qos = 0;
+        bool noLocal = false;
+    };
+
+    struct LocalDelivery {
+        std::shared_ptr<Session> session;
+        std::shared_ptr<const Message> message;
+        int qos = 0;
+        bool retained = false;
+    };
+
+    EmbeddedBrokerOptions options_;
+
+    int tcpFd_ = -1;
+    int unixFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+    int timerFd_ = -1;
+    uint16_t boundPort_ = 0;
+    std::thread ioThread_;
+    std::thread deliveryThread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+
+    // Sessions, subscriptions and retained messages
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Session>> sessions_;  // By client ID
+    std::unordered_map<std::string, std::vector<Subscriber>> exactSubscriptions_;
+    std::vector<std::pair<std::string, Subscriber>> wildcardSubscriptions_;
+    std::map<std::string, std::shared_ptr<const Message>> retained_;
+    uint64_t nextAssignedId_ = 0;
+
+    // Work queued by any thread: deliveries to in-process clients for the
+    // delivery thread, sessions with unsent data for the I/O thread
+    std::mutex pendingMutex_;
+    std::condition_variable pendingLocalCv_;
+    std::deque<LocalDelivery> pendingLocal_;
+    std::vector<std::shared_ptr<Session>> pendingFlush_;
+
+    // I/O thread state
+    std::unordered_map<int, std::shared_ptr<Session>> connections_;    // Remote sessions by socket
+
+    bool openListener(bool unixSocket);
+    void closeResources();
+    void ioLoop();
+    void acceptConnections(int listenFd);
+    bool readAvailable(const std::shared_ptr<Session>& session);
+    bool dispatchPacket(const std::shared_ptr<Session>& session, const char* data, size_t len);
+    bool handleConnect(const std::shared_ptr<Session>& session, const char* data, size_t len);
+    void queuePacket(const std::shared_ptr<Session>& session, const std::string& packet);
+    bool flushSession(Session& session);
+    void checkKeepAlive();
+    void closeConnection(const std::shared_ptr<Session>& session, bool publishWill, const std::string& reason);
+    void runPendingWork();
+    void deliveryLoop();
+
+    bool registerSession(const std::shared_ptr<Session>& session);
+    void endSession(const std::shared_ptr<Session>& session, bool publishWill);
+    std::vector<std::shared_ptr<const Message>> subscribe(const std::shared_ptr<Session>& session,
+                                                          const std::string& filter, int qos, bool noLocal);
+    bool unsubscribe(const std::shared_ptr<Session>& session, const std::string& filter);
+    void removeSubscriptions(Session& session);
+    void route(const Session* from, const std::shared_ptr<const Message>& message);
+    void deliver(const std::shared_ptr<Session>& session, const std::shared_ptr<const Message>& message,
+                 int qos, bool retained);
+    void deliverLocal(const LocalDelivery& delivery);
+    void wakeIoThread();
+    bool onIoThread() const;
+    bool onDeliveryThread() const;
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_EMBEDDED_BROKER_H
@@ -0,0 +1,168 @@
+#ifndef MCP_MQTT_EPOLL_MQTT_CLIENT_H
+#define MCP_MQTT_EPOLL_MQTT_CLIENT_H
+
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "mqtt_interface.h"
+
+namespace mcp_mqtt {
+
+namespace mqtt5 {
+struct PublishPacket;
+}
+
+/**
+ * @brief Options for EpollMqttClient
+ */
+struct EpollMqttClientOptions {
+    std::string host = "127.0.0.1";
+    uint16_t port = 1883;
+    std::string unixSocketPath;     // Connect over a Unix domain socket instead of TCP if set
+    std::string username;
+    std::string password;
+    uint16_t keepAliveSeconds = 60;
+    uint16_t topicAliasMaximum = 32;    // Aliases the broker may use towards us
+    size_t maxPacketSize = 1 << 20;     // Announced in CONNECT; larger packets close the connection
+    std::chrono::milliseconds connectTimeout{5000};
+};
+
+/**
+ * @brief Lightweight built-in MQTT 5.0 client for Linux.
+ *
+ * Intended for edge devices where a full MQTT stack costs too much memory
+ * and too many threads. The client runs a single I/O thread with an epoll
+ * loop over the socket, an eventfd for wake-ups and a timerfd for keep-alive:
+ * - Incoming packets are decoded in place in the receive buffer and handed
+ *   to the message handler through one reused MqttIncomingMessage
+ * - Outgoing packets are encoded straight into a shared buffer and written
+ *   with a single writev() per loop iteration, batching everything published
+ *   in between; large payloads stay in a buffer of their own and are
+ *   gathered behind their packet header instead of being packed
+ * - Topic aliases sent by the broker are resolved transparently, and aliases
+ *   passed to publishWithProperties() are used within the broker's maximum
+ *
+ * The message handler runs on the I/O thread. Publishing from any thread is
+ * safe. Subscriptions are restored when setWill() reconnects.
+ */
+class EpollMqttClient : public IMqttClient {
+public:
+    EpollMqttClient(const std::string& clientId, const EpollMqttClientOptions& options = {});
+    ~EpollMqttClient() override;
+
+    EpollMqttClient(const EpollMqttClient&) = delete;
+    EpollMqttClient& operator=(const EpollMqttClient&) = delete;
+
+    /**
+     * @brief Connect to the broker and start the I/O thread (blocking until CONNACK)
+     * @return true if connected
+     */
+    bool connect();
+
+    /**
+     * @brief Send DISCONNECT, close the socket and stop the I/O thread
+     */
+    void disconnect();
+
+    /**
+     * @brief Topic Alias Maximum announced by the broker in CONNACK
+     */
+    uint16_t getBrokerTopicAliasMaximum() const;
+
+    // IMqttClient interface
+    bool isConnected() const override;
+    bool subscribe(const std::string& topic, int qos, bool noLocal) override;
+    bool unsubscribe(const std::string& topic) override;
+    bool publish(const std::string& topic,
+                 const std::string& payload,
+                 int qos,
+                 bool retained,
+                 const std::map<std::string, std::string>& userProps = {}) override;
+    bool publishWithProperties(const std::string& topic,
+                               const std::string& payload,
+                               int qos,
+                               bool retained,
+                               const MqttPublishProperties& properties) override;
+    uint16_t getTopicAliasMaximum() const override;
+    std::string getClientId() const override;
+    void setMessageHandler(MqttMessageHandler handler) override;
+    void setConnectionLostCallback(std::function<void(const std::string& reason)> callback) override;
+    bool setConnectionRestoredCallback(std::function<void()> callback) override;
+    void setConnectProperties(uint32_t sessionExpiryInterval,
+                              const std::map<std::string, std::string>& userProperties) override;
+    void setWill(const std::string& topic, const std::string& payload,
+                 int qos, bool retained) override;
+
+private:
+    std::string clientId_;
+    EpollMqttClientOptions options_;
+
+    int sockFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+    int timerFd_ = -1;
+    std::thread ioThread_;
+    std::atomic<bool> connected_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> reconnectRequested_{false};
+    std::atomic<uint16_t> brokerTopicAliasMaximum_{0};
+
+    mutable std::mutex mutex_;
+    MqttMessageHandler messageHandler_;
+    std::function<void(const std::string&)> connectionLostCallback_;
+    std::function<void()> connectionRestoredCallback_;
+    std::map<std::string, std::pair<int, bool>> subscriptions_;  // Restored on reconnect
+    uint32_t sessionExpiryInterval_ = 0;
+    std::map<std::string, std::string> connectUserProperties_;
+    bool hasWill_ = false;
+    std::string willTopic_;
+    std::string willPayload_;
+    int willQos_ = 0;
+    bool willRetained_ = false;
+
+    // Outgoing packets, encoded by any thread and flushed by the I/O thread.
+    // Small packets are packed into the last chunk, which is never a payload
+    std::mutex outMutex_;
+    std::deque<std::string> outQueue_;
+    uint16_t nextPacketId_ = 0;
+    std::vector<std::string> outboundAliases_;  // Topics established per alias on this connection
+
+    // I/O thread state. inBuffer_ only grows, so reads do not zero-fill it
+    std::vector<char> inBuffer_;
+    size_t inFill_ = 0;     // Received bytes at the front of inBuffer_
+    std::deque<std::string> sending_;
+    size_t sendOffset_ = 0;     // Into sending_.front()
+    std::vector<std::string> inboundAliases_;
+    MqttIncomingMessage incoming_;
+    bool pingOutstanding_ = false;
+
+    bool openSocket();
+    bool handshake();
+    void closeSocket();
+    void startIoThread();
+    void ioLoop();
+    bool readAvailable();
+    bool checkPacketSize(long size);
+    void consumeInput(size_t used);
+    bool flushOutgoing(bool takeQueued = true);
+    bool enqueuePublish(const std::string& topic, const std::string& payload, int qos, bool retained,
+                        mqtt5::PublishPacket& publish, uint16_t topicAlias);
+    void collectQueued();
+    void resetOutgoing();
+    bool dispatchPacket(const char* data, size_t len);
+    void enqueue(const std::string& packet);
+    void wakeIoThread();
+    uint16_t allocatePacketId();
+    bool onIoThread() const;
+    bool reconnectInPlace();
+    void handleConnectionLost(const std::string& reason);
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_EPOLL_MQTT_CLIENT_H
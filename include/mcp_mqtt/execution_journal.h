@@ -0,0 +1,116 @@
+#ifndef MCP_MQTT_EXECUTION_JOURNAL_H
+#define MCP_MQTT_EXECUTION_JOURNAL_H
+
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Persistent, memory-mapped journal of tool executions.
+ *
+ * Backs the exactly-once mode of McpServer: a call is recorded as started
+ * before its tool runs and as completed, together with its result, afterwards.
+ * A duplicate of the call (QoS 1/2 redelivery, a client retry, or the same
+ * request after a server restart) finds the record and gets the recorded
+ * outcome instead of running the tool again.
+ *
+ * Records are appended to a memory-mapped file and flushed with msync() before
+ * begin() and complete() return. Each record carries a checksum; a torn record
+ * at the end of the file (crash during a write) is discarded on open. All
+ * records are indexed in memory on open. When the file is full it is
+ * compacted to the latest record per key, dropping keys older than the
+ * retention period, and grown if still more than half full.
+ *
+ * Thread-safe.
+ */
+class ExecutionJournal {
+public:
+    /**
+     * @brief State of an execution key
+     */
+    enum class State {
+        NEW,        // Not seen before (begin() has now recorded it as started)
+        STARTED,    // Started but never completed (in progress, or interrupted by a crash)
+        COMPLETED   // Completed; the recorded result is available
+    };
+
+    /**
+     * @brief Outcome of begin()
+     */
+    struct Entry {
+        State state = State::NEW;
+        std::string result;     // Recorded result if COMPLETED
+    };
+
+    ExecutionJournal() = default;
+    ~ExecutionJournal();
+
+    ExecutionJournal(const ExecutionJournal&) = delete;
+    ExecutionJournal& operator=(const ExecutionJournal&) = delete;
+
+    /**
+     * @brief Open (or create) a journal file and load its records
+     * @param path Journal file path
+     * @param initialCapacity Initial file size in bytes for a new journal
+     * @param retention How long completed executions are remembered
+     * @return true on success
+     */
+    bool open(const std::string& path,
+              size_t initialCapacity = 1 << 20,
+              std::chrono::seconds retention = std::chrono::hours(24));
+
+    /**
+     * @brief Unmap and close the journal file
+     */
+    void close();
+
+    bool isOpen() const;
+
+    /**
+     * @brief Record the start of an execution unless the key is already known
+     * @param key Execution key (e.g. client ID and request ID)
+     * @return NEW if the caller should execute now; otherwise the existing state
+     */
+    Entry begin(const std::string& key);
+
+    /**
+     * @brief Record the result of an execution started with begin()
+     * @return true if the record was persisted
+     */
+    bool complete(const std::string& key, const std::string& result);
+
+    /**
+     * @brief Number of executions currently remembered
+     */
+    size_t size() const;
+
+private:
+    struct IndexEntry {
+        State state;
+        int64_t timestamp;
+        std::string result;
+    };
+
+    mutable std::mutex mutex_;
+    std::string path_;
+    std::chrono::seconds retention_{0};
+    int fd_ = -1;
+    char* map_ = nullptr;
+    size_t capacity_ = 0;
+    size_t end_ = 0;
+    std::unordered_map<std::string, IndexEntry> index_;
+
+    bool mapFile(size_t capacity);
+    void unmapFile();
+    void loadRecords();
+    bool append(const std::string& key, State state, int64_t timestamp, const std::string& result);
+    bool compact(size_t required);
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_EXECUTION_JOURNAL_H
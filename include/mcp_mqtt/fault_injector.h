@@ -0,0 +1,126 @@
+#ifndef MCP_MQTT_FAULT_INJECTOR_H
+#define MCP_MQTT_FAULT_INJECTOR_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include "mqtt_interface.h"
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Faults injected by FaultInjectingMqttClient
+ *
+ * Rates are probabilities per call, in [0, 1].
+ */
+struct FaultInjectionOptions {
+    // Publish latency: base + uniform jitter, plus a tail delay for a share of
+    // publishes (a broker stalling on disk or GC)
+    std::chrono::microseconds publishLatency{0};
+    std::chrono::microseconds publishJitter{0};
+    double publishTailRate = 0.0;
+    std::chrono::microseconds publishTailLatency{0};
+
+    double publishFailureRate = 0.0;    // publish() returns false, nothing is sent
+    double subscribeFailureRate = 0.0;  // subscribe() returns false
+    double subscriptionDropRate = 0.0;  // subscribe() reports success but is never made
+};
+
+/**
+ * @brief IMqttClient decorator that makes a healthy client slow and lossy.
+ *
+ * Wraps any client to measure how the server behaves when the broker is not
+ * perfect. Publishes are delayed on the calling thread, as with a client
+ * that waits for the broker's acknowledgement, or fail. Subscriptions fail
+ * or are silently lost. injectConnectionLost() makes the client report a
+ * lost connection until restoreConnection(). Faults are drawn from a seeded
+ * generator, and the stats count what was injected. Thread-safe.
+ */
+class FaultInjectingMqttClient : public IMqttClient {
+public:
+    /**
+     * @brief Counts of injected faults
+     */
+    struct Stats {
+        uint64_t publishes = 0;             // Calls to publish()/publishWithProperties()
+        uint64_t failedPublishes = 0;
+        uint64_t delayedPublishes = 0;
+        uint64_t failedSubscribes = 0;
+        uint64_t droppedSubscriptions = 0;
+        uint64_t connectionLosses = 0;
+        std::chrono::microseconds injectedDelay{0};
+    };
+
+    /**
+     * @param client Client to wrap (must outlive the decorator)
+     * @param options Faults to inject
+     * @param seed Seed of the generator behind the faults
+     */
+    FaultInjectingMqttClient(IMqttClient* client, const FaultInjectionOptions& options = {},
+                             uint64_t seed = 1);
+
+    /**
+     * @brief Change the injected faults, e.g. between phases of a benchmark
+     */
+    void setOptions(const FaultInjectionOptions& options);
+
+    /**
+     * @brief Make the connection appear lost
+     *
+     * Runs the connection-lost callback. Until restoreConnection(),
+     * isConnected() is false and every publish and subscribe fails.
+     */
+    void injectConnectionLost(const std::string& reason = "Injected connection loss");
+
+    /**
+     * @brief End a loss started with injectConnectionLost()
+     */
+    void restoreConnection();
+
+    Stats getStats() const;
+
+    // IMqttClient
+    bool isConnected() const override;
+    bool subscribe(const std::string& topic, int qos, bool noLocal) override;
+    bool unsubscribe(const std::string& topic) override;
+    bool publish(const std::string& topic,
+                 const std::string& payload,
+                 int qos,
+                 bool retained,
+                 const std::map<std::string, std::string>& userProps = {}) override;
+    bool publishWithProperties(const std::string& topic,
+                               const std::string& payload,
+                               int qos,
+                               bool retained,
+                               const MqttPublishProperties& properties) override;
+    uint16_t getTopicAliasMaximum() const override;
+    std::string getClientId() const override;
+    void setMessageHandler(MqttMessageHandler handler) override;
+    void setConnectionLostCallback(std::function<void(const std::string& reason)> callback) override;
+    bool setConnectionRestoredCallback(std::function<void()> callback) override;
+    void setConnectProperties(uint32_t sessionExpiryInterval,
+                              const std::map<std::string, std::string>& userProperties) override;
+    void setWill(const std::string& topic, const std::string& payload,
+                 int qos, bool retained) override;
+
+private:
+    IMqttClient* client_;   // Non-owning
+    std::atomic<bool> lost_{false};
+
+    mutable std::mutex mutex_;
+    FaultInjectionOptions options_;
+    std::mt19937_64 random_;
+    Stats stats_;
+    std::function<void(const std::string&)> connectionLostCallback_;
+
+    double chance();
+    bool beforePublish();
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_FAULT_INJECTOR_H
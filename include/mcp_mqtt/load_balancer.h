@@ -0,0 +1,180 @@
+#ifndef MCP_MQTT_LOAD_BALANCER_H
+#define MCP_MQTT_LOAD_BALANCER_H
+
+#include <array>
+#include <string>
+#include <memory>
+#include <vector>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include "mcp_client.h"
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Options of a LoadBalancer
+ */
+struct LoadBalancerOptions {
+    double latencyWeight = 0.2;     // Weight of a new sample in the latency moving average
+    int maxAttempts = 3;            // Instances tried per request when instances go offline
+    bool retryOnServerLoss = true;  // Re-send requests cut off by an instance going offline
+    uint64_t seed = 0;              // Seed of the instance choices
+
+    // Hedged calls (callToolHedged)
+    double hedgePercentile = 95.0;  // Hedge after this percentile of the recent latencies
+    double hedgeBudget = 0.05;      // Hedges per hedged call at most, over time
+    uint64_t hedgeMinSamples = 100; // Latencies observed before hedging starts
+};
+
+/**
+ * @brief Observed state of one server instance
+ */
+struct InstanceStats {
+    std::string serverId;
+    double latencyUs = 0.0;         // Moving average of the answer latency
+    uint64_t samples = 0;           // Answers (and timeouts) observed
+    int64_t outstanding = 0;        // Requests sent or queued, not answered yet
+    bool ready = false;             // Has an initialized session
+};
+
+/**
+ * @brief Counters of callToolHedged()
+ */
+struct HedgeStats {
+    uint64_t requests = 0;          // callToolHedged() calls
+    uint64_t hedges = 0;            // Duplicates sent
+    uint64_t hedgeWins = 0;         // Calls answered first by the duplicate
+    double delayUs = 0.0;           // Current hedge delay; 0 until enough latencies were seen
+};
+
+/**
+ * @brief Spreads requests over the instances of one server name
+ *
+ * Instances are the servers online with the balancer's serverName, read from
+ * the client's ServerDirectory for every request. Each request picks two
+ * instances at random and goes to the cheaper one (power of two choices),
+ * where the cost is the moving average latency times the outstanding
+ * requests plus one. An instance without samples yet is compared by
+ * outstanding requests only, so new instances get traffic at once.
+ *
+ * Sessions are created and initialized lazily, on an instance's first
+ * request; requests that pick it meanwhile wait for the handshake. An
+ * instance whose presence disappears drops out of the choices at once, and
+ * its requests that were cut off are re-sent to another instance (up to
+ * maxAttempts instances per request). A tools/call re-sent this way may run
+ * twice; set retryOnServerLoss to false if that is not acceptable.
+ *
+ * Idempotent tool calls can be hedged against slow instances with
+ * callToolHedged(). If the call is still unanswered after the hedgePercentile
+ * of the recent latencies, a duplicate goes to a different instance. The first
+ * answer wins, and the other request is cancelled with notifications/cancelled.
+ * Hedges are budgeted: each hedged call earns hedgeBudget of a hedge, and a
+ * hedge is only sent when a whole one has been earned. At most hedgeBudget of
+ * the calls are duplicated over time, plus a burst of a few.
+ *
+ * Destroy the balancer only after its requests completed, e.g. after
+ * McpClient::stop().
+ */
+class LoadBalancer {
+public:
+    /**
+     * @param client Started client (must outlive the balancer)
+     * @param serverName Server name whose instances share the load
+     */
+    LoadBalancer(McpClient* client, std::string serverName, LoadBalancerOptions options = {});
+    ~LoadBalancer();
+
+    LoadBalancer(const LoadBalancer&) = delete;
+    LoadBalancer& operator=(const LoadBalancer&) = delete;
+
+    /**
+     * @brief Send a request to one of the instances
+     *
+     * Fails with ERROR if no instance is online.
+     */
+    void request(const std::string& method, const nlohmann::json& params,
+                 ResponseCallback callback, int timeoutMs);
+    std::future<McpResponse> request(const std::string& method, const nlohmann::json& params,
+                                     int timeoutMs);
+
+    void callTool(const std::string& name, const nlohmann::json& arguments,
+                  ResponseCallback callback, int timeoutMs = Timeouts::TOOLS_CALL);
+    std::future<McpResponse> callTool(const std::string& name, const nlohmann::json& arguments,
+                                      int timeoutMs = Timeouts::TOOLS_CALL);
+
+    /**
+     * @brief Call an idempotent tool, hedged against a slow instance
+     *
+     * Only for tools that may safely run twice. Without another instance
+     * online, or without hedge budget, this is a plain callTool().
+     */
+    void callToolHedged(const std::string& name, const nlohmann::json& arguments,
+                        ResponseCallback callback, int timeoutMs = Timeouts::TOOLS_CALL);
+    std::future<McpResponse> callToolHedged(const std::string& name, const nlohmann::json& arguments,
+                                            int timeoutMs = Timeouts::TOOLS_CALL);
+
+    void listTools(ResponseCallback callback, int timeoutMs = Timeouts::TOOLS_LIST);
+    std::future<McpResponse> listTools(int timeoutMs = Timeouts::TOOLS_LIST);
+
+    /**
+     * @brief State of the instances that received requests
+     */
+    std::vector<InstanceStats> getInstances() const;
+
+    /**
+     * @brief Counters of hedged calls
+     */
+    HedgeStats getHedgeStats() const;
+
+    const std::string& getServerName() const { return serverName_; }
+
+private:
+    struct Instance;
+    struct Call;
+    struct Hedge;
+    using SessionCallback = std::function<void(const std::shared_ptr<McpClientSession>& session)>;
+
+    McpClient* client_;     // Non-owning
+    const std::string serverName_;
+    const LoadBalancerOptions options_;
+    std::atomic<uint64_t> random_;
+
+    mutable std::mutex instancesMutex_;
+    std::unordered_map<std::string, std::shared_ptr<Instance>> instances_;     // By server ID
+    uint64_t directoryVersion_ = 0;     // Version instances_ was pruned at
+
+    // Recent latencies of all instances, and the hedge delay derived from them
+    static constexpr size_t LATENCY_WINDOW = 1024;
+    static constexpr uint64_t HEDGE_DELAY_UPDATE_INTERVAL = 128;
+    std::array<std::atomic<float>, LATENCY_WINDOW> latencyWindow_{};
+    std::atomic<uint64_t> latencyCount_{0};
+    std::mutex hedgeDelayMutex_;
+    std::atomic<double> hedgeDelayUs_{0.0};
+
+    // Hedge budget in millionths of a hedge
+    static constexpr int64_t HEDGE_COST = 1000000;
+    static constexpr int64_t MAX_HEDGE_CREDIT = 10 * HEDGE_COST;
+    const int64_t hedgeCreditPerCall_;
+    std::atomic<int64_t> hedgeCredit_{0};
+    std::atomic<uint64_t> hedgeRequests_{0};
+    std::atomic<uint64_t> hedgesSent_{0};
+    std::atomic<uint64_t> hedgeWins_{0};
+
+    void dispatch(const std::shared_ptr<Call>& call);
+    std::shared_ptr<Instance> pick(const std::vector<std::string>& excluded);
+    std::shared_ptr<Instance> instanceFor(const std::string& serverId, uint64_t directoryVersion);
+    void sendHedge(const std::shared_ptr<Hedge>& hedge);
+    void finishHedge(const std::shared_ptr<Hedge>& hedge, bool fromSecondary, McpResponse response);
+    static bool isAbandoned(Call& call);
+    static void abandon(Call& call);
+    void withSession(const std::shared_ptr<Instance>& instance, SessionCallback callback);
+    void record(Instance& instance, double latencyUs);
+    uint64_t nextRandom();
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_LOAD_BALANCER_H
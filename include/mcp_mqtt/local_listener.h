@@ -0,0 +1,88 @@
+#ifndef MCP_MQTT_LOCAL_LISTENER_H
+#define MCP_MQTT_LOCAL_LISTENER_H
+
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include "mcp_server.h"
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Serves an McpServer to local clients without a broker.
+ *
+ * Clients connect to a Unix domain socket, or talk over stdin/stdout, and
+ * exchange newline-delimited JSON-RPC messages (the framing of MCP's stdio
+ * transport). Each connection is one client session, opened by an initialize
+ * request and ended when the connection closes; the listener assigns its MCP
+ * client ID. Messages go into the same dispatch core as MQTT RPC messages
+ * (see McpServer::handleLocalMessage()), which makes the listener both a
+ * low-latency local path and a broker-free way to drive tool handlers under
+ * load. The server may be started without an MQTT client for that.
+ *
+ * Every connection has its own reader thread, so tool calls of different
+ * connections run concurrently. POSIX only.
+ */
+class LocalListener {
+public:
+    /**
+     * @param server Server to serve (must outlive the listener)
+     */
+    explicit LocalListener(McpServer* server);
+    ~LocalListener();
+
+    LocalListener(const LocalListener&) = delete;
+    LocalListener& operator=(const LocalListener&) = delete;
+
+    /**
+     * @brief Listen on a Unix domain socket and serve connections in the background
+     * @param unixSocketPath Socket path; an existing file at the path is replaced
+     * @return true if listening
+     */
+    bool listen(const std::string& unixSocketPath);
+
+    /**
+     * @brief Serve one session over stdin/stdout on the calling thread until EOF
+     */
+    void serveStdio();
+
+    /**
+     * @brief Close the socket and all connections and wait for their threads
+     */
+    void stop();
+
+    /**
+     * @brief Number of open connections
+     */
+    size_t getConnectionCount() const;
+
+private:
+    class LineTransport;
+
+    struct Connection {
+        std::shared_ptr<LineTransport> transport;
+        std::thread reader;
+        std::atomic<bool> done{false};
+    };
+
+    McpServer* server_;     // Non-owning
+    std::string socketPath_;
+    int listenFd_ = -1;
+    std::thread acceptThread_;
+    std::atomic<bool> stopping_{false};
+
+    mutable std::mutex connectionsMutex_;
+    std::list<Connection> connections_;
+
+    void acceptLoop();
+    void serve(const std::string& mcpClientId, int inFd, const std::shared_ptr<LineTransport>& transport);
+    void reapConnections();
+    static std::string nextClientId();
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_LOCAL_LISTENER_H
@@ -0,0 +1,150 @@
+#ifndef MCP_MQTT_LOOPBACK_BROKER_H
+#define MCP_MQTT_LOOPBACK_BROKER_H
+
+#include <string>
+#include <map>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <unordered_map>
+#include "mqtt_interface.h"
+#include "clock.h"
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Simulated network between the clients of a LoopbackBroker
+ *
+ * Applied to every delivery independently. Deliveries of one publisher can
+ * overtake each other through jitter or a reorder hold-back.
+ */
+struct LoopbackLinkOptions {
+    std::chrono::microseconds latency{0};       // Base one-way delay
+    std::chrono::microseconds jitter{0};        // Extra delay, uniform in [0, jitter]
+    double reorderRate = 0.0;                   // Share of deliveries held back by reorderDelay
+    std::chrono::microseconds reorderDelay{1000};
+    double dropRate = 0.0;                      // Share of deliveries lost
+};
+
+/**
+ * @brief Synchronous in-process message router for tests, benchmarks and tools.
+ *
+ * Clients from createClient() implement IMqttClient. A publish is matched
+ * against all subscriptions ('+' and '#' wildcards, No Local) and handed to
+ * the message handlers of the subscribers before publish() returns, on the
+ * publishing thread. There is no socket, queue or I/O thread, so a request
+ * published to an McpServer has been dispatched, and its response delivered,
+ * when the publish returns. Handlers of one client may run concurrently when
+ * several threads publish.
+ *
+ * Retained messages and Will messages are supported; a Will is published by
+ * disconnectClient(). Unlike EmbeddedBroker this builds on every platform and
+ * adds no latency of its own.
+ *
+ * For simulations, setLink() puts a lossy, jittery network between the
+ * clients: each delivery is then scheduled on a clock (normally a
+ * VirtualClock) after a sampled delay, or dropped. The samples come from a
+ * seeded generator, so a single-threaded scenario reproduces exactly.
+ */
+class LoopbackBroker {
+public:
+    LoopbackBroker();
+    ~LoopbackBroker();
+
+    LoopbackBroker(const LoopbackBroker&) = delete;
+    LoopbackBroker& operator=(const LoopbackBroker&) = delete;
+
+    /**
+     * @brief Create a connected client
+     *
+     * The broker must outlive the client. Destroying the client removes its
+     * subscriptions without publishing its Will.
+     *
+     * @param clientId Client ID, unique among the broker's clients
+     * @return The client, or nullptr if the ID is in use
+     */
+    std::unique_ptr<IMqttClient> createClient(const std::string& clientId);
+
+    /**
+     * @brief Drop a client as if its connection had failed
+     *
+     * Removes its subscriptions, publishes its Will and runs its
+     * connection-lost callback. The client reports disconnected afterwards.
+     *
+     * @return false if no connected client has this ID
+     */
+    bool disconnectClient(const std::string& clientId, const std::string& reason = "Connection lost");
+
+    /**
+     * @brief Simulate a network between the clients
+     *
+     * Call before the clients publish. Handlers then run from the clock's
+     * timers instead of inside publish().
+     *
+     * @param clock Clock the deliveries are scheduled on (must outlive the broker)
+     * @param options Delay, reordering and loss of each delivery
+     * @param seed Seed of the generator behind delays and drops
+     */
+    void setLink(IClock* clock, const LoopbackLinkOptions& options, uint64_t seed = 1);
+
+    /**
+     * @brief Deliveries lost on the simulated link so far
+     */
+    uint64_t getDroppedCount() const;
+
+    /**
+     * @brief Number of connected clients
+     */
+    size_t getClientCount() const;
+
+    /**
+     * @brief Number of retained messages held
+     */
+    size_t getRetainedCount() const;
+
+    /**
+     * @brief Messages handed to subscribers so far
+     */
+    uint64_t getDeliveredCount() const;
+
+private:
+    struct Message;
+    struct ClientState;
+    class Client;
+
+    struct Subscriber {
+        std::shared_ptr<ClientState> client;
+        int qos = 0;
+        bool noLocal = false;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<ClientState>> clients_;
+    std::unordered_map<std::string, std::vector<Subscriber>> exactSubscriptions_;
+    std::vector<std::pair<std::string, Subscriber>> wildcardSubscriptions_;
+    std::map<std::string, std::shared_ptr<const Message>> retained_;
+    std::atomic<uint64_t> delivered_{0};
+
+    // Simulated link, set up before use
+    IClock* clock_ = nullptr;   // Non-owning; null = synchronous delivery
+    LoopbackLinkOptions link_;
+    std::mutex linkMutex_;
+    std::mt19937_64 random_;
+    std::atomic<uint64_t> dropped_{0};
+
+    void subscribe(const std::shared_ptr<ClientState>& client, const std::string& filter, int qos, bool noLocal);
+    bool unsubscribe(const std::shared_ptr<ClientState>& client, const std::string& filter);
+    void removeSubscriptions(ClientState& client);
+    void removeClient(const std::shared_ptr<ClientState>& client);
+    void route(const ClientState* from, const std::shared_ptr<const Message>& message);
+    void transmit(const std::shared_ptr<ClientState>& client, const std::shared_ptr<const Message>& message,
+                  int qos, bool retained);
+    void deliver(ClientState& client, const Message& message, int qos, bool retained);
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_LOOPBACK_BROKER_H
@@ -0,0 +1,474 @@
+#ifndef MCP_MQTT_CLIENT_H
+#define MCP_MQTT_CLIENT_H
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <shared_mutex>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <unordered_map>
+#include "types.h"
+#include "json_rpc.h"
+#include "mqtt_interface.h"
+#include "clock.h"
+#include "server_directory.h"
+
+namespace mcp_mqtt {
+
+class McpClient;
+
+/**
+ * @brief How a client request ended
+ */
+enum class RequestStatus {
+    OK,             // The server answered with a result
+    ERROR,          // The server answered with an error, or the request could not be sent
+    TIMEOUT,        // No answer within the timeout
+    CANCELLED       // The session closed before the answer arrived
+};
+
+/**
+ * @brief Outcome of a client request
+ */
+struct McpResponse {
+    RequestStatus status = RequestStatus::OK;
+    nlohmann::json result;          // Result when status is OK
+    int errorCode = 0;              // JSON-RPC error code when the server answered with an error
+    std::string errorMessage;       // Error message, or a description of the status
+
+    bool ok() const { return status == RequestStatus::OK; }
+};
+
+/**
+ * @brief Callback receiving the outcome of a client request
+ *
+ * Runs on the MQTT client's message thread for answers and on the clock's
+ * timer thread for timeouts. It must not block waiting for another answer.
+ */
+using ResponseCallback = std::function<void(McpResponse response)>;
+
+/**
+ * @brief A server's tool catalog from tools/list, parsed once and indexed by name
+ *
+ * Immutable once built, so it can be shared between threads and kept by the
+ * caller for as long as needed.
+ */
+class ToolCatalog {
+public:
+    /**
+     * @brief Build a catalog from a tools/list result
+     * @return The catalog, or null if the result has no tools array
+     */
+    static std::shared_ptr<const ToolCatalog> fromResult(const nlohmann::json& result);
+
+    /**
+     * @brief Tools in the server's order
+     */
+    const std::vector<Tool>& getTools() const { return tools_; }
+
+    /**
+     * @brief The tools array as received, e.g. to forward to a model
+     */
+    const nlohmann::json& getToolsJson() const { return toolsJson_; }
+
+    /**
+     * @brief A tool by name, or null if the server has none by that name
+     */
+    const Tool* find(const std::string& name) const;
+
+    size_t size() const { return tools_.size(); }
+
+private:
+    std::vector<Tool> tools_;
+    nlohmann::json toolsJson_;
+    std::unordered_map<std::string, size_t> byName_;    // Index into tools_
+};
+
+using ToolCatalogPtr = std::shared_ptr<const ToolCatalog>;
+
+/**
+ * @brief Callback receiving a tool catalog
+ * @param response How listing ended; its result is left empty, the catalog holds it
+ * @param catalog The catalog, or null if it could not be listed
+ */
+using ToolCatalogCallback = std::function<void(const McpResponse& response, ToolCatalogPtr catalog)>;
+
+/**
+ * @brief Configuration for MCP client that uses external MQTT client
+ */
+struct McpClientConfig {
+    std::string clientId;           // MCP client ID (used in topics); empty = the MQTT client ID
+    ClientInfo clientInfo;
+    nlohmann::json capabilities = nlohmann::json::object();
+    int qos = 1;                    // QoS of requests, notifications and subscriptions
+    size_t maxInFlight = 1024;      // Requests in flight per session, rounded up to a power of two
+    std::chrono::milliseconds timeoutCheckInterval{50};    // Resolution of request timeouts
+    bool setWill = true;            // Set a Will that announces notifications/disconnected
+};
+
+/**
+ * @brief One initialized connection between an McpClient and an MCP server
+ *
+ * Created by McpClient::createSession(). Requests are pipelined: any number
+ * up to McpClientConfig::maxInFlight can be in flight at once, and answers
+ * are matched to them by request ID through a fixed table of completion
+ * slots. Slot i holds the request whose ID is i modulo the table size; it is
+ * claimed, completed and released with compare-and-swap only, so sending a
+ * request, matching its answer and expiring it never take a lock, and
+ * exactly one of answer, timeout and cancellation completes each request.
+ *
+ * Every request method has a callback form and a std::future form. Do not
+ * wait on a future on the MQTT client's message thread: the answer is
+ * delivered on that thread.
+ */
+class McpClientSession : public std::enable_shared_from_this<McpClientSession> {
+public:
+    /**
+     * @brief Lifecycle of a session
+     */
+    enum class State {
+        CREATED,        // initialize() not called yet
+        INITIALIZING,   // Waiting for the initialize response
+        READY,          // Initialized, requests may be sent
+        CLOSED          // Closed by either side, or the server went offline
+    };
+
+    /**
+     * @brief Callback for notifications the server sends on this session
+     */
+    using NotificationCallback = std::function<void(const std::string& method,
+                                                    const nlohmann::json& params)>;
+
+    /**
+     * @brief Callback for the end of the session
+     * @param reason Why the session closed
+     */
+    using ClosedCallback = std::function<void(const std::string& reason)>;
+
+    /**
+     * @param client Owning client (must outlive every use of the session but reading its state)
+     * @param capacity Size of the completion table, rounded up to a power of two
+     */
+    McpClientSession(McpClient* client, std::string serverId, std::string serverName, size_t capacity);
+    ~McpClientSession();
+
+    McpClientSession(const McpClientSession&) = delete;
+    McpClientSession& operator=(const McpClientSession&) = delete;
+
+    /**
+     * @brief Run the initialize handshake
+     *
+     * Sends initialize on the server's control topic. On success the session
+     * stores the server's info and capabilities, sends notifications/initialized
+     * and becomes READY before the callback runs.
+     */
+    void initialize(ResponseCallback callback, int timeoutMs = Timeouts::INITIALIZE);
+    std::future<McpResponse> initialize(int timeoutMs = Timeouts::INITIALIZE);
+
+    /**
+     * @brief Send a request on a READY session
+     * @param method JSON-RPC method
+     * @param params Parameters, or null to send none
+     * @param timeoutMs Time to wait for the answer; 0 or less waits forever
+     * @return ID of the request for cancel(); 0 if it was not sent (the
+     *         callback has then run already)
+     */
+    uint64_t request(const std::string& method, const nlohmann::json& params,
+                     ResponseCallback callback, int timeoutMs);
+    std::future<McpResponse> request(const std::string& method, const nlohmann::json& params,
+                                     int timeoutMs);
+
+    uint64_t ping(ResponseCallback callback, int timeoutMs = Timeouts::PING);
+    std::future<McpResponse> ping(int timeoutMs = Timeouts::PING);
+
+    uint64_t listTools(ResponseCallback callback, int timeoutMs = Timeouts::TOOLS_LIST);
+    std::future<McpResponse> listTools(int timeoutMs = Timeouts::TOOLS_LIST);
+
+    uint64_t callTool(const std::string& name, const nlohmann::json& arguments,
+                      ResponseCallback callback, int timeoutMs = Timeouts::TOOLS_CALL);
+    std::future<McpResponse> callTool(const std::string& name, const nlohmann::json& arguments,
+                                      int timeoutMs = Timeouts::TOOLS_CALL);
+
+    /**
+     * @brief Get the server's tool catalog, from the cache when it is current
+     *
+     * The catalog is cached if the server advertises tools.listChanged, and
+     * then only listed again after notifications/tools/list_changed. Servers
+     * without it are listed on every call. Concurrent calls share one
+     * tools/list request. The callback runs at once on a cache hit.
+     */
+    void getTools(ToolCatalogCallback callback, int timeoutMs = Timeouts::TOOLS_LIST);
+    std::future<ToolCatalogPtr> getTools(int timeoutMs = Timeouts::TOOLS_LIST);
+
+    /**
+     * @brief The cached tool catalog, or null if there is no current one
+     */
+    ToolCatalogPtr getCachedTools() const;
+
+    /**
+     * @brief Drop the cached tool catalog
+     */
+    void invalidateTools();
+
+    /**
+     * @brief Give up on a request and tell the server with notifications/cancelled
+     *
+     * The request completes as CANCELLED at once; an answer arriving later is
+     * dropped.
+     *
+     * @param requestId ID returned when the request was sent
+     * @param reason Optional reason sent to the server
+     * @return false if the request had already completed
+     */
+    bool cancel(uint64_t requestId, const std::string& reason = "");
+
+    /**
+     * @brief Send a notification to the server
+     * @return true if published
+     */
+    bool notify(const std::string& method, const std::optional<nlohmann::json>& params = std::nullopt);
+
+    /**
+     * @brief Close the session
+     *
+     * Sends notifications/disconnected, unsubscribes from the RPC topic and
+     * completes the requests still in flight as CANCELLED.
+     */
+    void close();
+
+    /**
+     * @brief Set callback for server notifications (e.g. notifications/tools/list_changed)
+     */
+    void setNotificationCallback(NotificationCallback callback);
+
+    /**
+     * @brief Set callback for the end of the session
+     */
+    void setClosedCallback(ClosedCallback callback);
+
+    State getState() const { return state_.load(std::memory_order_acquire); }
+    bool isReady() const { return getState() == State::READY; }
+    const std::string& getServerId() const { return serverId_; }
+    const std::string& getServerName() const { return serverName_; }
+    const std::string& getRpcTopic() const { return rpcTopic_; }
+
+    /**
+     * @brief Server info and capabilities from the initialize response
+     *
+     * Only valid once the session is READY.
+     */
+    const ServerInfo& getServerInfo() const { return serverInfo_; }
+    const nlohmann::json& getServerCapabilities() const { return serverCapabilities_; }
+
+    /**
+     * @brief Number of requests waiting for an answer
+     */
+    size_t getInFlight() const { return inFlight_.load(std::memory_order_relaxed); }
+
+private:
+    friend class McpClient;
+
+    // Slot states besides the ID of the request it holds
+    static constexpr uint64_t SLOT_FREE = 0;
+    static constexpr uint64_t SLOT_BUSY = ~uint64_t(0);     // Being filled or being completed
+
+    struct Slot {
+        std::atomic<uint64_t> state{SLOT_FREE};
+        std::atomic<int64_t> deadline{0};       // Steady clock ticks
+        ResponseCallback callback;              // Owned by whoever moved state to SLOT_BUSY
+    };
+
+    McpClient* client_;     // Non-owning, outlives the session's use of it
+    const std::string serverId_;
+    const std::string serverName_;
+    const std::string rpcTopic_;
+    std::atomic<State> state_{State::CREATED};
+
+    std::unique_ptr<Slot[]> slots_;
+    const uint64_t slotMask_;
+    std::atomic<uint64_t> nextRequestId_{1};
+    std::atomic<size_t> inFlight_{0};
+
+    ServerInfo serverInfo_;
+    nlohmann::json serverCapabilities_;
+
+    std::mutex callbackMutex_;
+    NotificationCallback notificationCallback_;
+    ClosedCallback closedCallback_;
+
+    // Tool catalog cache
+    mutable std::mutex toolsMutex_;
+    ToolCatalogPtr tools_;                          // Null when stale
+    uint64_t toolsGeneration_ = 0;                  // Bumped by every invalidation
+    std::vector<ToolCatalogCallback> toolsWaiting_; // Callers of the tools/list in flight
+
+    // Claim a slot and fill it; returns the request ID, 0 if the table is full
+    uint64_t reserve(ResponseCallback&& callback, int timeoutMs);
+    // Complete a request if it is still pending; false if someone else did
+    bool complete(uint64_t id, McpResponse&& response);
+    uint64_t send(const std::string& method, const nlohmann::json& params, ResponseCallback callback,
+                  int timeoutMs, bool control);
+
+    // Called by McpClient
+    void handleMessage(const std::string& payload);
+    void expire(IClock::TimePoint now);
+    void finishListTools(uint64_t generation, const McpResponse& response);
+    void shutDown(const std::string& reason, bool notifyServer);
+};
+
+/**
+ * @brief MCP over MQTT Client SDK main class.
+ *
+ * The client side of the protocol, on the same IMqttClient abstraction as
+ * McpServer:
+ * - Service discovery: follows the retained presence of all servers in a
+ *   ServerDirectory
+ * - Sessions: initialize handshake, pipelined requests, notifications
+ * - Timeouts: each request carries its own, defaulting to Timeouts
+ *
+ * Like McpServer it does not manage the MQTT connection and only handles
+ * $mcp-* topics. It takes over the MQTT client's message handler, so one
+ * MQTT client cannot be shared between an McpClient and an McpServer.
+ */
+class McpClient {
+public:
+    /**
+     * @brief Callback for a server coming online or updating its presence
+     */
+    using ServerOnlineCallback = std::function<void(const DiscoveredServer& server)>;
+
+    /**
+     * @brief Callback for a server whose presence was cleared
+     */
+    using ServerOfflineCallback = std::function<void(const std::string& serverId,
+                                                      const std::string& serverName)>;
+
+    McpClient();
+    ~McpClient();
+
+    McpClient(const McpClient&) = delete;
+    McpClient& operator=(const McpClient&) = delete;
+
+    /**
+     * @brief Start the MCP client with an external MQTT client
+     *
+     * The MQTT client must already be connected to the broker. The SDK will:
+     * - Set a Will announcing notifications/disconnected on the client presence
+     *   topic (unless config.setWill is false)
+     * - Register a message handler to process MCP messages
+     * - Subscribe to the presence topics of all servers
+     *
+     * @param mqttClient Pointer to user's MQTT client implementation (must outlive McpClient)
+     * @param config MCP client configuration
+     * @return true if client started successfully
+     */
+    bool start(IMqttClient* mqttClient, const McpClientConfig& config);
+
+    /**
+     * @brief Stop the MCP client
+     *
+     * Closes all sessions and unsubscribes from the presence topics. Does NOT
+     * disconnect the MQTT client.
+     */
+    void stop();
+
+    bool isRunning() const;
+
+    /**
+     * @brief Set the clock used for request timeouts
+     *
+     * @param clock Clock (must outlive the client), or null for the system clock
+     */
+    void setClock(IClock* clock);
+
+    /**
+     * @brief Servers currently online, in (serverName, serverId) order
+     */
+    std::vector<DiscoveredServer> getServers() const;
+
+    /**
+     * @brief Index of the servers currently online, for lock-free lookups
+     *        by server name or name prefix
+     */
+    const ServerDirectory& getDirectory() const;
+
+    /**
+     * @brief Set callback for servers coming online
+     */
+    void setServerOnlineCallback(ServerOnlineCallback callback);
+
+    /**
+     * @brief Set callback for servers going offline
+     */
+    void setServerOfflineCallback(ServerOfflineCallback callback);
+
+    /**
+     * @brief Create a session to a server
+     *
+     * Subscribes to the session's RPC topic. The session is not initialized
+     * yet; call initialize() on it. There is at most one open session per
+     * server instance and the existing one is returned if there is.
+     *
+     * @return The session, or null if the client is not running
+     */
+    std::shared_ptr<McpClientSession> createSession(const std::string& serverId,
+                                                    const std::string& serverName);
+
+    /**
+     * @brief Open sessions
+     */
+    std::vector<std::shared_ptr<McpClientSession>> getSessions() const;
+
+    const std::string& getClientId() const;
+
+    /**
+     * @brief Clock used for request timeouts
+     */
+    IClock* getClock() const;
+
+private:
+    friend class McpClientSession;
+
+    IMqttClient* mqttClient_ = nullptr;  // Non-owning pointer to user's MQTT client
+    McpClientConfig config_;
+    std::string clientId_;
+    std::atomic<bool> running_{false};
+
+    IClock* clock_;     // Non-owning
+
+    // Sessions by RPC topic; looked up for every incoming answer
+    mutable std::shared_mutex sessionsMutex_;
+    std::unordered_map<std::string, std::shared_ptr<McpClientSession>> sessions_;
+
+    ServerDirectory directory_;
+    mutable std::mutex serversMutex_;   // Guards the server callbacks
+    ServerOnlineCallback serverOnlineCallback_;
+    ServerOfflineCallback serverOfflineCallback_;
+
+    // Periodic timeout check, while running. The timer callback captures
+    // this; cancelTimeoutCheck() waits until none is pending or running.
+    std::mutex timerMutex_;
+    std::condition_variable timerDone_;
+    IClock::TimerId timeoutTimer_ = 0;
+    size_t timersInFlight_ = 0;     // Checks scheduled and neither cancelled nor finished
+
+    void handleIncomingMessage(const MqttIncomingMessage& message);
+    void handlePresence(const MqttIncomingMessage& message);
+    void scheduleTimeoutCheck();
+    void cancelTimeoutCheck();
+    void checkTimeouts();
+    bool removeSession(const McpClientSession* session);
+
+    std::string getRpcTopic(const std::string& serverId, const std::string& serverName) const;
+    std::string getClientPresenceTopic() const;
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_CLIENT_H
@@ -4,13 +4,18 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <set>
 #include <functional>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include "types.h"
 #include "json_rpc.h"
 #include "mqtt_interface.h"
 #include "tool_manager.h"
+#include "session_transport.h"
+#include "execution_journal.h"
+#include "clock.h"
 
 namespace mcp_mqtt {
 
@@ -76,8 +81,17 @@ public:
      * - Publish the presence (server online) notification
      * - Register a message handler to process MCP messages
      *
-     * @param mqttClient Pointer to user's MQTT client implementation (must outlive McpServer)
-     * @param config MCP server configuration (serverId, serverName)
+     * If config.role is ReplicaRole::STANDBY, the server instead starts in
+     * standby mode: it subscribes to the primary's presence and session mirror
+     * topics, does not serve traffic, and takes over when the primary's
+     * presence is cleared. A primary that reconnects after its Will fired
+     * demotes itself to standby if the other replica took over meanwhile.
+     *
+     * Without an MQTT client (null), the server serves local transports only
+     * (see handleLocalMessage()); it publishes no presence and cannot be a standby.
+     *
+     * @param mqttClient Pointer to user's MQTT client implementation (must outlive McpServer), or null
+     * @param config MCP server configuration (serverId, serverName, role)
      * @return true if server started successfully
      */
     bool start(IMqttClient* mqttClient, const McpServerConfig& config);
@@ -100,10 +114,105 @@ public:
      */
     bool isRunning() const;
 
+    /**
+     * @brief Check if the server is a standby replica that has not taken over yet
+     */
+    bool isStandby() const;
+
+    /**
+     * @brief Offer a shared-memory fast path to co-located clients
+     *
+     * When enabled, a client that advertises capabilities.experimental["mqtt/shm"]
+     * with a hostId equal to this host's ID (see ShmChannel::localHostId()) gets
+     * a shared-memory ring buffer pair announced in the initialize response.
+     * The session's further requests, responses and notifications then bypass
+     * the broker. Linux only.
+     *
+     * @param enabled Whether to offer the fast path to new sessions
+     * @param ringCapacity Size in bytes of each direction's ring buffer
+     */
+    void setSharedMemoryTransport(bool enabled, size_t ringCapacity = 1 << 20);
+
+    /**
+     * @brief Set the MQTT 5.0 Message Expiry Interval of responses and notifications
+     *
+     * The broker discards them instead of queueing them for a client that
+     * stays away longer than this. Requests that clients send with an expiry
+     * are dropped the same way by the broker, in its own clock, and never
+     * reach the server once expired.
+     *
+     * @param seconds Expiry interval in seconds (0 = never expire, the default)
+     */
+    void setMessageExpiryInterval(uint32_t seconds);
+
+    /**
+     * @brief Set the journal used by exactly-once tools
+     *
+     * @param journal Open journal (must outlive the server), or null to disable
+     */
+    void setExecutionJournal(ExecutionJournal* journal);
+
+    /**
+     * @brief Run a tool in exactly-once mode
+     *
+     * Each call of the tool is recorded in the execution journal, keyed by
+     * client ID, tool name, request ID and a hash of the arguments, before the
+     * tool runs; its result is recorded afterwards. Clients number requests
+     * per session, so only a call with the same arguments is a duplicate. A
+     * duplicate call gets the recorded result and does not run the tool again;
+     * a duplicate arriving while the call still runs gets the call's result
+     * when it finishes. If the server died while the tool ran, the outcome is
+     * unknown and duplicates get an error instead of a second execution.
+     * Requires a journal (see setExecutionJournal()); without one the tool is
+     * refused.
+     *
+     * @param toolName Tool name
+     * @param enabled Whether the tool runs in exactly-once mode
+     */
+    void setToolExactlyOnce(const std::string& toolName, bool enabled = true);
+
+    /**
+     * @brief Set the clock used for message expiry and timers
+     *
+     * Defaults to SystemClock::instance(). A VirtualClock makes the server's
+     * time-dependent behaviour deterministic in simulations. Set it before
+     * start().
+     *
+     * @param clock Clock (must outlive the server), or null for the system clock
+     */
+    void setClock(IClock* clock);
+
+    /**
+     * @brief Handle one JSON-RPC message from a client on a local transport
+     *
+     * Entry point for transports that bypass MQTT entirely (see LocalListener).
+     * An initialize request opens a session served only over the transport:
+     * its responses and notifications go to transport->send() and no MQTT
+     * topics are subscribed for it. All other messages go through the same
+     * dispatch core as MQTT RPC messages.
+     *
+     * @param mcpClientId Client ID of the transport's session
+     * @param payload Serialized JSON-RPC message
+     * @param transport Transport the message arrived on
+     */
+    void handleLocalMessage(const std::string& mcpClientId, const std::string& payload,
+                            const std::shared_ptr<ISessionTransport>& transport);
+
+    /**
+     * @brief End the session of a local transport that went away
+     */
+    void closeLocalSession(const std::string& mcpClientId);
+
     // Tool management
 
     /**
      * @brief Register a tool
+     *
+     * If the server advertises tools.listChanged, initialized sessions are
+     * sent notifications/tools/list_changed once the registry has been quiet
+     * for McpServerConfig::toolsListChangedDebounce; the same goes for
+     * unregisterTool().
+     *
      * @param tool Tool definition
      * @param handler Handler function
      * @return true if registered successfully
@@ -151,20 +260,61 @@ public:
     std::vector<std::string> getConnectedClients() const;
 
 private:
-    IMqttClient* mqttClient_ = nullptr;  // Non-owning pointer to user's MQTT client
+    std::atomic<IMqttClient*> mqttClient_{nullptr};  // Non-owning pointer to user's MQTT client
     ServerInfo serverInfo_;
     ServerCapabilities capabilities_;
     ServerOnlineParams onlineParams_;
 
     std::atomic<bool> running_{false};
+    std::atomic<bool> standby_{false};
     std::string serverId_;
     std::string serverName_;
+    std::atomic<ReplicaRole> role_{ReplicaRole::STANDALONE};
+    std::atomic<bool> reconnectReported_{false};    // Client calls us back after reconnecting
+    std::atomic<bool> announcePending_{false};      // Took over; announce once the Will is applied
+    std::atomic<bool> fenced_{false};               // Reconnected primary, awaiting the leader record
+    QosPolicy qosPolicy_;
 
     ToolManager toolManager_;
 
     mutable std::mutex sessionsMutex_;
     std::map<std::string, ClientSession> clientSessions_;
 
+    bool shmEnabled_ = false;
+    size_t shmRingCapacity_ = 1 << 20;
+
+    // Non-MQTT transports attached to sessions (e.g. shared memory)
+    mutable std::mutex transportsMutex_;
+    std::map<std::string, std::shared_ptr<ISessionTransport>> sessionTransports_;
+    std::set<std::string> localSessions_;   // Served only over their transport, no MQTT topics
+
+    // Topic aliases for per-session RPC topics, within the broker's maximum
+    std::mutex topicAliasMutex_;
+    uint16_t topicAliasMaximum_ = 0;
+    uint16_t nextTopicAlias_ = 1;
+    std::vector<uint16_t> freeTopicAliases_;
+    std::map<std::string, uint16_t> sessionTopicAliases_;
+
+    std::atomic<uint32_t> messageExpiryInterval_{0};
+
+    // Exactly-once tool execution
+    ExecutionJournal* executionJournal_ = nullptr;  // Non-owning
+    std::mutex exactlyOnceMutex_;
+    std::set<std::string> exactlyOnceTools_;
+    std::map<std::string, size_t> runningExecutions_;   // Keys executing in this process, and their duplicates
+
+    IClock* clock_;     // Non-owning
+
+    // Debounced notifications/tools/list_changed. The timer callback captures
+    // this; cancelToolsListChanged() waits until none is pending or running.
+    std::mutex listChangedMutex_;
+    std::condition_variable listChangedDone_;
+    std::chrono::milliseconds listChangedDebounce_{100};
+    IClock::TimerId listChangedTimer_ = 0;
+    uint64_t listChangedSchedules_ = 0;     // Tells a stale or cancelled timer from the current one
+    size_t listChangedInFlight_ = 0;        // Timers scheduled and neither cancelled nor finished
+    IClock::TimePoint firstListChange_;     // First change not announced yet
+
     ClientConnectedCallback clientConnectedCallback_;
     ClientDisconnectedCallback clientDisconnectedCallback_;
 
@@ -181,8 +331,25 @@ private:
     void handleControlMessage(const std::string& topic, const std::string& payload,
                                const std::map<std::string, std::string>& userProps);
     void handleRpcMessage(const std::string& topic, const std::string& payload);
+
+    // Dispatch core shared by all transports
+    void dispatchControl(const std::string& mcpClientId, const JsonRpcRequest& request);
+    void dispatchRpc(const std::string& mcpClientId, const std::string& payload);
     void handleClientPresence(const std::string& topic, const std::string& payload);
 
+    // Hot-standby replication
+    void handlePrimaryPresence(const std::string& payload);
+    void handlePrimaryHostPresence(const std::string& payload);
+    void handleMirrorMessage(const std::string& topic, const std::string& payload);
+    void takeOver();
+    void announceAsPrimary();
+    void claimLeadership();
+    void handleLeaderRecord(const std::string& payload);
+    void demoteToStandby();
+    void handleConnectionRestored();
+    void mirrorSession(const ClientSession& session);
+    void unmirrorSession(const std::string& mcpClientId);
+
     // Request handlers
     void handleInitialize(const std::string& mcpClientId, const JsonRpcRequest& request);
     void handleInitializedNotification(const std::string& mcpClientId);
@@ -191,11 +358,23 @@ private:
     void handleToolsCall(const std::string& mcpClientId, const JsonRpcRequest& request);
     void handleDisconnectedNotification(const std::string& mcpClientId);
 
+    // Session transports
+    std::optional<nlohmann::json> negotiateSharedMemory(const std::string& mcpClientId,
+                                                        const nlohmann::json& clientCapabilities,
+                                                        std::shared_ptr<ISessionTransport>& transport);
+    void attachTransport(const std::string& mcpClientId, std::shared_ptr<ISessionTransport> transport);
+    void detachTransport(const std::string& mcpClientId);
+    bool sendViaTransport(const std::string& mcpClientId, const std::string& payload);
+    bool isLocalSession(const std::string& mcpClientId) const;
+
     // Topic helpers
     std::string getControlTopic() const;
     std::string getPresenceTopic() const;
     std::string getRpcTopic(const std::string& mcpClientId) const;
     std::string getClientPresenceTopic(const std::string& mcpClientId) const;
+    std::string getHostPresenceTopic() const;
+    std::string getMirrorTopicPrefix() const;
+    std::string getLeaderTopic() const;
 
     // Parse client ID from topic
     std::optional<std::string> parseClientIdFromRpcTopic(const std::string& topic) const;
@@ -205,8 +384,18 @@ private:
     bool isMcpTopic(const std::string& topic) const;
 
     // Send response
-    void sendResponse(const std::string& mcpClientId, const JsonRpcResponse& response);
+    void sendResponse(const std::string& mcpClientId, const JsonRpcResponse& response, int qos);
     void sendNotification(const std::string& mcpClientId, const JsonRpcNotification& notification);
+    void scheduleToolsListChanged();
+    void cancelToolsListChanged();
+    void broadcastToolsListChanged(uint64_t schedule);
+    void sendToolsListChanged();
+    void publishRpc(const std::string& mcpClientId, const std::string& topic, const std::string& payload,
+                    int qos, bool isResponse);
+
+    // Topic alias assignment for per-session RPC topics
+    uint16_t topicAliasFor(const std::string& mcpClientId);
+    void releaseTopicAlias(const std::string& mcpClientId);
 
     // Cleanup client session
     void cleanupClientSession(const std::string& mcpClientId);
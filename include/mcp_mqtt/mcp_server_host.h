@@ -0,0 +1,120 @@
+#ifndef MCP_MQTT_SERVER_HOST_H
+#define MCP_MQTT_SERVER_HOST_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "mqtt_interface.h"
+#include "mcp_server.h"
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Hosts many MCP servers on one MQTT connection.
+ *
+ * IMqttClient accepts a single message handler, so normally every McpServer
+ * needs its own connection. McpServerHost takes over that handler and gives
+ * each hosted McpServer a lightweight IMqttClient view of the shared client.
+ * Incoming messages are dispatched by a single topic router; subscriptions
+ * are reference counted, so topics shared by several servers (such as client
+ * presence) are subscribed once and delivered to each of them.
+ *
+ * Each hosted server keeps its own tool registry and sessions. Message
+ * handling runs inline on the MQTT client's callback thread, so hosting adds
+ * no threads per server.
+ *
+ * All hosted servers share the serverId given to start(). MQTT allows one Will
+ * per connection, so the host owns it instead of the hosted servers: while
+ * running it keeps notifications/server/online retained on the host presence
+ * topic $mcp-server/presence/{server-id}, and its Will replaces that with
+ * notifications/server/offline. Clients (see ServerDirectory) then take every
+ * server of the server ID offline and ignore their retained presences, which
+ * nobody is left to clear, until the host is back.
+ */
+class McpServerHost {
+public:
+    McpServerHost();
+    ~McpServerHost();
+
+    McpServerHost(const McpServerHost&) = delete;
+    McpServerHost& operator=(const McpServerHost&) = delete;
+
+    /**
+     * @brief Attach the host to a connected MQTT client
+     * @param mqttClient Pointer to user's MQTT client implementation (must outlive the host)
+     * @param serverId Server instance ID shared by all hosted servers
+     * @return true if the host started successfully
+     */
+    bool start(IMqttClient* mqttClient, const std::string& serverId);
+
+    /**
+     * @brief Stop all hosted servers and release the MQTT client
+     */
+    void stop();
+
+    /**
+     * @brief Check if the host is running
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Start a configured McpServer on the shared connection
+     * @param server Server to host (must outlive the host or be removed first)
+     * @param config Server configuration; serverName must be unique within the
+     *               host, and serverId is replaced by the host's
+     * @return true if the server started successfully
+     */
+    bool addServer(McpServer* server, const McpServerConfig& config);
+
+    /**
+     * @brief Stop a hosted server and detach it from the shared connection
+     * @param serverName Name the server was added with
+     */
+    void removeServer(const std::string& serverName);
+
+    /**
+     * @brief Get the names of all hosted servers
+     */
+    std::vector<std::string> getServerNames() const;
+
+private:
+    class HostedClient;
+    friend class HostedClient;
+
+    struct HostedServer {
+        McpServer* server = nullptr;
+        std::shared_ptr<HostedClient> client;
+    };
+
+    IMqttClient* mqttClient_ = nullptr;  // Non-owning pointer to user's MQTT client
+    std::string serverId_;
+    std::atomic<bool> running_{false};
+
+    mutable std::mutex mutex_;
+    std::map<std::string, HostedServer> servers_;
+    bool restoreReported_ = false;  // Whether the shared client reports reconnects
+
+    // Topic router: exact topics are looked up directly, wildcard filters scanned
+    std::unordered_map<std::string, std::vector<std::shared_ptr<HostedClient>>> exactRoutes_;
+    std::vector<std::pair<std::string, std::shared_ptr<HostedClient>>> wildcardRoutes_;
+
+    void routeMessage(const MqttIncomingMessage& message);
+    void handleConnectionLost(const std::string& reason);
+    void handleConnectionRestored();
+    std::string getHostPresenceTopic() const;
+
+    // Called by HostedClient
+    void publishHostPresence();
+    bool addRoute(const std::shared_ptr<HostedClient>& client, const std::string& topic,
+                  int qos, bool noLocal);
+    bool removeRoute(const HostedClient* client, const std::string& topic);
+    void removeAllRoutes(const HostedClient* client);
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_SERVER_HOST_H
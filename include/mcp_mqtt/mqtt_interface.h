@@ -5,11 +5,16 @@
 #include <map>
 #include <functional>
 #include <optional>
+#include <chrono>
+#include <cstdint>
 
 namespace mcp_mqtt {
 
 /**
  * @brief MQTT message structure for incoming messages
+ *
+ * Clients built against the original interface only fill the first five
+ * fields; the MQTT 5.0 metadata below keeps its "not present" defaults then.
  */
 struct MqttIncomingMessage {
     std::string topic;
@@ -17,6 +22,42 @@ struct MqttIncomingMessage {
     int qos = 0;
     bool retained = false;
     std::map<std::string, std::string> userProperties;
+
+    // MQTT 5.0 Message Expiry Interval in seconds as received; the broker has
+    // already deducted the time it held the message and drops expired ones
+    std::optional<uint32_t> messageExpiryInterval;
+
+    // MQTT 5.0 request/response metadata; empty strings mean "not present"
+    std::string correlationData;        // Binary data, echoed in the response
+    std::string responseTopic;
+    std::string contentType;
+    uint8_t payloadFormatIndicator = 0; // 0 = unspecified bytes, 1 = UTF-8
+    uint16_t topicAlias = 0;            // Alias the broker used (topic is already resolved)
+};
+
+/**
+ * @brief MQTT 5.0 PUBLISH properties used by publishWithProperties()
+ *
+ * Together with the metadata fields of MqttIncomingMessage this is the v2
+ * publish interface: everything an MQTT 5.0 PUBLISH can carry that matters
+ * to the SDK, without going through user property strings.
+ */
+struct MqttPublishProperties {
+    std::map<std::string, std::string> userProperties;
+
+    // Topic alias the SDK assigned to this topic (0 = none). The implementation
+    // sends topic and alias the first time on a connection (or when the alias
+    // now names a different topic) and an empty topic with the alias after that.
+    uint16_t topicAlias = 0;
+
+    // Message Expiry Interval in seconds (0 = the message does not expire)
+    uint32_t messageExpiryInterval = 0;
+
+    // Request/response metadata; empty strings are not sent
+    std::string correlationData;
+    std::string responseTopic;
+    std::string contentType;
+    uint8_t payloadFormatIndicator = 0; // 0 = not sent, 1 = UTF-8
 };
 
 /**
@@ -79,6 +120,40 @@ public:
                          bool retained,
                          const std::map<std::string, std::string>& userProps = {}) = 0;
 
+    /**
+     * @brief Publish a message with MQTT 5.0 properties
+     *
+     * Optional. The default implementation ignores everything but the user
+     * properties and calls publish().
+     *
+     * @param topic Topic to publish to
+     * @param payload Message payload
+     * @param qos QoS level (0, 1, or 2)
+     * @param retained Whether to retain the message
+     * @param properties PUBLISH properties
+     * @return true if publish was successful
+     */
+    virtual bool publishWithProperties(const std::string& topic,
+                                       const std::string& payload,
+                                       int qos,
+                                       bool retained,
+                                       const MqttPublishProperties& properties) {
+        return publish(topic, payload, qos, retained, properties.userProperties);
+    }
+
+    /**
+     * @brief Get the Topic Alias Maximum usable towards the broker
+     *
+     * Optional. Return the value the broker announced in CONNACK to let the
+     * SDK assign topic aliases; the default of 0 disables them. Aliases the SDK
+     * passes to publishWithProperties() never exceed this value.
+     *
+     * @return Highest usable topic alias, 0 if unsupported
+     */
+    virtual uint16_t getTopicAliasMaximum() const {
+        return 0;
+    }
+
     /**
      * @brief Get the client ID used for this MQTT connection
      * @return The MQTT client ID
@@ -106,6 +181,27 @@ public:
      */
     virtual void setConnectionLostCallback(std::function<void(const std::string& reason)> callback) = 0;
 
+    /**
+     * @brief Set callback invoked when a reconnect has completed
+     *
+     * Implementations that reconnect asynchronously, for example to apply the
+     * Will given to setWill() from their callback thread, call it once the new
+     * connection is up and its subscriptions are restored. The SDK then
+     * publishes again what it sent while the client was reconnecting, such as
+     * a server's presence.
+     *
+     * The default returns false: the implementation does not report
+     * reconnects, and messages published right after setWill() must reach the
+     * new connection.
+     *
+     * @param callback Callback, or null to remove it
+     * @return true if the implementation reports completed reconnects
+     */
+    virtual bool setConnectionRestoredCallback(std::function<void()> callback) {
+        (void)callback;
+        return false;
+    }
+
     /**
      * @brief Set MQTT 5.0 CONNECT packet properties.
      *
@@ -145,12 +241,127 @@ public:
                          int qos, bool retained) = 0;
 };
 
+/**
+ * @brief Check whether a topic matches an MQTT topic filter
+ *
+ * Supports the single-level ('+') and multi-level ('#') wildcards.
+ *
+ * @param filter Topic filter, possibly containing wildcards
+ * @param topic Concrete topic name
+ * @return true if the topic matches the filter
+ */
+inline bool topicMatchesFilter(const std::string& filter, const std::string& topic) {
+    size_t f = 0;
+    size_t t = 0;
+    while (f < filter.size()) {
+        if (filter[f] == '#') {
+            return true;
+        }
+        if (filter[f] == '+') {
+            while (t < topic.size() && topic[t] != '/') ++t;
+            ++f;
+            continue;
+        }
+        if (t >= topic.size() || filter[f] != topic[t]) {
+            // "a/#" also matches the parent level "a"
+            return t == topic.size() && filter.compare(f, 2, "/#") == 0;
+        }
+        ++f;
+        ++t;
+    }
+    return t == topic.size();
+}
+
+/**
+ * @brief High-availability role of an MCP server instance.
+ *
+ * A PRIMARY and a STANDBY share the same serverId and serverName (but use
+ * different MQTT client IDs). The primary mirrors session creation and
+ * teardown as retained messages on an internal topic; the standby keeps a
+ * copy of those sessions without serving traffic. When the primary's presence
+ * goes empty (its Will fired), the standby takes over the primary's
+ * subscriptions and presence, so clients do not need to initialize again.
+ *
+ * Whichever replica serves as primary records its MQTT client ID as a
+ * retained message on $mcp-server/leader/{server-id}/{server-name}. A primary
+ * whose client reports a reconnect (IMqttClient::setConnectionRestoredCallback)
+ * serves nothing until it has read that record again, and demotes itself to
+ * standby if it names the other replica. Without reconnect reports, or while
+ * a reconnected primary's restored subscriptions deliver requests before its
+ * client reports the reconnect, both replicas can briefly answer the same
+ * requests.
+ */
+enum class ReplicaRole {
+    STANDALONE,     // No session mirroring (default)
+    PRIMARY,        // Serves traffic and mirrors sessions for a standby
+    STANDBY         // Mirrors the primary's sessions, takes over when it goes offline
+};
+
+/**
+ * @brief Classes of MCP messages that get their own QoS level
+ */
+enum class MessageClass {
+    PING_RESPONSE,  // Responses to ping
+    PROGRESS,       // notifications/progress
+    LIST_CHANGED,   // notifications/.../list_changed
+    TOOL_RESULT,    // Responses to tools/call
+    RESPONSE,       // All other responses (initialize, tools/list, errors)
+    NOTIFICATION,   // All other notifications (e.g. notifications/disconnected)
+    PRESENCE,       // Server presence and its Will
+    SUBSCRIPTION    // Control, RPC and client presence subscriptions
+};
+
+/**
+ * @brief QoS level per message class, with per-tool overrides for tool results
+ *
+ * Everything defaults to QoS 1, as the protocol recommends. Lowering chatty
+ * classes such as ping responses and progress to QoS 0 saves the PUBACK round
+ * trip and the broker's persistence write. Tools whose calls are idempotent
+ * reads can be moved to QoS 0 individually; a lost result is simply retried.
+ */
+struct QosPolicy {
+    int pingResponse = 1;
+    int progress = 1;
+    int listChanged = 1;
+    int toolResult = 1;
+    int response = 1;
+    int notification = 1;
+    int presence = 1;
+    int subscription = 1;
+
+    std::map<std::string, int> tools;   // Tool name -> QoS of its results
+
+    int qosFor(MessageClass messageClass) const {
+        switch (messageClass) {
+            case MessageClass::PING_RESPONSE: return pingResponse;
+            case MessageClass::PROGRESS: return progress;
+            case MessageClass::LIST_CHANGED: return listChanged;
+            case MessageClass::TOOL_RESULT: return toolResult;
+            case MessageClass::RESPONSE: return response;
+            case MessageClass::NOTIFICATION: return notification;
+            case MessageClass::PRESENCE: return presence;
+            case MessageClass::SUBSCRIPTION: return subscription;
+        }
+        return 1;
+    }
+
+    int qosForTool(const std::string& toolName) const {
+        auto it = tools.find(toolName);
+        return it != tools.end() ? it->second : toolResult;
+    }
+};
+
 /**
  * @brief Configuration for MCP server that uses external MQTT client
  */
 struct McpServerConfig {
     std::string serverId;       // Unique server instance ID (used in topics)
     std::string serverName;     // Hierarchical server name (e.g., "myapp/tools/v1")
+    ReplicaRole role = ReplicaRole::STANDALONE;  // Hot-standby replication role
+    QosPolicy qos;              // QoS per message class and per tool
+    // Quiet time after a tool (un)registration before notifications/tools/list_changed
+    // goes out; a burst of changes sends one, at most 10x this after the first
+    std::chrono::milliseconds toolsListChangedDebounce{100};
 };
 
 } // namespace mcp_mqtt
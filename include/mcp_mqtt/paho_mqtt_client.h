@@ -0,0 +1,180 @@
+#ifndef MCP_MQTT_PAHO_MQTT_CLIENT_H
+#define MCP_MQTT_PAHO_MQTT_CLIENT_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mqtt/async_client.h>
+#include "mqtt_interface.h"
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Options for PahoMqttClient
+ */
+struct PahoMqttClientOptions {
+    std::string username;
+    std::string password;
+    std::chrono::seconds keepAlive{60};
+
+    // Maximum number of publishes awaiting completion; publish() blocks
+    // (up to publishTimeout) when the window is full, except on the Paho
+    // callback thread where blocking would deadlock
+    int maxInflight = 64;
+    std::chrono::milliseconds publishTimeout{5000};
+
+    // Automatic reconnect with exponential backoff between min and max
+    bool autoReconnect = true;
+    std::chrono::seconds minReconnectDelay{1};
+    std::chrono::seconds maxReconnectDelay{30};
+};
+
+/**
+ * @brief IMqttClient implementation on top of Paho MQTT C++ (MQTT 5.0).
+ *
+ * Built as the optional mcp_mqtt_paho library target when Paho MQTT C++ is
+ * found. Compared to a straightforward adapter it:
+ * - Caches the mqtt::properties built from the SDK's user properties, which
+ *   are the same for every publish of a server
+ * - Reuses one MqttIncomingMessage for all arrivals, so topic and payload
+ *   buffers are not reallocated per message
+ * - Publishes asynchronously, tracking completion through an action listener
+ *   with a bounded inflight window
+ * - Reconnects automatically and restores its subscriptions, the Will and the
+ *   CONNECT properties; a reconnected callback lets users restore their own state
+ * - Sends topic aliases assigned by the SDK, within the broker's maximum
+ *
+ * The underlying async_client remains available for non-MCP use.
+ */
+class PahoMqttClient : public IMqttClient, private mqtt::callback {
+public:
+    PahoMqttClient(const std::string& brokerAddress, const std::string& clientId,
+                   const PahoMqttClientOptions& options = {});
+    ~PahoMqttClient() override;
+
+    PahoMqttClient(const PahoMqttClient&) = delete;
+    PahoMqttClient& operator=(const PahoMqttClient&) = delete;
+
+    /**
+     * @brief Connect to the broker (blocking)
+     * @return true if connected
+     */
+    bool connect();
+
+    /**
+     * @brief Disconnect from the broker (blocking)
+     */
+    void disconnect();
+
+    /**
+     * @brief Set callback invoked after an automatic reconnect has restored subscriptions
+     */
+    void setReconnectedCallback(std::function<void()> callback);
+
+    /**
+     * @brief Number of publishes not yet completed by the broker
+     */
+    int getInflightCount() const;
+
+    /**
+     * @brief Access the underlying Paho client for non-MCP operations
+     */
+    mqtt::async_client* getUnderlyingClient();
+
+    // IMqttClient interface
+    bool isConnected() const override;
+    bool subscribe(const std::string& topic, int qos, bool noLocal) override;
+    bool unsubscribe(const std::string& topic) override;
+    bool publish(const std::string& topic,
+                 const std::string& payload,
+                 int qos,
+                 bool retained,
+                 const std::map<std::string, std::string>& userProps) override;
+    bool publishWithProperties(const std::string& topic,
+                               const std::string& payload,
+                               int qos,
+                               bool retained,
+                               const MqttPublishProperties& properties) override;
+    uint16_t getTopicAliasMaximum() const override;
+    std::string getClientId() const override;
+    void setMessageHandler(MqttMessageHandler handler) override;
+    void setConnectionLostCallback(std::function<void(const std::string& reason)> callback) override;
+    bool setConnectionRestoredCallback(std::function<void()> callback) override;
+    void setConnectProperties(uint32_t sessionExpiryInterval,
+                              const std::map<std::string, std::string>& userProperties) override;
+    void setWill(const std::string& topic, const std::string& payload,
+                 int qos, bool retained) override;
+
+private:
+    class PublishListener;
+
+    std::string brokerAddress_;
+    std::string clientId_;
+    PahoMqttClientOptions options_;
+    std::unique_ptr<mqtt::async_client> client_;
+    std::unique_ptr<PublishListener> publishListener_;
+
+    mutable std::mutex mutex_;
+    MqttMessageHandler messageHandler_;
+    std::function<void(const std::string&)> connectionLostCallback_;
+    std::function<void()> reconnectedCallback_;
+    std::function<void()> connectionRestoredCallback_;
+
+    // Subscriptions restored after reconnect: topic -> (qos, noLocal)
+    std::map<std::string, std::pair<int, bool>> subscriptions_;
+
+    // Will message and CONNECT properties (set by SDK)
+    std::string willTopic_;
+    std::string willPayload_;
+    int willQos_ = 1;
+    bool willRetained_ = true;
+    uint32_t sessionExpiryInterval_ = 0;
+    std::map<std::string, std::string> connectUserProperties_;
+    bool connectPropsSet_ = false;
+
+    // Cached PUBLISH properties for the last seen user property set
+    std::mutex propsMutex_;
+    std::map<std::string, std::string> cachedUserProps_;
+    mqtt::properties cachedProperties_;
+
+    // Topic aliases established on the current connection (guarded by propsMutex_)
+    std::vector<std::string> outboundAliases_;
+    std::atomic<uint16_t> brokerTopicAliasMaximum_{0};
+
+    // Inflight window
+    std::mutex inflightMutex_;
+    std::condition_variable inflightCv_;
+    std::atomic<int> inflight_{0};
+
+    // Reused for every arrival (Paho delivers on one thread)
+    MqttIncomingMessage incoming_;
+    std::atomic<std::thread::id> callbackThread_{};
+    std::thread reconnectThread_;
+
+    mqtt::connect_options buildConnectOptions();
+    const mqtt::properties& publishProperties(const std::map<std::string, std::string>& userProps);
+    bool publishMessage(const std::string& topic, const std::string& payload, int qos, bool retained,
+                        const std::map<std::string, std::string>& userProps,
+                        const MqttPublishProperties* extra);
+    void resetTopicAliases();
+    void publishCompleted();
+    void restoreSubscriptions();
+    void notifyConnectionRestored();
+    bool onCallbackThread() const;
+
+    // mqtt::callback overrides
+    void connected(const std::string& cause) override;
+    void connection_lost(const std::string& cause) override;
+    void message_arrived(mqtt::const_message_ptr msg) override;
+    void delivery_complete(mqtt::delivery_token_ptr token) override;
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_PAHO_MQTT_CLIENT_H
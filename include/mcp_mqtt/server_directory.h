@@ -0,0 +1,211 @@
+#ifndef MCP_MQTT_SERVER_DIRECTORY_H
+#define MCP_MQTT_SERVER_DIRECTORY_H
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <set>
+#include <optional>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "mqtt_interface.h"
+
+namespace mcp_mqtt {
+
+/**
+ * @brief An MCP server seen through its presence topic
+ */
+struct DiscoveredServer {
+    std::string serverId;
+    std::string serverName;
+    std::string description;
+    std::optional<nlohmann::json> meta;
+    std::string mqttClientId;       // From the MCP-MQTT-CLIENT-ID user property, if sent
+};
+
+/**
+ * @brief Index of the MCP servers that are online, fed by their presence messages
+ *
+ * Each presence message updates the index incrementally. Lookups never take a
+ * lock: writers publish an immutable snapshot, sorted by (serverName,
+ * serverId), and readers use whichever snapshot is current when they start.
+ * Lookup by exact server name or by name prefix is a binary search, O(log n)
+ * plus the matches.
+ *
+ * A read section (View) only counts itself in one of two per-epoch reader
+ * counters. A writer swaps in the new snapshot, moves to the next epoch and
+ * frees the old snapshot once the readers of the previous epoch have left.
+ * Writers wait for those readers, so keep views short. A thread holding a
+ * View must not update the directory.
+ *
+ * Updates are serialized; entries are shared between snapshots, so an update
+ * copies pointers, not servers.
+ */
+class ServerDirectory {
+public:
+    using ServerPtr = std::shared_ptr<const DiscoveredServer>;
+
+    /**
+     * @brief Contiguous run of entries in a snapshot
+     */
+    struct Range {
+        const ServerPtr* first = nullptr;
+        const ServerPtr* last = nullptr;
+
+        const ServerPtr* begin() const { return first; }
+        const ServerPtr* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+    };
+
+    /**
+     * @brief Read section over the current snapshot
+     *
+     * The snapshot does not change while the view exists. Entries may be kept
+     * beyond the view by copying their ServerPtr.
+     */
+    class View {
+    public:
+        View(View&& other) noexcept;
+        View& operator=(View&&) = delete;
+        View(const View&) = delete;
+        ~View();
+
+        /**
+         * @brief All servers, sorted by (serverName, serverId)
+         */
+        Range all() const;
+
+        /**
+         * @brief Instances of one server name
+         */
+        Range withName(const std::string& serverName) const;
+
+        /**
+         * @brief Servers whose name starts with a prefix (plain string prefix)
+         */
+        Range withPrefix(const std::string& prefix) const;
+
+        /**
+         * @brief One instance, or null if it is not online
+         */
+        ServerPtr find(const std::string& serverId, const std::string& serverName) const;
+
+        size_t size() const;
+
+        /**
+         * @brief Version of the snapshot; changes with every update
+         */
+        uint64_t version() const;
+
+    private:
+        friend class ServerDirectory;
+        struct Snapshot;
+
+        View(const ServerDirectory* directory, size_t side, const Snapshot* snapshot);
+
+        const ServerDirectory* directory_;
+        size_t side_;
+        const Snapshot* snapshot_;
+    };
+
+    /**
+     * @brief What a presence message changed
+     */
+    enum class Change {
+        NONE,           // Not a valid presence message, or an offline server that was unknown
+        ONLINE,         // New server
+        UPDATED,        // Known server with a new presence (e.g. new description)
+        OFFLINE         // Server(s) removed
+    };
+
+    ServerDirectory();
+    ~ServerDirectory();
+
+    ServerDirectory(const ServerDirectory&) = delete;
+    ServerDirectory& operator=(const ServerDirectory&) = delete;
+
+    /**
+     * @brief Start a read section
+     */
+    View read() const;
+
+    /**
+     * @brief Copying shortcuts for a single lookup
+     */
+    std::vector<ServerPtr> findByName(const std::string& serverName) const;
+    std::vector<ServerPtr> findByPrefix(const std::string& prefix) const;
+    ServerPtr find(const std::string& serverId, const std::string& serverName) const;
+    size_t size() const;
+
+    /**
+     * @brief Apply a message from $mcp-server/presence/{server-id}/{server-name}
+     *
+     * A notifications/server/online payload adds or updates the server, an
+     * empty payload removes it.
+     *
+     * Messages on $mcp-server/presence/{server-id} report a server host (see
+     * McpServerHost): notifications/server/offline removes every server of
+     * the server ID, and their presences are ignored until the host reports
+     * notifications/server/online again. This drops the retained presences
+     * that a crashed host leaves behind, whatever order they arrive in.
+     *
+     * @param servers Set to the servers that were added, updated or removed
+     */
+    Change applyPresence(const MqttIncomingMessage& message, std::vector<ServerPtr>* servers = nullptr);
+
+    /**
+     * @brief Add or replace a server
+     * @return true if it was new
+     */
+    bool upsert(DiscoveredServer server);
+
+    /**
+     * @brief Remove a server
+     * @return The removed server, or null if it was not there
+     */
+    ServerPtr remove(const std::string& serverId, const std::string& serverName);
+
+    /**
+     * @brief Remove all servers of a server ID
+     * @return The removed servers
+     */
+    std::vector<ServerPtr> removeServerId(const std::string& serverId);
+
+    /**
+     * @brief Remove all servers
+     */
+    void clear();
+
+private:
+    using Snapshot = View::Snapshot;
+
+    std::mutex writeMutex_;
+    std::atomic<const Snapshot*> current_;
+    std::atomic<uint64_t> epoch_{0};
+
+    // Readers inside a view, per epoch parity, each on its own cache line
+    struct alignas(64) ReaderCount {
+        std::atomic<int64_t> count{0};
+    };
+    mutable ReaderCount readers_[2];
+
+    // Server IDs whose host went offline; their presences are stale
+    std::mutex hostsMutex_;
+    std::set<std::string> offlineHosts_;
+
+    Change applyHostPresence(const std::string& serverId, const MqttIncomingMessage& message,
+                             std::vector<ServerPtr>* servers);
+
+    // Add or replace an entry; true if it was new
+    bool insert(ServerPtr entry);
+
+    // Publish a snapshot and free the previous one once no reader uses it
+    void publish(std::vector<ServerPtr> servers);
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_SERVER_DIRECTORY_H
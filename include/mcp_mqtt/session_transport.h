@@ -0,0 +1,35 @@
+#ifndef MCP_MQTT_SESSION_TRANSPORT_H
+#define MCP_MQTT_SESSION_TRANSPORT_H
+
+#include <string>
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Non-MQTT channel carrying a client session's traffic.
+ *
+ * When a session has a transport attached, McpServer sends the session's
+ * responses and notifications through it instead of publishing them on the
+ * session's MQTT RPC topic. Requests received on the transport are fed into
+ * the same dispatch core as MQTT RPC messages.
+ */
+class ISessionTransport {
+public:
+    virtual ~ISessionTransport() = default;
+
+    /**
+     * @brief Send one serialized JSON-RPC message to the client
+     * @param payload Serialized JSON-RPC message
+     * @return true if the message was queued for delivery
+     */
+    virtual bool send(const std::string& payload) = 0;
+
+    /**
+     * @brief Close the transport; no messages are sent or received afterwards
+     */
+    virtual void close() = 0;
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_SESSION_TRANSPORT_H
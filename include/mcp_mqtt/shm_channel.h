@@ -0,0 +1,131 @@
+#ifndef MCP_MQTT_SHM_CHANNEL_H
+#define MCP_MQTT_SHM_CHANNEL_H
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <functional>
+#include "session_transport.h"
+
+namespace mcp_mqtt {
+
+// Capability key negotiated in initialize (capabilities.experimental)
+constexpr const char* SHM_CAPABILITY = "mqtt/shm";
+
+/**
+ * @brief Pair of single-producer/single-consumer ring buffers in POSIX shared memory.
+ *
+ * Used as a fast path for MCP clients running on the same host as the server.
+ * The server creates the segment and announces its name in the initialize
+ * response; the client opens it by name. One ring carries client-to-server
+ * messages, the other server-to-client messages. Each message is a
+ * length-prefixed frame.
+ *
+ * Waiting readers sleep on a futex word in the shared segment that writers
+ * bump per frame, so the wake-up needs no file descriptor passing between
+ * processes. Only available on Linux; elsewhere create() and open() return null.
+ *
+ * The peer can write the whole segment, so both sides check every frame
+ * against the ring's fill level and the capacity fixed at create()/open().
+ * A corrupt frame closes the channel.
+ */
+class ShmChannel {
+public:
+    ~ShmChannel();
+
+    ShmChannel(const ShmChannel&) = delete;
+    ShmChannel& operator=(const ShmChannel&) = delete;
+
+    /**
+     * @brief Create a new segment (server side)
+     *
+     * The channel unlinks the name when destroyed, so give each channel a
+     * name no later channel reuses.
+     *
+     * @param name Segment name (e.g. "/mcp-server1-client1-1")
+     * @param ringCapacity Size of each ring in bytes, rounded up to a power of two
+     * @return The channel, or null on failure
+     */
+    static std::unique_ptr<ShmChannel> create(const std::string& name, size_t ringCapacity);
+
+    /**
+     * @brief Open an existing segment (client side)
+     * @param name Segment name announced by the server
+     * @return The channel, or null on failure
+     */
+    static std::unique_ptr<ShmChannel> open(const std::string& name);
+
+    /**
+     * @brief Identifier of the current host, used to detect co-located peers
+     *
+     * Returns the kernel boot ID, or an empty string if unavailable.
+     */
+    static std::string localHostId();
+
+    /**
+     * @brief Write one message to the peer
+     *
+     * Callers that fall back to another path when this fails (McpServer
+     * falls back to MQTT) must expect those messages to overtake frames
+     * still queued in the ring.
+     *
+     * @return false if the ring is full, the message is too large or the channel is closed
+     */
+    bool send(const std::string& payload);
+
+    /**
+     * @brief Wait for one message from the peer
+     * @param payload Receives the message
+     * @param timeoutMs Maximum wait in milliseconds (negative waits forever)
+     * @return false on timeout, if the channel was closed, or if the peer
+     *         wrote a corrupt frame (the channel is closed then)
+     */
+    bool receive(std::string& payload, int timeoutMs);
+
+    /**
+     * @brief Mark the channel closed for both sides and wake any waiting reader
+     */
+    void close();
+
+    bool isClosed() const;
+    const std::string& name() const;
+    size_t ringCapacity() const;
+
+private:
+    struct Segment;
+
+    ShmChannel() = default;
+
+    std::string name_;
+    bool owner_ = false;
+    Segment* segment_ = nullptr;
+    size_t mappedSize_ = 0;
+    uint64_t capacity_ = 0;     // Ring capacity as validated; the peer can rewrite the segment
+    int txRing_ = 0;
+    int rxRing_ = 0;
+};
+
+/**
+ * @brief Server-side session transport over a ShmChannel.
+ *
+ * Runs a reader thread that hands every message from the client to the
+ * frame handler (McpServer's RPC dispatch core).
+ */
+class ShmSessionTransport : public ISessionTransport {
+public:
+    using FrameHandler = std::function<void(const std::string& payload)>;
+
+    ShmSessionTransport(std::unique_ptr<ShmChannel> channel, FrameHandler handler);
+    ~ShmSessionTransport() override;
+
+    bool send(const std::string& payload) override;
+    void close() override;
+
+private:
+    std::shared_ptr<ShmChannel> channel_;
+    std::thread reader_;
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_SHM_CHANNEL_H
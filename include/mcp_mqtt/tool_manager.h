@@ -29,8 +29,9 @@ public:
     /**
      * @brief Unregister a tool
      * @param name Tool name
+     * @return true if the tool was registered
      */
-    void unregisterTool(const std::string& name);
+    bool unregisterTool(const std::string& name);
 
     /**
      * @brief Get all registered tools
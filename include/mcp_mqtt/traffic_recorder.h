@@ -0,0 +1,158 @@
+#ifndef MCP_MQTT_TRAFFIC_RECORDER_H
+#define MCP_MQTT_TRAFFIC_RECORDER_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include "mqtt_interface.h"
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Direction of a recorded message, seen from the recording client
+ */
+enum class TrafficDirection {
+    INCOMING,       // Delivered to the message handler
+    OUTGOING        // Published through the client
+};
+
+/**
+ * @brief One message of a traffic recording
+ *
+ * Outgoing publishes are stored in the same form as incoming messages: the
+ * publish properties go into the matching MqttIncomingMessage fields.
+ */
+struct TrafficRecord {
+    TrafficDirection direction = TrafficDirection::INCOMING;
+    std::chrono::microseconds timestamp{0};     // Since the recording was opened
+    MqttIncomingMessage message;
+};
+
+/**
+ * @brief IMqttClient decorator recording all traffic to a binary file.
+ *
+ * Wraps the client an McpServer runs on and writes every message delivered to
+ * the server and every message it publishes, with a timestamp, to a compact
+ * binary recording (varint-encoded lengths and time deltas). TrafficReader
+ * reads it back; the mcp_mqtt_replay tool replays the incoming side of a
+ * recording into a server to measure throughput and latency on real traffic.
+ *
+ * Recording starts with open() and stops with close(); without an open file
+ * the decorator only forwards. Writes go through a buffered stream under a
+ * mutex, so recording adds a memcpy-sized cost per message. Thread-safe.
+ */
+class RecordingMqttClient : public IMqttClient {
+public:
+    /**
+     * @param client Client to wrap (must outlive the decorator)
+     */
+    explicit RecordingMqttClient(IMqttClient* client);
+    ~RecordingMqttClient() override;
+
+    RecordingMqttClient(const RecordingMqttClient&) = delete;
+    RecordingMqttClient& operator=(const RecordingMqttClient&) = delete;
+
+    /**
+     * @brief Start recording into a file, replacing its contents
+     * @return true on success
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Flush and close the recording
+     */
+    void close();
+
+    /**
+     * @brief Write buffered records to the file
+     */
+    void flush();
+
+    bool isRecording() const;
+
+    /**
+     * @brief Number of messages recorded since open()
+     */
+    uint64_t getRecordCount() const;
+
+    // IMqttClient
+    bool isConnected() const override;
+    bool subscribe(const std::string& topic, int qos, bool noLocal) override;
+    bool unsubscribe(const std::string& topic) override;
+    bool publish(const std::string& topic,
+                 const std::string& payload,
+                 int qos,
+                 bool retained,
+                 const std::map<std::string, std::string>& userProps = {}) override;
+    bool publishWithProperties(const std::string& topic,
+                               const std::string& payload,
+                               int qos,
+                               bool retained,
+                               const MqttPublishProperties& properties) override;
+    uint16_t getTopicAliasMaximum() const override;
+    std::string getClientId() const override;
+    void setMessageHandler(MqttMessageHandler handler) override;
+    void setConnectionLostCallback(std::function<void(const std::string& reason)> callback) override;
+    bool setConnectionRestoredCallback(std::function<void()> callback) override;
+    void setConnectProperties(uint32_t sessionExpiryInterval,
+                              const std::map<std::string, std::string>& userProperties) override;
+    void setWill(const std::string& topic, const std::string& payload,
+                 int qos, bool retained) override;
+
+private:
+    IMqttClient* client_;   // Non-owning
+
+    mutable std::mutex mutex_;
+    FILE* file_ = nullptr;
+    std::chrono::steady_clock::time_point start_;
+    int64_t lastTimestamp_ = 0;     // Microseconds since start_
+    uint64_t recordCount_ = 0;
+    std::string buffer_;            // Encoding scratch space
+
+    void record(TrafficDirection direction, const MqttIncomingMessage& message);
+};
+
+/**
+ * @brief Reads a recording written by RecordingMqttClient
+ */
+class TrafficReader {
+public:
+    TrafficReader() = default;
+    ~TrafficReader();
+
+    TrafficReader(const TrafficReader&) = delete;
+    TrafficReader& operator=(const TrafficReader&) = delete;
+
+    /**
+     * @brief Open a recording and check its header
+     * @return true on success
+     */
+    bool open(const std::string& path);
+
+    void close();
+
+    /**
+     * @brief Read the next record
+     *
+     * A record cut short at the end of the file (the recorder was not closed)
+     * ends the recording, as does a string longer than the rest of the file.
+     *
+     * @return false at the end of the recording
+     */
+    bool next(TrafficRecord& record);
+
+private:
+    FILE* file_ = nullptr;
+    uint64_t fileSize_ = 0;
+    int64_t lastTimestamp_ = 0;
+
+    bool readVarint(uint64_t& value);
+    bool readString(std::string& value);
+};
+
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_TRAFFIC_RECORDER_H
@@ -24,6 +24,13 @@ constexpr const char* USER_PROP_SERVER_NAME = "MCP-SERVER-NAME";
 constexpr const char* COMPONENT_TYPE_SERVER = "mcp-server";
 constexpr const char* COMPONENT_TYPE_CLIENT = "mcp-client";
 
+// Presence of a whole server ID, on $mcp-server/presence/{server-id}. An
+// McpServerHost keeps notifications/server/online retained there while it
+// is up; its Will replaces that with notifications/server/offline, which
+// takes every server of the server ID offline.
+constexpr const char* METHOD_SERVER_ONLINE = "notifications/server/online";
+constexpr const char* METHOD_SERVER_OFFLINE = "notifications/server/offline";
+
 // Default timeouts (milliseconds)
 struct Timeouts {
     static constexpr int INITIALIZE = 30000;
@@ -78,6 +85,22 @@ struct ToolInputSchema {
         }
         return j;
     }
+
+    static ToolInputSchema fromJson(const nlohmann::json& j) {
+        ToolInputSchema schema;
+        schema.type = j.value("type", "object");
+        if (j.contains("properties")) {
+            schema.properties = j["properties"];
+        }
+        if (j.contains("required") && j["required"].is_array()) {
+            for (const auto& name : j["required"]) {
+                if (name.is_string()) {
+                    schema.required.push_back(name.get<std::string>());
+                }
+            }
+        }
+        return schema;
+    }
 };
 
 // Tool definition
@@ -93,6 +116,16 @@ struct Tool {
         j["inputSchema"] = inputSchema.toJson();
         return j;
     }
+
+    static Tool fromJson(const nlohmann::json& j) {
+        Tool tool;
+        tool.name = j.value("name", "");
+        tool.description = j.value("description", "");
+        if (j.contains("inputSchema") && j["inputSchema"].is_object()) {
+            tool.inputSchema = ToolInputSchema::fromJson(j["inputSchema"]);
+        }
+        return tool;
+    }
 };
 
 // Tool call result content
@@ -164,6 +197,33 @@ struct ClientSession {
     ClientInfo clientInfo;
     nlohmann::json capabilities;
     bool initialized = false;
+
+    nlohmann::json toJson() const {
+        nlohmann::json j;
+        j["mcpClientId"] = mcpClientId;
+        j["protocolVersion"] = protocolVersion;
+        j["clientInfo"] = {{"name", clientInfo.name}, {"version", clientInfo.version}};
+        if (!capabilities.is_null()) {
+            j["capabilities"] = capabilities;
+        }
+        j["initialized"] = initialized;
+        return j;
+    }
+
+    static ClientSession fromJson(const nlohmann::json& j) {
+        ClientSession session;
+        session.mcpClientId = j.value("mcpClientId", "");
+        session.protocolVersion = j.value("protocolVersion", "");
+        if (j.contains("clientInfo")) {
+            session.clientInfo.name = j["clientInfo"].value("name", "");
+            session.clientInfo.version = j["clientInfo"].value("version", "");
+        }
+        if (j.contains("capabilities")) {
+            session.capabilities = j["capabilities"];
+        }
+        session.initialized = j.value("initialized", false);
+        return session;
+    }
 };
 
 } // namespace mcp_mqtt
@@ -0,0 +1,24 @@
+# Compiler options for both stages of the profile-guided build.
+# Needs MCP_MQTT_PGO_PROFILE_DIR. Sets:
+#   MCP_MQTT_PGO_GENERATE_OPTIONS  Instrumented build, also used for linking
+#   MCP_MQTT_PGO_USE_OPTIONS       Final build
+#   MCP_MQTT_PGO_PROFDATA          Merged Clang profile (Clang only)
+
+if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+    # GCC names each .gcda after its object file. Stripping the build
+    # directory leaves CMakeFiles#mcp_mqtt_server.dir#src#... in both stages.
+    set(MCP_MQTT_PGO_GENERATE_OPTIONS
+        -fprofile-generate=${MCP_MQTT_PGO_PROFILE_DIR}
+        -fprofile-update=atomic         # The training workloads are multithreaded
+        -fprofile-prefix-path=${PROJECT_BINARY_DIR}
+    )
+    set(MCP_MQTT_PGO_USE_OPTIONS
+        -fprofile-use=${MCP_MQTT_PGO_PROFILE_DIR}
+        -fprofile-partial-training      # Code the training never ran stays optimized for speed
+        -fprofile-prefix-path=${PROJECT_BINARY_DIR}
+    )
+else()
+    set(MCP_MQTT_PGO_PROFDATA ${MCP_MQTT_PGO_PROFILE_DIR}/mcp_mqtt.profdata)
+    set(MCP_MQTT_PGO_GENERATE_OPTIONS -fprofile-instr-generate)
+    set(MCP_MQTT_PGO_USE_OPTIONS -fprofile-instr-use=${MCP_MQTT_PGO_PROFDATA})
+endif()
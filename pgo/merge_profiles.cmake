@@ -0,0 +1,15 @@
+# Merges the raw Clang profiles of the training runs into one .profdata file.
+# Usage: cmake -DLLVM_PROFDATA=<path> -DPGO_DIR=<dir> -DOUTPUT=<file> -P merge_profiles.cmake
+
+file(GLOB RAW_PROFILES ${PGO_DIR}/*.profraw)
+if(NOT RAW_PROFILES)
+    message(FATAL_ERROR "No training profiles in ${PGO_DIR}")
+endif()
+
+execute_process(
+    COMMAND ${LLVM_PROFDATA} merge -o ${OUTPUT} ${RAW_PROFILES}
+    RESULT_VARIABLE MERGE_RESULT
+)
+if(NOT MERGE_RESULT EQUAL 0)
+    message(FATAL_ERROR "llvm-profdata merge failed")
+endif()
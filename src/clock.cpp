@@ -0,0 +1,158 @@
+#include "mcp_mqtt/clock.h"
+
+#include <algorithm>
+
+namespace mcp_mqtt {
+
+// SystemClock
+
+SystemClock::~SystemClock() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+SystemClock& SystemClock::instance() {
+    static SystemClock clock;
+    return clock;
+}
+
+IClock::TimePoint SystemClock::now() const {
+    return std::chrono::steady_clock::now();
+}
+
+IClock::TimerId SystemClock::schedule(TimePoint at, Callback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+        return 0;
+    }
+    if (!thread_.joinable()) {
+        thread_ = std::thread([this]() { timerLoop(); });
+    }
+
+    TimerId id = nextId_++;
+    bool earliest = timers_.empty() || at < timers_.begin()->first.first;
+    timers_.emplace(std::make_pair(at, id), std::move(callback));
+    timerIndex_.emplace(id, at);
+    if (earliest) {
+        cv_.notify_all();
+    }
+    return id;
+}
+
+bool SystemClock::cancel(TimerId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timerIndex_.find(id);
+    if (it == timerIndex_.end()) {
+        return false;
+    }
+    timers_.erase({it->second, id});
+    timerIndex_.erase(it);
+    return true;
+}
+
+void SystemClock::timerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (timers_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+        auto first = timers_.begin();
+        // A copy: cancel() may erase the timer while we wait
+        TimePoint due = first->first.first;
+        if (due > std::chrono::steady_clock::now()) {
+            cv_.wait_until(lock, due);
+            continue;
+        }
+
+        Callback callback = std::move(first->second);
+        timerIndex_.erase(first->first.second);
+        timers_.erase(first);
+        lock.unlock();
+        callback();
+        lock.lock();
+    }
+}
+
+// VirtualClock
+
+VirtualClock::VirtualClock(TimePoint start) : now_(start) {
+}
+
+IClock::TimePoint VirtualClock::now() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return now_;
+}
+
+IClock::TimerId VirtualClock::schedule(TimePoint at, Callback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TimerId id = nextId_++;
+    // A timer in the past fires on the next run, at the current time
+    at = std::max(at, now_);
+    timers_.emplace(std::make_pair(at, id), std::move(callback));
+    timerIndex_.emplace(id, at);
+    return id;
+}
+
+bool VirtualClock::cancel(TimerId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timerIndex_.find(id);
+    if (it == timerIndex_.end()) {
+        return false;
+    }
+    timers_.erase({it->second, id});
+    timerIndex_.erase(it);
+    return true;
+}
+
+bool VirtualClock::runNext(TimePoint until) {
+    Callback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (timers_.empty() || timers_.begin()->first.first > until) {
+            return false;
+        }
+        auto first = timers_.begin();
+        now_ = first->first.first;
+        callback = std::move(first->second);
+        timerIndex_.erase(first->first.second);
+        timers_.erase(first);
+    }
+    callback();
+    return true;
+}
+
+size_t VirtualClock::runUntil(TimePoint until) {
+    size_t fired = 0;
+    while (runNext(until)) {
+        ++fired;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    now_ = std::max(now_, until);
+    return fired;
+}
+
+size_t VirtualClock::runFor(Duration duration) {
+    return runUntil(now() + duration);
+}
+
+size_t VirtualClock::runUntilIdle(size_t maxTimers) {
+    size_t fired = 0;
+    while (fired < maxTimers && runNext(TimePoint::max())) {
+        ++fired;
+    }
+    return fired;
+}
+
+size_t VirtualClock::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.size();
+}
+
+} // namespace mcp_mqtt
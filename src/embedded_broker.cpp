@@ -0,0 +1,1202 @@
+#include "mcp_mqtt/embedded_broker.h"
+#include "mcp_mqtt/logger.h"
+#include "mqtt5_codec.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <set>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace mcp_mqtt {
+
+static constexpr size_t READ_CHUNK = 64 * 1024;
+
+// MQTT 5.0 reason codes used by the broker
+static constexpr uint8_t RC_SUCCESS = 0x00;
+static constexpr uint8_t RC_NO_SUBSCRIPTION_EXISTED = 0x11;
+static constexpr uint8_t RC_UNSUPPORTED_PROTOCOL_VERSION = 0x84;
+static constexpr uint8_t RC_CLIENT_ID_NOT_VALID = 0x85;
+static constexpr uint8_t RC_TOPIC_FILTER_INVALID = 0x8F;
+static constexpr uint8_t RC_SHARED_SUBSCRIPTIONS_NOT_SUPPORTED = 0x9E;
+static constexpr uint8_t RC_DISCONNECT_WITH_WILL = 0x04;
+
+static thread_local const EmbeddedBroker* tlsIoBroker = nullptr;
+static thread_local const EmbeddedBroker* tlsDeliveryBroker = nullptr;
+
+/**
+ * @brief A published message, shared by every delivery of it
+ */
+struct EmbeddedBroker::Message {
+    std::string topic;
+    std::string payload;
+    int qos = 0;
+    bool retain = false;
+    uint32_t messageExpiryInterval = 0;     // 0 = does not expire
+    std::chrono::steady_clock::time_point receivedAt;
+    std::string correlationData;
+    std::string responseTopic;
+    std::string contentType;
+    uint8_t payloadFormatIndicator = 0;
+    std::map<std::string, std::string> userProperties;
+};
+
+/**
+ * @brief A connected client, in-process or remote
+ */
+struct EmbeddedBroker::Session {
+    std::string clientId;
+    bool local = false;
+    std::atomic<bool> closed{false};
+
+    // Guarded by the broker's mutex_
+    std::map<std::string, std::pair<int, bool>> filters;
+    std::shared_ptr<const Message> will;
+
+    // In-process client callbacks
+    std::mutex callbackMutex;
+    MqttMessageHandler handler;
+    std::function<void(const std::string&)> connectionLostCallback;
+
+    // Outgoing packets of a remote client, encoded by any thread
+    std::mutex outMutex;
+    std::string out;
+    uint16_t nextPacketId = 0;
+
+    // Remote client, I/O thread only
+    int fd = -1;
+    bool connected = false;     // CONNECT accepted
+    uint16_t keepAlive = 0;
+    std::chrono::steady_clock::time_point lastActivity;
+    std::string in;
+    std::string sending;
+    size_t sendOffset = 0;
+    bool wantWrite = false;
+    std::vector<std::string> inboundAliases;
+    std::set<uint16_t> awaitingRelease;     // QoS 2 packet IDs already routed
+    bool willOnClose = true;
+    std::string closeReason;
+};
+
+/**
+ * @brief IMqttClient of an in-process client
+ */
+class EmbeddedBroker::LocalClient : public IMqttClient {
+public:
+    LocalClient(EmbeddedBroker* broker, std::shared_ptr<Session> session)
+        : broker_(broker), session_(std::move(session)) {}
+
+    ~LocalClient() override {
+        broker_->endSession(session_, false);
+    }
+
+    bool isConnected() const override {
+        return broker_->isRunning() && !session_->closed;
+    }
+
+    bool subscribe(const std::string& topic, int qos, bool noLocal) override {
+        if (session_->closed) {
+            return false;
+        }
+        qos = std::min(qos, 1);
+        for (const auto& message : broker_->subscribe(session_, topic, qos, noLocal)) {
+            broker_->deliver(session_, message, std::min(message->qos, qos), true);
+        }
+        return true;
+    }
+
+    bool unsubscribe(const std::string& topic) override {
+        return broker_->unsubscribe(session_, topic);
+    }
+
+    bool publish(const std::string& topic,
+                 const std::string& payload,
+                 int qos,
+                 bool retained,
+                 const std::map<std::string, std::string>& userProps) override {
+        MqttPublishProperties properties;
+        properties.userProperties = userProps;
+        return publishWithProperties(topic, payload, qos, retained, properties);
+    }
+
+    bool publishWithProperties(const std::string& topic,
+                               const std::string& payload,
+                               int qos,
+                               bool retained,
+                               const MqttPublishProperties& properties) override {
+        if (!isConnected()) {
+            return false;
+        }
+        auto message = std::make_shared<Message>();
+        message->topic = topic;
+        message->payload = payload;
+        message->qos = std::min(qos, 2);
+        message->retain = retained;
+        message->messageExpiryInterval = properties.messageExpiryInterval;
+        message->receivedAt = std::chrono::steady_clock::now();
+        message->correlationData = properties.correlationData;
+        message->responseTopic = properties.responseTopic;
+        message->contentType = properties.contentType;
+        message->payloadFormatIndicator = properties.payloadFormatIndicator;
+        message->userProperties = properties.userProperties;
+        broker_->route(session_.get(), message);
+        return true;
+    }
+
+    std::string getClientId() const override {
+        return session_->clientId;
+    }
+
+    void setMessageHandler(MqttMessageHandler handler) override {
+        std::lock_guard<std::mutex> lock(session_->callbackMutex);
+        session_->handler = std::move(handler);
+    }
+
+    void setConnectionLostCallback(std::function<void(const std::string& reason)> callback) override {
+        std::lock_guard<std::mutex> lock(session_->callbackMutex);
+        session_->connectionLostCallback = std::move(callback);
+    }
+
+    void setConnectProperties(uint32_t, const std::map<std::string, std::string>&) override {
+        // Sessions are never persisted and CONNECT user properties are not used
+    }
+
+    void setWill(const std::string& topic, const std::string& payload, int qos, bool retained) override {
+        // Kept for completeness: an in-process client cannot go away abnormally,
+        // so the Will is only published if the broker ends the session with one
+        auto will = std::make_shared<Message>();
+        will->topic = topic;
+        will->payload = payload;
+        will->qos = qos;
+        will->retain = retained;
+        std::lock_guard<std::mutex> lock(broker_->mutex_);
+        session_->will = will;
+    }
+
+private:
+    EmbeddedBroker* broker_;
+    std::shared_ptr<Session> session_;
+};
+
+static bool isWildcard(const std::string& filter) {
+    return filter.find_first_of("+#") != std::string::npos;
+}
+
+// Wildcards at the first level do not match topics starting with '$'
+static bool filterMatches(const std::string& filter, const std::string& topic) {
+    if (!topic.empty() && topic[0] == '$' && !filter.empty() && (filter[0] == '+' || filter[0] == '#')) {
+        return false;
+    }
+    return topicMatchesFilter(filter, topic);
+}
+
+// Seconds left before a message expires; false if it already has
+static bool remainingExpiry(uint32_t interval, std::chrono::steady_clock::time_point receivedAt,
+                            uint32_t& remaining) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - receivedAt).count();
+    if (elapsed >= static_cast<int64_t>(interval)) {
+        return false;
+    }
+    remaining = interval - static_cast<uint32_t>(elapsed);
+    return true;
+}
+
+EmbeddedBroker::EmbeddedBroker(const EmbeddedBrokerOptions& options)
+    : options_(options) {
+}
+
+EmbeddedBroker::~EmbeddedBroker() {
+    stop();
+}
+
+bool EmbeddedBroker::start() {
+    if (running_) {
+        return true;
+    }
+    if (ioThread_.joinable()) {
+        ioThread_.join();
+    }
+    if (deliveryThread_.joinable()) {
+        deliveryThread_.join();
+    }
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0 || timerFd_ < 0) {
+        MCP_LOG_ERROR("Failed to create epoll resources: " << std::strerror(errno));
+        closeResources();
+        return false;
+    }
+
+    if ((options_.listenTcp && !openListener(false)) ||
+        (!options_.unixSocketPath.empty() && !openListener(true))) {
+        closeResources();
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    for (int fd : {wakeFd_, timerFd_, tcpFd_, unixFd_}) {
+        if (fd >= 0) {
+            ev.data.fd = fd;
+            epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+        }
+    }
+
+    // Keep-alive and CONNECT timeouts are checked once a second
+    itimerspec spec{};
+    spec.it_value.tv_sec = 1;
+    spec.it_interval.tv_sec = 1;
+    timerfd_settime(timerFd_, 0, &spec, nullptr);
+
+    stopping_ = false;
+    running_ = true;
+    ioThread_ = std::thread([this]() {
+        tlsIoBroker = this;
+        ioLoop();
+        tlsIoBroker = nullptr;
+    });
+    deliveryThread_ = std::thread([this]() {
+        tlsDeliveryBroker = this;
+        deliveryLoop();
+        tlsDeliveryBroker = nullptr;
+    });
+
+    MCP_LOG_INFO("Embedded MQTT broker started"
+              << (tcpFd_ >= 0 ? ", tcp=" + options_.listenHost + ":" + std::to_string(boundPort_) : "")
+              << (unixFd_ >= 0 ? ", unix=" + options_.unixSocketPath : ""));
+    return true;
+}
+
+void EmbeddedBroker::stop() {
+    if (onIoThread() || onDeliveryThread()) {
+        // Cannot join ourselves; the loops exit after this iteration
+        stopping_ = true;
+        wakeIoThread();
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex_);
+        }
+        pendingLocalCv_.notify_all();
+        return;
+    }
+    if (!ioThread_.joinable()) {
+        return;
+    }
+
+    stopping_ = true;
+    wakeIoThread();
+    ioThread_.join();
+    {
+        // Under the lock, so the delivery thread cannot miss stopping_
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+    }
+    pendingLocalCv_.notify_all();
+    deliveryThread_.join();
+    running_ = false;
+    closeResources();
+
+    std::vector<std::function<void(const std::string&)>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [clientId, session] : sessions_) {
+            std::lock_guard<std::mutex> callbackLock(session->callbackMutex);
+            if (session->connectionLostCallback) {
+                callbacks.push_back(session->connectionLostCallback);
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pendingLocal_.clear();
+        pendingFlush_.clear();
+    }
+    for (const auto& callback : callbacks) {
+        callback("embedded broker stopped");
+    }
+    MCP_LOG_INFO("Embedded MQTT broker stopped");
+}
+
+bool EmbeddedBroker::isRunning() const {
+    return running_ && !stopping_;
+}
+
+uint16_t EmbeddedBroker::getPort() const {
+    return boundPort_;
+}
+
+std::unique_ptr<IMqttClient> EmbeddedBroker::createClient(const std::string& clientId) {
+    auto session = std::make_shared<Session>();
+    session->clientId = clientId;
+    session->local = true;
+    if (clientId.empty() || !registerSession(session)) {
+        MCP_LOG_ERROR("Embedded broker client ID not available: '" << clientId << "'");
+        return nullptr;
+    }
+    return std::make_unique<LocalClient>(this, session);
+}
+
+size_t EmbeddedBroker::getSessionCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sessions_.size();
+}
+
+size_t EmbeddedBroker::getRetainedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retained_.size();
+}
+
+// ---------------------------------------------------------------------------
+// Listeners and the I/O loop
+// ---------------------------------------------------------------------------
+
+bool EmbeddedBroker::openListener(bool unixSocket) {
+    int fd = -1;
+    if (unixSocket) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (options_.unixSocketPath.size() >= sizeof(addr.sun_path)) {
+            MCP_LOG_ERROR("Unix socket path too long: " << options_.unixSocketPath);
+            return false;
+        }
+        std::strncpy(addr.sun_path, options_.unixSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+        ::unlink(options_.unixSocketPath.c_str());      // Left over from a previous run
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            MCP_LOG_ERROR("Failed to bind " << options_.unixSocketPath << ": " << std::strerror(errno));
+            if (fd >= 0) ::close(fd);
+            return false;
+        }
+    } else {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        addrinfo* res = nullptr;
+        std::string port = std::to_string(options_.port);
+        const char* host = options_.listenHost.empty() ? nullptr : options_.listenHost.c_str();
+        if (getaddrinfo(host, port.c_str(), &hints, &res) != 0 || !res) {
+            MCP_LOG_ERROR("Failed to resolve listen address: " << options_.listenHost);
+            return false;
+        }
+        fd = socket(res->ai_family, res->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, res->ai_protocol);
+        int one = 1;
+        if (fd >= 0) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        }
+        if (fd < 0 || bind(fd, res->ai_addr, res->ai_addrlen) != 0) {
+            MCP_LOG_ERROR("Failed to bind " << options_.listenHost << ":" << options_.port
+                      << ": " << std::strerror(errno));
+            if (fd >= 0) ::close(fd);
+            freeaddrinfo(res);
+            return false;
+        }
+        freeaddrinfo(res);
+
+        sockaddr_storage bound{};
+        socklen_t len = sizeof(bound);
+        getsockname(fd, reinterpret_cast<sockaddr*>(&bound), &len);
+        boundPort_ = ntohs(bound.ss_family == AF_INET6
+                               ? reinterpret_cast<sockaddr_in6*>(&bound)->sin6_port
+                               : reinterpret_cast<sockaddr_in*>(&bound)->sin_port);
+    }
+
+    if (listen(fd, SOMAXCONN) != 0) {
+        MCP_LOG_ERROR("Failed to listen: " << std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    (unixSocket ? unixFd_ : tcpFd_) = fd;
+    return true;
+}
+
+void EmbeddedBroker::closeResources() {
+    for (int* fd : {&tcpFd_, &unixFd_, &epollFd_, &wakeFd_, &timerFd_}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    if (!options_.unixSocketPath.empty()) {
+        ::unlink(options_.unixSocketPath.c_str());
+    }
+}
+
+void EmbeddedBroker::ioLoop() {
+    epoll_event events[32];
+
+    while (!stopping_) {
+        int n = epoll_wait(epollFd_, events, 32, -1);
+        if (n < 0 && errno != EINTR) {
+            MCP_LOG_ERROR("Embedded broker epoll_wait failed: " << std::strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == tcpFd_ || fd == unixFd_) {
+                acceptConnections(fd);
+            } else if (fd == wakeFd_) {
+                uint64_t count;
+                ssize_t r = ::read(wakeFd_, &count, sizeof(count));
+                (void)r;
+            } else if (fd == timerFd_) {
+                uint64_t expirations;
+                ssize_t r = ::read(timerFd_, &expirations, sizeof(expirations));
+                (void)r;
+                checkKeepAlive();
+            } else {
+                auto it = connections_.find(fd);
+                if (it == connections_.end()) {
+                    continue;
+                }
+                std::shared_ptr<Session> session = it->second;
+                if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !readAvailable(session)) {
+                    closeConnection(session, session->willOnClose,
+                                    session->closeReason.empty() ? "connection closed" : session->closeReason);
+                    continue;
+                }
+                if ((events[i].events & EPOLLOUT) && !flushSession(*session)) {
+                    closeConnection(session, true, "write failed");
+                }
+            }
+        }
+
+        runPendingWork();
+    }
+
+    // Shutting down: drop remote clients without publishing their Wills
+    auto connections = std::move(connections_);
+    connections_.clear();
+    for (const auto& [fd, session] : connections) {
+        ::close(fd);
+        session->fd = -1;
+        if (session->connected) {
+            endSession(session, false);
+        }
+    }
+}
+
+void EmbeddedBroker::acceptConnections(int listenFd) {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                MCP_LOG_WARN("Embedded broker accept failed: " << std::strerror(errno));
+            }
+            return;
+        }
+        if (listenFd == tcpFd_) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        auto session = std::make_shared<Session>();
+        session->fd = fd;
+        session->lastActivity = std::chrono::steady_clock::now();
+        session->in.reserve(READ_CHUNK);
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+        connections_[fd] = session;
+    }
+}
+
+bool EmbeddedBroker::readAvailable(const std::shared_ptr<Session>& session) {
+    // Decode after every chunk, so an oversized packet is refused from its
+    // fixed header instead of being buffered first
+    std::string& in = session->in;
+    bool more = true;
+    while (more) {
+        size_t oldSize = in.size();
+        in.resize(oldSize + READ_CHUNK);
+        ssize_t n = ::read(session->fd, &in[oldSize], READ_CHUNK);
+        in.resize(oldSize + (n > 0 ? static_cast<size_t>(n) : 0));
+        if (n == 0) return false;
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            return false;
+        }
+        more = static_cast<size_t>(n) == READ_CHUNK;
+        session->lastActivity = std::chrono::steady_clock::now();
+
+        size_t offset = 0;
+        while (offset < in.size()) {
+            const char* data = in.data() + offset;
+            size_t len = in.size() - offset;
+            long size = mqtt5::packetSize(data, len);
+            if (size < 0) {
+                session->closeReason = "malformed packet";
+                return false;
+            }
+            if (static_cast<size_t>(size) > options_.maxPacketSize) {
+                session->closeReason = "packet too large";
+                return false;
+            }
+            mqtt5::Packet pkt;
+            long used = size > 0 ? mqtt5::parsePacket(data, len, pkt) : 0;
+            if (used < 0) {
+                session->closeReason = "malformed packet";
+                return false;
+            }
+            if (used == 0) break;
+            if (!dispatchPacket(session, data, static_cast<size_t>(used))) {
+                return false;
+            }
+            offset += static_cast<size_t>(used);
+        }
+        in.erase(0, offset);
+    }
+    return true;
+}
+
+bool EmbeddedBroker::dispatchPacket(const std::shared_ptr<Session>& session, const char* data, size_t len) {
+    if (!session->connected) {
+        return handleConnect(session, data, len);
+    }
+
+    mqtt5::Packet pkt;
+    mqtt5::parsePacket(data, len, pkt);
+
+    switch (pkt.type) {
+        case mqtt5::PUBLISH: {
+            mqtt5::PublishView view;
+            if (!mqtt5::decodePublish(pkt, view) || view.qos > 2) {
+                session->closeReason = "malformed PUBLISH";
+                return false;
+            }
+
+            auto message = std::make_shared<Message>();
+            if (view.properties.topicAlias) {
+                uint16_t alias = *view.properties.topicAlias;
+                if (alias == 0 || alias >= session->inboundAliases.size()) {
+                    session->closeReason = "invalid topic alias";
+                    return false;
+                }
+                if (!view.topic.empty()) {
+                    session->inboundAliases[alias].assign(view.topic.data(), view.topic.size());
+                } else if (session->inboundAliases[alias].empty()) {
+                    session->closeReason = "unknown topic alias";
+                    return false;
+                }
+                message->topic = session->inboundAliases[alias];
+            } else {
+                message->topic.assign(view.topic.data(), view.topic.size());
+            }
+            if (message->topic.empty() || isWildcard(message->topic)) {
+                session->closeReason = "invalid topic name";
+                return false;
+            }
+
+            message->payload.assign(view.payload.data(), view.payload.size());
+            message->qos = view.qos;
+            message->retain = view.retain;
+            message->messageExpiryInterval = view.properties.messageExpiryInterval.value_or(0);
+            message->receivedAt = session->lastActivity;
+            message->correlationData.assign(view.properties.correlationData.value_or(std::string_view()));
+            message->responseTopic.assign(view.properties.responseTopic.value_or(std::string_view()));
+            message->contentType.assign(view.properties.contentType.value_or(std::string_view()));
+            message->payloadFormatIndicator = view.properties.payloadFormatIndicator.value_or(0);
+            for (const auto& [key, value] : view.properties.userProperties) {
+                message->userProperties.emplace(std::string(key), std::string(value));
+            }
+
+            // A QoS 2 message is routed once, even if the client resends it
+            // before PUBREL
+            if (view.qos < 2 || session->awaitingRelease.insert(view.packetId).second) {
+                route(session.get(), message);
+            }
+
+            if (view.qos > 0) {
+                std::string ack;
+                mqtt5::encodeAck(ack, view.qos == 1 ? mqtt5::PUBACK : mqtt5::PUBREC, view.packetId);
+                queuePacket(session, ack);
+            }
+            return true;
+        }
+        case mqtt5::PUBREL: {
+            uint16_t packetId = 0;
+            uint8_t reason = 0;
+            mqtt5::decodeAck(pkt, packetId, reason);
+            session->awaitingRelease.erase(packetId);
+            std::string ack;
+            mqtt5::encodeAck(ack, mqtt5::PUBCOMP, packetId);
+            queuePacket(session, ack);
+            return true;
+        }
+        case mqtt5::PUBACK:
+        case mqtt5::PUBREC:
+        case mqtt5::PUBCOMP:
+            // Outgoing messages are not retransmitted, so acks need no tracking
+            return true;
+        case mqtt5::SUBSCRIBE: {
+            uint16_t packetId = 0;
+            std::vector<mqtt5::SubscriptionRequest> requests;
+            if (!mqtt5::decodeSubscribe(pkt, packetId, requests)) {
+                session->closeReason = "malformed SUBSCRIBE";
+                return false;
+            }
+
+            std::vector<uint8_t> reasons;
+            std::vector<std::pair<std::shared_ptr<const Message>, int>> retained;
+            for (const auto& request : requests) {
+                std::string filter(request.filter);
+                if (filter.empty() || request.qos > 2) {
+                    reasons.push_back(RC_TOPIC_FILTER_INVALID);
+                    continue;
+                }
+                if (filter.compare(0, 7, "$share/") == 0) {
+                    reasons.push_back(RC_SHARED_SUBSCRIPTIONS_NOT_SUPPORTED);
+                    continue;
+                }
+                int granted = std::min(request.qos, 1);
+                for (auto& message : subscribe(session, filter, granted, request.noLocal)) {
+                    retained.emplace_back(std::move(message), granted);
+                }
+                reasons.push_back(static_cast<uint8_t>(granted));
+            }
+
+            // SUBACK goes out before the retained messages it unlocks
+            std::string ack;
+            mqtt5::encodeSubAck(ack, mqtt5::SUBACK, packetId, reasons);
+            queuePacket(session, ack);
+            for (const auto& [message, granted] : retained) {
+                deliver(session, message, std::min(message->qos, granted), true);
+            }
+            return true;
+        }
+        case mqtt5::UNSUBSCRIBE: {
+            uint16_t packetId = 0;
+            std::vector<std::string_view> filters;
+            if (!mqtt5::decodeUnsubscribe(pkt, packetId, filters)) {
+                session->closeReason = "malformed UNSUBSCRIBE";
+                return false;
+            }
+            std::vector<uint8_t> reasons;
+            for (std::string_view filter : filters) {
+                reasons.push_back(unsubscribe(session, std::string(filter)) ? RC_SUCCESS
+                                                                            : RC_NO_SUBSCRIPTION_EXISTED);
+            }
+            std::string ack;
+            mqtt5::encodeSubAck(ack, mqtt5::UNSUBACK, packetId, reasons);
+            queuePacket(session, ack);
+            return true;
+        }
+        case mqtt5::PINGREQ: {
+            std::string pong;
+            mqtt5::encodePingResp(pong);
+            queuePacket(session, pong);
+            return true;
+        }
+        case mqtt5::DISCONNECT: {
+            uint8_t reason = pkt.body.empty() ? RC_SUCCESS : static_cast<uint8_t>(pkt.body[0]);
+            session->willOnClose = reason == RC_DISCONNECT_WITH_WILL;
+            session->closeReason = "client disconnected";
+            return false;
+        }
+        default:
+            session->closeReason = "unexpected packet type " + std::to_string(pkt.type);
+            return false;
+    }
+}
+
+bool EmbeddedBroker::handleConnect(const std::shared_ptr<Session>& session, const char* data, size_t len) {
+    session->willOnClose = false;   // Nothing to publish until CONNECT is accepted
+
+    mqtt5::Packet pkt;
+    mqtt5::parsePacket(data, len, pkt);
+    mqtt5::ConnectView view;
+    if (pkt.type != mqtt5::CONNECT || !mqtt5::decodeConnect(pkt, view)) {
+        session->closeReason = "expected CONNECT";
+        return false;
+    }
+
+    auto reject = [&](uint8_t reasonCode, const char* reason) {
+        std::string ack;
+        mqtt5::encodeConnack(ack, reasonCode, 0, {});
+        queuePacket(session, ack);
+        flushSession(*session);
+        session->closeReason = reason;
+        return false;
+    };
+
+    if (view.protocolVersion != 5) {
+        return reject(RC_UNSUPPORTED_PROTOCOL_VERSION, "unsupported protocol version");
+    }
+
+    std::string clientId(view.clientId);
+    std::string assignedId;
+    if (clientId.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        assignedId = "mcp-broker-" + std::to_string(++nextAssignedId_);
+        clientId = assignedId;
+    }
+
+    // A new connection with the same client ID takes over the old one
+    std::shared_ptr<Session> existing;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sessions_.find(clientId);
+        if (it != sessions_.end()) {
+            existing = it->second;
+        }
+    }
+    if (existing) {
+        if (existing->local) {
+            return reject(RC_CLIENT_ID_NOT_VALID, "client ID in use by an in-process client");
+        }
+        closeConnection(existing, true, "session taken over");
+    }
+
+    session->clientId = clientId;
+    session->keepAlive = view.keepAlive;
+    session->inboundAliases.assign(static_cast<size_t>(options_.topicAliasMaximum) + 1, std::string());
+    if (view.hasWill) {
+        auto will = std::make_shared<Message>();
+        will->topic.assign(view.willTopic.data(), view.willTopic.size());
+        will->payload.assign(view.willPayload.data(), view.willPayload.size());
+        will->qos = view.willQos;
+        will->retain = view.willRetain;
+        will->messageExpiryInterval = view.willProperties.messageExpiryInterval.value_or(0);
+        will->correlationData.assign(view.willProperties.correlationData.value_or(std::string_view()));
+        will->responseTopic.assign(view.willProperties.responseTopic.value_or(std::string_view()));
+        will->contentType.assign(view.willProperties.contentType.value_or(std::string_view()));
+        will->payloadFormatIndicator = view.willProperties.payloadFormatIndicator.value_or(0);
+        for (const auto& [key, value] : view.willProperties.userProperties) {
+            will->userProperties.emplace(std::string(key), std::string(value));
+        }
+        session->will = will;
+    }
+
+    if (!registerSession(session)) {
+        return reject(RC_CLIENT_ID_NOT_VALID, "client ID in use");
+    }
+    session->connected = true;
+    session->willOnClose = true;
+
+    std::string ack;
+    mqtt5::encodeConnack(ack, RC_SUCCESS, options_.topicAliasMaximum, assignedId);
+    queuePacket(session, ack);
+    MCP_LOG_INFO("Embedded broker: client connected: " << clientId);
+    return true;
+}
+
+void EmbeddedBroker::queuePacket(const std::shared_ptr<Session>& session, const std::string& packet) {
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(session->outMutex);
+        first = session->out.empty();
+        session->out.append(packet);
+    }
+    if (first) {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pendingFlush_.push_back(session);
+    }
+    wakeIoThread();
+}
+
+bool EmbeddedBroker::flushSession(Session& session) {
+    if (session.fd < 0) {
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(session.outMutex);
+        if (!session.out.empty()) {
+            session.sending.append(session.out);
+            session.out.clear();
+        }
+    }
+    if (session.sending.size() - session.sendOffset > options_.maxQueuedBytes) {
+        MCP_LOG_WARN("Embedded broker: dropping slow client " << session.clientId);
+        return false;
+    }
+
+    while (session.sendOffset < session.sending.size()) {
+        ssize_t n = ::write(session.fd, session.sending.data() + session.sendOffset,
+                            session.sending.size() - session.sendOffset);
+        if (n > 0) {
+            session.sendOffset += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        return false;
+    }
+
+    bool pending = session.sendOffset < session.sending.size();
+    if (!pending) {
+        session.sending.clear();
+        session.sendOffset = 0;
+    }
+    // Poll for writability only while a partial write is pending
+    if (pending != session.wantWrite) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | (pending ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.fd = session.fd;
+        epoll_ctl(epollFd_, EPOLL_CTL_MOD, session.fd, &ev);
+        session.wantWrite = pending;
+    }
+    return true;
+}
+
+void EmbeddedBroker::checkKeepAlive() {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<Session>> expired;
+    for (const auto& [fd, session] : connections_) {
+        if (session->connected) {
+            // MQTT allows one and a half keep-alive periods of silence
+            if (session->keepAlive > 0 &&
+                now - session->lastActivity > std::chrono::milliseconds(session->keepAlive * 1500)) {
+                expired.push_back(session);
+            }
+        } else if (now - session->lastActivity > options_.connectTimeout) {
+            expired.push_back(session);
+        }
+    }
+    for (const auto& session : expired) {
+        closeConnection(session, true, "keep-alive timeout");
+    }
+}
+
+void EmbeddedBroker::closeConnection(const std::shared_ptr<Session>& session, bool publishWill,
+                                     const std::string& reason) {
+    if (session->fd < 0) {
+        return;
+    }
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, session->fd, nullptr);
+    ::close(session->fd);
+    connections_.erase(session->fd);
+    session->fd = -1;
+
+    if (session->connected) {
+        MCP_LOG_INFO("Embedded broker: client " << session->clientId << " disconnected: " << reason);
+        endSession(session, publishWill);
+    }
+}
+
+void EmbeddedBroker::runPendingWork() {
+    // A failed write publishes a Will, which may queue more; keep going until nothing is left
+    while (true) {
+        std::vector<std::shared_ptr<Session>> flush;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex_);
+            flush.swap(pendingFlush_);
+        }
+        if (flush.empty()) {
+            return;
+        }
+
+        for (const auto& session : flush) {
+            if (session->fd >= 0 && !flushSession(*session)) {
+                closeConnection(session, true, "write failed");
+            }
+        }
+    }
+}
+
+void EmbeddedBroker::deliveryLoop() {
+    std::deque<LocalDelivery> local;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(pendingMutex_);
+            pendingLocalCv_.wait(lock, [this]() { return stopping_ || !pendingLocal_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            local.swap(pendingLocal_);
+        }
+        // Handlers may publish again; that only queues
+        for (const auto& delivery : local) {
+            deliverLocal(delivery);
+        }
+        local.clear();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Sessions, subscriptions and routing
+// ---------------------------------------------------------------------------
+
+bool EmbeddedBroker::registerSession(const std::shared_ptr<Session>& session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sessions_.emplace(session->clientId, session).second;
+}
+
+void EmbeddedBroker::endSession(const std::shared_ptr<Session>& session, bool publishWill) {
+    std::shared_ptr<const Message> will;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (session->closed.exchange(true)) {
+            return;
+        }
+        removeSubscriptions(*session);
+        auto it = sessions_.find(session->clientId);
+        if (it != sessions_.end() && it->second == session) {
+            sessions_.erase(it);
+        }
+        will = std::move(session->will);
+    }
+    if (publishWill && will) {
+        auto message = std::make_shared<Message>(*will);
+        message->receivedAt = std::chrono::steady_clock::now();
+        route(session.get(), message);
+    }
+}
+
+std::vector<std::shared_ptr<const EmbeddedBroker::Message>> EmbeddedBroker::subscribe(
+    const std::shared_ptr<Session>& session, const std::string& filter, int qos, bool noLocal) {
+    std::vector<std::shared_ptr<const Message>> retained;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (session->closed) {
+        return retained;
+    }
+    session->filters[filter] = {qos, noLocal};
+
+    Subscriber subscriber{session, qos, noLocal};
+    if (isWildcard(filter)) {
+        auto it = std::find_if(wildcardSubscriptions_.begin(), wildcardSubscriptions_.end(),
+                               [&](const auto& entry) {
+                                   return entry.second.session == session && entry.first == filter;
+                               });
+        if (it != wildcardSubscriptions_.end()) {
+            it->second = subscriber;
+        } else {
+            wildcardSubscriptions_.emplace_back(filter, subscriber);
+        }
+        for (const auto& [topic, message] : retained_) {
+            if (filterMatches(filter, topic)) {
+                retained.push_back(message);
+            }
+        }
+    } else {
+        auto& subscribers = exactSubscriptions_[filter];
+        auto it = std::find_if(subscribers.begin(), subscribers.end(),
+                               [&](const Subscriber& s) { return s.session == session; });
+        if (it != subscribers.end()) {
+            *it = subscriber;
+        } else {
+            subscribers.push_back(subscriber);
+        }
+        auto found = retained_.find(filter);
+        if (found != retained_.end()) {
+            retained.push_back(found->second);
+        }
+    }
+    return retained;
+}
+
+bool EmbeddedBroker::unsubscribe(const std::shared_ptr<Session>& session, const std::string& filter) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (session->filters.erase(filter) == 0) {
+        return false;
+    }
+    if (isWildcard(filter)) {
+        wildcardSubscriptions_.erase(
+            std::remove_if(wildcardSubscriptions_.begin(), wildcardSubscriptions_.end(),
+                           [&](const auto& entry) {
+                               return entry.second.session == session && entry.first == filter;
+                           }),
+            wildcardSubscriptions_.end());
+    } else {
+        auto it = exactSubscriptions_.find(filter);
+        if (it != exactSubscriptions_.end()) {
+            auto& subscribers = it->second;
+            subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+                                             [&](const Subscriber& s) { return s.session == session; }),
+                              subscribers.end());
+            if (subscribers.empty()) {
+                exactSubscriptions_.erase(it);
+            }
+        }
+    }
+    return true;
+}
+
+void EmbeddedBroker::removeSubscriptions(Session& session) {
+    // Caller holds mutex_
+    for (const auto& [filter, options] : session.filters) {
+        if (isWildcard(filter)) {
+            wildcardSubscriptions_.erase(
+                std::remove_if(wildcardSubscriptions_.begin(), wildcardSubscriptions_.end(),
+                               [&](const auto& entry) {
+                                   return entry.second.session.get() == &session && entry.first == filter;
+                               }),
+                wildcardSubscriptions_.end());
+            continue;
+        }
+        auto it = exactSubscriptions_.find(filter);
+        if (it == exactSubscriptions_.end()) {
+            continue;
+        }
+        auto& subscribers = it->second;
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+                                         [&](const Subscriber& s) { return s.session.get() == &session; }),
+                          subscribers.end());
+        if (subscribers.empty()) {
+            exactSubscriptions_.erase(it);
+        }
+    }
+    session.filters.clear();
+}
+
+void EmbeddedBroker::route(const Session* from, const std::shared_ptr<const Message>& message) {
+    std::vector<Subscriber> targets;
+
+    // One delivery per session, at the highest QoS of its matching subscriptions
+    auto addTarget = [&](const Subscriber& subscriber) {
+        if (subscriber.noLocal && subscriber.session.get() == from) {
+            return;
+        }
+        for (auto& target : targets) {
+            if (target.session == subscriber.session) {
+                target.qos = std::max(target.qos, subscriber.qos);
+                return;
+            }
+        }
+        targets.push_back(subscriber);
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (message->retain) {
+            if (message->payload.empty()) {
+                retained_.erase(message->topic);
+            } else {
+                retained_[message->topic] = message;
+            }
+        }
+
+        auto it = exactSubscriptions_.find(message->topic);
+        if (it != exactSubscriptions_.end()) {
+            for (const auto& subscriber : it->second) {
+                addTarget(subscriber);
+            }
+        }
+        for (const auto& [filter, subscriber] : wildcardSubscriptions_) {
+            if (filterMatches(filter, message->topic)) {
+                addTarget(subscriber);
+            }
+        }
+    }
+
+    for (const auto& target : targets) {
+        deliver(target.session, message, std::min(message->qos, target.qos), false);
+    }
+}
+
+void EmbeddedBroker::deliver(const std::shared_ptr<Session>& session, const std::shared_ptr<const Message>& message,
+                             int qos, bool retained) {
+    if (session->closed) {
+        return;
+    }
+
+    if (session->local) {
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex_);
+            pendingLocal_.push_back(LocalDelivery{session, message, qos, retained});
+        }
+        pendingLocalCv_.notify_one();
+        return;
+    }
+
+    mqtt5::PublishPacket publish;
+    publish.topic = message->topic;
+    publish.payload = message->payload;
+    publish.qos = qos;
+    publish.retain = retained;
+    if (message->messageExpiryInterval > 0 &&
+        !remainingExpiry(message->messageExpiryInterval, message->receivedAt, publish.messageExpiryInterval)) {
+        return;
+    }
+    publish.payloadFormatIndicator = message->payloadFormatIndicator;
+    publish.contentType = message->contentType;
+    publish.responseTopic = message->responseTopic;
+    publish.correlationData = message->correlationData;
+    publish.userProperties = message->userProperties.empty() ? nullptr : &message->userProperties;
+
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(session->outMutex);
+        if (qos > 0) {
+            if (++session->nextPacketId == 0) session->nextPacketId = 1;
+            publish.packetId = session->nextPacketId;
+        }
+        first = session->out.empty();
+        mqtt5::encodePublish(session->out, publish);
+    }
+    if (first) {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pendingFlush_.push_back(session);
+    }
+    wakeIoThread();
+}
+
+void EmbeddedBroker::deliverLocal(const LocalDelivery& delivery) {
+    const Session& session = *delivery.session;
+    const Message& message = *delivery.message;
+    uint32_t remaining = 0;
+    if (session.closed ||
+        (message.messageExpiryInterval > 0 &&
+         !remainingExpiry(message.messageExpiryInterval, message.receivedAt, remaining))) {
+        return;
+    }
+
+    MqttMessageHandler handler;
+    {
+        std::lock_guard<std::mutex> lock(delivery.session->callbackMutex);
+        handler = session.handler;
+    }
+    if (!handler) {
+        return;
+    }
+
+    MqttIncomingMessage incoming;
+    incoming.topic = message.topic;
+    incoming.payload = message.payload;
+    incoming.qos = delivery.qos;
+    incoming.retained = delivery.retained;
+    incoming.userProperties = message.userProperties;
+    if (message.messageExpiryInterval > 0) {
+        incoming.messageExpiryInterval = remaining;     // Less the time the broker held it
+    }
+    incoming.correlationData = message.correlationData;
+    incoming.responseTopic = message.responseTopic;
+    incoming.contentType = message.contentType;
+    incoming.payloadFormatIndicator = message.payloadFormatIndicator;
+    handler(incoming);
+}
+
+void EmbeddedBroker::wakeIoThread() {
+    // The I/O thread runs pending work after each iteration; others must wake it
+    if (!onIoThread() && wakeFd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t n = ::write(wakeFd_, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+bool EmbeddedBroker::onIoThread() const {
+    return tlsIoBroker == this;
+}
+
+bool EmbeddedBroker::onDeliveryThread() const {
+    return tlsDeliveryBroker == this;
+}
+
+} // namespace mcp_mqtt
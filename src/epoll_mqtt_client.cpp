@@ -0,0 +1,877 @@
+#include "mcp_mqtt/epoll_mqtt_client.h"
+#include "mcp_mqtt/logger.h"
+#include "mqtt5_codec.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace mcp_mqtt {
+
+static constexpr size_t READ_CHUNK = 64 * 1024;
+static constexpr int MAX_IOV = 64;
+static constexpr size_t GATHER_PAYLOAD_MIN = 4 * 1024;     // Larger payloads are not packed
+
+static thread_local const EpollMqttClient* tlsIoClient = nullptr;
+
+static int remainingMs(std::chrono::steady_clock::time_point deadline) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    return left > 0 ? static_cast<int>(left) : 0;
+}
+
+EpollMqttClient::EpollMqttClient(const std::string& clientId, const EpollMqttClientOptions& options)
+    : clientId_(clientId), options_(options) {
+    // Only the I/O thread touches these; size once so receives do not reallocate
+    inBuffer_.resize(READ_CHUNK);
+    outQueue_.emplace_back();
+    inboundAliases_.resize(static_cast<size_t>(options_.topicAliasMaximum) + 1);
+}
+
+EpollMqttClient::~EpollMqttClient() {
+    disconnect();
+    if (epollFd_ >= 0) ::close(epollFd_);
+    if (wakeFd_ >= 0) ::close(wakeFd_);
+    if (timerFd_ >= 0) ::close(timerFd_);
+}
+
+bool EpollMqttClient::connect() {
+    if (connected_) {
+        return true;
+    }
+    if (ioThread_.joinable()) {
+        ioThread_.join();
+    }
+
+    resetOutgoing();
+    if (!openSocket() || !handshake()) {
+        closeSocket();
+        return false;
+    }
+
+    if (epollFd_ < 0) {
+        epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (epollFd_ < 0 || wakeFd_ < 0 || timerFd_ < 0) {
+            MCP_LOG_ERROR("Failed to create epoll resources: " << std::strerror(errno));
+            closeSocket();
+            return false;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = wakeFd_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+        ev.data.fd = timerFd_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, timerFd_, &ev);
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = sockFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, sockFd_, &ev);
+
+    if (options_.keepAliveSeconds > 0) {
+        itimerspec spec{};
+        spec.it_value.tv_sec = options_.keepAliveSeconds;
+        spec.it_interval.tv_sec = options_.keepAliveSeconds;
+        timerfd_settime(timerFd_, 0, &spec, nullptr);
+    }
+
+    stopping_ = false;
+    connected_ = true;
+    startIoThread();
+    MCP_LOG_INFO("Connected to MQTT broker: clientId=" << clientId_);
+    return true;
+}
+
+void EpollMqttClient::disconnect() {
+    if (onIoThread()) {
+        // Cannot join ourselves; the loop flushes DISCONNECT and exits
+        stopping_ = true;
+        std::string packet;
+        mqtt5::encodeDisconnect(packet);
+        enqueue(packet);
+        return;
+    }
+
+    if (ioThread_.joinable()) {
+        stopping_ = true;
+        if (connected_) {
+            std::string packet;
+            mqtt5::encodeDisconnect(packet);
+            enqueue(packet);
+        }
+        wakeIoThread();
+        ioThread_.join();
+    }
+    closeSocket();
+}
+
+uint16_t EpollMqttClient::getBrokerTopicAliasMaximum() const {
+    return brokerTopicAliasMaximum_;
+}
+
+bool EpollMqttClient::isConnected() const {
+    return connected_;
+}
+
+bool EpollMqttClient::subscribe(const std::string& topic, int qos, bool noLocal) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptions_[topic] = {qos, noLocal};
+    }
+    if (!connected_) {
+        return false;
+    }
+    std::string packet;
+    {
+        std::lock_guard<std::mutex> lock(outMutex_);
+        mqtt5::encodeSubscribe(packet, allocatePacketId(), topic, qos, noLocal);
+    }
+    enqueue(packet);
+    return true;
+}
+
+bool EpollMqttClient::unsubscribe(const std::string& topic) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptions_.erase(topic);
+    }
+    if (!connected_) {
+        return false;
+    }
+    std::string packet;
+    {
+        std::lock_guard<std::mutex> lock(outMutex_);
+        mqtt5::encodeUnsubscribe(packet, allocatePacketId(), topic);
+    }
+    enqueue(packet);
+    return true;
+}
+
+bool EpollMqttClient::publish(const std::string& topic,
+                              const std::string& payload,
+                              int qos,
+                              bool retained,
+                              const std::map<std::string, std::string>& userProps) {
+    mqtt5::PublishPacket publish;
+    publish.userProperties = userProps.empty() ? nullptr : &userProps;
+    return enqueuePublish(topic, payload, qos, retained, publish, 0);
+}
+
+bool EpollMqttClient::publishWithProperties(const std::string& topic,
+                                            const std::string& payload,
+                                            int qos,
+                                            bool retained,
+                                            const MqttPublishProperties& properties) {
+    mqtt5::PublishPacket publish;
+    publish.userProperties = properties.userProperties.empty() ? nullptr : &properties.userProperties;
+    publish.messageExpiryInterval = properties.messageExpiryInterval;
+    publish.payloadFormatIndicator = properties.payloadFormatIndicator;
+    publish.contentType = properties.contentType;
+    publish.responseTopic = properties.responseTopic;
+    publish.correlationData = properties.correlationData;
+    return enqueuePublish(topic, payload, qos, retained, publish, properties.topicAlias);
+}
+
+uint16_t EpollMqttClient::getTopicAliasMaximum() const {
+    return brokerTopicAliasMaximum_;
+}
+
+bool EpollMqttClient::enqueuePublish(const std::string& topic, const std::string& payload,
+                                     int qos, bool retained,
+                                     mqtt5::PublishPacket& publish, uint16_t topicAlias) {
+    if (!connected_) {
+        return false;
+    }
+
+    publish.topic = topic;
+    publish.payload = payload;
+    publish.qos = qos;
+    publish.retain = retained;
+
+    {
+        std::lock_guard<std::mutex> lock(outMutex_);
+        if (qos > 0) {
+            publish.packetId = allocatePacketId();
+        }
+        // The broker's maximum may have shrunk on reconnect; publish in full then
+        if (topicAlias > 0 && topicAlias <= brokerTopicAliasMaximum_) {
+            if (outboundAliases_.size() <= topicAlias) {
+                outboundAliases_.resize(static_cast<size_t>(topicAlias) + 1);
+            }
+            if (outboundAliases_[topicAlias] == topic) {
+                publish.topic = std::string_view();
+            } else {
+                outboundAliases_[topicAlias] = topic;
+            }
+            publish.topicAlias = topicAlias;
+        }
+        if (publish.payload.size() >= GATHER_PAYLOAD_MIN) {
+            mqtt5::encodePublishHeader(outQueue_.back(), publish);
+            outQueue_.emplace_back(payload);
+            outQueue_.emplace_back();
+        } else {
+            mqtt5::encodePublish(outQueue_.back(), publish);
+        }
+    }
+    wakeIoThread();
+    return true;
+}
+
+std::string EpollMqttClient::getClientId() const {
+    return clientId_;
+}
+
+void EpollMqttClient::setMessageHandler(MqttMessageHandler handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    messageHandler_ = handler;
+}
+
+void EpollMqttClient::setConnectionLostCallback(std::function<void(const std::string&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connectionLostCallback_ = callback;
+}
+
+bool EpollMqttClient::setConnectionRestoredCallback(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connectionRestoredCallback_ = callback;
+    return true;
+}
+
+void EpollMqttClient::setConnectProperties(uint32_t sessionExpiryInterval,
+                                           const std::map<std::string, std::string>& userProperties) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sessionExpiryInterval_ = sessionExpiryInterval;
+    connectUserProperties_ = userProperties;
+}
+
+void EpollMqttClient::setWill(const std::string& topic, const std::string& payload,
+                              int qos, bool retained) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hasWill_ = true;
+        willTopic_ = topic;
+        willPayload_ = payload;
+        willQos_ = qos;
+        willRetained_ = retained;
+    }
+
+    // The I/O thread flushes what is queued, reconnects with the new Will and
+    // restores subscriptions; callers never block on it
+    if (connected_) {
+        reconnectRequested_ = true;
+        wakeIoThread();
+    }
+}
+
+bool EpollMqttClient::openSocket() {
+    auto deadline = std::chrono::steady_clock::now() + options_.connectTimeout;
+    int fd = -1;
+    int rc = -1;
+
+    if (!options_.unixSocketPath.empty()) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (options_.unixSocketPath.size() >= sizeof(addr.sun_path)) {
+            MCP_LOG_ERROR("Unix socket path too long: " << options_.unixSocketPath);
+            return false;
+        }
+        std::strncpy(addr.sun_path, options_.unixSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd >= 0) {
+            rc = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        }
+    } else {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* res = nullptr;
+        std::string port = std::to_string(options_.port);
+        if (getaddrinfo(options_.host.c_str(), port.c_str(), &hints, &res) != 0 || !res) {
+            MCP_LOG_ERROR("Failed to resolve broker host: " << options_.host);
+            return false;
+        }
+        fd = socket(res->ai_family, res->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, res->ai_protocol);
+        if (fd >= 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            rc = ::connect(fd, res->ai_addr, res->ai_addrlen);
+        }
+        freeaddrinfo(res);
+    }
+
+    if (fd < 0) {
+        MCP_LOG_ERROR("Failed to create socket: " << std::strerror(errno));
+        return false;
+    }
+
+    if (rc != 0 && errno == EINPROGRESS) {
+        pollfd pfd{fd, POLLOUT, 0};
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (poll(&pfd, 1, remainingMs(deadline)) == 1 &&
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) {
+            rc = 0;
+        } else {
+            errno = err ? err : ETIMEDOUT;
+        }
+    }
+    if (rc != 0) {
+        MCP_LOG_ERROR("Failed to connect to broker: " << std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    sockFd_ = fd;
+    return true;
+}
+
+bool EpollMqttClient::handshake() {
+    auto deadline = std::chrono::steady_clock::now() + options_.connectTimeout;
+
+    mqtt5::ConnectPacket connect;
+    connect.clientId = clientId_;
+    connect.keepAlive = options_.keepAliveSeconds;
+    connect.topicAliasMaximum = options_.topicAliasMaximum;
+    connect.maximumPacketSize = static_cast<uint32_t>(
+        std::min<size_t>(options_.maxPacketSize, UINT32_MAX));
+    connect.username = options_.username;
+    connect.password = options_.password;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connect.sessionExpiryInterval = sessionExpiryInterval_;
+        connect.userProperties = connectUserProperties_;
+        connect.hasWill = hasWill_;
+        connect.willTopic = willTopic_;
+        connect.willPayload = willPayload_;
+        connect.willQos = willQos_;
+        connect.willRetain = willRetained_;
+    }
+
+    std::string packet;
+    mqtt5::encodeConnect(packet, connect);
+    size_t written = 0;
+    while (written < packet.size()) {
+        ssize_t n = ::write(sockFd_, packet.data() + written, packet.size() - written);
+        if (n > 0) {
+            written += static_cast<size_t>(n);
+            continue;
+        }
+        pollfd pfd{sockFd_, POLLOUT, 0};
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            MCP_LOG_ERROR("Failed to send CONNECT: " << std::strerror(errno));
+            return false;
+        }
+        if (poll(&pfd, 1, remainingMs(deadline)) <= 0) {
+            MCP_LOG_ERROR("Timed out sending CONNECT");
+            return false;
+        }
+    }
+
+    inFill_ = 0;
+    while (true) {
+        long size = mqtt5::packetSize(inBuffer_.data(), inFill_);
+        if (!checkPacketSize(size)) {
+            return false;
+        }
+        if (static_cast<size_t>(size) > inBuffer_.size()) {
+            inBuffer_.resize(static_cast<size_t>(size));
+        }
+        mqtt5::Packet pkt;
+        long used = mqtt5::parsePacket(inBuffer_.data(), inFill_, pkt);
+        if (used < 0) {
+            MCP_LOG_ERROR("Malformed packet during handshake");
+            return false;
+        }
+        if (used > 0) {
+            mqtt5::ConnackView connack;
+            if (!mqtt5::decodeConnack(pkt, connack)) {
+                MCP_LOG_ERROR("Expected CONNACK, got packet type " << static_cast<int>(pkt.type));
+                return false;
+            }
+            if (connack.reasonCode != 0) {
+                MCP_LOG_ERROR("Broker refused connection: reason=0x" << std::hex
+                          << static_cast<int>(connack.reasonCode) << std::dec);
+                return false;
+            }
+            brokerTopicAliasMaximum_ = connack.properties.topicAliasMaximum.value_or(0);
+            consumeInput(static_cast<size_t>(used));
+            return true;
+        }
+
+        pollfd pfd{sockFd_, POLLIN, 0};
+        if (poll(&pfd, 1, remainingMs(deadline)) <= 0) {
+            MCP_LOG_ERROR("Timed out waiting for CONNACK");
+            return false;
+        }
+        ssize_t n = ::read(sockFd_, inBuffer_.data() + inFill_, inBuffer_.size() - inFill_);
+        if (n <= 0 && !(n < 0 && (errno == EAGAIN || errno == EINTR))) {
+            MCP_LOG_ERROR("Connection closed during handshake");
+            return false;
+        }
+        if (n > 0) {
+            inFill_ += static_cast<size_t>(n);
+        }
+    }
+}
+
+void EpollMqttClient::closeSocket() {
+    if (sockFd_ >= 0) {
+        if (epollFd_ >= 0) {
+            epoll_ctl(epollFd_, EPOLL_CTL_DEL, sockFd_, nullptr);
+        }
+        ::close(sockFd_);
+        sockFd_ = -1;
+    }
+    connected_ = false;
+}
+
+void EpollMqttClient::startIoThread() {
+    ioThread_ = std::thread([this]() {
+        tlsIoClient = this;
+        ioLoop();
+        tlsIoClient = nullptr;
+    });
+}
+
+void EpollMqttClient::ioLoop() {
+    epoll_event events[8];
+    bool wantWrite = false;
+
+    while (true) {
+        int n = epoll_wait(epollFd_, events, 8, -1);
+        if (n < 0 && errno != EINTR) {
+            handleConnectionLost(std::string("epoll_wait failed: ") + std::strerror(errno));
+            return;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == sockFd_) {
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    if (!readAvailable()) {
+                        handleConnectionLost("connection closed by broker");
+                        return;
+                    }
+                }
+            } else if (fd == wakeFd_) {
+                uint64_t count;
+                ssize_t r = ::read(wakeFd_, &count, sizeof(count));
+                (void)r;
+            } else if (fd == timerFd_) {
+                uint64_t expirations;
+                ssize_t r = ::read(timerFd_, &expirations, sizeof(expirations));
+                (void)r;
+                if (pingOutstanding_) {
+                    handleConnectionLost("keep-alive timeout");
+                    return;
+                }
+                std::string ping;
+                mqtt5::encodePingReq(ping);
+                enqueue(ping);
+                pingOutstanding_ = true;
+            }
+        }
+
+        if (!flushOutgoing()) {
+            handleConnectionLost(std::string("write failed: ") + std::strerror(errno));
+            return;
+        }
+
+        if (stopping_) {
+            closeSocket();
+            return;
+        }
+
+        if (reconnectRequested_.exchange(false)) {
+            if (!reconnectInPlace()) {
+                handleConnectionLost("reconnect failed");
+                return;
+            }
+            // The new socket is registered for EPOLLIN only, and nothing
+            // wakes us for the restored subscriptions
+            wantWrite = false;
+            if (!flushOutgoing()) {
+                handleConnectionLost(std::string("write failed: ") + std::strerror(errno));
+                return;
+            }
+        }
+
+        // Poll for writability only while a partial write is pending
+        bool pending = !sending_.empty();
+        if (pending != wantWrite && sockFd_ >= 0) {
+            epoll_event ev{};
+            ev.events = EPOLLIN | (pending ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+            ev.data.fd = sockFd_;
+            epoll_ctl(epollFd_, EPOLL_CTL_MOD, sockFd_, &ev);
+            wantWrite = pending;
+        }
+    }
+}
+
+bool EpollMqttClient::readAvailable() {
+    // Decode after every read, so an oversized packet is refused from its
+    // fixed header instead of being buffered first
+    bool more = true;
+    while (more) {
+        size_t space = inBuffer_.size() - inFill_;
+        ssize_t n = ::read(sockFd_, inBuffer_.data() + inFill_, space);
+        if (n == 0) return false;
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            return false;
+        }
+        inFill_ += static_cast<size_t>(n);
+        more = static_cast<size_t>(n) == space;
+
+        // Decode every complete packet in place
+        size_t offset = 0;
+        while (offset < inFill_) {
+            const char* data = inBuffer_.data() + offset;
+            size_t len = inFill_ - offset;
+            long size = mqtt5::packetSize(data, len);
+            if (!checkPacketSize(size)) {
+                return false;
+            }
+            if (static_cast<size_t>(size) > len) {
+                // Make room for the rest of a packet larger than the buffer
+                if (static_cast<size_t>(size) > inBuffer_.size()) {
+                    inBuffer_.resize(static_cast<size_t>(size));
+                }
+                break;
+            }
+            if (size == 0) break;
+            mqtt5::Packet pkt;
+            if (mqtt5::parsePacket(data, len, pkt) <= 0 ||
+                !dispatchPacket(data, static_cast<size_t>(size))) {
+                return false;
+            }
+            offset += static_cast<size_t>(size);
+        }
+        consumeInput(offset);
+    }
+    return true;
+}
+
+bool EpollMqttClient::checkPacketSize(long size) {
+    if (size < 0) {
+        MCP_LOG_ERROR("Malformed packet from broker");
+        return false;
+    }
+    if (static_cast<size_t>(size) > options_.maxPacketSize) {
+        MCP_LOG_ERROR("Packet from broker exceeds maximum size: " << size << " > " << options_.maxPacketSize);
+        return false;
+    }
+    return true;
+}
+
+void EpollMqttClient::consumeInput(size_t used) {
+    if (used > 0) {
+        std::memmove(inBuffer_.data(), inBuffer_.data() + used, inFill_ - used);
+        inFill_ -= used;
+    }
+}
+
+bool EpollMqttClient::dispatchPacket(const char* data, size_t len) {
+    mqtt5::Packet pkt;
+    mqtt5::parsePacket(data, len, pkt);
+
+    switch (pkt.type) {
+        case mqtt5::PUBLISH: {
+            mqtt5::PublishView view;
+            if (!mqtt5::decodePublish(pkt, view)) {
+                MCP_LOG_ERROR("Malformed PUBLISH from broker");
+                return false;
+            }
+
+            // Resolve broker-assigned topic aliases
+            if (view.properties.topicAlias) {
+                uint16_t alias = *view.properties.topicAlias;
+                if (alias == 0 || alias >= inboundAliases_.size()) {
+                    MCP_LOG_ERROR("Invalid topic alias from broker: " << alias);
+                    return false;
+                }
+                if (!view.topic.empty()) {
+                    inboundAliases_[alias].assign(view.topic.data(), view.topic.size());
+                } else if (inboundAliases_[alias].empty()) {
+                    MCP_LOG_ERROR("Unknown topic alias from broker: " << alias);
+                    return false;
+                }
+                incoming_.topic = inboundAliases_[alias];
+            } else {
+                incoming_.topic.assign(view.topic.data(), view.topic.size());
+            }
+            incoming_.payload.assign(view.payload.data(), view.payload.size());
+            incoming_.qos = view.qos;
+            incoming_.retained = view.retain;
+            incoming_.messageExpiryInterval = view.properties.messageExpiryInterval;
+            incoming_.correlationData.assign(view.properties.correlationData.value_or(std::string_view()));
+            incoming_.responseTopic.assign(view.properties.responseTopic.value_or(std::string_view()));
+            incoming_.contentType.assign(view.properties.contentType.value_or(std::string_view()));
+            incoming_.payloadFormatIndicator = view.properties.payloadFormatIndicator.value_or(0);
+            incoming_.topicAlias = view.properties.topicAlias.value_or(0);
+            incoming_.userProperties.clear();
+            for (const auto& [key, value] : view.properties.userProperties) {
+                incoming_.userProperties.emplace(std::string(key), std::string(value));
+            }
+
+            MqttMessageHandler handler;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                handler = messageHandler_;
+            }
+            if (handler) {
+                handler(incoming_);
+            }
+
+            if (view.qos == 1) {
+                std::string ack;
+                mqtt5::encodeAck(ack, mqtt5::PUBACK, view.packetId);
+                enqueue(ack);
+            } else if (view.qos == 2) {
+                std::string ack;
+                mqtt5::encodeAck(ack, mqtt5::PUBREC, view.packetId);
+                enqueue(ack);
+            }
+            return true;
+        }
+        case mqtt5::PUBREC:
+        case mqtt5::PUBREL: {
+            uint16_t packetId = 0;
+            uint8_t reason = 0;
+            mqtt5::decodeAck(pkt, packetId, reason);
+            std::string ack;
+            mqtt5::encodeAck(ack, pkt.type == mqtt5::PUBREC ? mqtt5::PUBREL : mqtt5::PUBCOMP, packetId);
+            enqueue(ack);
+            return true;
+        }
+        case mqtt5::PUBACK:
+        case mqtt5::PUBCOMP: {
+            uint16_t packetId = 0;
+            uint8_t reason = 0;
+            mqtt5::decodeAck(pkt, packetId, reason);
+            if (reason >= 0x80) {
+                MCP_LOG_WARN("Publish rejected by broker: packetId=" << packetId
+                          << ", reason=0x" << std::hex << static_cast<int>(reason) << std::dec);
+            }
+            return true;
+        }
+        case mqtt5::SUBACK:
+        case mqtt5::UNSUBACK: {
+            uint16_t packetId = 0;
+            std::vector<uint8_t> reasons;
+            mqtt5::decodeSubAck(pkt, packetId, reasons);
+            for (uint8_t reason : reasons) {
+                if (reason >= 0x80) {
+                    MCP_LOG_WARN("(Un)subscribe rejected by broker: packetId=" << packetId
+                              << ", reason=0x" << std::hex << static_cast<int>(reason) << std::dec);
+                }
+            }
+            return true;
+        }
+        case mqtt5::PINGRESP:
+            pingOutstanding_ = false;
+            return true;
+        case mqtt5::DISCONNECT:
+            MCP_LOG_WARN("Broker sent DISCONNECT");
+            return false;
+        default:
+            MCP_LOG_DEBUG("Ignoring packet type " << static_cast<int>(pkt.type));
+            return true;
+    }
+}
+
+bool EpollMqttClient::flushOutgoing(bool takeQueued) {
+    if (takeQueued) {
+        std::lock_guard<std::mutex> lock(outMutex_);
+        collectQueued();
+    }
+    if (sockFd_ < 0) {
+        sending_.clear();
+        sendOffset_ = 0;
+        return true;
+    }
+
+    while (!sending_.empty()) {
+        iovec iov[MAX_IOV];
+        int count = 0;
+        for (auto it = sending_.begin(); it != sending_.end() && count < MAX_IOV; ++it, ++count) {
+            size_t skip = count == 0 ? sendOffset_ : 0;
+            iov[count].iov_base = it->data() + skip;
+            iov[count].iov_len = it->size() - skip;
+        }
+        ssize_t n = ::writev(sockFd_, iov, count);
+        if (n > 0) {
+            size_t written = static_cast<size_t>(n);
+            while (written > 0) {
+                size_t left = sending_.front().size() - sendOffset_;
+                if (written < left) {
+                    sendOffset_ += written;
+                    break;
+                }
+                written -= left;
+                sending_.pop_front();
+                sendOffset_ = 0;
+            }
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;    // Resume on EPOLLOUT
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return false;
+    }
+    sendOffset_ = 0;
+    return true;
+}
+
+void EpollMqttClient::collectQueued() {
+    // Caller holds outMutex_
+    for (auto& chunk : outQueue_) {
+        if (!chunk.empty()) {
+            sending_.push_back(std::move(chunk));
+        }
+    }
+    outQueue_.clear();
+    outQueue_.emplace_back();
+}
+
+void EpollMqttClient::resetOutgoing() {
+    // Nothing queued for an old connection may leak into a new one, and
+    // topic aliases have to be established again
+    std::lock_guard<std::mutex> lock(outMutex_);
+    outQueue_.clear();
+    outQueue_.emplace_back();
+    sending_.clear();
+    sendOffset_ = 0;
+    outboundAliases_.clear();
+}
+
+void EpollMqttClient::enqueue(const std::string& packet) {
+    {
+        std::lock_guard<std::mutex> lock(outMutex_);
+        outQueue_.back().append(packet);
+    }
+    wakeIoThread();
+}
+
+void EpollMqttClient::wakeIoThread() {
+    // The I/O thread flushes after dispatching; other threads must wake it
+    if (!onIoThread() && wakeFd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t n = ::write(wakeFd_, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+uint16_t EpollMqttClient::allocatePacketId() {
+    // Caller holds outMutex_
+    if (++nextPacketId_ == 0) nextPacketId_ = 1;
+    return nextPacketId_;
+}
+
+bool EpollMqttClient::onIoThread() const {
+    return tlsIoClient == this;
+}
+
+bool EpollMqttClient::reconnectInPlace() {
+    MCP_LOG_DEBUG("Reconnecting to apply new Will: clientId=" << clientId_);
+
+    // Drain what is queued on the old connection and end it with a normal
+    // DISCONNECT, so the old Will is not published. Publishes made from now on
+    // are encoded against reset aliases and wait for the new connection.
+    {
+        std::lock_guard<std::mutex> lock(outMutex_);
+        mqtt5::encodeDisconnect(outQueue_.back());
+        collectQueued();
+        outboundAliases_.clear();
+        brokerTopicAliasMaximum_ = 0;   // No aliases until the new CONNACK
+    }
+    auto deadline = std::chrono::steady_clock::now() + options_.connectTimeout;
+    while (!sending_.empty() && flushOutgoing(false)) {
+        pollfd pfd{sockFd_, POLLOUT, 0};
+        if (!sending_.empty() && poll(&pfd, 1, remainingMs(deadline)) <= 0) {
+            break;
+        }
+    }
+    sending_.clear();
+    sendOffset_ = 0;
+    closeSocket();
+
+    if (!openSocket() || !handshake()) {
+        closeSocket();
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = sockFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, sockFd_, &ev);
+    connected_ = true;
+    pingOutstanding_ = false;
+    for (auto& alias : inboundAliases_) {
+        alias.clear();
+    }
+
+    std::map<std::string, std::pair<int, bool>> subscriptions;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptions = subscriptions_;
+    }
+    for (const auto& [topic, opts] : subscriptions) {
+        std::string sub;
+        {
+            std::lock_guard<std::mutex> lock(outMutex_);
+            mqtt5::encodeSubscribe(sub, allocatePacketId(), topic, opts.first, opts.second);
+        }
+        enqueue(sub);
+    }
+    MCP_LOG_INFO("Reconnected with new Will, restored " << subscriptions.size() << " subscription(s)");
+
+    std::function<void()> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = connectionRestoredCallback_;
+    }
+    if (callback) {
+        callback();
+    }
+    return true;
+}
+
+void EpollMqttClient::handleConnectionLost(const std::string& reason) {
+    closeSocket();
+    if (stopping_) {
+        return;     // Closed by our own disconnect()
+    }
+    MCP_LOG_WARN("MQTT connection lost: " << reason);
+
+    std::function<void(const std::string&)> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = connectionLostCallback_;
+    }
+    if (callback) {
+        callback(reason);
+    }
+}
+
+} // namespace mcp_mqtt
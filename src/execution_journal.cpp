@@ -0,0 +1,307 @@
+#include "mcp_mqtt/execution_journal.h"
+#include "mcp_mqtt/logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mcp_mqtt {
+
+static constexpr char JOURNAL_MAGIC[8] = {'M', 'C', 'P', 'J', 'R', 'N', 'L', '1'};
+static constexpr size_t FILE_HEADER_SIZE = 64;
+static constexpr size_t RECORD_ALIGN = 8;
+
+struct RecordHeader {
+    uint32_t length;        // Whole record including this header and padding
+    uint32_t checksum;      // FNV-1a over everything after this field
+    int64_t timestamp;      // Seconds since the epoch
+    uint8_t state;
+    uint8_t reserved[3];
+    uint32_t keyLength;
+    uint32_t resultLength;
+    uint32_t reserved2;
+};
+
+static_assert(sizeof(RecordHeader) == 32, "journal record header layout");
+
+static uint32_t fnv1a(const char* data, size_t len, uint32_t hash = 2166136261u) {
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static size_t recordSize(size_t keyLength, size_t resultLength) {
+    size_t size = sizeof(RecordHeader) + keyLength + resultLength;
+    return (size + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+}
+
+static int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// msync() needs a page-aligned start address
+static void syncRange(char* base, size_t offset, size_t length) {
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t start = offset & ~(pageSize - 1);
+    msync(base + start, offset + length - start, MS_SYNC);
+}
+
+ExecutionJournal::~ExecutionJournal() {
+    close();
+}
+
+bool ExecutionJournal::open(const std::string& path, size_t initialCapacity, std::chrono::seconds retention) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ >= 0) {
+        MCP_LOG_ERROR("Execution journal already open: " << path_);
+        return false;
+    }
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd_ < 0) {
+        MCP_LOG_ERROR("Failed to open execution journal " << path << ": " << std::strerror(errno));
+        return false;
+    }
+    path_ = path;
+    retention_ = retention;
+
+    struct stat st;
+    fstat(fd_, &st);
+    size_t capacity = static_cast<size_t>(st.st_size);
+    bool fresh = capacity < FILE_HEADER_SIZE;
+    if (fresh) {
+        capacity = std::max(initialCapacity, FILE_HEADER_SIZE + sizeof(RecordHeader));
+    }
+
+    if (!mapFile(capacity)) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    if (fresh || std::memcmp(map_, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) {
+        if (!fresh) {
+            MCP_LOG_WARN("Execution journal has no valid header, starting empty: " << path);
+        }
+        std::memset(map_, 0, capacity_);
+        std::memcpy(map_, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        syncRange(map_, 0, capacity_);
+    }
+
+    loadRecords();
+    MCP_LOG_INFO("Execution journal opened: " << path << ", " << index_.size() << " execution(s)");
+    return true;
+}
+
+void ExecutionJournal::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unmapFile();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    index_.clear();
+}
+
+bool ExecutionJournal::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fd_ >= 0;
+}
+
+ExecutionJournal::Entry ExecutionJournal::begin(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry entry;
+
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        entry.state = it->second.state;
+        entry.result = it->second.result;
+        return entry;
+    }
+
+    int64_t timestamp = nowSeconds();
+    if (!append(key, State::STARTED, timestamp, std::string())) {
+        // Not persisted: report it as started so the caller does not execute
+        // without a record
+        entry.state = State::STARTED;
+        return entry;
+    }
+    index_[key] = IndexEntry{State::STARTED, timestamp, std::string()};
+    return entry;
+}
+
+bool ExecutionJournal::complete(const std::string& key, const std::string& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t timestamp = nowSeconds();
+    if (!append(key, State::COMPLETED, timestamp, result)) {
+        return false;
+    }
+    index_[key] = IndexEntry{State::COMPLETED, timestamp, result};
+    return true;
+}
+
+size_t ExecutionJournal::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+bool ExecutionJournal::mapFile(size_t capacity) {
+    if (ftruncate(fd_, static_cast<off_t>(capacity)) != 0) {
+        MCP_LOG_ERROR("Failed to size execution journal: " << std::strerror(errno));
+        return false;
+    }
+    void* map = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        MCP_LOG_ERROR("Failed to map execution journal: " << std::strerror(errno));
+        return false;
+    }
+    map_ = static_cast<char*>(map);
+    capacity_ = capacity;
+    return true;
+}
+
+void ExecutionJournal::unmapFile() {
+    if (map_) {
+        munmap(map_, capacity_);
+        map_ = nullptr;
+        capacity_ = 0;
+    }
+}
+
+void ExecutionJournal::loadRecords() {
+    // Caller holds mutex_
+    index_.clear();
+    size_t offset = FILE_HEADER_SIZE;
+    int64_t cutoff = nowSeconds() - retention_.count();
+
+    while (offset + sizeof(RecordHeader) <= capacity_) {
+        RecordHeader header;
+        std::memcpy(&header, map_ + offset, sizeof(header));
+        if (header.length == 0 ||
+            header.length != recordSize(header.keyLength, header.resultLength) ||
+            offset + header.length > capacity_) {
+            break;
+        }
+        const char* body = map_ + offset + sizeof(uint32_t) * 2;
+        if (fnv1a(body, header.length - sizeof(uint32_t) * 2) != header.checksum) {
+            MCP_LOG_WARN("Discarding torn execution journal record at offset " << offset);
+            break;
+        }
+
+        const char* key = map_ + offset + sizeof(RecordHeader);
+        if (header.timestamp >= cutoff) {
+            index_[std::string(key, header.keyLength)] = IndexEntry{
+                static_cast<State>(header.state), header.timestamp,
+                std::string(key + header.keyLength, header.resultLength)};
+        }
+        offset += header.length;
+    }
+
+    // Anything after the last valid record is garbage from an interrupted write
+    end_ = offset;
+    if (end_ < capacity_) {
+        std::memset(map_ + end_, 0, std::min(capacity_ - end_, sizeof(RecordHeader)));
+    }
+}
+
+bool ExecutionJournal::append(const std::string& key, State state, int64_t timestamp,
+                              const std::string& result) {
+    // Caller holds mutex_
+    if (!map_) {
+        MCP_LOG_ERROR("Execution journal is not open");
+        return false;
+    }
+
+    size_t size = recordSize(key.size(), result.size());
+    if (end_ + size + sizeof(RecordHeader) > capacity_ && !compact(size)) {
+        return false;
+    }
+
+    char* record = map_ + end_;
+    RecordHeader header{};
+    header.timestamp = timestamp;
+    header.state = static_cast<uint8_t>(state);
+    header.keyLength = static_cast<uint32_t>(key.size());
+    header.resultLength = static_cast<uint32_t>(result.size());
+
+    // Write the body, then the header with length and checksum, so a crash
+    // leaves either a whole record or one that fails validation
+    std::memset(record + sizeof(RecordHeader), 0, size - sizeof(RecordHeader));
+    std::memcpy(record + sizeof(RecordHeader), key.data(), key.size());
+    std::memcpy(record + sizeof(RecordHeader) + key.size(), result.data(), result.size());
+    std::memcpy(record, &header, sizeof(header));
+    header.length = static_cast<uint32_t>(size);
+    header.checksum = fnv1a(record + sizeof(uint32_t) * 2, size - sizeof(uint32_t) * 2);
+    std::memcpy(record, &header, sizeof(uint32_t) * 2);
+
+    syncRange(map_, end_, size);
+    end_ += size;
+    return true;
+}
+
+bool ExecutionJournal::compact(size_t required) {
+    // Caller holds mutex_. Rewrite the latest record of every live key into a
+    // new file and swap it in atomically.
+    int64_t cutoff = nowSeconds() - retention_.count();
+    size_t live = FILE_HEADER_SIZE;
+    for (auto it = index_.begin(); it != index_.end();) {
+        if (it->second.timestamp < cutoff) {
+            it = index_.erase(it);
+        } else {
+            live += recordSize(it->first.size(), it->second.result.size());
+            ++it;
+        }
+    }
+
+    size_t capacity = capacity_;
+    while (live + required + sizeof(RecordHeader) > capacity / 2) {
+        capacity *= 2;
+    }
+
+    std::string tmpPath = path_ + ".tmp";
+    int tmpFd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (tmpFd < 0) {
+        MCP_LOG_ERROR("Failed to create compacted execution journal: " << std::strerror(errno));
+        return false;
+    }
+
+    unmapFile();
+    int oldFd = fd_;
+    fd_ = tmpFd;
+    if (!mapFile(capacity)) {
+        ::close(tmpFd);
+        ::unlink(tmpPath.c_str());
+        fd_ = oldFd;
+        struct stat st;
+        fstat(fd_, &st);
+        mapFile(static_cast<size_t>(st.st_size));
+        return false;
+    }
+
+    std::memcpy(map_, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    end_ = FILE_HEADER_SIZE;
+    std::vector<std::pair<std::string, IndexEntry>> entries(index_.begin(), index_.end());
+    for (const auto& [key, entry] : entries) {
+        append(key, entry.state, entry.timestamp, entry.result);
+    }
+    syncRange(map_, 0, capacity_);
+
+    if (::rename(tmpPath.c_str(), path_.c_str()) != 0) {
+        MCP_LOG_ERROR("Failed to replace execution journal: " << std::strerror(errno));
+    }
+    ::close(oldFd);
+    MCP_LOG_INFO("Compacted execution journal: " << index_.size() << " execution(s), capacity="
+              << capacity_);
+    return true;
+}
+
+} // namespace mcp_mqtt
@@ -0,0 +1,155 @@
+#include "mcp_mqtt/fault_injector.h"
+#include "mcp_mqtt/logger.h"
+
+#include <thread>
+
+namespace mcp_mqtt {
+
+FaultInjectingMqttClient::FaultInjectingMqttClient(IMqttClient* client, const FaultInjectionOptions& options,
+                                                   uint64_t seed)
+    : client_(client), options_(options), random_(seed) {
+}
+
+void FaultInjectingMqttClient::setOptions(const FaultInjectionOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+}
+
+void FaultInjectingMqttClient::injectConnectionLost(const std::string& reason) {
+    std::function<void(const std::string&)> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (lost_) {
+            return;
+        }
+        lost_ = true;
+        ++stats_.connectionLosses;
+        callback = connectionLostCallback_;
+    }
+    MCP_LOG_WARN("Injecting connection loss: " << reason);
+    if (callback) {
+        callback(reason);
+    }
+}
+
+void FaultInjectingMqttClient::restoreConnection() {
+    lost_ = false;
+}
+
+FaultInjectingMqttClient::Stats FaultInjectingMqttClient::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+// Caller holds mutex_. Same bits-to-double conversion as the loopback link.
+double FaultInjectingMqttClient::chance() {
+    return static_cast<double>(random_() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Draws this publish's fate; sleeps outside the lock. false = fail it.
+bool FaultInjectingMqttClient::beforePublish() {
+    std::chrono::microseconds delay{0};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.publishes;
+        if (lost_ || (options_.publishFailureRate > 0.0 && chance() < options_.publishFailureRate)) {
+            ++stats_.failedPublishes;
+            return false;
+        }
+        delay = options_.publishLatency;
+        if (options_.publishJitter.count() > 0) {
+            delay += std::chrono::microseconds(static_cast<int64_t>(
+                chance() * static_cast<double>(options_.publishJitter.count() + 1)));
+        }
+        if (options_.publishTailRate > 0.0 && chance() < options_.publishTailRate) {
+            delay += options_.publishTailLatency;
+        }
+        if (delay.count() > 0) {
+            ++stats_.delayedPublishes;
+            stats_.injectedDelay += delay;
+        }
+    }
+    if (delay.count() > 0) {
+        std::this_thread::sleep_for(delay);
+    }
+    return true;
+}
+
+bool FaultInjectingMqttClient::isConnected() const {
+    return !lost_ && client_->isConnected();
+}
+
+bool FaultInjectingMqttClient::subscribe(const std::string& topic, int qos, bool noLocal) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (lost_ || (options_.subscribeFailureRate > 0.0 && chance() < options_.subscribeFailureRate)) {
+            ++stats_.failedSubscribes;
+            return false;
+        }
+        if (options_.subscriptionDropRate > 0.0 && chance() < options_.subscriptionDropRate) {
+            ++stats_.droppedSubscriptions;
+            MCP_LOG_DEBUG("Dropping subscription: " << topic);
+            return true;
+        }
+    }
+    return client_->subscribe(topic, qos, noLocal);
+}
+
+bool FaultInjectingMqttClient::unsubscribe(const std::string& topic) {
+    if (lost_) {
+        return false;
+    }
+    return client_->unsubscribe(topic);
+}
+
+bool FaultInjectingMqttClient::publish(const std::string& topic,
+                                       const std::string& payload,
+                                       int qos,
+                                       bool retained,
+                                       const std::map<std::string, std::string>& userProps) {
+    return beforePublish() && client_->publish(topic, payload, qos, retained, userProps);
+}
+
+bool FaultInjectingMqttClient::publishWithProperties(const std::string& topic,
+                                                     const std::string& payload,
+                                                     int qos,
+                                                     bool retained,
+                                                     const MqttPublishProperties& properties) {
+    return beforePublish() && client_->publishWithProperties(topic, payload, qos, retained, properties);
+}
+
+uint16_t FaultInjectingMqttClient::getTopicAliasMaximum() const {
+    return client_->getTopicAliasMaximum();
+}
+
+std::string FaultInjectingMqttClient::getClientId() const {
+    return client_->getClientId();
+}
+
+void FaultInjectingMqttClient::setMessageHandler(MqttMessageHandler handler) {
+    client_->setMessageHandler(std::move(handler));
+}
+
+void FaultInjectingMqttClient::setConnectionLostCallback(std::function<void(const std::string& reason)> callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connectionLostCallback_ = callback;
+    }
+    client_->setConnectionLostCallback(std::move(callback));
+}
+
+bool FaultInjectingMqttClient::setConnectionRestoredCallback(std::function<void()> callback) {
+    return client_->setConnectionRestoredCallback(std::move(callback));
+}
+
+void FaultInjectingMqttClient::setConnectProperties(uint32_t sessionExpiryInterval,
+                                                    const std::map<std::string, std::string>& userProperties) {
+    client_->setConnectProperties(sessionExpiryInterval, userProperties);
+}
+
+void FaultInjectingMqttClient::setWill(const std::string& topic, const std::string& payload,
+                                       int qos, bool retained) {
+    client_->setWill(topic, payload, qos, retained);
+}
+
+} // namespace mcp_mqtt
@@ -0,0 +1,499 @@
+#include "mcp_mqtt/load_balancer.h"
+#include "mcp_mqtt/logger.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace mcp_mqtt {
+
+struct LoadBalancer::Instance {
+    std::string serverId;
+    std::atomic<double> latencyUs{0.0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<int64_t> outstanding{0};
+
+    std::mutex mutex;
+    std::shared_ptr<McpClientSession> session;
+    std::vector<SessionCallback> waiting;       // Requests waiting for initialize
+};
+
+struct LoadBalancer::Call {
+    std::string method;
+    nlohmann::json params;
+    ResponseCallback callback;
+    int timeoutMs = 0;
+    std::atomic<int> attempts{0};       // Instances this call was sent to
+
+    std::mutex mutex;
+    std::vector<std::string> tried;     // Server IDs not to pick (tried, or the other hedge leg's)
+    std::shared_ptr<McpClientSession> session;  // Where the request was last sent
+    uint64_t requestId = 0;
+    bool abandoned = false;             // Lost a hedge; must not be sent or re-sent
+};
+
+struct LoadBalancer::Hedge {
+    ResponseCallback callback;
+    std::mutex mutex;
+    bool done = false;
+    bool primaryPending = true;
+    bool secondaryPending = false;
+    // The legs own the hedge through their callbacks, not the other way round
+    std::weak_ptr<Call> primary;
+    std::weak_ptr<Call> secondary;      // Set when the hedge was sent
+    IClock::TimerId timer = 0;
+};
+
+static McpResponse errorResponse(const std::string& message) {
+    McpResponse response;
+    response.status = RequestStatus::ERROR;
+    response.errorMessage = message;
+    return response;
+}
+
+LoadBalancer::LoadBalancer(McpClient* client, std::string serverName, LoadBalancerOptions options)
+    : client_(client),
+      serverName_(std::move(serverName)),
+      options_(options),
+      random_(options.seed),
+      hedgeCreditPerCall_(static_cast<int64_t>(std::max(options.hedgeBudget, 0.0) * HEDGE_COST)) {
+}
+
+LoadBalancer::~LoadBalancer() = default;
+
+void LoadBalancer::request(const std::string& method, const nlohmann::json& params,
+                           ResponseCallback callback, int timeoutMs) {
+    auto call = std::make_shared<Call>();
+    call->method = method;
+    call->params = params;
+    call->callback = std::move(callback);
+    call->timeoutMs = timeoutMs;
+    dispatch(call);
+}
+
+std::future<McpResponse> LoadBalancer::request(const std::string& method, const nlohmann::json& params,
+                                               int timeoutMs) {
+    auto promise = std::make_shared<std::promise<McpResponse>>();
+    std::future<McpResponse> future = promise->get_future();
+    request(method, params, [promise](McpResponse response) { promise->set_value(std::move(response)); },
+            timeoutMs);
+    return future;
+}
+
+void LoadBalancer::callTool(const std::string& name, const nlohmann::json& arguments,
+                            ResponseCallback callback, int timeoutMs) {
+    request("tools/call", {{"name", name}, {"arguments", arguments}}, std::move(callback), timeoutMs);
+}
+
+std::future<McpResponse> LoadBalancer::callTool(const std::string& name, const nlohmann::json& arguments,
+                                                int timeoutMs) {
+    return request("tools/call", {{"name", name}, {"arguments", arguments}}, timeoutMs);
+}
+
+void LoadBalancer::listTools(ResponseCallback callback, int timeoutMs) {
+    request("tools/list", nullptr, std::move(callback), timeoutMs);
+}
+
+std::future<McpResponse> LoadBalancer::listTools(int timeoutMs) {
+    return request("tools/list", nullptr, timeoutMs);
+}
+
+void LoadBalancer::callToolHedged(const std::string& name, const nlohmann::json& arguments,
+                                  ResponseCallback callback, int timeoutMs) {
+    hedgeRequests_.fetch_add(1, std::memory_order_relaxed);
+    // Every hedgeable call earns a share of a hedge, up to a small burst
+    int64_t credit = hedgeCredit_.fetch_add(hedgeCreditPerCall_, std::memory_order_relaxed);
+    if (credit + hedgeCreditPerCall_ > MAX_HEDGE_CREDIT) {
+        hedgeCredit_.fetch_sub(hedgeCreditPerCall_, std::memory_order_relaxed);
+    }
+
+    auto hedge = std::make_shared<Hedge>();
+    hedge->callback = std::move(callback);
+    auto primary = std::make_shared<Call>();
+    primary->method = "tools/call";
+    primary->params = {{"name", name}, {"arguments", arguments}};
+    primary->timeoutMs = timeoutMs;
+    primary->callback = [this, hedge](McpResponse response) { finishHedge(hedge, false, std::move(response)); };
+    hedge->primary = primary;
+
+    // Armed before sending: the transport may answer before dispatch() returns
+    double delayUs = hedgeDelayUs_.load(std::memory_order_relaxed);
+    if (delayUs > 0.0) {
+        auto delay = std::chrono::duration_cast<IClock::Duration>(std::chrono::duration<double, std::micro>(delayUs));
+        std::lock_guard<std::mutex> lock(hedge->mutex);
+        hedge->timer = client_->getClock()->scheduleAfter(delay, [this, hedge]() { sendHedge(hedge); });
+    }
+    dispatch(primary);
+}
+
+std::future<McpResponse> LoadBalancer::callToolHedged(const std::string& name, const nlohmann::json& arguments,
+                                                      int timeoutMs) {
+    auto promise = std::make_shared<std::promise<McpResponse>>();
+    std::future<McpResponse> future = promise->get_future();
+    callToolHedged(name, arguments, [promise](McpResponse response) { promise->set_value(std::move(response)); },
+                   timeoutMs);
+    return future;
+}
+
+HedgeStats LoadBalancer::getHedgeStats() const {
+    HedgeStats stats;
+    stats.requests = hedgeRequests_.load(std::memory_order_relaxed);
+    stats.hedges = hedgesSent_.load(std::memory_order_relaxed);
+    stats.hedgeWins = hedgeWins_.load(std::memory_order_relaxed);
+    stats.delayUs = hedgeDelayUs_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::vector<InstanceStats> LoadBalancer::getInstances() const {
+    std::lock_guard<std::mutex> lock(instancesMutex_);
+    std::vector<InstanceStats> stats;
+    stats.reserve(instances_.size());
+    for (const auto& [serverId, instance] : instances_) {
+        InstanceStats entry;
+        entry.serverId = serverId;
+        entry.latencyUs = instance->latencyUs.load(std::memory_order_relaxed);
+        entry.samples = instance->samples.load(std::memory_order_relaxed);
+        entry.outstanding = instance->outstanding.load(std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> sessionLock(instance->mutex);
+            entry.ready = instance->session && instance->session->isReady();
+        }
+        stats.push_back(std::move(entry));
+    }
+    std::sort(stats.begin(), stats.end(),
+              [](const InstanceStats& a, const InstanceStats& b) { return a.serverId < b.serverId; });
+    return stats;
+}
+
+// Internal methods
+
+void LoadBalancer::dispatch(const std::shared_ptr<Call>& call) {
+    std::vector<std::string> excluded;
+    {
+        std::lock_guard<std::mutex> lock(call->mutex);
+        if (call->abandoned) {
+            return;
+        }
+        excluded = call->tried;
+    }
+    std::shared_ptr<Instance> instance = pick(excluded);
+    if (!instance) {
+        MCP_LOG_WARN("No instance of " << serverName_ << " online for method=" << call->method);
+        call->callback(errorResponse("No instance of " + serverName_ + " online"));
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(call->mutex);
+        call->tried.push_back(instance->serverId);
+        ++call->attempts;
+    }
+    instance->outstanding.fetch_add(1, std::memory_order_relaxed);
+
+    withSession(instance, [this, call, instance](const std::shared_ptr<McpClientSession>& session) {
+        if (!session || isAbandoned(*call)) {
+            instance->outstanding.fetch_sub(1, std::memory_order_relaxed);
+            if (!session) {
+                // The handshake failed; the instance is likely going away
+                if (call->attempts < options_.maxAttempts) {
+                    dispatch(call);
+                } else {
+                    call->callback(errorResponse("Cannot initialize a session to " + serverName_));
+                }
+            }
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t requestId = session->request(call->method, call->params,
+                                              [this, call, instance, start](McpResponse response) {
+            instance->outstanding.fetch_sub(1, std::memory_order_relaxed);
+            if (response.status != RequestStatus::CANCELLED) {
+                record(*instance, std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count());
+            } else if (options_.retryOnServerLoss && call->attempts < options_.maxAttempts &&
+                       !isAbandoned(*call) && !client_->getDirectory().find(instance->serverId, serverName_)) {
+                MCP_LOG_INFO("Instance went offline, re-sending method=" << call->method
+                          << " from serverId=" << instance->serverId);
+                dispatch(call);
+                return;
+            }
+            call->callback(std::move(response));
+        }, call->timeoutMs);
+
+        // Remember where the request went, unless it lost a hedge meanwhile
+        bool abandoned;
+        {
+            std::lock_guard<std::mutex> lock(call->mutex);
+            abandoned = call->abandoned;
+            call->session = session;
+            call->requestId = requestId;
+        }
+        if (abandoned) {
+            session->cancel(requestId, "hedge lost");
+        }
+    });
+}
+
+bool LoadBalancer::isAbandoned(Call& call) {
+    std::lock_guard<std::mutex> lock(call.mutex);
+    return call.abandoned;
+}
+
+void LoadBalancer::abandon(Call& call) {
+    std::shared_ptr<McpClientSession> session;
+    uint64_t requestId;
+    {
+        std::lock_guard<std::mutex> lock(call.mutex);
+        call.abandoned = true;
+        session = call.session;
+        requestId = call.requestId;
+    }
+    if (session) {
+        session->cancel(requestId, "hedge lost");   // No-op if it completed already
+    }
+}
+
+void LoadBalancer::sendHedge(const std::shared_ptr<Hedge>& hedge) {
+    std::shared_ptr<Call> primary;
+    std::vector<std::string> excluded;
+    {
+        std::lock_guard<std::mutex> lock(hedge->mutex);
+        primary = hedge->primary.lock();
+        if (hedge->done || !primary) {
+            return;
+        }
+        hedge->timer = 0;
+        std::lock_guard<std::mutex> callLock(primary->mutex);
+        excluded = primary->tried;
+    }
+
+    // A hedge needs another instance, and budget
+    if (client_->getDirectory().read().withName(serverName_).size() <= excluded.size()) {
+        return;
+    }
+    int64_t credit = hedgeCredit_.fetch_sub(HEDGE_COST, std::memory_order_relaxed);
+    if (credit < HEDGE_COST) {
+        hedgeCredit_.fetch_add(HEDGE_COST, std::memory_order_relaxed);
+        return;
+    }
+
+    auto secondary = std::make_shared<Call>();
+    secondary->method = primary->method;
+    secondary->params = primary->params;
+    secondary->timeoutMs = primary->timeoutMs;
+    secondary->tried = std::move(excluded);
+    secondary->callback = [this, hedge](McpResponse response) { finishHedge(hedge, true, std::move(response)); };
+    {
+        std::lock_guard<std::mutex> lock(hedge->mutex);
+        if (hedge->done) {
+            hedgeCredit_.fetch_add(HEDGE_COST, std::memory_order_relaxed);
+            return;
+        }
+        hedge->secondary = secondary;
+        hedge->secondaryPending = true;
+    }
+    hedgesSent_.fetch_add(1, std::memory_order_relaxed);
+    MCP_LOG_DEBUG("Hedging " << secondary->method << " on " << serverName_);
+    dispatch(secondary);
+}
+
+void LoadBalancer::finishHedge(const std::shared_ptr<Hedge>& hedge, bool fromSecondary, McpResponse response) {
+    std::shared_ptr<Call> loser;
+    IClock::TimerId timer;
+    {
+        std::lock_guard<std::mutex> lock(hedge->mutex);
+        if (hedge->done) {
+            return;
+        }
+        (fromSecondary ? hedge->secondaryPending : hedge->primaryPending) = false;
+        bool otherPending = fromSecondary ? hedge->primaryPending : hedge->secondaryPending;
+        // A leg that got no answer from its server leaves the decision to the other
+        bool answered = response.ok() || response.errorCode != 0;
+        if (!answered && otherPending) {
+            return;
+        }
+        hedge->done = true;
+        timer = hedge->timer;
+        hedge->timer = 0;
+        if (otherPending) {
+            loser = (fromSecondary ? hedge->primary : hedge->secondary).lock();
+        }
+    }
+
+    if (timer != 0) {
+        client_->getClock()->cancel(timer);
+    }
+    if (loser) {
+        abandon(*loser);
+    }
+    if (fromSecondary && response.ok()) {
+        hedgeWins_.fetch_add(1, std::memory_order_relaxed);
+    }
+    hedge->callback(std::move(response));
+}
+
+std::shared_ptr<LoadBalancer::Instance> LoadBalancer::pick(const std::vector<std::string>& excluded) {
+    std::string first;
+    std::string second;
+    uint64_t directoryVersion;
+    {
+        ServerDirectory::View view = client_->getDirectory().read();
+        directoryVersion = view.version();
+        ServerDirectory::Range range = view.withName(serverName_);
+
+        // Without exclusions, index the snapshot directly
+        std::vector<const ServerDirectory::ServerPtr*> candidates;
+        size_t count = range.size();
+        if (!excluded.empty()) {
+            for (const auto& server : range) {
+                if (std::find(excluded.begin(), excluded.end(), server->serverId) == excluded.end()) {
+                    candidates.push_back(&server);
+                }
+            }
+            count = candidates.size();
+        }
+        auto at = [&](size_t index) -> const std::string& {
+            return excluded.empty() ? range.begin()[index]->serverId : (*candidates[index])->serverId;
+        };
+
+        if (count == 0) {
+            return nullptr;
+        }
+        uint64_t random = nextRandom();
+        size_t a = static_cast<size_t>(random % count);
+        first = at(a);
+        if (count > 1) {
+            size_t b = (a + 1 + static_cast<size_t>((random >> 32) % (count - 1))) % count;
+            second = at(b);
+        }
+    }
+
+    std::shared_ptr<Instance> a = instanceFor(first, directoryVersion);
+    if (second.empty()) {
+        return a;
+    }
+    std::shared_ptr<Instance> b = instanceFor(second, directoryVersion);
+
+    double latencyA = a->latencyUs.load(std::memory_order_relaxed);
+    double latencyB = b->latencyUs.load(std::memory_order_relaxed);
+    int64_t outstandingA = a->outstanding.load(std::memory_order_relaxed);
+    int64_t outstandingB = b->outstanding.load(std::memory_order_relaxed);
+    if (a->samples.load(std::memory_order_relaxed) == 0 || b->samples.load(std::memory_order_relaxed) == 0) {
+        return outstandingB < outstandingA ? b : a;
+    }
+    double costA = latencyA * static_cast<double>(outstandingA + 1);
+    double costB = latencyB * static_cast<double>(outstandingB + 1);
+    return costB < costA ? b : a;
+}
+
+std::shared_ptr<LoadBalancer::Instance> LoadBalancer::instanceFor(const std::string& serverId,
+                                                                  uint64_t directoryVersion) {
+    std::lock_guard<std::mutex> lock(instancesMutex_);
+    if (directoryVersion != directoryVersion_) {
+        // Forget instances that went offline; their requests hold their own references
+        directoryVersion_ = directoryVersion;
+        const ServerDirectory& directory = client_->getDirectory();
+        for (auto it = instances_.begin(); it != instances_.end();) {
+            if (it->first != serverId && !directory.find(it->first, serverName_)) {
+                it = instances_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    auto& instance = instances_[serverId];
+    if (!instance) {
+        instance = std::make_shared<Instance>();
+        instance->serverId = serverId;
+    }
+    return instance;
+}
+
+void LoadBalancer::withSession(const std::shared_ptr<Instance>& instance, SessionCallback callback) {
+    std::shared_ptr<McpClientSession> session;
+    bool needsInitialize = false;
+    {
+        std::lock_guard<std::mutex> lock(instance->mutex);
+        // instance->session is only set to a READY session or one we are initializing
+        if (instance->session) {
+            auto state = instance->session->getState();
+            if (state == McpClientSession::State::READY) {
+                session = instance->session;
+            } else if (state == McpClientSession::State::INITIALIZING) {
+                instance->waiting.push_back(std::move(callback));
+                return;
+            }
+        }
+        if (!session) {
+            // First request, or the previous session closed: connect lazily
+            session = client_->createSession(instance->serverId, serverName_);
+            auto state = session ? session->getState() : McpClientSession::State::CLOSED;
+            if (state == McpClientSession::State::READY) {
+                instance->session = session;
+            } else if (state == McpClientSession::State::CREATED) {
+                instance->session = session;
+                instance->waiting.push_back(std::move(callback));
+                needsInitialize = true;
+            } else {
+                session = nullptr;      // Client stopped, or someone else is initializing it
+            }
+        }
+    }
+
+    if (!needsInitialize) {
+        if (callback) {
+            callback(session);
+        }
+        return;
+    }
+
+    MCP_LOG_DEBUG("Initializing session to serverId=" << instance->serverId << ", serverName=" << serverName_);
+    session->initialize([instance, session](McpResponse response) {
+        std::vector<SessionCallback> waiting;
+        {
+            std::lock_guard<std::mutex> lock(instance->mutex);
+            waiting.swap(instance->waiting);
+        }
+        for (auto& waiter : waiting) {
+            if (waiter) {
+                waiter(response.ok() ? session : nullptr);
+            }
+        }
+    });
+}
+
+void LoadBalancer::record(Instance& instance, double latencyUs) {
+    // Concurrent updates may lose a sample, which an average can afford
+    uint64_t samples = instance.samples.fetch_add(1, std::memory_order_relaxed);
+    double average = instance.latencyUs.load(std::memory_order_relaxed);
+    double next = samples == 0 ? latencyUs : average + options_.latencyWeight * (latencyUs - average);
+    instance.latencyUs.store(next, std::memory_order_relaxed);
+
+    // Recent latencies of all instances, for the hedge delay
+    uint64_t count = latencyCount_.fetch_add(1, std::memory_order_relaxed) + 1;
+    latencyWindow_[(count - 1) % LATENCY_WINDOW].store(static_cast<float>(latencyUs), std::memory_order_relaxed);
+    if (count % HEDGE_DELAY_UPDATE_INTERVAL != 0 || count < options_.hedgeMinSamples) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(hedgeDelayMutex_, std::try_to_lock);
+    if (!lock) {
+        return;     // Another thread is updating it
+    }
+    std::vector<float> latencies(std::min<uint64_t>(count, LATENCY_WINDOW));
+    for (size_t i = 0; i < latencies.size(); ++i) {
+        latencies[i] = latencyWindow_[i].load(std::memory_order_relaxed);
+    }
+    double rank = std::clamp(options_.hedgePercentile, 0.0, 100.0) / 100.0 * static_cast<double>(latencies.size() - 1);
+    auto nth = latencies.begin() + static_cast<ptrdiff_t>(rank + 0.5);
+    std::nth_element(latencies.begin(), nth, latencies.end());
+    hedgeDelayUs_.store(*nth, std::memory_order_relaxed);
+}
+
+uint64_t LoadBalancer::nextRandom() {
+    // splitmix64 over a shared counter: lock-free and reproducible for a seed
+    uint64_t z = random_.fetch_add(0x9E3779B97F4A7C15ull, std::memory_order_relaxed) + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+} // namespace mcp_mqtt
@@ -0,0 +1,257 @@
+#include "mcp_mqtt/local_listener.h"
+#include "mcp_mqtt/logger.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace mcp_mqtt {
+
+static constexpr size_t READ_CHUNK = 64 * 1024;
+
+/**
+ * @brief Session transport writing one JSON-RPC message per line
+ */
+class LocalListener::LineTransport : public ISessionTransport {
+public:
+    // A socket is shut down on close() to wake its reader; stdout is not
+    LineTransport(int fd, bool isSocket) : fd_(fd), isSocket_(isSocket) {}
+
+    ~LineTransport() override {
+        if (isSocket_) {
+            ::close(fd_);
+        }
+    }
+
+    bool send(const std::string& payload) override {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        if (closed_) {
+            return false;
+        }
+
+        iovec iov[2];
+        iov[0].iov_base = const_cast<char*>(payload.data());
+        iov[0].iov_len = payload.size();
+        iov[1].iov_base = const_cast<char*>("\n");
+        iov[1].iov_len = 1;
+        size_t total = payload.size() + 1;
+
+        ssize_t n;
+        do {
+            if (isSocket_) {
+                msghdr msg{};
+                msg.msg_iov = iov;
+                msg.msg_iovlen = 2;
+                n = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+            } else {
+                n = ::writev(fd_, iov, 2);
+            }
+        } while (n < 0 && errno == EINTR);
+
+        if (n >= 0 && static_cast<size_t>(n) < total) {
+            // Partial write: send the rest of the line
+            std::string rest = payload.substr(std::min(static_cast<size_t>(n), payload.size()));
+            if (static_cast<size_t>(n) <= payload.size()) {
+                rest.push_back('\n');
+            }
+            n = writeAll(rest.data(), rest.size()) ? static_cast<ssize_t>(total) : -1;
+        }
+        if (n < 0) {
+            closed_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    void close() override {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        closed_ = true;
+        if (isSocket_) {
+            ::shutdown(fd_, SHUT_RDWR);
+        }
+    }
+
+    bool isClosed() {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        return closed_;
+    }
+
+private:
+    bool writeAll(const char* data, size_t len) {
+        while (len > 0) {
+            ssize_t n = isSocket_ ? ::send(fd_, data, len, MSG_NOSIGNAL) : ::write(fd_, data, len);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    int fd_;
+    bool isSocket_;
+    std::mutex writeMutex_;
+    bool closed_ = false;
+};
+
+LocalListener::LocalListener(McpServer* server) : server_(server) {
+}
+
+LocalListener::~LocalListener() {
+    stop();
+}
+
+bool LocalListener::listen(const std::string& unixSocketPath) {
+    if (listenFd_ >= 0) {
+        MCP_LOG_ERROR("Local listener already listening on " << socketPath_);
+        return false;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (unixSocketPath.size() >= sizeof(addr.sun_path)) {
+        MCP_LOG_ERROR("Unix socket path too long: " << unixSocketPath);
+        return false;
+    }
+    std::strncpy(addr.sun_path, unixSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ::unlink(unixSocketPath.c_str());     // Left over from a previous run
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0) {
+        MCP_LOG_ERROR("Failed to listen on " << unixSocketPath << ": " << std::strerror(errno));
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+
+    listenFd_ = fd;
+    socketPath_ = unixSocketPath;
+    stopping_ = false;
+    acceptThread_ = std::thread([this]() { acceptLoop(); });
+    MCP_LOG_INFO("Local listener on " << unixSocketPath);
+    return true;
+}
+
+void LocalListener::serveStdio() {
+    auto transport = std::make_shared<LineTransport>(STDOUT_FILENO, false);
+    serve(nextClientId(), STDIN_FILENO, transport);
+}
+
+void LocalListener::stop() {
+    stopping_ = true;
+    if (listenFd_ >= 0) {
+        // Wakes the blocking accept()
+        ::shutdown(listenFd_, SHUT_RDWR);
+        if (acceptThread_.joinable()) {
+            acceptThread_.join();
+        }
+        ::close(listenFd_);
+        listenFd_ = -1;
+        ::unlink(socketPath_.c_str());
+    }
+
+    std::list<Connection> connections;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        connections.splice(connections.end(), connections_);
+    }
+    for (auto& connection : connections) {
+        connection.transport->close();
+    }
+    for (auto& connection : connections) {
+        if (connection.reader.joinable()) {
+            connection.reader.join();
+        }
+    }
+}
+
+size_t LocalListener::getConnectionCount() const {
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    size_t count = 0;
+    for (const auto& connection : connections_) {
+        if (!connection.done) ++count;
+    }
+    return count;
+}
+
+void LocalListener::acceptLoop() {
+    while (!stopping_) {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (!stopping_) {
+                MCP_LOG_ERROR("Local listener accept failed: " << std::strerror(errno));
+            }
+            return;
+        }
+
+        reapConnections();
+
+        std::string mcpClientId = nextClientId();
+        MCP_LOG_DEBUG("Local client connected: " << mcpClientId);
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        Connection& connection = connections_.emplace_back();
+        connection.transport = std::make_shared<LineTransport>(fd, true);
+        connection.reader = std::thread([this, &connection, mcpClientId, fd]() {
+            serve(mcpClientId, fd, connection.transport);
+            connection.done = true;
+        });
+    }
+}
+
+void LocalListener::serve(const std::string& mcpClientId, int inFd,
+                          const std::shared_ptr<LineTransport>& transport) {
+    std::string buffer;
+    size_t scanned = 0;
+    while (!transport->isClosed()) {
+        size_t oldSize = buffer.size();
+        buffer.resize(oldSize + READ_CHUNK);
+        ssize_t n = ::read(inFd, &buffer[oldSize], READ_CHUNK);
+        buffer.resize(oldSize + (n > 0 ? static_cast<size_t>(n) : 0));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        // Dispatch every complete line; keep the partial one
+        size_t start = 0;
+        size_t eol;
+        while ((eol = buffer.find('\n', scanned)) != std::string::npos) {
+            size_t end = (eol > start && buffer[eol - 1] == '\r') ? eol - 1 : eol;
+            if (end > start) {
+                server_->handleLocalMessage(mcpClientId, buffer.substr(start, end - start), transport);
+            }
+            start = eol + 1;
+            scanned = start;
+        }
+        buffer.erase(0, start);
+        scanned = buffer.size();
+    }
+
+    server_->closeLocalSession(mcpClientId);
+    transport->close();
+    MCP_LOG_DEBUG("Local client disconnected: " << mcpClientId);
+}
+
+void LocalListener::reapConnections() {
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        if (it->done) {
+            it->reader.join();
+            it = connections_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::string LocalListener::nextClientId() {
+    // Unique across listeners, since several may serve the same server
+    static std::atomic<uint64_t> counter{0};
+    return "local-" + std::to_string(getpid()) + "-" + std::to_string(++counter);
+}
+
+} // namespace mcp_mqtt
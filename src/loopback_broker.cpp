@@ -0,0 +1,452 @@
+#include "mcp_mqtt/loopback_broker.h"
+#include "mcp_mqtt/logger.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace mcp_mqtt {
+
+/**
+ * @brief A published message, shared by every delivery of it
+ */
+struct LoopbackBroker::Message {
+    std::string topic;
+    std::string payload;
+    int qos = 0;
+    bool retain = false;
+    MqttPublishProperties properties;
+    std::chrono::steady_clock::time_point publishedAt;
+};
+
+/**
+ * @brief State of one client, shared between the broker and its IMqttClient
+ */
+struct LoopbackBroker::ClientState {
+    std::string clientId;
+    std::atomic<bool> connected{true};
+
+    // Guarded by the broker's mutex_
+    std::map<std::string, std::pair<int, bool>> filters;    // Filter -> (QoS, No Local)
+    std::shared_ptr<const Message> will;
+
+    // Shared so a delivery copies a pointer rather than the std::function
+    std::mutex callbackMutex;
+    std::shared_ptr<const MqttMessageHandler> handler;
+    std::function<void(const std::string&)> connectionLostCallback;
+};
+
+/**
+ * @brief IMqttClient of a loopback client
+ */
+class LoopbackBroker::Client : public IMqttClient {
+public:
+    Client(LoopbackBroker* broker, std::shared_ptr<ClientState> state)
+        : broker_(broker), state_(std::move(state)) {}
+
+    ~Client() override {
+        broker_->removeClient(state_);
+    }
+
+    bool isConnected() const override {
+        return state_->connected;
+    }
+
+    bool subscribe(const std::string& topic, int qos, bool noLocal) override {
+        if (!state_->connected) {
+            return false;
+        }
+        broker_->subscribe(state_, topic, std::min(qos, 2), noLocal);
+        return true;
+    }
+
+    bool unsubscribe(const std::string& topic) override {
+        return broker_->unsubscribe(state_, topic);
+    }
+
+    bool publish(const std::string& topic,
+                 const std::string& payload,
+                 int qos,
+                 bool retained,
+                 const std::map<std::string, std::string>& userProps) override {
+        MqttPublishProperties properties;
+        properties.userProperties = userProps;
+        return publishWithProperties(topic, payload, qos, retained, properties);
+    }
+
+    bool publishWithProperties(const std::string& topic,
+                               const std::string& payload,
+                               int qos,
+                               bool retained,
+                               const MqttPublishProperties& properties) override {
+        if (!state_->connected) {
+            return false;
+        }
+        auto message = std::make_shared<Message>();
+        message->topic = topic;
+        message->payload = payload;
+        message->qos = std::min(qos, 2);
+        message->retain = retained;
+        message->properties = properties;
+        message->properties.topicAlias = 0;     // Nothing to save in-process
+        message->publishedAt = broker_->clock_ ? broker_->clock_->now() : std::chrono::steady_clock::now();
+        broker_->route(state_.get(), message);
+        return true;
+    }
+
+    std::string getClientId() const override {
+        return state_->clientId;
+    }
+
+    void setMessageHandler(MqttMessageHandler handler) override {
+        std::lock_guard<std::mutex> lock(state_->callbackMutex);
+        state_->handler = handler ? std::make_shared<const MqttMessageHandler>(std::move(handler)) : nullptr;
+    }
+
+    void setConnectionLostCallback(std::function<void(const std::string& reason)> callback) override {
+        std::lock_guard<std::mutex> lock(state_->callbackMutex);
+        state_->connectionLostCallback = std::move(callback);
+    }
+
+    void setConnectProperties(uint32_t, const std::map<std::string, std::string>&) override {
+        // Nothing is persisted and CONNECT user properties are not used
+    }
+
+    void setWill(const std::string& topic, const std::string& payload, int qos, bool retained) override {
+        auto will = std::make_shared<Message>();
+        will->topic = topic;
+        will->payload = payload;
+        will->qos = qos;
+        will->retain = retained;
+        std::lock_guard<std::mutex> lock(broker_->mutex_);
+        state_->will = will;
+    }
+
+private:
+    LoopbackBroker* broker_;
+    std::shared_ptr<ClientState> state_;
+};
+
+static bool isWildcard(const std::string& filter) {
+    return filter.find_first_of("+#") != std::string::npos;
+}
+
+// Wildcards at the first level do not match topics starting with '$'
+static bool filterMatches(const std::string& filter, const std::string& topic) {
+    if (!topic.empty() && topic[0] == '$' && !filter.empty() && (filter[0] == '+' || filter[0] == '#')) {
+        return false;
+    }
+    return topicMatchesFilter(filter, topic);
+}
+
+LoopbackBroker::LoopbackBroker() = default;
+
+LoopbackBroker::~LoopbackBroker() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [clientId, client] : clients_) {
+        client->connected = false;
+    }
+}
+
+std::unique_ptr<IMqttClient> LoopbackBroker::createClient(const std::string& clientId) {
+    auto state = std::make_shared<ClientState>();
+    state->clientId = clientId;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!clients_.emplace(clientId, state).second) {
+            MCP_LOG_ERROR("Loopback client ID already in use: " << clientId);
+            return nullptr;
+        }
+    }
+    return std::make_unique<Client>(this, std::move(state));
+}
+
+bool LoopbackBroker::disconnectClient(const std::string& clientId, const std::string& reason) {
+    std::shared_ptr<ClientState> client;
+    std::shared_ptr<const Message> will;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = clients_.find(clientId);
+        if (it == clients_.end() || !it->second->connected) {
+            return false;
+        }
+        client = it->second;
+        client->connected = false;
+        removeSubscriptions(*client);
+        will = std::move(client->will);
+        client->will.reset();
+    }
+
+    MCP_LOG_DEBUG("Loopback client disconnected: " << clientId << " (" << reason << ")");
+    if (will) {
+        auto message = std::make_shared<Message>(*will);
+        message->publishedAt = clock_ ? clock_->now() : std::chrono::steady_clock::now();
+        route(client.get(), message);
+    }
+
+    std::function<void(const std::string&)> callback;
+    {
+        std::lock_guard<std::mutex> lock(client->callbackMutex);
+        callback = client->connectionLostCallback;
+    }
+    if (callback) {
+        callback(reason);
+    }
+    return true;
+}
+
+size_t LoopbackBroker::getClientCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& [clientId, client] : clients_) {
+        if (client->connected) ++count;
+    }
+    return count;
+}
+
+size_t LoopbackBroker::getRetainedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retained_.size();
+}
+
+uint64_t LoopbackBroker::getDeliveredCount() const {
+    return delivered_;
+}
+
+void LoopbackBroker::setLink(IClock* clock, const LoopbackLinkOptions& options, uint64_t seed) {
+    std::lock_guard<std::mutex> lock(linkMutex_);
+    clock_ = clock;
+    link_ = options;
+    random_.seed(seed);
+}
+
+uint64_t LoopbackBroker::getDroppedCount() const {
+    return dropped_;
+}
+
+void LoopbackBroker::subscribe(const std::shared_ptr<ClientState>& client, const std::string& filter,
+                               int qos, bool noLocal) {
+    std::vector<std::shared_ptr<const Message>> retained;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool existed = client->filters.count(filter) > 0;
+        client->filters[filter] = {qos, noLocal};
+
+        Subscriber subscriber{client, qos, noLocal};
+        if (isWildcard(filter)) {
+            auto it = std::find_if(wildcardSubscriptions_.begin(), wildcardSubscriptions_.end(),
+                                   [&](const auto& entry) {
+                                       return entry.first == filter && entry.second.client == client;
+                                   });
+            if (it != wildcardSubscriptions_.end()) {
+                it->second = subscriber;
+            } else {
+                wildcardSubscriptions_.emplace_back(filter, subscriber);
+            }
+        } else {
+            auto& subscribers = exactSubscriptions_[filter];
+            auto it = std::find_if(subscribers.begin(), subscribers.end(),
+                                   [&](const Subscriber& entry) { return entry.client == client; });
+            if (it != subscribers.end()) {
+                *it = subscriber;
+            } else {
+                subscribers.push_back(subscriber);
+            }
+        }
+
+        // Retained messages are sent for new subscriptions only
+        if (!existed) {
+            for (const auto& [topic, message] : retained_) {
+                if (filterMatches(filter, topic)) {
+                    retained.push_back(message);
+                }
+            }
+        }
+    }
+
+    for (const auto& message : retained) {
+        transmit(client, message, std::min(message->qos, qos), true);
+    }
+}
+
+bool LoopbackBroker::unsubscribe(const std::shared_ptr<ClientState>& client, const std::string& filter) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (client->filters.erase(filter) == 0) {
+        return false;
+    }
+    if (isWildcard(filter)) {
+        wildcardSubscriptions_.erase(
+            std::remove_if(wildcardSubscriptions_.begin(), wildcardSubscriptions_.end(),
+                           [&](const auto& entry) {
+                               return entry.first == filter && entry.second.client == client;
+                           }),
+            wildcardSubscriptions_.end());
+    } else {
+        auto it = exactSubscriptions_.find(filter);
+        if (it != exactSubscriptions_.end()) {
+            auto& subscribers = it->second;
+            subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+                                             [&](const Subscriber& entry) { return entry.client == client; }),
+                              subscribers.end());
+            if (subscribers.empty()) {
+                exactSubscriptions_.erase(it);
+            }
+        }
+    }
+    return true;
+}
+
+// Caller holds mutex_
+void LoopbackBroker::removeSubscriptions(ClientState& client) {
+    for (const auto& [filter, options] : client.filters) {
+        if (isWildcard(filter)) {
+            continue;
+        }
+        auto it = exactSubscriptions_.find(filter);
+        if (it == exactSubscriptions_.end()) {
+            continue;
+        }
+        auto& subscribers = it->second;
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+                                         [&](const Subscriber& entry) { return entry.client.get() == &client; }),
+                          subscribers.end());
+        if (subscribers.empty()) {
+            exactSubscriptions_.erase(it);
+        }
+    }
+    wildcardSubscriptions_.erase(
+        std::remove_if(wildcardSubscriptions_.begin(), wildcardSubscriptions_.end(),
+                       [&](const auto& entry) { return entry.second.client.get() == &client; }),
+        wildcardSubscriptions_.end());
+    client.filters.clear();
+}
+
+void LoopbackBroker::removeClient(const std::shared_ptr<ClientState>& client) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    client->connected = false;
+    removeSubscriptions(*client);
+    auto it = clients_.find(client->clientId);
+    if (it != clients_.end() && it->second == client) {
+        clients_.erase(it);
+    }
+}
+
+void LoopbackBroker::route(const ClientState* from, const std::shared_ptr<const Message>& message) {
+    std::vector<Subscriber> targets;
+
+    // One delivery per client, at the highest QoS of its matching subscriptions
+    auto addTarget = [&](const Subscriber& subscriber) {
+        if (subscriber.noLocal && subscriber.client.get() == from) {
+            return;
+        }
+        for (auto& target : targets) {
+            if (target.client == subscriber.client) {
+                target.qos = std::max(target.qos, subscriber.qos);
+                return;
+            }
+        }
+        targets.push_back(subscriber);
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (message->retain) {
+            if (message->payload.empty()) {
+                retained_.erase(message->topic);
+            } else {
+                retained_[message->topic] = message;
+            }
+        }
+
+        auto it = exactSubscriptions_.find(message->topic);
+        if (it != exactSubscriptions_.end()) {
+            for (const auto& subscriber : it->second) {
+                addTarget(subscriber);
+            }
+        }
+        for (const auto& [filter, subscriber] : wildcardSubscriptions_) {
+            if (filterMatches(filter, message->topic)) {
+                addTarget(subscriber);
+            }
+        }
+    }
+
+    for (const auto& target : targets) {
+        transmit(target.client, message, std::min(message->qos, target.qos), false);
+    }
+}
+
+// Uniform in [0, 1) from the top 53 bits; unlike std::uniform_real_distribution
+// the result is the same with every standard library
+static double unitInterval(std::mt19937_64& random) {
+    return static_cast<double>(random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void LoopbackBroker::transmit(const std::shared_ptr<ClientState>& client,
+                              const std::shared_ptr<const Message>& message, int qos, bool retained) {
+    if (!clock_) {
+        deliver(*client, *message, qos, retained);
+        return;
+    }
+
+    std::chrono::microseconds delay = link_.latency;
+    {
+        std::lock_guard<std::mutex> lock(linkMutex_);
+        if (link_.dropRate > 0.0 && unitInterval(random_) < link_.dropRate) {
+            ++dropped_;
+            return;
+        }
+        if (link_.jitter.count() > 0) {
+            delay += std::chrono::microseconds(
+                static_cast<int64_t>(unitInterval(random_) * static_cast<double>(link_.jitter.count() + 1)));
+        }
+        if (link_.reorderRate > 0.0 && unitInterval(random_) < link_.reorderRate) {
+            delay += link_.reorderDelay;
+        }
+    }
+
+    clock_->scheduleAfter(delay, [this, client, message, qos, retained]() {
+        deliver(*client, *message, qos, retained);
+    });
+}
+
+void LoopbackBroker::deliver(ClientState& client, const Message& message, int qos, bool retained) {
+    if (!client.connected) {
+        return;
+    }
+
+    std::shared_ptr<const MqttMessageHandler> handler;
+    {
+        std::lock_guard<std::mutex> lock(client.callbackMutex);
+        handler = client.handler;
+    }
+    if (!handler) {
+        return;
+    }
+
+    const MqttPublishProperties& properties = message.properties;
+    MqttIncomingMessage incoming;
+    incoming.topic = message.topic;
+    incoming.payload = message.payload;
+    incoming.qos = qos;
+    incoming.retained = retained;
+    incoming.userProperties = properties.userProperties;
+    if (properties.messageExpiryInterval > 0) {
+        // Like a broker: deduct the time in transit and drop what expired meanwhile
+        auto now = clock_ ? clock_->now() : std::chrono::steady_clock::now();
+        auto held = std::chrono::duration_cast<std::chrono::seconds>(now - message.publishedAt).count();
+        if (held >= static_cast<int64_t>(properties.messageExpiryInterval)) {
+            MCP_LOG_DEBUG("Loopback broker dropping expired message: topic=" << message.topic);
+            return;
+        }
+        incoming.messageExpiryInterval = properties.messageExpiryInterval - static_cast<uint32_t>(held);
+    }
+    incoming.correlationData = properties.correlationData;
+    incoming.responseTopic = properties.responseTopic;
+    incoming.contentType = properties.contentType;
+    incoming.payloadFormatIndicator = properties.payloadFormatIndicator;
+
+    ++delivered_;
+    (*handler)(incoming);
+}
+
+} // namespace mcp_mqtt
@@ -0,0 +1,798 @@
+#include "mcp_mqtt/mcp_client.h"
+#include "mcp_mqtt/logger.h"
+
+#include <algorithm>
+
+namespace mcp_mqtt {
+
+// MCP topic prefixes
+static constexpr const char* MCP_SERVER_PREFIX = "$mcp-server/";
+static constexpr const char* MCP_PRESENCE_PREFIX = "$mcp-server/presence/";
+static constexpr const char* MCP_CLIENT_PRESENCE_PREFIX = "$mcp-client/presence/";
+static constexpr const char* MCP_RPC_PREFIX = "$mcp-rpc/";
+
+static size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+static McpResponse statusResponse(RequestStatus status, const std::string& message) {
+    McpResponse response;
+    response.status = status;
+    response.errorMessage = message;
+    return response;
+}
+
+// Callback that fulfils a promise, for the future forms of the request methods
+static ResponseCallback promiseCallback(std::future<McpResponse>& future) {
+    auto promise = std::make_shared<std::promise<McpResponse>>();
+    future = promise->get_future();
+    return [promise](McpResponse response) { promise->set_value(std::move(response)); };
+}
+
+// ToolCatalog
+
+std::shared_ptr<const ToolCatalog> ToolCatalog::fromResult(const nlohmann::json& result) {
+    auto tools = result.find("tools");
+    if (tools == result.end() || !tools->is_array()) {
+        return nullptr;
+    }
+    auto catalog = std::make_shared<ToolCatalog>();
+    catalog->toolsJson_ = *tools;
+    catalog->tools_.reserve(tools->size());
+    catalog->byName_.reserve(tools->size());
+    for (const auto& entry : *tools) {
+        auto name = entry.is_object() ? entry.find("name") : entry.end();
+        if (!entry.is_object() || name == entry.end() || !name->is_string()) {
+            MCP_LOG_WARN("Skipping tool without a name in tools/list result");
+            continue;
+        }
+        try {
+            catalog->tools_.push_back(Tool::fromJson(entry));
+        } catch (const nlohmann::json::exception& e) {
+            MCP_LOG_WARN("Skipping malformed tool " << name->get<std::string>() << ": " << e.what());
+            continue;
+        }
+        catalog->byName_.emplace(catalog->tools_.back().name, catalog->tools_.size() - 1);
+    }
+    return catalog;
+}
+
+const Tool* ToolCatalog::find(const std::string& name) const {
+    auto it = byName_.find(name);
+    return it == byName_.end() ? nullptr : &tools_[it->second];
+}
+
+// McpClientSession
+
+McpClientSession::McpClientSession(McpClient* client, std::string serverId, std::string serverName,
+                                   size_t capacity)
+    : client_(client),
+      serverId_(std::move(serverId)),
+      serverName_(std::move(serverName)),
+      rpcTopic_(client->getRpcTopic(serverId_, serverName_)),
+      slots_(new Slot[roundUpToPowerOfTwo(std::max<size_t>(capacity, 1))]),
+      slotMask_(roundUpToPowerOfTwo(std::max<size_t>(capacity, 1)) - 1) {
+}
+
+McpClientSession::~McpClientSession() = default;
+
+void McpClientSession::initialize(ResponseCallback callback, int timeoutMs) {
+    State expected = State::CREATED;
+    if (!state_.compare_exchange_strong(expected, State::INITIALIZING)) {
+        callback(statusResponse(RequestStatus::ERROR, "Session already initialized or closed"));
+        return;
+    }
+
+    const McpClientConfig& config = client_->config_;
+    nlohmann::json params;
+    params["protocolVersion"] = MCP_PROTOCOL_VERSION;
+    params["clientInfo"] = {{"name", config.clientInfo.name}, {"version", config.clientInfo.version}};
+    params["capabilities"] = config.capabilities;
+
+    MCP_LOG_INFO("Initializing session: serverId=" << serverId_ << ", serverName=" << serverName_);
+
+    auto self = shared_from_this();
+    send("initialize", params, [self, callback = std::move(callback)](McpResponse response) {
+        if (response.ok()) {
+            const nlohmann::json& result = response.result;
+            if (result.contains("serverInfo") && result["serverInfo"].is_object()) {
+                self->serverInfo_.name = result["serverInfo"].value("name", "");
+                self->serverInfo_.version = result["serverInfo"].value("version", "");
+            }
+            self->serverCapabilities_ = result.value("capabilities", nlohmann::json::object());
+
+            // The server only serves requests that follow notifications/initialized
+            self->notify("notifications/initialized");
+            State expected = State::INITIALIZING;
+            if (self->state_.compare_exchange_strong(expected, State::READY)) {
+                MCP_LOG_INFO("Session initialized: serverId=" << self->serverId_
+                          << ", server=" << self->serverInfo_.name << " " << self->serverInfo_.version);
+            } else {
+                response = statusResponse(RequestStatus::CANCELLED, "Session closed during initialize");
+            }
+        } else {
+            MCP_LOG_WARN("Initialize failed: serverId=" << self->serverId_
+                      << ", error=" << response.errorMessage);
+            self->shutDown("initialize failed: " + response.errorMessage, true);
+        }
+        callback(std::move(response));
+    }, timeoutMs, true);
+}
+
+std::future<McpResponse> McpClientSession::initialize(int timeoutMs) {
+    std::future<McpResponse> future;
+    initialize(promiseCallback(future), timeoutMs);
+    return future;
+}
+
+uint64_t McpClientSession::request(const std::string& method, const nlohmann::json& params,
+                                   ResponseCallback callback, int timeoutMs) {
+    return send(method, params, std::move(callback), timeoutMs, false);
+}
+
+std::future<McpResponse> McpClientSession::request(const std::string& method, const nlohmann::json& params,
+                                                   int timeoutMs) {
+    std::future<McpResponse> future;
+    send(method, params, promiseCallback(future), timeoutMs, false);
+    return future;
+}
+
+uint64_t McpClientSession::ping(ResponseCallback callback, int timeoutMs) {
+    return send("ping", nullptr, std::move(callback), timeoutMs, false);
+}
+
+std::future<McpResponse> McpClientSession::ping(int timeoutMs) {
+    return request("ping", nullptr, timeoutMs);
+}
+
+uint64_t McpClientSession::listTools(ResponseCallback callback, int timeoutMs) {
+    return send("tools/list", nullptr, std::move(callback), timeoutMs, false);
+}
+
+std::future<McpResponse> McpClientSession::listTools(int timeoutMs) {
+    return request("tools/list", nullptr, timeoutMs);
+}
+
+uint64_t McpClientSession::callTool(const std::string& name, const nlohmann::json& arguments,
+                                    ResponseCallback callback, int timeoutMs) {
+    return send("tools/call", {{"name", name}, {"arguments", arguments}}, std::move(callback), timeoutMs, false);
+}
+
+std::future<McpResponse> McpClientSession::callTool(const std::string& name, const nlohmann::json& arguments,
+                                                    int timeoutMs) {
+    return request("tools/call", {{"name", name}, {"arguments", arguments}}, timeoutMs);
+}
+
+void McpClientSession::getTools(ToolCatalogCallback callback, int timeoutMs) {
+    uint64_t generation;
+    {
+        std::unique_lock<std::mutex> lock(toolsMutex_);
+        if (tools_ && isReady()) {
+            ToolCatalogPtr catalog = tools_;
+            lock.unlock();
+            callback(McpResponse(), std::move(catalog));
+            return;
+        }
+        toolsWaiting_.push_back(std::move(callback));
+        if (toolsWaiting_.size() > 1) {
+            return;     // Answered with the tools/list already in flight
+        }
+        generation = toolsGeneration_;
+    }
+
+    auto self = shared_from_this();
+    send("tools/list", nullptr, [self, generation](McpResponse response) {
+        self->finishListTools(generation, response);
+    }, timeoutMs, false);
+}
+
+std::future<ToolCatalogPtr> McpClientSession::getTools(int timeoutMs) {
+    auto promise = std::make_shared<std::promise<ToolCatalogPtr>>();
+    std::future<ToolCatalogPtr> future = promise->get_future();
+    getTools([promise](const McpResponse&, ToolCatalogPtr catalog) { promise->set_value(std::move(catalog)); },
+             timeoutMs);
+    return future;
+}
+
+ToolCatalogPtr McpClientSession::getCachedTools() const {
+    std::lock_guard<std::mutex> lock(toolsMutex_);
+    return tools_;
+}
+
+void McpClientSession::invalidateTools() {
+    std::lock_guard<std::mutex> lock(toolsMutex_);
+    tools_.reset();
+    ++toolsGeneration_;
+}
+
+bool McpClientSession::cancel(uint64_t requestId, const std::string& reason) {
+    if (requestId == 0 || !complete(requestId, statusResponse(RequestStatus::CANCELLED, "Cancelled by client"))) {
+        return false;
+    }
+    nlohmann::json params = {{"requestId", static_cast<int64_t>(requestId)}};
+    if (!reason.empty()) {
+        params["reason"] = reason;
+    }
+    notify("notifications/cancelled", params);
+    return true;
+}
+
+bool McpClientSession::notify(const std::string& method, const std::optional<nlohmann::json>& params) {
+    if (getState() == State::CLOSED) {
+        return false;
+    }
+    auto notification = JsonRpcNotification::create(method, params);
+    return client_->mqttClient_->publish(rpcTopic_, JsonRpc::serialize(notification.toJson()),
+                                         client_->config_.qos, false);
+}
+
+void McpClientSession::close() {
+    shutDown("closed by client", true);
+}
+
+void McpClientSession::setNotificationCallback(NotificationCallback callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    notificationCallback_ = std::move(callback);
+}
+
+void McpClientSession::setClosedCallback(ClosedCallback callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    closedCallback_ = std::move(callback);
+}
+
+uint64_t McpClientSession::reserve(ResponseCallback&& callback, int timeoutMs) {
+    int64_t deadline = timeoutMs > 0
+        ? (client_->clock_->now() + std::chrono::milliseconds(timeoutMs)).time_since_epoch().count()
+        : INT64_MAX;
+
+    // A slot still held by an older request skips its ID; the next one maps to the next slot
+    for (uint64_t attempt = 0; attempt <= slotMask_; ++attempt) {
+        uint64_t id = nextRequestId_.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots_[id & slotMask_];
+        uint64_t expected = SLOT_FREE;
+        if (!slot.state.compare_exchange_strong(expected, SLOT_BUSY, std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+            continue;
+        }
+        slot.callback = std::move(callback);
+        slot.deadline.store(deadline, std::memory_order_relaxed);
+        inFlight_.fetch_add(1, std::memory_order_relaxed);
+        // Sequentially consistent with the CLOSED check in send() and shutDown()'s sweep
+        slot.state.store(id, std::memory_order_seq_cst);
+        return id;
+    }
+    return 0;
+}
+
+bool McpClientSession::complete(uint64_t id, McpResponse&& response) {
+    // Never a request ID: matching these would take over an idle or filling slot
+    if (id == SLOT_FREE || id == SLOT_BUSY) {
+        return false;
+    }
+    Slot& slot = slots_[id & slotMask_];
+    uint64_t expected = id;
+    if (!slot.state.compare_exchange_strong(expected, SLOT_BUSY, std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+        return false;
+    }
+    ResponseCallback callback = std::move(slot.callback);
+    slot.callback = nullptr;
+    inFlight_.fetch_sub(1, std::memory_order_relaxed);
+    slot.state.store(SLOT_FREE, std::memory_order_release);
+
+    if (callback) {
+        callback(std::move(response));
+    }
+    return true;
+}
+
+uint64_t McpClientSession::send(const std::string& method, const nlohmann::json& params,
+                                ResponseCallback callback, int timeoutMs, bool control) {
+    State state = getState();
+    if (state == State::CLOSED) {
+        callback(statusResponse(RequestStatus::CANCELLED, "Session closed"));
+        return 0;
+    }
+    if (!control && state != State::READY) {
+        callback(statusResponse(RequestStatus::ERROR, "Session not initialized"));
+        return 0;
+    }
+
+    uint64_t id = reserve(std::move(callback), timeoutMs);
+    if (id == 0) {
+        MCP_LOG_WARN("Too many requests in flight: serverId=" << serverId_ << ", method=" << method);
+        callback(statusResponse(RequestStatus::ERROR, "Too many requests in flight"));
+        return 0;
+    }
+    if (state_.load(std::memory_order_seq_cst) == State::CLOSED) {
+        complete(id, statusResponse(RequestStatus::CANCELLED, "Session closed"));
+        return 0;
+    }
+
+    nlohmann::json message;
+    message["jsonrpc"] = JSONRPC_VERSION;
+    message["id"] = static_cast<int64_t>(id);
+    message["method"] = method;
+    if (!params.is_null()) {
+        message["params"] = params;
+    }
+    std::string payload = JsonRpc::serialize(message);
+
+    IMqttClient* mqtt = client_->mqttClient_;
+    int qos = client_->config_.qos;
+    bool sent;
+    if (control) {
+        // The server learns our client ID from the user property
+        std::string controlTopic = std::string(MCP_SERVER_PREFIX) + serverId_ + "/" + serverName_;
+        sent = mqtt->publish(controlTopic, payload, qos, false,
+                             {{USER_PROP_MQTT_CLIENT_ID, client_->clientId_}});
+    } else {
+        sent = mqtt->publish(rpcTopic_, payload, qos, false);
+    }
+    if (!sent) {
+        MCP_LOG_ERROR("Failed to publish request: method=" << method << ", serverId=" << serverId_);
+        complete(id, statusResponse(RequestStatus::ERROR, "Failed to publish request"));
+        return 0;
+    }
+    return id;
+}
+
+void McpClientSession::handleMessage(const std::string& payload) {
+    auto jsonOpt = JsonRpc::parse(payload);
+    if (!jsonOpt || !jsonOpt->is_object()) {
+        MCP_LOG_ERROR("Failed to parse RPC message JSON from serverId=" << serverId_);
+        return;
+    }
+    nlohmann::json& message = *jsonOpt;
+    auto method = message.find("method");
+    auto id = message.find("id");
+
+    // Answer to one of our requests
+    if (method == message.end()) {
+        // IDs we send are positive; the peer can be any client on the broker
+        if (id == message.end() || !id->is_number_unsigned() || id->get<uint64_t>() == 0) {
+            MCP_LOG_WARN("Answer without a request ID we could have sent: serverId=" << serverId_);
+            return;
+        }
+        McpResponse response;
+        auto error = message.find("error");
+        if (error != message.end()) {
+            response.status = RequestStatus::ERROR;
+            response.errorCode = error->value("code", 0);
+            response.errorMessage = error->value("message", "");
+        } else {
+            auto result = message.find("result");
+            if (result != message.end()) {
+                response.result = std::move(*result);
+            }
+        }
+        if (!complete(id->get<uint64_t>(), std::move(response))) {
+            MCP_LOG_DEBUG("Answer to an unknown or expired request: serverId=" << serverId_
+                      << ", id=" << id->dump());
+        }
+        return;
+    }
+
+    std::string methodName = method->is_string() ? method->get<std::string>() : "";
+
+    // Notification from the server
+    if (id == message.end()) {
+        MCP_LOG_DEBUG("Server notification: method=" << methodName << ", serverId=" << serverId_);
+        if (methodName == "notifications/disconnected") {
+            shutDown("disconnected by server", false);
+            return;
+        }
+        if (methodName == "notifications/tools/list_changed") {
+            invalidateTools();
+        }
+        NotificationCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(callbackMutex_);
+            callback = notificationCallback_;
+        }
+        if (callback) {
+            callback(methodName, message.value("params", nlohmann::json::object()));
+        }
+        return;
+    }
+
+    // Request from the server; we only answer ping
+    JsonRpcResponse response = methodName == "ping"
+        ? JsonRpcResponse::success(JsonRpc::jsonToId(*id), nlohmann::json::object())
+        : JsonRpcResponse::errorResponse(JsonRpc::jsonToId(*id), JsonRpcError::METHOD_NOT_FOUND,
+                                         "Method not found: " + methodName);
+    client_->mqttClient_->publish(rpcTopic_, JsonRpc::serialize(response.toJson()),
+                                  client_->config_.qos, false);
+}
+
+void McpClientSession::finishListTools(uint64_t generation, const McpResponse& response) {
+    ToolCatalogPtr catalog;
+    McpResponse outcome;
+    outcome.status = response.status;
+    outcome.errorCode = response.errorCode;
+    outcome.errorMessage = response.errorMessage;
+    if (response.ok()) {
+        catalog = ToolCatalog::fromResult(response.result);
+        if (!catalog) {
+            MCP_LOG_WARN("tools/list result without a tools array: serverId=" << serverId_);
+            outcome.status = RequestStatus::ERROR;
+            outcome.errorMessage = "Malformed tools/list result";
+        }
+    }
+
+    // Without list_changed from the server a cached catalog could go stale unnoticed
+    auto tools = serverCapabilities_.find("tools");
+    bool cacheable = tools != serverCapabilities_.end() && tools->is_object() &&
+                     tools->contains("listChanged") && (*tools)["listChanged"] == true;
+
+    std::vector<ToolCatalogCallback> waiting;
+    {
+        std::lock_guard<std::mutex> lock(toolsMutex_);
+        waiting.swap(toolsWaiting_);
+        // A list_changed that arrived meanwhile may not be reflected in this answer
+        if (catalog && cacheable && generation == toolsGeneration_) {
+            tools_ = catalog;
+        }
+    }
+    MCP_LOG_DEBUG("Listed " << (catalog ? catalog->size() : 0) << " tools for " << waiting.size()
+              << " callers: serverId=" << serverId_);
+    for (auto& callback : waiting) {
+        callback(outcome, catalog);
+    }
+}
+
+void McpClientSession::expire(IClock::TimePoint now) {
+    if (inFlight_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    int64_t nowTicks = now.time_since_epoch().count();
+    for (uint64_t i = 0; i <= slotMask_; ++i) {
+        Slot& slot = slots_[i];
+        uint64_t id = slot.state.load(std::memory_order_acquire);
+        if (id == SLOT_FREE || id == SLOT_BUSY) {
+            continue;
+        }
+        // The deadline may already be a later request's; complete() then finds another ID
+        if (slot.deadline.load(std::memory_order_relaxed) <= nowTicks) {
+            complete(id, statusResponse(RequestStatus::TIMEOUT, "Request timed out"));
+        }
+    }
+}
+
+void McpClientSession::shutDown(const std::string& reason, bool notifyServer) {
+    State previous = state_.exchange(State::CLOSED, std::memory_order_seq_cst);
+    if (previous == State::CLOSED) {
+        return;
+    }
+    MCP_LOG_INFO("Session closed: serverId=" << serverId_ << ", serverName=" << serverName_
+              << " (" << reason << ")");
+
+    IMqttClient* mqtt = client_->mqttClient_;
+    if (notifyServer && previous != State::CREATED) {
+        auto notification = JsonRpcNotification::create("notifications/disconnected");
+        mqtt->publish(rpcTopic_, JsonRpc::serialize(notification.toJson()), client_->config_.qos, false);
+    }
+    // A new session to the same server may already have taken over the topic
+    if (client_->removeSession(this)) {
+        mqtt->unsubscribe(rpcTopic_);
+    }
+
+    for (uint64_t i = 0; i <= slotMask_; ++i) {
+        uint64_t id = slots_[i].state.load(std::memory_order_seq_cst);
+        if (id != SLOT_FREE && id != SLOT_BUSY) {
+            complete(id, statusResponse(RequestStatus::CANCELLED, "Session closed: " + reason));
+        }
+    }
+
+    ClosedCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        callback = closedCallback_;
+    }
+    if (callback) {
+        callback(reason);
+    }
+}
+
+// McpClient
+
+McpClient::McpClient() : clock_(&SystemClock::instance()) {
+}
+
+McpClient::~McpClient() {
+    if (running_) {
+        stop();
+    }
+    cancelTimeoutCheck();
+}
+
+bool McpClient::start(IMqttClient* mqttClient, const McpClientConfig& config) {
+    if (running_) {
+        MCP_LOG_WARN("Client already running, ignoring start()");
+        return false;
+    }
+    if (!mqttClient || !mqttClient->isConnected()) {
+        MCP_LOG_ERROR("MQTT client is not connected");
+        return false;
+    }
+
+    mqttClient_ = mqttClient;
+    config_ = config;
+    clientId_ = config.clientId.empty() ? mqttClient->getClientId() : config.clientId;
+
+    MCP_LOG_INFO("Starting MCP client: clientId=" << clientId_);
+
+    if (config_.setWill) {
+        // Set MQTT 5.0 CONNECT properties (called before setWill so reconnect applies both)
+        mqttClient_->setConnectProperties(0, {{USER_PROP_COMPONENT_TYPE, COMPONENT_TYPE_CLIENT}});
+
+        // Servers end our sessions when the broker publishes the Will
+        auto notification = JsonRpcNotification::create("notifications/disconnected");
+        mqttClient_->setWill(getClientPresenceTopic(), JsonRpc::serialize(notification.toJson()),
+                             config_.qos, false);
+        MCP_LOG_DEBUG("Set Will message on topic: " << getClientPresenceTopic());
+    }
+
+    // Register our message handler - SDK will filter MCP topics
+    mqttClient_->setMessageHandler([this](const MqttIncomingMessage& msg) {
+        handleIncomingMessage(msg);
+    });
+    mqttClient_->setConnectionLostCallback([](const std::string& reason) {
+        MCP_LOG_ERROR("MQTT connection lost: " << reason);
+    });
+
+    running_ = true;
+
+    // Retained presence messages report the servers that are already online
+    mqttClient_->subscribe(std::string(MCP_PRESENCE_PREFIX) + "#", config_.qos, false);
+    scheduleTimeoutCheck();
+
+    MCP_LOG_INFO("MCP client started successfully");
+    return true;
+}
+
+void McpClient::stop() {
+    {
+        std::lock_guard<std::mutex> lock(timerMutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cancelTimeoutCheck();
+    MCP_LOG_INFO("Stopping MCP client: clientId=" << clientId_);
+
+    for (const auto& session : getSessions()) {
+        session->shutDown("client stopped", true);
+    }
+    mqttClient_->unsubscribe(std::string(MCP_PRESENCE_PREFIX) + "#");
+    directory_.clear();
+    MCP_LOG_INFO("MCP client stopped");
+}
+
+bool McpClient::isRunning() const {
+    return running_;
+}
+
+void McpClient::setClock(IClock* clock) {
+    clock_ = clock ? clock : &SystemClock::instance();
+}
+
+std::vector<DiscoveredServer> McpClient::getServers() const {
+    ServerDirectory::View view = directory_.read();
+    std::vector<DiscoveredServer> servers;
+    servers.reserve(view.size());
+    for (const auto& server : view.all()) {
+        servers.push_back(*server);
+    }
+    return servers;
+}
+
+const ServerDirectory& McpClient::getDirectory() const {
+    return directory_;
+}
+
+void McpClient::setServerOnlineCallback(ServerOnlineCallback callback) {
+    std::lock_guard<std::mutex> lock(serversMutex_);
+    serverOnlineCallback_ = std::move(callback);
+}
+
+void McpClient::setServerOfflineCallback(ServerOfflineCallback callback) {
+    std::lock_guard<std::mutex> lock(serversMutex_);
+    serverOfflineCallback_ = std::move(callback);
+}
+
+std::shared_ptr<McpClientSession> McpClient::createSession(const std::string& serverId,
+                                                           const std::string& serverName) {
+    if (!running_) {
+        MCP_LOG_ERROR("Client not running, cannot create a session");
+        return nullptr;
+    }
+
+    std::string rpcTopic = getRpcTopic(serverId, serverName);
+    std::shared_ptr<McpClientSession> session;
+    {
+        std::unique_lock<std::shared_mutex> lock(sessionsMutex_);
+        auto it = sessions_.find(rpcTopic);
+        if (it != sessions_.end() && it->second->getState() != McpClientSession::State::CLOSED) {
+            return it->second;
+        }
+        session = std::make_shared<McpClientSession>(this, serverId, serverName, config_.maxInFlight);
+        sessions_[rpcTopic] = session;
+    }
+
+    // Subscribe before initialize so the response cannot overtake us. No Local:
+    // our own requests on the topic are not for us.
+    mqttClient_->subscribe(rpcTopic, config_.qos, true);
+    MCP_LOG_DEBUG("Subscribed to RPC topic: " << rpcTopic);
+    return session;
+}
+
+std::vector<std::shared_ptr<McpClientSession>> McpClient::getSessions() const {
+    std::shared_lock<std::shared_mutex> lock(sessionsMutex_);
+    std::vector<std::shared_ptr<McpClientSession>> sessions;
+    sessions.reserve(sessions_.size());
+    for (const auto& [topic, session] : sessions_) {
+        sessions.push_back(session);
+    }
+    return sessions;
+}
+
+const std::string& McpClient::getClientId() const {
+    return clientId_;
+}
+
+IClock* McpClient::getClock() const {
+    return clock_;
+}
+
+// Internal methods
+
+void McpClient::handleIncomingMessage(const MqttIncomingMessage& message) {
+    const std::string& topic = message.topic;
+    if (topic.rfind(MCP_RPC_PREFIX, 0) == 0) {
+        std::shared_ptr<McpClientSession> session;
+        {
+            std::shared_lock<std::shared_mutex> lock(sessionsMutex_);
+            auto it = sessions_.find(topic);
+            if (it != sessions_.end()) {
+                session = it->second;
+            }
+        }
+        if (!session) {
+            MCP_LOG_DEBUG("RPC message for no open session: " << topic);
+            return;
+        }
+        if (message.payload.empty()) {
+            MCP_LOG_WARN("Empty payload on RPC topic: " << topic);
+            return;
+        }
+        session->handleMessage(message.payload);
+    } else if (topic.rfind(MCP_PRESENCE_PREFIX, 0) == 0) {
+        handlePresence(message);
+    } else {
+        MCP_LOG_DEBUG("Ignoring topic: " << topic);
+    }
+}
+
+void McpClient::handlePresence(const MqttIncomingMessage& message) {
+    std::vector<ServerDirectory::ServerPtr> servers;
+    ServerDirectory::Change change = directory_.applyPresence(message, &servers);
+    if (change == ServerDirectory::Change::NONE) {
+        return;
+    }
+
+    ServerOnlineCallback onlineCallback;
+    ServerOfflineCallback offlineCallback;
+    {
+        std::lock_guard<std::mutex> lock(serversMutex_);
+        onlineCallback = serverOnlineCallback_;
+        offlineCallback = serverOfflineCallback_;
+    }
+
+    if (change == ServerDirectory::Change::OFFLINE) {
+        // A host going offline takes all its servers with it
+        auto sessions = getSessions();
+        for (const auto& server : servers) {
+            MCP_LOG_INFO("Server offline: serverId=" << server->serverId << ", serverName=" << server->serverName);
+
+            // Nobody is left to answer the sessions' requests
+            for (const auto& session : sessions) {
+                if (session->getServerId() == server->serverId && session->getServerName() == server->serverName) {
+                    session->shutDown("server offline", false);
+                }
+            }
+            if (offlineCallback) {
+                offlineCallback(server->serverId, server->serverName);
+            }
+        }
+        return;
+    }
+
+    const auto& server = servers.front();
+    MCP_LOG_DEBUG("Server online: serverId=" << server->serverId << ", serverName=" << server->serverName);
+    if (onlineCallback) {
+        onlineCallback(*server);
+    }
+}
+
+// Set while a timeout check runs, so stopping the client from a timeout
+// callback does not wait for itself
+static thread_local const McpClient* tlsCheckingClient = nullptr;
+
+void McpClient::scheduleTimeoutCheck() {
+    std::lock_guard<std::mutex> lock(timerMutex_);
+    if (running_) {
+        timeoutTimer_ = clock_->scheduleAfter(config_.timeoutCheckInterval, [this]() { checkTimeouts(); });
+        if (timeoutTimer_ != 0) {
+            ++timersInFlight_;
+        }
+    }
+}
+
+void McpClient::cancelTimeoutCheck() {
+    std::unique_lock<std::mutex> lock(timerMutex_);
+    if (timeoutTimer_ != 0) {
+        if (clock_->cancel(timeoutTimer_)) {
+            --timersInFlight_;
+        }
+        timeoutTimer_ = 0;
+    }
+    // IClock::cancel() does not wait for a check that already fired
+    if (tlsCheckingClient != this) {
+        timerDone_.wait(lock, [this]() { return timersInFlight_ == 0; });
+    }
+}
+
+void McpClient::checkTimeouts() {
+    std::vector<std::shared_ptr<McpClientSession>> sessions;
+    IClock::TimePoint now;
+    {
+        std::lock_guard<std::mutex> lock(timerMutex_);
+        if (running_) {
+            sessions = getSessions();
+            now = clock_->now();
+            timeoutTimer_ = clock_->scheduleAfter(config_.timeoutCheckInterval, [this]() { checkTimeouts(); });
+            if (timeoutTimer_ != 0) {
+                ++timersInFlight_;
+            }
+        }
+    }
+    const McpClient* previous = tlsCheckingClient;
+    tlsCheckingClient = this;
+    for (const auto& session : sessions) {
+        session->expire(now);
+    }
+    tlsCheckingClient = previous;
+
+    // Last use of this; cancelTimeoutCheck() may be waiting to destroy it
+    std::lock_guard<std::mutex> lock(timerMutex_);
+    --timersInFlight_;
+    timerDone_.notify_all();
+}
+
+bool McpClient::removeSession(const McpClientSession* session) {
+    std::unique_lock<std::shared_mutex> lock(sessionsMutex_);
+    auto it = sessions_.find(session->getRpcTopic());
+    if (it == sessions_.end() || it->second.get() != session) {
+        return false;
+    }
+    sessions_.erase(it);
+    return true;
+}
+
+std::string McpClient::getRpcTopic(const std::string& serverId, const std::string& serverName) const {
+    // Format: $mcp-rpc/{mcp-client-id}/{server-id}/{server-name}
+    return std::string(MCP_RPC_PREFIX) + clientId_ + "/" + serverId + "/" + serverName;
+}
+
+std::string McpClient::getClientPresenceTopic() const {
+    // Format: $mcp-client/presence/{mcp-client-id}
+    return std::string(MCP_CLIENT_PRESENCE_PREFIX) + clientId_;
+}
+
+} // namespace mcp_mqtt
@@ -1,5 +1,9 @@
 #include "mcp_mqtt/mcp_server.h"
 #include "mcp_mqtt/logger.h"
+#include "mcp_mqtt/shm_channel.h"
+
+#include <cstdio>
+#include <random>
 
 namespace mcp_mqtt {
 
@@ -7,13 +11,39 @@ namespace mcp_mqtt {
 static constexpr const char* MCP_SERVER_PREFIX = "$mcp-server/";
 static constexpr const char* MCP_CLIENT_PREFIX = "$mcp-client/";
 static constexpr const char* MCP_RPC_PREFIX = "$mcp-rpc/";
+static constexpr const char* MCP_MIRROR_PREFIX = "$mcp-server/mirror/";
+static constexpr const char* MCP_LEADER_PREFIX = "$mcp-server/leader/";
+
+// Journal key of an exactly-once call. Clients number requests per session,
+// so the arguments are part of it: a reused request ID with other arguments
+// is a new call. FNV-1a, because keys outlive the process.
+static std::string executionKeyFor(const std::string& mcpClientId, const std::string& toolName,
+                                   const JsonRpcId& id, const nlohmann::json& arguments) {
+    std::string key = mcpClientId + '\n' + toolName + '\n';
+    if (const auto* number = std::get_if<int64_t>(&id)) {
+        key += std::to_string(*number);
+    } else if (const auto* text = std::get_if<std::string>(&id)) {
+        key += '"' + *text + '"';
+    }
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : arguments.dump()) {     // Object keys are sorted, so this is canonical
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return key + '\n' + hex;
+}
 
-McpServer::McpServer() = default;
+McpServer::McpServer() : clock_(&SystemClock::instance()) {
+}
 
 McpServer::~McpServer() {
     if (running_) {
         stop();
     }
+    // Also when stop() had nothing to do: a list_changed timer can still be
+    // pending or its callback running
+    cancelToolsListChanged();
 }
 
 void McpServer::configure(const ServerInfo& serverInfo, const ServerCapabilities& capabilities) {
@@ -35,46 +65,105 @@ bool McpServer::start(IMqttClient* mqttClient, const McpServerConfig& config) {
         return false;
     }
 
-    if (!mqttClient || !mqttClient->isConnected()) {
+    if (mqttClient && !mqttClient->isConnected()) {
         MCP_LOG_ERROR("MQTT client is not connected");
         return false;
     }
+    if (!mqttClient && config.role == ReplicaRole::STANDBY) {
+        MCP_LOG_ERROR("A standby needs an MQTT client");
+        return false;
+    }
 
     mqttClient_ = mqttClient;
     serverId_ = config.serverId;
     serverName_ = config.serverName;
+    role_ = config.role;
+    qosPolicy_ = config.qos;
+    {
+        std::lock_guard<std::mutex> lock(listChangedMutex_);
+        listChangedDebounce_ = config.toolsListChangedDebounce;
+    }
 
     MCP_LOG_INFO("Starting MCP server: serverId=" << serverId_ << ", serverName=" << serverName_);
 
+    if (!mqttClient_) {
+        running_ = true;
+        MCP_LOG_INFO("MCP server started without MQTT, serving local transports only");
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(topicAliasMutex_);
+        topicAliasMaximum_ = mqttClient_.load()->getTopicAliasMaximum();
+        nextTopicAlias_ = 1;
+        freeTopicAliases_.clear();
+        sessionTopicAliases_.clear();
+    }
+
     // Set MQTT 5.0 CONNECT properties (called before setWill so reconnect applies both)
     std::map<std::string, std::string> connectUserProps = {
         {USER_PROP_COMPONENT_TYPE, COMPONENT_TYPE_SERVER}
     };
-    mqttClient_->setConnectProperties(0, connectUserProps);
+    mqttClient_.load()->setConnectProperties(0, connectUserProps);
     MCP_LOG_DEBUG("Set connect properties: SESSION_EXPIRY_INTERVAL=0, "
               << USER_PROP_COMPONENT_TYPE << "=" << COMPONENT_TYPE_SERVER);
 
+    if (role_ == ReplicaRole::STANDBY) {
+        // A standby must not set the presence Will yet: if it died while the
+        // primary is alive, the broker would clear the primary's presence.
+        mqttClient_.load()->setMessageHandler([this](const MqttIncomingMessage& msg) {
+            handleIncomingMessage(msg);
+        });
+        // isRunning() reports the connection; running_ stays set for a reconnect
+        mqttClient_.load()->setConnectionLostCallback([](const std::string& reason) {
+            MCP_LOG_ERROR("MQTT connection lost: " << reason);
+        });
+        reconnectReported_ = mqttClient_.load()->setConnectionRestoredCallback([this]() {
+            handleConnectionRestored();
+        });
+        announcePending_ = false;
+
+        standby_ = true;
+        running_ = true;
+
+        // The retained presence tells us the primary is up; the retained
+        // mirror messages give us a snapshot of its current sessions.
+        mqttClient_.load()->subscribe(getMirrorTopicPrefix() + "#", 1, false);
+        mqttClient_.load()->subscribe(getPresenceTopic(), 1, false);
+        mqttClient_.load()->subscribe(getHostPresenceTopic(), 1, false);
+        MCP_LOG_INFO("MCP server started in standby mode");
+        return true;
+    }
+
     // Set Will message for presence cleanup on unexpected disconnection
     std::string presenceTopic = getPresenceTopic();
-    mqttClient_->setWill(presenceTopic, "", 1, true);
+    mqttClient_.load()->setWill(presenceTopic, "", qosPolicy_.presence, true);
     MCP_LOG_DEBUG("Set Will message on topic: " << presenceTopic);
 
     // Register our message handler - SDK will filter MCP topics
-    mqttClient_->setMessageHandler([this](const MqttIncomingMessage& msg) {
+    mqttClient_.load()->setMessageHandler([this](const MqttIncomingMessage& msg) {
         handleIncomingMessage(msg);
     });
 
-    // Set connection lost callback
-    mqttClient_->setConnectionLostCallback([this](const std::string& reason) {
+    // Set connection lost callback. isRunning() reports the connection;
+    // running_ stays set, so a reconnect can restore the server.
+    mqttClient_.load()->setConnectionLostCallback([](const std::string& reason) {
         MCP_LOG_ERROR("MQTT connection lost: " << reason);
-        running_ = false;
     });
+    reconnectReported_ = mqttClient_.load()->setConnectionRestoredCallback([this]() {
+        handleConnectionRestored();
+    });
+    announcePending_ = false;
 
     // Setup MCP subscriptions
     setupSubscriptions();
 
     // Publish presence (server online notification)
     publishPresence();
+    fenced_ = false;
+    if (role_ == ReplicaRole::PRIMARY) {
+        claimLeadership();
+    }
 
     running_ = true;
     MCP_LOG_INFO("MCP server started successfully");
@@ -87,24 +176,62 @@ void McpServer::stop() {
     }
 
     MCP_LOG_INFO("Stopping MCP server...");
+    cancelToolsListChanged();
+
+    if (standby_) {
+        // Sessions belong to the primary; just stop mirroring them
+        mqttClient_.load()->unsubscribe(getMirrorTopicPrefix() + "#");
+        mqttClient_.load()->unsubscribe(getPresenceTopic());
+        mqttClient_.load()->unsubscribe(getHostPresenceTopic());
+        mqttClient_.load()->setConnectionRestoredCallback(nullptr);
+        {
+            std::lock_guard<std::mutex> lock(sessionsMutex_);
+            clientSessions_.clear();
+        }
+        standby_ = false;
+        running_ = false;
+        mqttClient_ = nullptr;
+        MCP_LOG_INFO("MCP standby stopped");
+        return;
+    }
+
+    // Unsubscribe while the sessions, whose topics it needs, still exist
+    cleanupSubscriptions();
+    if (role_ == ReplicaRole::PRIMARY && mqttClient_) {
+        mqttClient_.load()->unsubscribe(getLeaderTopic());
+    }
 
-    // Send disconnected notifications to all connected clients
+    // Send disconnected notifications to all connected clients. Publishing
+    // looks sessions up (topic aliases), so it runs outside sessionsMutex_.
+    std::vector<std::string> clientIds = getConnectedClients();
+    for (const auto& clientId : clientIds) {
+        MCP_LOG_DEBUG("Sending disconnect notification to client: " << clientId);
+        auto notif = JsonRpcNotification::create("notifications/disconnected");
+        sendNotification(clientId, notif);
+        unmirrorSession(clientId);
+    }
     {
         std::lock_guard<std::mutex> lock(sessionsMutex_);
-        for (const auto& [clientId, session] : clientSessions_) {
-            MCP_LOG_DEBUG("Sending disconnect notification to client: " << clientId);
-            auto notif = JsonRpcNotification::create("notifications/disconnected");
-            sendNotification(clientId, notif);
-        }
         MCP_LOG_INFO("Cleared " << clientSessions_.size() << " client session(s)");
         clientSessions_.clear();
     }
 
+    // Close non-MQTT session transports
+    std::map<std::string, std::shared_ptr<ISessionTransport>> transports;
+    {
+        std::lock_guard<std::mutex> lock(transportsMutex_);
+        transports.swap(sessionTransports_);
+        localSessions_.clear();
+    }
+    for (auto& [clientId, transport] : transports) {
+        transport->close();
+    }
+
     // Clear presence
     clearPresence();
-
-    // Cleanup subscriptions
-    cleanupSubscriptions();
+    if (mqttClient_) {
+        mqttClient_.load()->setConnectionRestoredCallback(nullptr);
+    }
 
     running_ = false;
     mqttClient_ = nullptr;
@@ -112,13 +239,50 @@ void McpServer::stop() {
 }
 
 bool McpServer::isRunning() const {
-    return running_ && mqttClient_ && mqttClient_->isConnected();
+    IMqttClient* client = mqttClient_;
+    return running_ && (!client || client->isConnected());
+}
+
+bool McpServer::isStandby() const {
+    return standby_;
+}
+
+void McpServer::setSharedMemoryTransport(bool enabled, size_t ringCapacity) {
+    shmEnabled_ = enabled;
+    shmRingCapacity_ = ringCapacity;
+    MCP_LOG_DEBUG("Shared memory transport " << (enabled ? "enabled" : "disabled")
+              << ", ring capacity=" << ringCapacity);
+}
+
+void McpServer::setMessageExpiryInterval(uint32_t seconds) {
+    messageExpiryInterval_ = seconds;
+    MCP_LOG_DEBUG("Message expiry interval for responses and notifications: " << seconds << "s");
+}
+
+void McpServer::setExecutionJournal(ExecutionJournal* journal) {
+    std::lock_guard<std::mutex> lock(exactlyOnceMutex_);
+    executionJournal_ = journal;
+}
+
+void McpServer::setToolExactlyOnce(const std::string& toolName, bool enabled) {
+    std::lock_guard<std::mutex> lock(exactlyOnceMutex_);
+    if (enabled) {
+        exactlyOnceTools_.insert(toolName);
+    } else {
+        exactlyOnceTools_.erase(toolName);
+    }
+    MCP_LOG_DEBUG("Exactly-once mode " << (enabled ? "enabled" : "disabled") << " for tool: " << toolName);
+}
+
+void McpServer::setClock(IClock* clock) {
+    clock_ = clock ? clock : &SystemClock::instance();
 }
 
 bool McpServer::registerTool(const Tool& tool, ToolHandler handler) {
     bool ok = toolManager_.registerTool(tool, handler);
     if (ok) {
         MCP_LOG_INFO("Tool registered: " << tool.name);
+        scheduleToolsListChanged();
     } else {
         MCP_LOG_WARN("Failed to register tool (already exists?): " << tool.name);
     }
@@ -126,8 +290,10 @@ bool McpServer::registerTool(const Tool& tool, ToolHandler handler) {
 }
 
 void McpServer::unregisterTool(const std::string& name) {
-    toolManager_.unregisterTool(name);
-    MCP_LOG_INFO("Tool unregistered: " << name);
+    if (toolManager_.unregisterTool(name)) {
+        MCP_LOG_INFO("Tool unregistered: " << name);
+        scheduleToolsListChanged();
+    }
 }
 
 std::vector<Tool> McpServer::getTools() const {
@@ -165,7 +331,7 @@ std::vector<std::string> McpServer::getConnectedClients() const {
 void McpServer::publishPresence() {
     std::string topic = getPresenceTopic();
 
-    auto notif = JsonRpcNotification::create("notifications/server/online", onlineParams_.toJson());
+    auto notif = JsonRpcNotification::create(METHOD_SERVER_ONLINE, onlineParams_.toJson());
     std::string payload = JsonRpc::serialize(notif.toJson());
 
     // Publish with retain flag
@@ -173,7 +339,7 @@ void McpServer::publishPresence() {
         {USER_PROP_COMPONENT_TYPE, COMPONENT_TYPE_SERVER},
         {USER_PROP_MQTT_CLIENT_ID, serverId_}
     };
-    mqttClient_->publish(topic, payload, 1, true, props);
+    mqttClient_.load()->publish(topic, payload, qosPolicy_.presence, true, props);
     MCP_LOG_DEBUG("Published presence on topic: " << topic);
 }
 
@@ -182,14 +348,14 @@ void McpServer::clearPresence() {
 
     std::string topic = getPresenceTopic();
     // Publish empty retained message to clear presence
-    mqttClient_->publish(topic, "", 1, true, {});
+    mqttClient_.load()->publish(topic, "", qosPolicy_.presence, true, {});
     MCP_LOG_DEBUG("Cleared presence on topic: " << topic);
 }
 
 void McpServer::setupSubscriptions() {
     // Subscribe to control topic
     std::string controlTopic = getControlTopic();
-    mqttClient_->subscribe(controlTopic, 1, false);
+    mqttClient_.load()->subscribe(controlTopic, qosPolicy_.subscription, false);
     MCP_LOG_DEBUG("Subscribed to control topic: " << controlTopic);
 }
 
@@ -198,14 +364,14 @@ void McpServer::cleanupSubscriptions() {
 
     // Unsubscribe from control topic
     std::string controlTopic = getControlTopic();
-    mqttClient_->unsubscribe(controlTopic);
+    mqttClient_.load()->unsubscribe(controlTopic);
     MCP_LOG_DEBUG("Unsubscribed from control topic: " << controlTopic);
 
     // Unsubscribe from all client RPC and presence topics
     std::lock_guard<std::mutex> lock(sessionsMutex_);
     for (const auto& [clientId, session] : clientSessions_) {
-        mqttClient_->unsubscribe(getRpcTopic(clientId));
-        mqttClient_->unsubscribe(getClientPresenceTopic(clientId));
+        mqttClient_.load()->unsubscribe(getRpcTopic(clientId));
+        mqttClient_.load()->unsubscribe(getClientPresenceTopic(clientId));
         MCP_LOG_DEBUG("Unsubscribed from client topics: clientId=" << clientId);
     }
 }
@@ -216,6 +382,20 @@ bool McpServer::isMcpTopic(const std::string& topic) const {
            topic.rfind(MCP_RPC_PREFIX, 0) == 0;
 }
 
+// Message whose request is being dispatched on this thread. Dispatch is
+// synchronous, so responses sent meanwhile answer it and echo its correlation data.
+static thread_local const MqttIncomingMessage* tlsDispatchedMessage = nullptr;
+
+namespace {
+struct DispatchScope {
+    const MqttIncomingMessage* previous;
+    explicit DispatchScope(const MqttIncomingMessage& message) : previous(tlsDispatchedMessage) {
+        tlsDispatchedMessage = &message;
+    }
+    ~DispatchScope() { tlsDispatchedMessage = previous; }
+};
+} // namespace
+
 void McpServer::handleIncomingMessage(const MqttIncomingMessage& message) {
     MCP_LOG_DEBUG("Received MQTT message: topic=" << message.topic
               << ", payload=" << message.payload
@@ -231,6 +411,33 @@ void McpServer::handleIncomingMessage(const MqttIncomingMessage& message) {
     const std::string& topic = message.topic;
     const std::string& payload = message.payload;
 
+    if (topic == getLeaderTopic()) {
+        handleLeaderRecord(payload);
+        return;
+    }
+
+    // A standby only follows the primary's presence and session mirror
+    if (standby_) {
+        if (topic == getPresenceTopic()) {
+            handlePrimaryPresence(payload);
+        } else if (topic == getHostPresenceTopic()) {
+            handlePrimaryHostPresence(payload);
+        } else if (topic.rfind(getMirrorTopicPrefix(), 0) == 0) {
+            handleMirrorMessage(topic, payload);
+        } else {
+            MCP_LOG_DEBUG("Standby ignoring MCP topic: " << topic);
+        }
+        return;
+    }
+
+    // A reconnected primary serves nothing until it knows it still is one
+    if (fenced_) {
+        MCP_LOG_DEBUG("Fenced until the leader record confirms us, dropping: " << topic);
+        return;
+    }
+
+    DispatchScope scope(message);
+
     // Route to appropriate handler based on topic prefix
     if (topic.rfind(MCP_RPC_PREFIX, 0) == 0) {
         // RPC message
@@ -282,11 +489,57 @@ void McpServer::handleControlMessage(const std::string& topic, const std::string
         MCP_LOG_DEBUG("Client ID from params: " << mcpClientId);
     }
 
-    if (request.method == "initialize" && !mcpClientId.empty()) {
+    if (mcpClientId.empty()) {
+        MCP_LOG_WARN("Control request without client ID: method=" << request.method);
+        return;
+    }
+    dispatchControl(mcpClientId, request);
+}
+
+void McpServer::dispatchControl(const std::string& mcpClientId, const JsonRpcRequest& request) {
+    if (request.method == "initialize") {
         handleInitialize(mcpClientId, request);
     } else {
-        MCP_LOG_WARN("Unhandled control method=" << request.method << " or empty clientId");
+        MCP_LOG_WARN("Unhandled control method=" << request.method << ", client=" << mcpClientId);
+    }
+}
+
+void McpServer::handleLocalMessage(const std::string& mcpClientId, const std::string& payload,
+                                   const std::shared_ptr<ISessionTransport>& transport) {
+    if (!running_ || standby_) {
+        MCP_LOG_DEBUG("Not serving, ignoring local message from client=" << mcpClientId);
+        return;
+    }
+
+    // initialize is a control message on MQTT; locally it arrives in-band and
+    // opens the session, which is then served over this transport
+    auto jsonOpt = JsonRpc::parse(payload);
+    if (jsonOpt && jsonOpt->is_object() && jsonOpt->value("method", "") == "initialize" &&
+        jsonOpt->contains("id")) {
+        auto reqOpt = JsonRpcRequest::fromJson(*jsonOpt);
+        if (!reqOpt) {
+            MCP_LOG_ERROR("Invalid initialize request from local client=" << mcpClientId);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(transportsMutex_);
+            sessionTransports_[mcpClientId] = transport;
+            localSessions_.insert(mcpClientId);
+        }
+        dispatchControl(mcpClientId, *reqOpt);
+        return;
+    }
+
+    dispatchRpc(mcpClientId, payload);
+}
+
+void McpServer::closeLocalSession(const std::string& mcpClientId) {
+    if (!isLocalSession(mcpClientId)) {
+        return;
     }
+    MCP_LOG_INFO("Local client went away: " << mcpClientId);
+    cleanupClientSession(mcpClientId);
+    detachTransport(mcpClientId);   // Also if the session never initialized
 }
 
 void McpServer::handleRpcMessage(const std::string& topic, const std::string& payload) {
@@ -304,6 +557,10 @@ void McpServer::handleRpcMessage(const std::string& topic, const std::string& pa
         return;
     }
 
+    dispatchRpc(mcpClientId, payload);
+}
+
+void McpServer::dispatchRpc(const std::string& mcpClientId, const std::string& payload) {
     MCP_LOG_DEBUG("RPC message from client=" << mcpClientId << ", payload=" << payload);
 
     auto jsonOpt = JsonRpc::parse(payload);
@@ -349,7 +606,7 @@ void McpServer::handleRpcMessage(const std::string& topic, const std::string& pa
         auto response = JsonRpcResponse::errorResponse(
             request.id, JsonRpcError::METHOD_NOT_FOUND,
             "Method not found: " + request.method);
-        sendResponse(mcpClientId, response);
+        sendResponse(mcpClientId, response, qosPolicy_.qosFor(MessageClass::RESPONSE));
     }
 }
 
@@ -379,6 +636,187 @@ void McpServer::handleClientPresence(const std::string& topic, const std::string
     }
 }
 
+void McpServer::handlePrimaryPresence(const std::string& payload) {
+    if (!payload.empty()) {
+        MCP_LOG_DEBUG("Primary is online: serverId=" << serverId_ << ", serverName=" << serverName_);
+        return;
+    }
+
+    MCP_LOG_WARN("Primary presence cleared, standby taking over: serverId=" << serverId_
+              << ", serverName=" << serverName_);
+    takeOver();
+}
+
+void McpServer::handlePrimaryHostPresence(const std::string& payload) {
+    // A primary hosted by McpServerHost leaves its presence behind when the
+    // host dies; the host's Will reports it on the host presence topic instead
+    auto jsonOpt = JsonRpc::parse(payload);
+    if (!jsonOpt || !jsonOpt->is_object() || jsonOpt->value("method", "") != METHOD_SERVER_OFFLINE) {
+        return;
+    }
+
+    MCP_LOG_WARN("Primary host went offline, standby taking over: serverId=" << serverId_
+              << ", serverName=" << serverName_);
+    takeOver();
+}
+
+void McpServer::handleMirrorMessage(const std::string& topic, const std::string& payload) {
+    // Topic format: $mcp-server/mirror/{server-id}/{server-name}/{mcp-client-id}
+    std::string mcpClientId = topic.substr(getMirrorTopicPrefix().length());
+    if (mcpClientId.empty()) {
+        MCP_LOG_WARN("Failed to parse client ID from mirror topic: " << topic);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(sessionsMutex_);
+    if (payload.empty()) {
+        clientSessions_.erase(mcpClientId);
+        MCP_LOG_DEBUG("Mirrored session removed: " << mcpClientId);
+        return;
+    }
+
+    auto jsonOpt = JsonRpc::parse(payload);
+    if (!jsonOpt || !jsonOpt->is_object()) {
+        MCP_LOG_ERROR("Failed to parse mirrored session for client=" << mcpClientId);
+        return;
+    }
+    ClientSession session = ClientSession::fromJson(*jsonOpt);
+    session.mcpClientId = mcpClientId;
+    clientSessions_[mcpClientId] = session;
+    MCP_LOG_DEBUG("Mirrored session updated: " << mcpClientId
+              << ", initialized=" << session.initialized);
+}
+
+void McpServer::takeOver() {
+    if (!standby_.exchange(false)) {
+        return;
+    }
+    // From now on we are the primary and mirror sessions for the next standby
+    role_ = ReplicaRole::PRIMARY;
+
+    mqttClient_.load()->unsubscribe(getPresenceTopic());
+    mqttClient_.load()->unsubscribe(getHostPresenceTopic());
+    mqttClient_.load()->unsubscribe(getMirrorTopicPrefix() + "#");
+
+    // Take over the presence Will. Applying it may reconnect the client in the
+    // background, and what we publish meanwhile can be lost; a client that
+    // reports the reconnect gets our subscriptions and presence afterwards.
+    bool deferred = reconnectReported_;
+    announcePending_ = deferred;
+    std::string presenceTopic = getPresenceTopic();
+    mqttClient_.load()->setWill(presenceTopic, "", qosPolicy_.presence, true);
+    MCP_LOG_DEBUG("Set Will message on topic: " << presenceTopic);
+
+    if (!deferred) {
+        announceAsPrimary();
+    }
+}
+
+void McpServer::announceAsPrimary() {
+    setupSubscriptions();
+
+    std::vector<std::string> clients = getConnectedClients();
+    for (const auto& clientId : clients) {
+        mqttClient_.load()->subscribe(getRpcTopic(clientId), qosPolicy_.subscription, true);
+        mqttClient_.load()->subscribe(getClientPresenceTopic(clientId), qosPolicy_.subscription, false);
+    }
+
+    publishPresence();
+    claimLeadership();
+    MCP_LOG_INFO("Standby took over as primary with " << clients.size() << " mirrored session(s)");
+}
+
+void McpServer::claimLeadership() {
+    // Publish before subscribing, so the retained record we get back is ours
+    // unless another replica claimed the role after us
+    mqttClient_.load()->publish(getLeaderTopic(), mqttClient_.load()->getClientId(), 1, true, {});
+    mqttClient_.load()->subscribe(getLeaderTopic(), 1, false);
+}
+
+void McpServer::handleLeaderRecord(const std::string& payload) {
+    if (role_ != ReplicaRole::PRIMARY || standby_) {
+        return;
+    }
+    std::string self = mqttClient_.load()->getClientId();
+    if (payload == self) {
+        if (fenced_.exchange(false)) {
+            // The old connection's Will may have cleared our presence
+            publishPresence();
+            MCP_LOG_INFO("Still the primary after reconnect, republished presence");
+        }
+        return;
+    }
+    if (payload.empty()) {
+        // The record was cleared, or a demoted replica's Will fired: keep the role
+        mqttClient_.load()->publish(getLeaderTopic(), self, 1, true, {});
+        return;
+    }
+
+    MCP_LOG_WARN("Replica " << payload << " took over as primary, demoting to standby: serverId="
+              << serverId_ << ", serverName=" << serverName_);
+    demoteToStandby();
+}
+
+void McpServer::demoteToStandby() {
+    standby_ = true;
+    role_ = ReplicaRole::STANDBY;
+    fenced_ = false;
+
+    cleanupSubscriptions();
+    mqttClient_.load()->unsubscribe(getLeaderTopic());
+    {
+        // The new primary's mirror messages bring the sessions back
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        clientSessions_.clear();
+    }
+
+    // IMqttClient cannot drop a Will: point ours where it does no harm, instead
+    // of clearing the presence of the primary that replaced us
+    mqttClient_.load()->setWill(getLeaderTopic(), "", qosPolicy_.presence, false);
+
+    mqttClient_.load()->subscribe(getMirrorTopicPrefix() + "#", 1, false);
+    mqttClient_.load()->subscribe(getPresenceTopic(), 1, false);
+    mqttClient_.load()->subscribe(getHostPresenceTopic(), 1, false);
+}
+
+void McpServer::handleConnectionRestored() {
+    if (!running_ || standby_) {
+        return;     // The client restored a standby's subscriptions itself
+    }
+    if (announcePending_.exchange(false)) {
+        announceAsPrimary();
+        return;
+    }
+    if (role_ == ReplicaRole::PRIMARY) {
+        // Our Will may have let the standby take over meanwhile. Serve nothing
+        // until the retained leader record, fetched again by subscribing anew,
+        // says whether we are still the primary.
+        fenced_ = true;
+        mqttClient_.load()->unsubscribe(getLeaderTopic());
+        mqttClient_.load()->subscribe(getLeaderTopic(), 1, false);
+        return;
+    }
+    // The old connection's Will may have cleared our presence
+    publishPresence();
+    MCP_LOG_INFO("Republished presence after reconnect");
+}
+
+void McpServer::mirrorSession(const ClientSession& session) {
+    // A local session cannot move to the standby with its transport
+    if (role_ != ReplicaRole::PRIMARY || isLocalSession(session.mcpClientId)) return;
+
+    std::string payload = JsonRpc::serialize(session.toJson());
+    mqttClient_.load()->publish(getMirrorTopicPrefix() + session.mcpClientId, payload, 1, true, {});
+    MCP_LOG_DEBUG("Mirrored session: " << session.mcpClientId);
+}
+
+void McpServer::unmirrorSession(const std::string& mcpClientId) {
+    if (role_ != ReplicaRole::PRIMARY || isLocalSession(mcpClientId)) return;
+
+    mqttClient_.load()->publish(getMirrorTopicPrefix() + mcpClientId, "", 1, true, {});
+    MCP_LOG_DEBUG("Cleared mirrored session: " << mcpClientId);
+}
+
 void McpServer::handleInitialize(const std::string& mcpClientId, const JsonRpcRequest& request) {
     MCP_LOG_INFO("Initializing client session: " << mcpClientId);
 
@@ -408,21 +846,25 @@ void McpServer::handleInitialize(const std::string& mcpClientId, const JsonRpcRe
         }
     }
 
-    // Subscribe to RPC topic for this client (with No Local option)
-    std::string rpcTopic = getRpcTopic(mcpClientId);
-    mqttClient_->subscribe(rpcTopic, 1, true);
-    MCP_LOG_DEBUG("Subscribed to RPC topic: " << rpcTopic);
-
-    // Subscribe to client's presence topic
-    std::string clientPresenceTopic = getClientPresenceTopic(mcpClientId);
-    mqttClient_->subscribe(clientPresenceTopic, 1, false);
-    MCP_LOG_DEBUG("Subscribed to client presence topic: " << clientPresenceTopic);
+    bool local = isLocalSession(mcpClientId);
+    if (!local) {
+        // Subscribe to RPC topic for this client (with No Local option)
+        std::string rpcTopic = getRpcTopic(mcpClientId);
+        mqttClient_.load()->subscribe(rpcTopic, qosPolicy_.subscription, true);
+        MCP_LOG_DEBUG("Subscribed to RPC topic: " << rpcTopic);
+
+        // Subscribe to client's presence topic
+        std::string clientPresenceTopic = getClientPresenceTopic(mcpClientId);
+        mqttClient_.load()->subscribe(clientPresenceTopic, qosPolicy_.subscription, false);
+        MCP_LOG_DEBUG("Subscribed to client presence topic: " << clientPresenceTopic);
+    }
 
     // Store session
     {
         std::lock_guard<std::mutex> lock(sessionsMutex_);
         clientSessions_[mcpClientId] = session;
     }
+    mirrorSession(session);
 
     // Build initialize response
     nlohmann::json result;
@@ -433,27 +875,145 @@ void McpServer::handleInitialize(const std::string& mcpClientId, const JsonRpcRe
         {"version", serverInfo_.version}
     };
 
+    std::shared_ptr<ISessionTransport> transport;
+    if (local) {
+        // Already on a direct transport
+    } else if (auto shm = negotiateSharedMemory(mcpClientId, session.capabilities, transport)) {
+        result["capabilities"]["experimental"][SHM_CAPABILITY] = *shm;
+    }
+
     auto response = JsonRpcResponse::success(request.id, result);
-    sendResponse(mcpClientId, response);
+    sendResponse(mcpClientId, response, qosPolicy_.qosFor(MessageClass::RESPONSE));
     MCP_LOG_INFO("Initialize response sent to client: " << mcpClientId);
+
+    // Attach after responding, so the client learns about the channel over MQTT
+    if (transport) {
+        attachTransport(mcpClientId, transport);
+    }
+}
+
+// Unique per channel, across processes too: hot-standby replicas share a serverId
+static std::string shmNameSuffix() {
+    static const uint32_t processNonce = std::random_device{}();
+    static std::atomic<uint64_t> sequence{0};
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "%08x-%llu", processNonce,
+                  static_cast<unsigned long long>(++sequence));
+    return suffix;
+}
+
+std::optional<nlohmann::json> McpServer::negotiateSharedMemory(const std::string& mcpClientId,
+                                                               const nlohmann::json& clientCapabilities,
+                                                               std::shared_ptr<ISessionTransport>& transport) {
+    if (!shmEnabled_ || !clientCapabilities.is_object() ||
+        !clientCapabilities.contains("experimental") ||
+        !clientCapabilities["experimental"].contains(SHM_CAPABILITY)) {
+        return std::nullopt;
+    }
+
+    const auto& offer = clientCapabilities["experimental"][SHM_CAPABILITY];
+    std::string hostId = ShmChannel::localHostId();
+    if (hostId.empty() || !offer.is_object() || offer.value("hostId", "") != hostId) {
+        MCP_LOG_DEBUG("Client not co-located, not offering shared memory: " << mcpClientId);
+        return std::nullopt;
+    }
+
+    // POSIX shm names are a single path component. The owner unlinks the name
+    // when its channel goes away, possibly after a new session of this client
+    // negotiated another channel, so every channel gets a name of its own.
+    std::string name = "/mcp-" + serverId_ + "-" + mcpClientId + "-" + shmNameSuffix();
+    for (size_t i = 1; i < name.size(); ++i) {
+        if (name[i] == '/') name[i] = '_';
+    }
+
+    // Replace any channel left over from a previous session of this client
+    detachTransport(mcpClientId);
+
+    auto channel = ShmChannel::create(name, shmRingCapacity_);
+    if (!channel) {
+        MCP_LOG_WARN("Failed to create shared memory channel for client: " << mcpClientId);
+        return std::nullopt;
+    }
+
+    nlohmann::json accepted = {
+        {"name", channel->name()},
+        {"capacity", channel->ringCapacity()}
+    };
+    transport = std::make_shared<ShmSessionTransport>(std::move(channel),
+        [this, mcpClientId](const std::string& payload) {
+            dispatchRpc(mcpClientId, payload);
+        });
+    MCP_LOG_INFO("Shared memory channel negotiated: client=" << mcpClientId << ", name=" << name);
+    return accepted;
+}
+
+void McpServer::attachTransport(const std::string& mcpClientId, std::shared_ptr<ISessionTransport> transport) {
+    std::lock_guard<std::mutex> lock(transportsMutex_);
+    sessionTransports_[mcpClientId] = std::move(transport);
+}
+
+void McpServer::detachTransport(const std::string& mcpClientId) {
+    std::shared_ptr<ISessionTransport> transport;
+    {
+        std::lock_guard<std::mutex> lock(transportsMutex_);
+        auto it = sessionTransports_.find(mcpClientId);
+        if (it == sessionTransports_.end()) {
+            return;
+        }
+        transport = std::move(it->second);
+        sessionTransports_.erase(it);
+        localSessions_.erase(mcpClientId);
+    }
+    transport->close();
+    MCP_LOG_DEBUG("Closed session transport: client=" << mcpClientId);
+}
+
+bool McpServer::sendViaTransport(const std::string& mcpClientId, const std::string& payload) {
+    std::shared_ptr<ISessionTransport> transport;
+    bool local = false;
+    {
+        std::lock_guard<std::mutex> lock(transportsMutex_);
+        if (sessionTransports_.empty()) {
+            return false;
+        }
+        auto it = sessionTransports_.find(mcpClientId);
+        if (it == sessionTransports_.end()) {
+            return false;
+        }
+        transport = it->second;
+        local = localSessions_.count(mcpClientId) > 0;
+    }
+    // Fall back to MQTT if the channel is full or closed, unless the session
+    // has no MQTT side
+    return transport->send(payload) || local;
+}
+
+bool McpServer::isLocalSession(const std::string& mcpClientId) const {
+    std::lock_guard<std::mutex> lock(transportsMutex_);
+    return localSessions_.count(mcpClientId) > 0;
 }
 
 void McpServer::handleInitializedNotification(const std::string& mcpClientId) {
     MCP_LOG_DEBUG("Received initialized notification from client: " << mcpClientId);
 
-    std::lock_guard<std::mutex> lock(sessionsMutex_);
-    auto it = clientSessions_.find(mcpClientId);
-    if (it != clientSessions_.end()) {
+    ClientInfo clientInfo;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        auto it = clientSessions_.find(mcpClientId);
+        if (it == clientSessions_.end()) {
+            MCP_LOG_WARN("Received initialized notification for unknown client: " << mcpClientId);
+            return;
+        }
         it->second.initialized = true;
-        MCP_LOG_INFO("Client session initialized: " << mcpClientId
-                  << " (" << it->second.clientInfo.name << " v" << it->second.clientInfo.version << ")");
+        mirrorSession(it->second);
+        clientInfo = it->second.clientInfo;
+    }
+    MCP_LOG_INFO("Client session initialized: " << mcpClientId
+              << " (" << clientInfo.name << " v" << clientInfo.version << ")");
 
-        // Notify callback
-        if (clientConnectedCallback_) {
-            clientConnectedCallback_(mcpClientId, it->second.clientInfo);
-        }
-    } else {
-        MCP_LOG_WARN("Received initialized notification for unknown client: " << mcpClientId);
+    // Notify callback, which may well send to the client
+    if (clientConnectedCallback_) {
+        clientConnectedCallback_(mcpClientId, clientInfo);
     }
 }
 
@@ -461,7 +1021,7 @@ void McpServer::handlePing(const std::string& mcpClientId, const JsonRpcRequest&
     MCP_LOG_DEBUG("Ping from client: " << mcpClientId);
     // Respond with empty result
     auto response = JsonRpcResponse::success(request.id, nlohmann::json::object());
-    sendResponse(mcpClientId, response);
+    sendResponse(mcpClientId, response, qosPolicy_.qosFor(MessageClass::PING_RESPONSE));
 }
 
 void McpServer::handleToolsList(const std::string& mcpClientId, const JsonRpcRequest& request) {
@@ -471,7 +1031,7 @@ void McpServer::handleToolsList(const std::string& mcpClientId, const JsonRpcReq
     result["tools"] = toolManager_.getToolsJson();
 
     auto response = JsonRpcResponse::success(request.id, result);
-    sendResponse(mcpClientId, response);
+    sendResponse(mcpClientId, response, qosPolicy_.qosFor(MessageClass::RESPONSE));
     MCP_LOG_DEBUG("Sent tools list (" << toolManager_.getTools().size() << " tools) to client: " << mcpClientId);
 }
 
@@ -481,7 +1041,7 @@ void McpServer::handleToolsCall(const std::string& mcpClientId, const JsonRpcReq
         auto response = JsonRpcResponse::errorResponse(
             request.id, JsonRpcError::INVALID_PARAMS,
             "Missing 'name' parameter");
-        sendResponse(mcpClientId, response);
+        sendResponse(mcpClientId, response, qosPolicy_.qosFor(MessageClass::TOOL_RESULT));
         return;
     }
 
@@ -491,17 +1051,84 @@ void McpServer::handleToolsCall(const std::string& mcpClientId, const JsonRpcReq
     MCP_LOG_INFO("Tool call: tool=" << toolName << ", client=" << mcpClientId);
     MCP_LOG_DEBUG("Tool call arguments: " << arguments.dump());
 
+    int qos = qosPolicy_.qosForTool(toolName);
+
+    // Exactly-once tools: journal the call before running it. The running
+    // check and begin() are one step, so a duplicate racing the first call
+    // finds it running rather than STARTED (outcome unknown).
+    ExecutionJournal* journal = nullptr;
+    std::string executionKey;
+    std::optional<JsonRpcResponse> early;
+    {
+        std::lock_guard<std::mutex> lock(exactlyOnceMutex_);
+        if (exactlyOnceTools_.count(toolName)) {
+            journal = executionJournal_;
+            if (!journal) {
+                MCP_LOG_ERROR("Exactly-once tool called without an execution journal: " << toolName);
+                early = JsonRpcResponse::errorResponse(
+                    request.id, JsonRpcError::INTERNAL_ERROR,
+                    "Execution journal unavailable for tool: " + toolName);
+            } else {
+                executionKey = executionKeyFor(mcpClientId, toolName, request.id, arguments);
+                auto running = runningExecutions_.find(executionKey);
+                if (running != runningExecutions_.end()) {
+                    ++running->second;
+                    MCP_LOG_DEBUG("Duplicate of running call shares its result: tool=" << toolName
+                              << ", client=" << mcpClientId);
+                    return;
+                }
+                auto entry = journal->begin(executionKey);
+                if (entry.state == ExecutionJournal::State::COMPLETED) {
+                    MCP_LOG_INFO("Replaying recorded result: tool=" << toolName << ", client=" << mcpClientId);
+                    auto recorded = JsonRpc::parse(entry.result);
+                    early = recorded
+                        ? JsonRpcResponse::success(request.id, *recorded)
+                        : JsonRpcResponse::errorResponse(request.id, JsonRpcError::INTERNAL_ERROR,
+                                                         "Recorded result is unreadable");
+                } else if (entry.state == ExecutionJournal::State::STARTED) {
+                    // Started by an earlier process that never recorded the outcome
+                    MCP_LOG_WARN("Refusing to re-run interrupted call: tool=" << toolName
+                              << ", client=" << mcpClientId);
+                    early = JsonRpcResponse::errorResponse(
+                        request.id, JsonRpcError::INTERNAL_ERROR,
+                        "Outcome of an earlier execution is unknown; not executing again");
+                } else {
+                    runningExecutions_[executionKey] = 0;
+                }
+            }
+        }
+    }
+    if (early) {
+        sendResponse(mcpClientId, *early, qos);
+        return;
+    }
+
     // Call the tool
     ToolCallResult result = toolManager_.callTool(toolName, arguments);
 
+    size_t duplicates = 0;
+    if (journal) {
+        if (!journal->complete(executionKey, JsonRpc::serialize(result.toJson()))) {
+            MCP_LOG_ERROR("Failed to record result: tool=" << toolName << ", client=" << mcpClientId);
+        }
+        std::lock_guard<std::mutex> lock(exactlyOnceMutex_);
+        auto running = runningExecutions_.find(executionKey);
+        duplicates = running->second;
+        runningExecutions_.erase(running);
+    }
+
     if (result.isError) {
         MCP_LOG_WARN("Tool call failed: tool=" << toolName << ", client=" << mcpClientId);
     } else {
         MCP_LOG_DEBUG("Tool call succeeded: tool=" << toolName);
     }
 
+    // Duplicates that arrived meanwhile have the same client and request ID;
+    // each gets the response, in case the first one is lost
     auto response = JsonRpcResponse::success(request.id, result.toJson());
-    sendResponse(mcpClientId, response);
+    for (size_t i = 0; i <= duplicates; ++i) {
+        sendResponse(mcpClientId, response, qos);
+    }
 }
 
 void McpServer::handleDisconnectedNotification(const std::string& mcpClientId) {
@@ -525,6 +1152,18 @@ std::string McpServer::getClientPresenceTopic(const std::string& mcpClientId) co
     return "$mcp-client/presence/" + mcpClientId;
 }
 
+std::string McpServer::getHostPresenceTopic() const {
+    return "$mcp-server/presence/" + serverId_;
+}
+
+std::string McpServer::getMirrorTopicPrefix() const {
+    return MCP_MIRROR_PREFIX + serverId_ + "/" + serverName_ + "/";
+}
+
+std::string McpServer::getLeaderTopic() const {
+    return MCP_LEADER_PREFIX + serverId_ + "/" + serverName_;
+}
+
 std::optional<std::string> McpServer::parseClientIdFromRpcTopic(const std::string& topic) const {
     // Topic format: $mcp-rpc/{mcp-client-id}/{server-id}/{server-name}
     std::string prefix = "$mcp-rpc/";
@@ -551,18 +1190,18 @@ std::optional<std::string> McpServer::parseClientIdFromPresenceTopic(const std::
     return topic.substr(prefix.length());
 }
 
-void McpServer::sendResponse(const std::string& mcpClientId, const JsonRpcResponse& response) {
+void McpServer::sendResponse(const std::string& mcpClientId, const JsonRpcResponse& response, int qos) {
     std::string topic = getRpcTopic(mcpClientId);
     std::string payload = JsonRpc::serialize(response.toJson());
 
     MCP_LOG_DEBUG("Sending response to client=" << mcpClientId << ", topic=" << topic
               << ", payload=" << payload);
 
-    std::map<std::string, std::string> props = {
-        {USER_PROP_COMPONENT_TYPE, COMPONENT_TYPE_SERVER},
-        {USER_PROP_MQTT_CLIENT_ID, serverId_}
-    };
-    mqttClient_->publish(topic, payload, 1, false, props);
+    if (sendViaTransport(mcpClientId, payload)) {
+        return;
+    }
+
+    publishRpc(mcpClientId, topic, payload, qos, true);
 }
 
 void McpServer::sendNotification(const std::string& mcpClientId, const JsonRpcNotification& notification) {
@@ -572,11 +1211,190 @@ void McpServer::sendNotification(const std::string& mcpClientId, const JsonRpcNo
     MCP_LOG_DEBUG("Sending notification to client=" << mcpClientId << ", topic=" << topic
               << ", payload=" << payload);
 
-    std::map<std::string, std::string> props = {
+    if (sendViaTransport(mcpClientId, payload)) {
+        return;
+    }
+
+    MessageClass messageClass = MessageClass::NOTIFICATION;
+    if (notification.method == "notifications/progress") {
+        messageClass = MessageClass::PROGRESS;
+    } else if (notification.method.size() >= 13 &&
+               notification.method.compare(notification.method.size() - 13, 13, "/list_changed") == 0) {
+        messageClass = MessageClass::LIST_CHANGED;
+    }
+    publishRpc(mcpClientId, topic, payload, qosPolicy_.qosFor(messageClass), false);
+}
+
+// Set while a list_changed timer callback runs, so stopping the server from
+// within it does not wait for itself
+static thread_local const McpServer* tlsBroadcastingServer = nullptr;
+
+void McpServer::scheduleToolsListChanged() {
+    if (!capabilities_.toolsListChanged || !running_ || standby_) {
+        return;     // Nobody to tell; clients list the tools when they connect
+    }
+    std::lock_guard<std::mutex> lock(listChangedMutex_);
+    IClock::TimePoint now = clock_->now();
+    if (listChangedTimer_ != 0 && clock_->cancel(listChangedTimer_)) {
+        --listChangedInFlight_;
+    } else {
+        firstListChange_ = now;     // No change pending, or its broadcast is running
+    }
+    IClock::TimePoint at = std::min(now + listChangedDebounce_, firstListChange_ + 10 * listChangedDebounce_);
+    uint64_t schedule = ++listChangedSchedules_;
+    listChangedTimer_ = clock_->schedule(at, [this, schedule]() { broadcastToolsListChanged(schedule); });
+    if (listChangedTimer_ != 0) {
+        ++listChangedInFlight_;
+    }
+}
+
+void McpServer::cancelToolsListChanged() {
+    std::unique_lock<std::mutex> lock(listChangedMutex_);
+    ++listChangedSchedules_;    // A callback that already fired finds itself stale
+    if (listChangedTimer_ != 0) {
+        if (clock_->cancel(listChangedTimer_)) {
+            --listChangedInFlight_;
+        }
+        listChangedTimer_ = 0;
+    }
+    // IClock::cancel() does not wait for a callback that already fired
+    if (tlsBroadcastingServer != this) {
+        listChangedDone_.wait(lock, [this]() { return listChangedInFlight_ == 0; });
+    }
+}
+
+void McpServer::broadcastToolsListChanged(uint64_t schedule) {
+    bool current;
+    {
+        std::lock_guard<std::mutex> lock(listChangedMutex_);
+        current = schedule == listChangedSchedules_;
+        if (current) {
+            listChangedTimer_ = 0;
+        }
+    }
+    if (current) {
+        const McpServer* previous = tlsBroadcastingServer;
+        tlsBroadcastingServer = this;
+        sendToolsListChanged();
+        tlsBroadcastingServer = previous;
+    }
+
+    // Last use of this; cancelToolsListChanged() may be waiting to destroy it
+    std::lock_guard<std::mutex> lock(listChangedMutex_);
+    --listChangedInFlight_;
+    listChangedDone_.notify_all();
+}
+
+void McpServer::sendToolsListChanged() {
+    if (!running_ || standby_) {
+        return;
+    }
+
+    std::vector<std::string> clientIds;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        for (const auto& [clientId, session] : clientSessions_) {
+            if (session.initialized) {
+                clientIds.push_back(clientId);
+            }
+        }
+    }
+    if (clientIds.empty()) {
+        return;
+    }
+
+    // Same payload for every session: serialize once
+    auto notification = JsonRpcNotification::create("notifications/tools/list_changed");
+    std::string payload = JsonRpc::serialize(notification.toJson());
+    int qos = qosPolicy_.qosFor(MessageClass::LIST_CHANGED);
+    for (const auto& clientId : clientIds) {
+        if (!sendViaTransport(clientId, payload)) {
+            publishRpc(clientId, getRpcTopic(clientId), payload, qos, false);
+        }
+    }
+    MCP_LOG_INFO("Sent notifications/tools/list_changed to " << clientIds.size() << " session(s)");
+}
+
+void McpServer::publishRpc(const std::string& mcpClientId, const std::string& topic,
+                           const std::string& payload, int qos, bool isResponse) {
+    IMqttClient* client = mqttClient_;
+    if (!client) {
+        return;
+    }
+
+    MqttPublishProperties props;
+    props.userProperties = {
         {USER_PROP_COMPONENT_TYPE, COMPONENT_TYPE_SERVER},
         {USER_PROP_MQTT_CLIENT_ID, serverId_}
     };
-    mqttClient_->publish(topic, payload, 1, false, props);
+    props.topicAlias = topicAliasFor(mcpClientId);
+    props.messageExpiryInterval = messageExpiryInterval_.load(std::memory_order_relaxed);
+    props.payloadFormatIndicator = 1;   // JSON-RPC is UTF-8
+
+    // Clients can match responses by correlation data without parsing JSON
+    if (isResponse && tlsDispatchedMessage) {
+        props.correlationData = tlsDispatchedMessage->correlationData;
+    }
+    client->publishWithProperties(topic, payload, qos, false, props);
+}
+
+uint16_t McpServer::topicAliasFor(const std::string& mcpClientId) {
+    {
+        std::lock_guard<std::mutex> lock(topicAliasMutex_);
+        if (topicAliasMaximum_ == 0) {
+            return 0;
+        }
+        auto it = sessionTopicAliases_.find(mcpClientId);
+        if (it != sessionTopicAliases_.end()) {
+            return it->second;
+        }
+    }
+
+    // Only established sessions get an alias, so every alias is released again.
+    // sessionsMutex_ is never taken inside topicAliasMutex_, and callers must
+    // not hold it.
+    auto established = [this, &mcpClientId]() {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        return clientSessions_.find(mcpClientId) != clientSessions_.end();
+    };
+    if (!established()) {
+        return 0;
+    }
+
+    uint16_t alias = 0;
+    {
+        std::lock_guard<std::mutex> lock(topicAliasMutex_);
+        auto it = sessionTopicAliases_.find(mcpClientId);
+        if (it != sessionTopicAliases_.end()) {
+            return it->second;      // Assigned by another thread meanwhile
+        }
+        if (!freeTopicAliases_.empty()) {
+            alias = freeTopicAliases_.back();
+            freeTopicAliases_.pop_back();
+        } else if (nextTopicAlias_ <= topicAliasMaximum_) {
+            alias = nextTopicAlias_++;
+        } else {
+            return 0;   // Out of aliases; publish with the full topic
+        }
+        sessionTopicAliases_[mcpClientId] = alias;
+    }
+
+    // A cleanup since the check found no alias to release; release it here
+    if (!established()) {
+        releaseTopicAlias(mcpClientId);
+        return 0;
+    }
+    MCP_LOG_DEBUG("Assigned topic alias " << alias << " to client: " << mcpClientId);
+    return alias;
+}
+
+void McpServer::releaseTopicAlias(const std::string& mcpClientId) {
+    std::lock_guard<std::mutex> lock(topicAliasMutex_);
+    auto it = sessionTopicAliases_.find(mcpClientId);
+    if (it != sessionTopicAliases_.end()) {
+        freeTopicAliases_.push_back(it->second);
+        sessionTopicAliases_.erase(it);
+    }
 }
 
 void McpServer::cleanupClientSession(const std::string& mcpClientId) {
@@ -595,13 +1413,20 @@ void McpServer::cleanupClientSession(const std::string& mcpClientId) {
         }
     }
 
+    bool local = isLocalSession(mcpClientId);
+    unmirrorSession(mcpClientId);
+    detachTransport(mcpClientId);
+    releaseTopicAlias(mcpClientId);
+
     // Unsubscribe from client's topics
-    std::string rpcTopic = getRpcTopic(mcpClientId);
-    std::string presenceTopic = getClientPresenceTopic(mcpClientId);
+    if (!local && mqttClient_) {
+        std::string rpcTopic = getRpcTopic(mcpClientId);
+        std::string presenceTopic = getClientPresenceTopic(mcpClientId);
 
-    mqttClient_->unsubscribe(rpcTopic);
-    mqttClient_->unsubscribe(presenceTopic);
-    MCP_LOG_DEBUG("Unsubscribed from client topics: rpc=" << rpcTopic << ", presence=" << presenceTopic);
+        mqttClient_.load()->unsubscribe(rpcTopic);
+        mqttClient_.load()->unsubscribe(presenceTopic);
+        MCP_LOG_DEBUG("Unsubscribed from client topics: rpc=" << rpcTopic << ", presence=" << presenceTopic);
+    }
 
     // Notify callback
     if (clientDisconnectedCallback_) {
@@ -0,0 +1,402 @@
+#include "mcp_mqtt/mcp_server_host.h"
+#include "mcp_mqtt/logger.h"
+#include "mcp_mqtt/json_rpc.h"
+#include <algorithm>
+
+namespace mcp_mqtt {
+
+/**
+ * @brief IMqttClient view of the shared connection given to one hosted server.
+ *
+ * Publishing goes straight to the shared client; subscriptions, the message
+ * handler and connection-level settings go through the host.
+ */
+class McpServerHost::HostedClient : public IMqttClient,
+                                    public std::enable_shared_from_this<HostedClient> {
+public:
+    HostedClient(McpServerHost* host, IMqttClient* mqttClient)
+        : host_(host), mqttClient_(mqttClient) {}
+
+    bool isConnected() const override {
+        return mqttClient_->isConnected();
+    }
+
+    bool subscribe(const std::string& topic, int qos, bool noLocal) override {
+        return host_->addRoute(shared_from_this(), topic, qos, noLocal);
+    }
+
+    bool unsubscribe(const std::string& topic) override {
+        return host_->removeRoute(this, topic);
+    }
+
+    bool publish(const std::string& topic,
+                 const std::string& payload,
+                 int qos,
+                 bool retained,
+                 const std::map<std::string, std::string>& userProps) override {
+        return mqttClient_->publish(topic, payload, qos, retained, userProps);
+    }
+
+    // Topic aliases are per connection, so hosted servers cannot each assign
+    // their own; getTopicAliasMaximum() keeps its default of 0 for them
+    bool publishWithProperties(const std::string& topic,
+                               const std::string& payload,
+                               int qos,
+                               bool retained,
+                               const MqttPublishProperties& properties) override {
+        return mqttClient_->publishWithProperties(topic, payload, qos, retained, properties);
+    }
+
+    std::string getClientId() const override {
+        return mqttClient_->getClientId();
+    }
+
+    void setMessageHandler(MqttMessageHandler handler) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        messageHandler_ = handler;
+    }
+
+    void setConnectionLostCallback(std::function<void(const std::string& reason)> callback) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connectionLostCallback_ = callback;
+    }
+
+    bool setConnectionRestoredCallback(std::function<void()> callback) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connectionRestoredCallback_ = callback;
+        return host_->restoreReported_;
+    }
+
+    // The host set the connection's properties and Will in start()
+    void setConnectProperties(uint32_t, const std::map<std::string, std::string>&) override {}
+
+    void setWill(const std::string& topic, const std::string&, int, bool) override {
+        // A standby taking over after a host crash: clients ignore this server
+        // ID until its host presence is back. No reconnect to wait for.
+        MCP_LOG_DEBUG("Hosted server Will covered by the host presence: " << topic);
+        host_->publishHostPresence();
+        if (host_->restoreReported_) {
+            connectionRestored();
+        }
+    }
+
+    void deliver(const MqttIncomingMessage& message) {
+        MqttMessageHandler handler;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            handler = messageHandler_;
+        }
+        if (handler) {
+            handler(message);
+        }
+    }
+
+    void connectionLost(const std::string& reason) {
+        std::function<void(const std::string&)> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callback = connectionLostCallback_;
+        }
+        if (callback) {
+            callback(reason);
+        }
+    }
+
+    void connectionRestored() {
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callback = connectionRestoredCallback_;
+        }
+        if (callback) {
+            callback();
+        }
+    }
+
+private:
+    McpServerHost* host_;
+    IMqttClient* mqttClient_;
+    std::mutex mutex_;
+    MqttMessageHandler messageHandler_;
+    std::function<void(const std::string&)> connectionLostCallback_;
+    std::function<void()> connectionRestoredCallback_;
+};
+
+McpServerHost::McpServerHost() = default;
+
+McpServerHost::~McpServerHost() {
+    if (running_) {
+        stop();
+    }
+}
+
+bool McpServerHost::start(IMqttClient* mqttClient, const std::string& serverId) {
+    if (running_) {
+        MCP_LOG_WARN("Server host already running, ignoring start()");
+        return false;
+    }
+
+    if (!mqttClient || !mqttClient->isConnected()) {
+        MCP_LOG_ERROR("MQTT client is not connected");
+        return false;
+    }
+
+    mqttClient_ = mqttClient;
+    serverId_ = serverId;
+
+    // One Will for the connection, taking all hosted servers offline
+    mqttClient_->setConnectProperties(0, {{USER_PROP_COMPONENT_TYPE, COMPONENT_TYPE_SERVER}});
+    auto offline = JsonRpcNotification::create(METHOD_SERVER_OFFLINE);
+    mqttClient_->setWill(getHostPresenceTopic(), JsonRpc::serialize(offline.toJson()), 1, true);
+
+    mqttClient_->setMessageHandler([this](const MqttIncomingMessage& msg) {
+        routeMessage(msg);
+    });
+    mqttClient_->setConnectionLostCallback([this](const std::string& reason) {
+        handleConnectionLost(reason);
+    });
+    restoreReported_ = mqttClient_->setConnectionRestoredCallback([this]() {
+        handleConnectionRestored();
+    });
+
+    // Before any hosted presence, so clients stop ignoring them
+    publishHostPresence();
+
+    running_ = true;
+    MCP_LOG_INFO("MCP server host started: serverId=" << serverId_);
+    return true;
+}
+
+void McpServerHost::stop() {
+    if (!running_) {
+        return;
+    }
+
+    MCP_LOG_INFO("Stopping MCP server host...");
+
+    for (const auto& serverName : getServerNames()) {
+        removeServer(serverName);
+    }
+
+    // Every hosted presence is cleared; clear the host's too
+    mqttClient_->publish(getHostPresenceTopic(), "", 1, true, {});
+
+    mqttClient_->setMessageHandler(nullptr);
+    mqttClient_->setConnectionLostCallback(nullptr);
+    mqttClient_->setConnectionRestoredCallback(nullptr);
+
+    running_ = false;
+    mqttClient_ = nullptr;
+    MCP_LOG_INFO("MCP server host stopped");
+}
+
+bool McpServerHost::isRunning() const {
+    return running_ && mqttClient_ && mqttClient_->isConnected();
+}
+
+bool McpServerHost::addServer(McpServer* server, const McpServerConfig& config) {
+    if (!running_ || !server) {
+        MCP_LOG_ERROR("Cannot add server: host not running or server is null");
+        return false;
+    }
+
+    const std::string& serverName = config.serverName;
+    auto client = std::make_shared<HostedClient>(this, mqttClient_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (servers_.find(serverName) != servers_.end()) {
+            MCP_LOG_WARN("Server already hosted: " << serverName);
+            return false;
+        }
+        servers_[serverName] = {server, client};
+    }
+
+    McpServerConfig hostedConfig = config;
+    hostedConfig.serverId = serverId_;
+    if (!server->start(client.get(), hostedConfig)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        servers_.erase(serverName);
+        removeAllRoutes(client.get());
+        return false;
+    }
+
+    MCP_LOG_INFO("Hosted server added: " << serverName);
+    return true;
+}
+
+void McpServerHost::removeServer(const std::string& serverName) {
+    HostedServer hosted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = servers_.find(serverName);
+        if (it == servers_.end()) {
+            MCP_LOG_DEBUG("Hosted server not found: " << serverName);
+            return;
+        }
+        hosted = it->second;
+        servers_.erase(it);
+    }
+
+    // McpServer::stop() unsubscribes through the hosted client
+    hosted.server->stop();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    removeAllRoutes(hosted.client.get());
+    MCP_LOG_INFO("Hosted server removed: " << serverName);
+}
+
+std::vector<std::string> McpServerHost::getServerNames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    names.reserve(servers_.size());
+    for (const auto& [name, hosted] : servers_) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+void McpServerHost::routeMessage(const MqttIncomingMessage& message) {
+    // Collect targets under the lock but deliver outside it, since handlers
+    // subscribe and unsubscribe through the host
+    std::vector<std::shared_ptr<HostedClient>> targets;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = exactRoutes_.find(message.topic);
+        if (it != exactRoutes_.end()) {
+            targets = it->second;
+        }
+        for (const auto& [filter, client] : wildcardRoutes_) {
+            if (topicMatchesFilter(filter, message.topic) &&
+                std::find(targets.begin(), targets.end(), client) == targets.end()) {
+                targets.push_back(client);
+            }
+        }
+    }
+
+    if (targets.empty()) {
+        MCP_LOG_DEBUG("No hosted server for topic: " << message.topic);
+        return;
+    }
+
+    for (const auto& client : targets) {
+        client->deliver(message);
+    }
+}
+
+void McpServerHost::handleConnectionLost(const std::string& reason) {
+    std::vector<std::shared_ptr<HostedClient>> clients;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [name, hosted] : servers_) {
+            clients.push_back(hosted.client);
+        }
+    }
+    for (const auto& client : clients) {
+        client->connectionLost(reason);
+    }
+}
+
+void McpServerHost::handleConnectionRestored() {
+    // The Will of the old connection may have replaced the host presence
+    publishHostPresence();
+
+    std::vector<std::shared_ptr<HostedClient>> clients;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [name, hosted] : servers_) {
+            clients.push_back(hosted.client);
+        }
+    }
+    for (const auto& client : clients) {
+        client->connectionRestored();
+    }
+}
+
+bool McpServerHost::addRoute(const std::shared_ptr<HostedClient>& client, const std::string& topic,
+                             int qos, bool noLocal) {
+    bool firstSubscriber = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool isWildcard = topic.find_first_of("+#") != std::string::npos;
+        if (isWildcard) {
+            auto sameFilter = [&topic](const auto& route) { return route.first == topic; };
+            firstSubscriber = std::none_of(wildcardRoutes_.begin(), wildcardRoutes_.end(), sameFilter);
+            wildcardRoutes_.emplace_back(topic, client);
+        } else {
+            auto& subscribers = exactRoutes_[topic];
+            firstSubscriber = subscribers.empty();
+            if (std::find(subscribers.begin(), subscribers.end(), client) == subscribers.end()) {
+                subscribers.push_back(client);
+            }
+        }
+    }
+
+    if (!firstSubscriber) {
+        MCP_LOG_DEBUG("Topic already subscribed on shared connection: " << topic);
+        return true;
+    }
+    return mqttClient_->subscribe(topic, qos, noLocal);
+}
+
+bool McpServerHost::removeRoute(const HostedClient* client, const std::string& topic) {
+    bool lastSubscriber = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = exactRoutes_.find(topic);
+        if (it != exactRoutes_.end()) {
+            auto& subscribers = it->second;
+            subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+                [client](const auto& c) { return c.get() == client; }), subscribers.end());
+            if (subscribers.empty()) {
+                exactRoutes_.erase(it);
+                lastSubscriber = true;
+            }
+        } else {
+            auto sameRoute = [&](const auto& route) {
+                return route.first == topic && route.second.get() == client;
+            };
+            wildcardRoutes_.erase(std::remove_if(wildcardRoutes_.begin(), wildcardRoutes_.end(), sameRoute),
+                                  wildcardRoutes_.end());
+            auto sameFilter = [&topic](const auto& route) { return route.first == topic; };
+            lastSubscriber = std::none_of(wildcardRoutes_.begin(), wildcardRoutes_.end(), sameFilter);
+        }
+    }
+
+    if (!lastSubscriber) {
+        return true;
+    }
+    return mqttClient_->unsubscribe(topic);
+}
+
+void McpServerHost::removeAllRoutes(const HostedClient* client) {
+    // Caller holds mutex_; drops routes a stopped server left behind
+    for (auto it = exactRoutes_.begin(); it != exactRoutes_.end();) {
+        auto& subscribers = it->second;
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+            [client](const auto& c) { return c.get() == client; }), subscribers.end());
+        if (subscribers.empty()) {
+            mqttClient_->unsubscribe(it->first);
+            it = exactRoutes_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    wildcardRoutes_.erase(std::remove_if(wildcardRoutes_.begin(), wildcardRoutes_.end(),
+        [client](const auto& route) { return route.second.get() == client; }), wildcardRoutes_.end());
+}
+
+std::string McpServerHost::getHostPresenceTopic() const {
+    return "$mcp-server/presence/" + serverId_;
+}
+
+void McpServerHost::publishHostPresence() {
+    auto online = JsonRpcNotification::create(METHOD_SERVER_ONLINE);
+    std::map<std::string, std::string> props = {
+        {USER_PROP_COMPONENT_TYPE, COMPONENT_TYPE_SERVER},
+        {USER_PROP_MQTT_CLIENT_ID, serverId_}
+    };
+    mqttClient_->publish(getHostPresenceTopic(), JsonRpc::serialize(online.toJson()), 1, true, props);
+    MCP_LOG_DEBUG("Published host presence: " << getHostPresenceTopic());
+}
+
+} // namespace mcp_mqtt
@@ -0,0 +1,528 @@
+#include "mqtt5_codec.h"
+
+namespace mcp_mqtt {
+namespace mqtt5 {
+
+// Wire primitives
+
+static void putU8(std::string& out, uint8_t v) {
+    out.push_back(static_cast<char>(v));
+}
+
+static void putU16(std::string& out, uint16_t v) {
+    out.push_back(static_cast<char>(v >> 8));
+    out.push_back(static_cast<char>(v & 0xFF));
+}
+
+static void putU32(std::string& out, uint32_t v) {
+    putU16(out, static_cast<uint16_t>(v >> 16));
+    putU16(out, static_cast<uint16_t>(v & 0xFFFF));
+}
+
+static void putVarint(std::string& out, uint32_t v) {
+    do {
+        uint8_t byte = v & 0x7F;
+        v >>= 7;
+        if (v > 0) byte |= 0x80;
+        putU8(out, byte);
+    } while (v > 0);
+}
+
+static size_t varintSize(uint32_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+static void putString(std::string& out, std::string_view s) {
+    putU16(out, static_cast<uint16_t>(s.size()));
+    out.append(s.data(), s.size());
+}
+
+static void putUserProperties(std::string& out, const std::map<std::string, std::string>* props) {
+    if (!props) return;
+    for (const auto& [key, value] : *props) {
+        putU8(out, Property::USER_PROPERTY);
+        putString(out, key);
+        putString(out, value);
+    }
+}
+
+// Append fixed header + body
+static void putPacket(std::string& out, uint8_t header, const std::string& body) {
+    putU8(out, header);
+    putVarint(out, static_cast<uint32_t>(body.size()));
+    out.append(body);
+}
+
+/**
+ * @brief Bounds-checked reader over a packet body
+ */
+class Reader {
+public:
+    explicit Reader(std::string_view data) : p_(data.data()), end_(data.data() + data.size()) {}
+
+    bool ok() const { return ok_; }
+    size_t remaining() const { return static_cast<size_t>(end_ - p_); }
+
+    uint8_t u8() {
+        if (!need(1)) return 0;
+        return static_cast<uint8_t>(*p_++);
+    }
+
+    uint16_t u16() {
+        if (!need(2)) return 0;
+        uint16_t v = static_cast<uint16_t>((static_cast<uint8_t>(p_[0]) << 8) | static_cast<uint8_t>(p_[1]));
+        p_ += 2;
+        return v;
+    }
+
+    uint32_t u32() {
+        uint32_t hi = u16();
+        uint32_t lo = u16();
+        return (hi << 16) | lo;
+    }
+
+    uint32_t varint() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 28; shift += 7) {
+            uint8_t byte = u8();
+            if (!ok_) return 0;
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        ok_ = false;
+        return 0;
+    }
+
+    std::string_view bytes(size_t n) {
+        if (!need(n)) return {};
+        std::string_view v(p_, n);
+        p_ += n;
+        return v;
+    }
+
+    std::string_view str() {
+        uint16_t len = u16();
+        return bytes(len);
+    }
+
+    std::string_view rest() {
+        return bytes(remaining());
+    }
+
+    bool properties(Properties& props) {
+        props.clear();
+        uint32_t len = varint();
+        if (!ok_ || len > remaining()) {
+            ok_ = false;
+            return false;
+        }
+        Reader r(std::string_view(p_, len));
+        p_ += len;
+
+        while (r.ok() && r.remaining() > 0) {
+            uint8_t id = r.u8();
+            switch (id) {
+                case Property::PAYLOAD_FORMAT_INDICATOR: props.payloadFormatIndicator = r.u8(); break;
+                case Property::MESSAGE_EXPIRY_INTERVAL:  props.messageExpiryInterval = r.u32(); break;
+                case Property::CONTENT_TYPE:             props.contentType = r.str(); break;
+                case Property::RESPONSE_TOPIC:           props.responseTopic = r.str(); break;
+                case Property::CORRELATION_DATA:         props.correlationData = r.str(); break;
+                case Property::SUBSCRIPTION_IDENTIFIER:  r.varint(); break;
+                case Property::SESSION_EXPIRY_INTERVAL:  props.sessionExpiryInterval = r.u32(); break;
+                case Property::ASSIGNED_CLIENT_IDENTIFIER: props.assignedClientIdentifier = r.str(); break;
+                case Property::SERVER_KEEP_ALIVE:        props.serverKeepAlive = r.u16(); break;
+                case Property::REASON_STRING:            props.reasonString = r.str(); break;
+                case Property::RECEIVE_MAXIMUM:          props.receiveMaximum = r.u16(); break;
+                case Property::TOPIC_ALIAS_MAXIMUM:      props.topicAliasMaximum = r.u16(); break;
+                case Property::TOPIC_ALIAS:              props.topicAlias = r.u16(); break;
+                case Property::MAXIMUM_PACKET_SIZE:      props.maximumPacketSize = r.u32(); break;
+                case Property::USER_PROPERTY: {
+                    std::string_view key = r.str();
+                    std::string_view value = r.str();
+                    props.userProperties.emplace_back(key, value);
+                    break;
+                }
+                // Properties the SDK does not use; skipped by type
+                case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+                    r.u8();
+                    break;
+                case 0x18:
+                    r.u32();
+                    break;
+                case 0x15: case 0x16: case 0x1A: case 0x1C:
+                    r.str();
+                    break;
+                default:
+                    return ok_ = false;
+            }
+        }
+        if (!r.ok()) ok_ = false;
+        return ok_;
+    }
+
+private:
+    bool need(size_t n) {
+        if (!ok_ || remaining() < n) {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    const char* p_;
+    const char* end_;
+    bool ok_ = true;
+};
+
+void Properties::clear() {
+    payloadFormatIndicator.reset();
+    messageExpiryInterval.reset();
+    contentType.reset();
+    responseTopic.reset();
+    correlationData.reset();
+    sessionExpiryInterval.reset();
+    assignedClientIdentifier.reset();
+    serverKeepAlive.reset();
+    reasonString.reset();
+    receiveMaximum.reset();
+    topicAliasMaximum.reset();
+    topicAlias.reset();
+    maximumPacketSize.reset();
+    userProperties.clear();
+}
+
+// Fixed header: 1 if decoded into remaining/pos, 0 if incomplete, -1 if malformed
+static int parseFixedHeader(const char* data, size_t len, uint32_t& remaining, size_t& pos) {
+    remaining = 0;
+    pos = 1;
+    for (int shift = 0;; shift += 7) {
+        if (shift > 21) return -1;
+        if (pos >= len) return 0;
+        uint8_t byte = static_cast<uint8_t>(data[pos++]);
+        remaining |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return 1;
+    }
+}
+
+long packetSize(const char* data, size_t len) {
+    uint32_t remaining;
+    size_t pos;
+    int rc = parseFixedHeader(data, len, remaining, pos);
+    return rc > 0 ? static_cast<long>(pos + remaining) : rc;
+}
+
+long parsePacket(const char* data, size_t len, Packet& packet) {
+    uint32_t remaining;
+    size_t pos;
+    int rc = parseFixedHeader(data, len, remaining, pos);
+    if (rc <= 0) return rc;
+    if (len - pos < remaining) return 0;
+
+    uint8_t header = static_cast<uint8_t>(data[0]);
+    packet.type = header >> 4;
+    packet.flags = header & 0x0F;
+    packet.body = std::string_view(data + pos, remaining);
+    return static_cast<long>(pos + remaining);
+}
+
+bool decodeConnack(const Packet& packet, ConnackView& out) {
+    if (packet.type != CONNACK) return false;
+    Reader r(packet.body);
+    out.sessionPresent = (r.u8() & 0x01) != 0;
+    out.reasonCode = r.u8();
+    if (r.remaining() > 0) {
+        r.properties(out.properties);
+    } else {
+        out.properties.clear();
+    }
+    return r.ok();
+}
+
+bool decodePublish(const Packet& packet, PublishView& out) {
+    if (packet.type != PUBLISH) return false;
+    out.dup = (packet.flags & 0x08) != 0;
+    out.qos = (packet.flags >> 1) & 0x03;
+    out.retain = (packet.flags & 0x01) != 0;
+    if (out.qos > 2) return false;
+
+    Reader r(packet.body);
+    out.topic = r.str();
+    out.packetId = out.qos > 0 ? r.u16() : 0;
+    r.properties(out.properties);
+    out.payload = r.rest();
+    return r.ok();
+}
+
+bool decodeAck(const Packet& packet, uint16_t& packetId, uint8_t& reasonCode) {
+    Reader r(packet.body);
+    packetId = r.u16();
+    reasonCode = r.remaining() > 0 ? r.u8() : 0;
+    return r.ok();
+}
+
+bool decodeSubAck(const Packet& packet, uint16_t& packetId, std::vector<uint8_t>& reasonCodes) {
+    Reader r(packet.body);
+    packetId = r.u16();
+    Properties props;
+    r.properties(props);
+    reasonCodes.clear();
+    while (r.ok() && r.remaining() > 0) {
+        reasonCodes.push_back(r.u8());
+    }
+    return r.ok();
+}
+
+void encodeConnect(std::string& out, const ConnectPacket& c) {
+    std::string body;
+    putString(body, "MQTT");
+    putU8(body, 5);
+
+    uint8_t flags = 0;
+    if (c.cleanStart) flags |= 0x02;
+    if (c.hasWill) {
+        flags |= 0x04;
+        flags |= static_cast<uint8_t>((c.willQos & 0x03) << 3);
+        if (c.willRetain) flags |= 0x20;
+    }
+    if (!c.password.empty()) flags |= 0x40;
+    if (!c.username.empty()) flags |= 0x80;
+    putU8(body, flags);
+    putU16(body, c.keepAlive);
+
+    std::string props;
+    if (c.sessionExpiryInterval > 0) {
+        putU8(props, Property::SESSION_EXPIRY_INTERVAL);
+        putU32(props, c.sessionExpiryInterval);
+    }
+    if (c.topicAliasMaximum > 0) {
+        putU8(props, Property::TOPIC_ALIAS_MAXIMUM);
+        putU16(props, c.topicAliasMaximum);
+    }
+    if (c.maximumPacketSize > 0) {
+        putU8(props, Property::MAXIMUM_PACKET_SIZE);
+        putU32(props, c.maximumPacketSize);
+    }
+    putUserProperties(props, &c.userProperties);
+    putVarint(body, static_cast<uint32_t>(props.size()));
+    body.append(props);
+
+    putString(body, c.clientId);
+    if (c.hasWill) {
+        putVarint(body, 0);     // Will properties
+        putString(body, c.willTopic);
+        putString(body, c.willPayload);
+    }
+    if (!c.username.empty()) putString(body, c.username);
+    if (!c.password.empty()) putString(body, c.password);
+
+    putPacket(out, CONNECT << 4, body);
+}
+
+static void encodePublishPacket(std::string& out, const PublishPacket& p, bool withPayload) {
+    // Properties are small; size them first so the packet is built in place
+    size_t propsSize = 0;
+    if (p.payloadFormatIndicator > 0) propsSize += 2;
+    if (p.messageExpiryInterval > 0) propsSize += 5;
+    if (!p.contentType.empty()) propsSize += 3 + p.contentType.size();
+    if (!p.responseTopic.empty()) propsSize += 3 + p.responseTopic.size();
+    if (!p.correlationData.empty()) propsSize += 3 + p.correlationData.size();
+    if (p.topicAlias > 0) propsSize += 3;
+    if (p.userProperties) {
+        for (const auto& [key, value] : *p.userProperties) {
+            propsSize += 1 + 2 + key.size() + 2 + value.size();
+        }
+    }
+
+    uint32_t remaining = static_cast<uint32_t>(2 + p.topic.size() + (p.qos > 0 ? 2 : 0) +
+                                               varintSize(static_cast<uint32_t>(propsSize)) +
+                                               propsSize + p.payload.size());
+    uint8_t header = static_cast<uint8_t>(PUBLISH << 4);
+    if (p.dup) header |= 0x08;
+    header |= static_cast<uint8_t>((p.qos & 0x03) << 1);
+    if (p.retain) header |= 0x01;
+
+    out.reserve(out.size() + 5 + remaining - (withPayload ? 0 : p.payload.size()));
+    putU8(out, header);
+    putVarint(out, remaining);
+    putString(out, p.topic);
+    if (p.qos > 0) putU16(out, p.packetId);
+    putVarint(out, static_cast<uint32_t>(propsSize));
+    if (p.payloadFormatIndicator > 0) {
+        putU8(out, Property::PAYLOAD_FORMAT_INDICATOR);
+        putU8(out, p.payloadFormatIndicator);
+    }
+    if (p.messageExpiryInterval > 0) {
+        putU8(out, Property::MESSAGE_EXPIRY_INTERVAL);
+        putU32(out, p.messageExpiryInterval);
+    }
+    if (!p.contentType.empty()) {
+        putU8(out, Property::CONTENT_TYPE);
+        putString(out, p.contentType);
+    }
+    if (!p.responseTopic.empty()) {
+        putU8(out, Property::RESPONSE_TOPIC);
+        putString(out, p.responseTopic);
+    }
+    if (!p.correlationData.empty()) {
+        putU8(out, Property::CORRELATION_DATA);
+        putString(out, p.correlationData);     // Binary data has the same length-prefixed layout
+    }
+    if (p.topicAlias > 0) {
+        putU8(out, Property::TOPIC_ALIAS);
+        putU16(out, p.topicAlias);
+    }
+    putUserProperties(out, p.userProperties);
+    if (withPayload) {
+        out.append(p.payload.data(), p.payload.size());
+    }
+}
+
+void encodePublish(std::string& out, const PublishPacket& p) {
+    encodePublishPacket(out, p, true);
+}
+
+void encodePublishHeader(std::string& out, const PublishPacket& p) {
+    encodePublishPacket(out, p, false);
+}
+
+void encodeAck(std::string& out, PacketType type, uint16_t packetId) {
+    // PUBREL has fixed header flags 0b0010
+    uint8_t header = static_cast<uint8_t>(type << 4) | (type == PUBREL ? 0x02 : 0x00);
+    putU8(out, header);
+    putU8(out, 2);
+    putU16(out, packetId);
+}
+
+void encodeSubscribe(std::string& out, uint16_t packetId, std::string_view filter, int qos, bool noLocal) {
+    std::string body;
+    putU16(body, packetId);
+    putVarint(body, 0);
+    putString(body, filter);
+    uint8_t options = static_cast<uint8_t>(qos & 0x03);
+    if (noLocal) options |= 0x04;
+    putU8(body, options);
+    putPacket(out, (SUBSCRIBE << 4) | 0x02, body);
+}
+
+void encodeUnsubscribe(std::string& out, uint16_t packetId, std::string_view filter) {
+    std::string body;
+    putU16(body, packetId);
+    putVarint(body, 0);
+    putString(body, filter);
+    putPacket(out, (UNSUBSCRIBE << 4) | 0x02, body);
+}
+
+void encodePingReq(std::string& out) {
+    putU8(out, PINGREQ << 4);
+    putU8(out, 0);
+}
+
+void encodeDisconnect(std::string& out) {
+    putU8(out, DISCONNECT << 4);
+    putU8(out, 0);
+}
+
+bool decodeConnect(const Packet& packet, ConnectView& out) {
+    if (packet.type != CONNECT) return false;
+    Reader r(packet.body);
+    if (r.str() != "MQTT") return false;
+    out.protocolVersion = r.u8();
+    if (out.protocolVersion != 5) {
+        return r.ok();      // Caller rejects the version; nothing else is parsed
+    }
+
+    uint8_t flags = r.u8();
+    out.cleanStart = (flags & 0x02) != 0;
+    out.hasWill = (flags & 0x04) != 0;
+    out.willQos = (flags >> 3) & 0x03;
+    out.willRetain = (flags & 0x20) != 0;
+    out.keepAlive = r.u16();
+    r.properties(out.properties);
+    out.clientId = r.str();
+
+    out.willProperties.clear();
+    out.willTopic = {};
+    out.willPayload = {};
+    if (out.hasWill) {
+        r.properties(out.willProperties);
+        out.willTopic = r.str();
+        out.willPayload = r.str();
+    }
+    out.username = (flags & 0x80) ? r.str() : std::string_view();
+    out.password = (flags & 0x40) ? r.str() : std::string_view();
+    return r.ok() && out.willQos < 3;
+}
+
+bool decodeSubscribe(const Packet& packet, uint16_t& packetId, std::vector<SubscriptionRequest>& out) {
+    if (packet.type != SUBSCRIBE) return false;
+    Reader r(packet.body);
+    packetId = r.u16();
+    Properties props;
+    r.properties(props);
+    out.clear();
+    while (r.ok() && r.remaining() > 0) {
+        SubscriptionRequest sub;
+        sub.filter = r.str();
+        uint8_t options = r.u8();
+        sub.qos = options & 0x03;
+        sub.noLocal = (options & 0x04) != 0;
+        out.push_back(sub);
+    }
+    return r.ok() && !out.empty();
+}
+
+bool decodeUnsubscribe(const Packet& packet, uint16_t& packetId, std::vector<std::string_view>& out) {
+    if (packet.type != UNSUBSCRIBE) return false;
+    Reader r(packet.body);
+    packetId = r.u16();
+    Properties props;
+    r.properties(props);
+    out.clear();
+    while (r.ok() && r.remaining() > 0) {
+        out.push_back(r.str());
+    }
+    return r.ok() && !out.empty();
+}
+
+void encodeConnack(std::string& out, uint8_t reasonCode, uint16_t topicAliasMaximum,
+                   std::string_view assignedClientId) {
+    std::string props;
+    if (topicAliasMaximum > 0) {
+        putU8(props, Property::TOPIC_ALIAS_MAXIMUM);
+        putU16(props, topicAliasMaximum);
+    }
+    if (!assignedClientId.empty()) {
+        putU8(props, Property::ASSIGNED_CLIENT_IDENTIFIER);
+        putString(props, assignedClientId);
+    }
+
+    std::string body;
+    putU8(body, 0);     // Session present: sessions are never persisted
+    putU8(body, reasonCode);
+    putVarint(body, static_cast<uint32_t>(props.size()));
+    body.append(props);
+    putPacket(out, CONNACK << 4, body);
+}
+
+void encodeSubAck(std::string& out, PacketType type, uint16_t packetId, const std::vector<uint8_t>& reasonCodes) {
+    std::string body;
+    putU16(body, packetId);
+    putVarint(body, 0);
+    for (uint8_t code : reasonCodes) {
+        putU8(body, code);
+    }
+    putPacket(out, static_cast<uint8_t>(type << 4), body);
+}
+
+void encodePingResp(std::string& out) {
+    putU8(out, PINGRESP << 4);
+    putU8(out, 0);
+}
+
+} // namespace mqtt5
+} // namespace mcp_mqtt
@@ -0,0 +1,214 @@
+#ifndef MCP_MQTT_MQTT5_CODEC_H
+#define MCP_MQTT_MQTT5_CODEC_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <optional>
+
+namespace mcp_mqtt {
+namespace mqtt5 {
+
+/**
+ * @brief Minimal MQTT 5.0 packet codec used by the built-in client.
+ *
+ * Encoders append to a caller-owned buffer so packets can be batched.
+ * Decoders return views into the receive buffer; nothing is copied until the
+ * caller materializes the fields it needs.
+ */
+
+enum PacketType : uint8_t {
+    CONNECT = 1,
+    CONNACK = 2,
+    PUBLISH = 3,
+    PUBACK = 4,
+    PUBREC = 5,
+    PUBREL = 6,
+    PUBCOMP = 7,
+    SUBSCRIBE = 8,
+    SUBACK = 9,
+    UNSUBSCRIBE = 10,
+    UNSUBACK = 11,
+    PINGREQ = 12,
+    PINGRESP = 13,
+    DISCONNECT = 14
+};
+
+// Property identifiers
+namespace Property {
+    constexpr uint8_t PAYLOAD_FORMAT_INDICATOR = 0x01;
+    constexpr uint8_t MESSAGE_EXPIRY_INTERVAL = 0x02;
+    constexpr uint8_t CONTENT_TYPE = 0x03;
+    constexpr uint8_t RESPONSE_TOPIC = 0x08;
+    constexpr uint8_t CORRELATION_DATA = 0x09;
+    constexpr uint8_t SUBSCRIPTION_IDENTIFIER = 0x0B;
+    constexpr uint8_t SESSION_EXPIRY_INTERVAL = 0x11;
+    constexpr uint8_t ASSIGNED_CLIENT_IDENTIFIER = 0x12;
+    constexpr uint8_t SERVER_KEEP_ALIVE = 0x13;
+    constexpr uint8_t REASON_STRING = 0x1F;
+    constexpr uint8_t RECEIVE_MAXIMUM = 0x21;
+    constexpr uint8_t TOPIC_ALIAS_MAXIMUM = 0x22;
+    constexpr uint8_t TOPIC_ALIAS = 0x23;
+    constexpr uint8_t USER_PROPERTY = 0x26;
+    constexpr uint8_t MAXIMUM_PACKET_SIZE = 0x27;
+}
+
+/**
+ * @brief Decoded properties; string and binary values are views into the packet
+ */
+struct Properties {
+    std::optional<uint8_t> payloadFormatIndicator;
+    std::optional<uint32_t> messageExpiryInterval;
+    std::optional<std::string_view> contentType;
+    std::optional<std::string_view> responseTopic;
+    std::optional<std::string_view> correlationData;
+    std::optional<uint32_t> sessionExpiryInterval;
+    std::optional<std::string_view> assignedClientIdentifier;
+    std::optional<uint16_t> serverKeepAlive;
+    std::optional<std::string_view> reasonString;
+    std::optional<uint16_t> receiveMaximum;
+    std::optional<uint16_t> topicAliasMaximum;
+    std::optional<uint16_t> topicAlias;
+    std::optional<uint32_t> maximumPacketSize;
+    std::vector<std::pair<std::string_view, std::string_view>> userProperties;
+
+    // Reset all fields, keeping the user property vector's capacity
+    void clear();
+};
+
+/**
+ * @brief A complete packet located in a receive buffer
+ */
+struct Packet {
+    uint8_t type = 0;
+    uint8_t flags = 0;
+    std::string_view body;      // Variable header and payload
+};
+
+/**
+ * @brief Locate the next complete packet in a buffer
+ * @return Bytes occupied by the packet, 0 if more data is needed, -1 if malformed
+ */
+long parsePacket(const char* data, size_t len, Packet& packet);
+
+/**
+ * @brief Size of the next packet, known as soon as its fixed header is in
+ * @return Bytes the whole packet will occupy, 0 if the fixed header is incomplete, -1 if malformed
+ */
+long packetSize(const char* data, size_t len);
+
+// Decoders; all return false on malformed input
+
+struct ConnackView {
+    bool sessionPresent = false;
+    uint8_t reasonCode = 0;
+    Properties properties;
+};
+bool decodeConnack(const Packet& packet, ConnackView& out);
+
+struct PublishView {
+    std::string_view topic;
+    std::string_view payload;
+    int qos = 0;
+    bool retain = false;
+    bool dup = false;
+    uint16_t packetId = 0;
+    Properties properties;
+};
+bool decodePublish(const Packet& packet, PublishView& out);
+
+// PUBACK, PUBREC, PUBREL, PUBCOMP
+bool decodeAck(const Packet& packet, uint16_t& packetId, uint8_t& reasonCode);
+
+// SUBACK, UNSUBACK
+bool decodeSubAck(const Packet& packet, uint16_t& packetId, std::vector<uint8_t>& reasonCodes);
+
+// Encoders append one packet to out
+
+struct ConnectPacket {
+    std::string clientId;
+    uint16_t keepAlive = 60;
+    bool cleanStart = true;
+    uint32_t sessionExpiryInterval = 0;
+    uint16_t topicAliasMaximum = 0;
+    uint32_t maximumPacketSize = 0;     // 0 = omit (no limit)
+    std::map<std::string, std::string> userProperties;
+    bool hasWill = false;
+    std::string willTopic;
+    std::string willPayload;
+    int willQos = 0;
+    bool willRetain = false;
+    std::string username;
+    std::string password;
+};
+void encodeConnect(std::string& out, const ConnectPacket& connect);
+
+struct PublishPacket {
+    std::string_view topic;
+    std::string_view payload;
+    int qos = 0;
+    bool retain = false;
+    bool dup = false;
+    uint16_t packetId = 0;
+    uint16_t topicAlias = 0;
+    uint32_t messageExpiryInterval = 0;     // 0 = omit
+    uint8_t payloadFormatIndicator = 0;     // 0 = omit
+    std::string_view contentType;           // Empty = omit, likewise below
+    std::string_view responseTopic;
+    std::string_view correlationData;
+    const std::map<std::string, std::string>* userProperties = nullptr;
+};
+void encodePublish(std::string& out, const PublishPacket& publish);
+// Everything up to the payload, whose size the remaining length still counts;
+// the caller sends the payload right after it
+void encodePublishHeader(std::string& out, const PublishPacket& publish);
+
+// PUBACK, PUBREC, PUBREL, PUBCOMP
+void encodeAck(std::string& out, PacketType type, uint16_t packetId);
+
+void encodeSubscribe(std::string& out, uint16_t packetId, std::string_view filter, int qos, bool noLocal);
+void encodeUnsubscribe(std::string& out, uint16_t packetId, std::string_view filter);
+void encodePingReq(std::string& out);
+void encodeDisconnect(std::string& out);
+
+// Server side, used by the embedded broker
+
+struct ConnectView {
+    uint8_t protocolVersion = 0;
+    std::string_view clientId;
+    uint16_t keepAlive = 0;
+    bool cleanStart = false;
+    Properties properties;
+    bool hasWill = false;
+    int willQos = 0;
+    bool willRetain = false;
+    Properties willProperties;
+    std::string_view willTopic;
+    std::string_view willPayload;
+    std::string_view username;
+    std::string_view password;
+};
+bool decodeConnect(const Packet& packet, ConnectView& out);
+
+struct SubscriptionRequest {
+    std::string_view filter;
+    int qos = 0;
+    bool noLocal = false;
+};
+bool decodeSubscribe(const Packet& packet, uint16_t& packetId, std::vector<SubscriptionRequest>& out);
+bool decodeUnsubscribe(const Packet& packet, uint16_t& packetId, std::vector<std::string_view>& out);
+
+// Reason code 0 accepts; assignedClientId is sent if not empty
+void encodeConnack(std::string& out, uint8_t reasonCode, uint16_t topicAliasMaximum,
+                   std::string_view assignedClientId);
+
+// SUBACK or UNSUBACK
+void encodeSubAck(std::string& out, PacketType type, uint16_t packetId, const std::vector<uint8_t>& reasonCodes);
+void encodePingResp(std::string& out);
+
+} // namespace mqtt5
+} // namespace mcp_mqtt
+
+#endif // MCP_MQTT_MQTT5_CODEC_H
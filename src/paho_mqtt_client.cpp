@@ -0,0 +1,504 @@
+#include "mcp_mqtt/paho_mqtt_client.h"
+#include "mcp_mqtt/logger.h"
+
+namespace mcp_mqtt {
+
+/**
+ * @brief Completion listener shared by all publishes; releases inflight slots
+ */
+class PahoMqttClient::PublishListener : public mqtt::iaction_listener {
+public:
+    explicit PublishListener(PahoMqttClient* owner) : owner_(owner) {}
+
+    void on_success(const mqtt::token&) override {
+        owner_->publishCompleted();
+    }
+
+    void on_failure(const mqtt::token& tok) override {
+        MCP_LOG_WARN("Publish failed: rc=" << tok.get_return_code());
+        owner_->publishCompleted();
+    }
+
+private:
+    PahoMqttClient* owner_;
+};
+
+PahoMqttClient::PahoMqttClient(const std::string& brokerAddress, const std::string& clientId,
+                               const PahoMqttClientOptions& options)
+    : brokerAddress_(brokerAddress), clientId_(clientId), options_(options) {
+    mqtt::create_options createOpts(MQTTVERSION_5);
+    client_ = std::make_unique<mqtt::async_client>(brokerAddress, clientId, createOpts);
+    publishListener_ = std::make_unique<PublishListener>(this);
+    client_->set_callback(*this);
+}
+
+PahoMqttClient::~PahoMqttClient() {
+    if (reconnectThread_.joinable()) {
+        reconnectThread_.join();
+    }
+    disconnect();
+}
+
+mqtt::connect_options PahoMqttClient::buildConnectOptions() {
+    auto connBuilder = mqtt::connect_options_builder()
+        .mqtt_version(MQTTVERSION_5)
+        .clean_start(true)
+        .keep_alive_interval(options_.keepAlive);
+
+    if (options_.autoReconnect) {
+        connBuilder.automatic_reconnect(options_.minReconnectDelay, options_.maxReconnectDelay);
+    }
+
+    if (!options_.username.empty()) {
+        connBuilder.user_name(options_.username);
+        if (!options_.password.empty()) {
+            connBuilder.password(options_.password);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Set will message if configured via setWill()
+    if (!willTopic_.empty()) {
+        mqtt::message willMsg(willTopic_, willPayload_, willQos_, willRetained_);
+        connBuilder.will(willMsg);
+    }
+
+    // Set MQTT 5.0 CONNECT properties if configured via setConnectProperties()
+    if (connectPropsSet_) {
+        mqtt::properties props;
+        props.add(mqtt::property(mqtt::property::SESSION_EXPIRY_INTERVAL, sessionExpiryInterval_));
+        for (const auto& [key, value] : connectUserProperties_) {
+            props.add(mqtt::property(mqtt::property::USER_PROPERTY, key, value));
+        }
+        connBuilder.properties(props);
+    }
+
+    // Enable SSL/TLS if the broker address uses a secure scheme
+    if (brokerAddress_.rfind("ssl://", 0) == 0 ||
+        brokerAddress_.rfind("wss://", 0) == 0 ||
+        brokerAddress_.rfind("mqtts://", 0) == 0) {
+        auto sslOpts = mqtt::ssl_options_builder()
+            .enable_server_cert_auth(true)
+            .verify(true)
+            .finalize();
+        connBuilder.ssl(sslOpts);
+    }
+
+    return connBuilder.finalize();
+}
+
+bool PahoMqttClient::connect() {
+    try {
+        auto tok = client_->connect(buildConnectOptions());
+        tok->wait();
+        resetTopicAliases();
+
+        // Topic Alias Maximum from CONNACK; absent means the broker accepts none
+        uint16_t aliasMax = 0;
+        const auto& cProps = tok->get_connect_response().get_properties().c_struct();
+        for (int i = 0; i < cProps.count; ++i) {
+            if (cProps.array[i].identifier == MQTTPROPERTY_CODE_TOPIC_ALIAS_MAXIMUM) {
+                aliasMax = static_cast<uint16_t>(cProps.array[i].value.integer2);
+            }
+        }
+        brokerTopicAliasMaximum_ = aliasMax;
+        MCP_LOG_INFO("Connected to MQTT broker: " << brokerAddress_);
+        return true;
+    } catch (const mqtt::exception& e) {
+        MCP_LOG_ERROR("MQTT connect error: " << e.what());
+        return false;
+    }
+}
+
+void PahoMqttClient::disconnect() {
+    try {
+        if (client_->is_connected()) {
+            client_->disconnect()->wait();
+        }
+    } catch (const mqtt::exception& e) {
+        MCP_LOG_WARN("MQTT disconnect error: " << e.what());
+    }
+}
+
+void PahoMqttClient::setReconnectedCallback(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reconnectedCallback_ = callback;
+}
+
+bool PahoMqttClient::setConnectionRestoredCallback(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connectionRestoredCallback_ = callback;
+    return true;
+}
+
+int PahoMqttClient::getInflightCount() const {
+    return inflight_.load(std::memory_order_relaxed);
+}
+
+mqtt::async_client* PahoMqttClient::getUnderlyingClient() {
+    return client_.get();
+}
+
+bool PahoMqttClient::isConnected() const {
+    return client_->is_connected();
+}
+
+bool PahoMqttClient::subscribe(const std::string& topic, int qos, bool noLocal) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptions_[topic] = {qos, noLocal};
+    }
+    try {
+        mqtt::subscribe_options subOpts;
+        subOpts.set_no_local(noLocal);
+        // Never wait on the token: subscribe() is called from message_arrived,
+        // and the SUBACK is processed on that same thread
+        client_->subscribe(topic, qos, subOpts);
+        return true;
+    } catch (const mqtt::exception& e) {
+        MCP_LOG_ERROR("MQTT subscribe error: topic=" << topic << ", error=" << e.what());
+        return false;
+    }
+}
+
+bool PahoMqttClient::unsubscribe(const std::string& topic) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptions_.erase(topic);
+    }
+    try {
+        client_->unsubscribe(topic);
+        return true;
+    } catch (const mqtt::exception& e) {
+        MCP_LOG_ERROR("MQTT unsubscribe error: topic=" << topic << ", error=" << e.what());
+        return false;
+    }
+}
+
+const mqtt::properties& PahoMqttClient::publishProperties(const std::map<std::string, std::string>& userProps) {
+    // Caller holds propsMutex_
+    if (userProps != cachedUserProps_) {
+        mqtt::properties props;
+        for (const auto& [key, value] : userProps) {
+            props.add(mqtt::property(mqtt::property::USER_PROPERTY, key, value));
+        }
+        cachedProperties_ = std::move(props);
+        cachedUserProps_ = userProps;
+    }
+    return cachedProperties_;
+}
+
+bool PahoMqttClient::publish(const std::string& topic,
+                             const std::string& payload,
+                             int qos,
+                             bool retained,
+                             const std::map<std::string, std::string>& userProps) {
+    return publishMessage(topic, payload, qos, retained, userProps, nullptr);
+}
+
+bool PahoMqttClient::publishWithProperties(const std::string& topic,
+                                           const std::string& payload,
+                                           int qos,
+                                           bool retained,
+                                           const MqttPublishProperties& properties) {
+    return publishMessage(topic, payload, qos, retained, properties.userProperties, &properties);
+}
+
+uint16_t PahoMqttClient::getTopicAliasMaximum() const {
+    return brokerTopicAliasMaximum_.load(std::memory_order_relaxed);
+}
+
+bool PahoMqttClient::publishMessage(const std::string& topic,
+                                    const std::string& payload,
+                                    int qos,
+                                    bool retained,
+                                    const std::map<std::string, std::string>& userProps,
+                                    const MqttPublishProperties* extra) {
+    // Wait for a free inflight slot, unless we are on the callback thread that
+    // completes publishes
+    if (inflight_.load(std::memory_order_acquire) >= options_.maxInflight && !onCallbackThread()) {
+        std::unique_lock<std::mutex> lock(inflightMutex_);
+        bool ready = inflightCv_.wait_for(lock, options_.publishTimeout, [this] {
+            return inflight_.load(std::memory_order_acquire) < options_.maxInflight;
+        });
+        if (!ready) {
+            MCP_LOG_WARN("Publish window full for " << options_.publishTimeout.count()
+                      << "ms, dropping message on topic: " << topic);
+            return false;
+        }
+    }
+
+    uint16_t topicAlias = extra ? extra->topicAlias : 0;
+    if (topicAlias > getTopicAliasMaximum()) {
+        topicAlias = 0;
+    }
+    bool hasExtraProps = topicAlias > 0 ||
+        (extra && (extra->messageExpiryInterval > 0 || extra->payloadFormatIndicator > 0 ||
+                   !extra->contentType.empty() || !extra->responseTopic.empty() ||
+                   !extra->correlationData.empty()));
+
+    inflight_.fetch_add(1, std::memory_order_acq_rel);
+    try {
+        std::lock_guard<std::mutex> lock(propsMutex_);
+        mqtt::message_ptr msg;
+        if (topicAlias > 0) {
+            // Send the full topic only until the alias is established
+            if (outboundAliases_.size() <= topicAlias) {
+                outboundAliases_.resize(static_cast<size_t>(topicAlias) + 1);
+            }
+            bool established = outboundAliases_[topicAlias] == topic;
+            msg = mqtt::make_message(established ? std::string() : topic, payload, qos, retained);
+            outboundAliases_[topicAlias] = topic;
+        } else {
+            msg = mqtt::make_message(topic, payload, qos, retained);
+        }
+
+        if (hasExtraProps) {
+            // Per-message properties on top of the cached user properties
+            mqtt::properties props = publishProperties(userProps);
+            if (topicAlias > 0) {
+                props.add(mqtt::property(mqtt::property::TOPIC_ALIAS, topicAlias));
+            }
+            if (extra->messageExpiryInterval > 0) {
+                props.add(mqtt::property(mqtt::property::MESSAGE_EXPIRY_INTERVAL,
+                                         static_cast<int>(extra->messageExpiryInterval)));
+            }
+            if (extra->payloadFormatIndicator > 0) {
+                props.add(mqtt::property(mqtt::property::PAYLOAD_FORMAT_INDICATOR,
+                                         extra->payloadFormatIndicator));
+            }
+            if (!extra->contentType.empty()) {
+                props.add(mqtt::property(mqtt::property::CONTENT_TYPE, extra->contentType));
+            }
+            if (!extra->responseTopic.empty()) {
+                props.add(mqtt::property(mqtt::property::RESPONSE_TOPIC, extra->responseTopic));
+            }
+            if (!extra->correlationData.empty()) {
+                props.add(mqtt::property(mqtt::property::CORRELATION_DATA, extra->correlationData));
+            }
+            msg->set_properties(props);
+        } else if (!userProps.empty()) {
+            msg->set_properties(publishProperties(userProps));
+        }
+        client_->publish(msg, nullptr, *publishListener_);
+        return true;
+    } catch (const mqtt::exception& e) {
+        if (topicAlias > 0) {
+            // The broker never saw this mapping
+            std::lock_guard<std::mutex> lock(propsMutex_);
+            outboundAliases_[topicAlias].clear();
+        }
+        publishCompleted();
+        MCP_LOG_ERROR("MQTT publish error: topic=" << topic << ", error=" << e.what());
+        return false;
+    }
+}
+
+void PahoMqttClient::resetTopicAliases() {
+    std::lock_guard<std::mutex> lock(propsMutex_);
+    outboundAliases_.clear();
+}
+
+void PahoMqttClient::publishCompleted() {
+    {
+        // Pairs with the predicate check in publish() so no wake-up is lost
+        std::lock_guard<std::mutex> lock(inflightMutex_);
+        inflight_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    inflightCv_.notify_one();
+}
+
+std::string PahoMqttClient::getClientId() const {
+    return clientId_;
+}
+
+void PahoMqttClient::setMessageHandler(MqttMessageHandler handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    messageHandler_ = handler;
+}
+
+void PahoMqttClient::setConnectionLostCallback(std::function<void(const std::string&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connectionLostCallback_ = callback;
+}
+
+void PahoMqttClient::setConnectProperties(uint32_t sessionExpiryInterval,
+                                          const std::map<std::string, std::string>& userProperties) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sessionExpiryInterval_ = sessionExpiryInterval;
+    connectUserProperties_ = userProperties;
+    connectPropsSet_ = true;
+}
+
+void PahoMqttClient::setWill(const std::string& topic, const std::string& payload,
+                             int qos, bool retained) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        willTopic_ = topic;
+        willPayload_ = payload;
+        willQos_ = qos;
+        willRetained_ = retained;
+    }
+
+    if (!client_->is_connected()) {
+        return;
+    }
+
+    // Reconnect to apply the new Will. From the callback thread (e.g. a standby
+    // taking over) this must not block, so reconnect on a helper thread;
+    // subscriptions made meanwhile are restored in connected().
+    auto reconnect = [this]() {
+        try {
+            client_->disconnect()->wait();
+            if (!connect()) {
+                return;
+            }
+            restoreSubscriptions();
+            notifyConnectionRestored();
+        } catch (const mqtt::exception& e) {
+            MCP_LOG_ERROR("Reconnect with Will error: " << e.what());
+        }
+    };
+
+    if (onCallbackThread()) {
+        if (reconnectThread_.joinable()) {
+            reconnectThread_.join();
+        }
+        reconnectThread_ = std::thread(reconnect);
+    } else {
+        reconnect();
+    }
+}
+
+void PahoMqttClient::restoreSubscriptions() {
+    std::map<std::string, std::pair<int, bool>> subscriptions;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptions = subscriptions_;
+    }
+    for (const auto& [topic, opts] : subscriptions) {
+        try {
+            mqtt::subscribe_options subOpts;
+            subOpts.set_no_local(opts.second);
+            client_->subscribe(topic, opts.first, subOpts);
+        } catch (const mqtt::exception& e) {
+            MCP_LOG_ERROR("MQTT resubscribe error: topic=" << topic << ", error=" << e.what());
+        }
+    }
+    MCP_LOG_DEBUG("Restored " << subscriptions.size() << " subscription(s)");
+}
+
+void PahoMqttClient::notifyConnectionRestored() {
+    std::function<void()> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = connectionRestoredCallback_;
+    }
+    if (callback) {
+        callback();
+    }
+}
+
+bool PahoMqttClient::onCallbackThread() const {
+    return callbackThread_.load(std::memory_order_relaxed) == std::this_thread::get_id();
+}
+
+// mqtt::callback overrides
+
+void PahoMqttClient::connected(const std::string& cause) {
+    callbackThread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    resetTopicAliases();
+
+    // Paho reports "automatic reconnect" as the cause after an automatic reconnect
+    if (cause.find("reconnect") == std::string::npos) {
+        return;
+    }
+
+    MCP_LOG_INFO("Reconnected to MQTT broker: " << brokerAddress_);
+    restoreSubscriptions();
+    notifyConnectionRestored();
+
+    std::function<void()> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = reconnectedCallback_;
+    }
+    if (callback) {
+        callback();
+    }
+}
+
+void PahoMqttClient::connection_lost(const std::string& cause) {
+    resetTopicAliases();
+
+    std::function<void(const std::string&)> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = connectionLostCallback_;
+    }
+
+    // With automatic reconnect the session will be restored; only report
+    // the loss when nothing will bring the connection back
+    if (options_.autoReconnect) {
+        MCP_LOG_WARN("MQTT connection lost, reconnecting: " << cause);
+        return;
+    }
+    if (callback) {
+        callback(cause);
+    }
+}
+
+void PahoMqttClient::message_arrived(mqtt::const_message_ptr msg) {
+    callbackThread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+    MqttMessageHandler handler;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handler = messageHandler_;
+    }
+    if (!handler) {
+        return;
+    }
+
+    // assign() keeps the capacity of previous arrivals
+    incoming_.topic.assign(msg->get_topic());
+    incoming_.payload.assign(msg->get_payload());
+    incoming_.qos = msg->get_qos();
+    incoming_.retained = msg->is_retained();
+    incoming_.userProperties.clear();
+    incoming_.messageExpiryInterval.reset();
+    incoming_.correlationData.clear();
+    incoming_.responseTopic.clear();
+    incoming_.contentType.clear();
+    incoming_.payloadFormatIndicator = 0;
+    incoming_.topicAlias = 0;     // Paho resolves inbound aliases itself
+
+    // Extract properties using C-level API for cross-version compatibility
+    const auto& cProps = msg->get_properties().c_struct();
+    for (int i = 0; i < cProps.count; ++i) {
+        if (cProps.array[i].identifier == MQTTPROPERTY_CODE_USER_PROPERTY) {
+            incoming_.userProperties.emplace(
+                std::string(cProps.array[i].value.data.data, cProps.array[i].value.data.len),
+                std::string(cProps.array[i].value.value.data, cProps.array[i].value.value.len));
+        } else if (cProps.array[i].identifier == MQTTPROPERTY_CODE_MESSAGE_EXPIRY_INTERVAL) {
+            incoming_.messageExpiryInterval = static_cast<uint32_t>(cProps.array[i].value.integer4);
+        } else if (cProps.array[i].identifier == MQTTPROPERTY_CODE_CORRELATION_DATA) {
+            incoming_.correlationData.assign(cProps.array[i].value.data.data, cProps.array[i].value.data.len);
+        } else if (cProps.array[i].identifier == MQTTPROPERTY_CODE_RESPONSE_TOPIC) {
+            incoming_.responseTopic.assign(cProps.array[i].value.data.data, cProps.array[i].value.data.len);
+        } else if (cProps.array[i].identifier == MQTTPROPERTY_CODE_CONTENT_TYPE) {
+            incoming_.contentType.assign(cProps.array[i].value.data.data, cProps.array[i].value.data.len);
+        } else if (cProps.array[i].identifier == MQTTPROPERTY_CODE_PAYLOAD_FORMAT_INDICATOR) {
+            incoming_.payloadFormatIndicator = cProps.array[i].value.byte;
+        }
+    }
+
+    handler(incoming_);
+}
+
+void PahoMqttClient::delivery_complete(mqtt::delivery_token_ptr) {
+    // Completion is tracked through PublishListener
+}
+
+} // namespace mcp_mqtt
@@ -0,0 +1,311 @@
+#include "mcp_mqtt/server_directory.h"
+#include "mcp_mqtt/json_rpc.h"
+#include "mcp_mqtt/logger.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace mcp_mqtt {
+
+static constexpr const char* MCP_PRESENCE_PREFIX = "$mcp-server/presence/";
+
+struct ServerDirectory::View::Snapshot {
+    std::vector<ServerPtr> servers;     // Sorted by (serverName, serverId)
+    uint64_t version = 0;
+};
+
+namespace {
+
+bool entryLess(const ServerDirectory::ServerPtr& entry, const std::pair<const std::string&, const std::string&>& key) {
+    int order = entry->serverName.compare(key.first);
+    return order < 0 || (order == 0 && entry->serverId < key.second);
+}
+
+const ServerDirectory::ServerPtr* lowerBound(const std::vector<ServerDirectory::ServerPtr>& servers,
+                                             const std::string& serverName, const std::string& serverId) {
+    auto it = std::lower_bound(servers.begin(), servers.end(),
+                               std::pair<const std::string&, const std::string&>(serverName, serverId),
+                               entryLess);
+    return servers.data() + (it - servers.begin());
+}
+
+} // namespace
+
+// View
+
+ServerDirectory::View::View(const ServerDirectory* directory, size_t side, const Snapshot* snapshot)
+    : directory_(directory), side_(side), snapshot_(snapshot) {
+}
+
+ServerDirectory::View::View(View&& other) noexcept
+    : directory_(other.directory_), side_(other.side_), snapshot_(other.snapshot_) {
+    other.directory_ = nullptr;
+}
+
+ServerDirectory::View::~View() {
+    if (directory_) {
+        directory_->readers_[side_].count.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+ServerDirectory::Range ServerDirectory::View::all() const {
+    const ServerPtr* data = snapshot_->servers.data();
+    return {data, data + snapshot_->servers.size()};
+}
+
+ServerDirectory::Range ServerDirectory::View::withName(const std::string& serverName) const {
+    const auto& servers = snapshot_->servers;
+    const ServerPtr* first = lowerBound(servers, serverName, "");
+    const ServerPtr* end = servers.data() + servers.size();
+    const ServerPtr* last = std::upper_bound(first, end, serverName,
+        [](const std::string& name, const ServerPtr& entry) { return name < entry->serverName; });
+    return {first, last};
+}
+
+ServerDirectory::Range ServerDirectory::View::withPrefix(const std::string& prefix) const {
+    const auto& servers = snapshot_->servers;
+    const ServerPtr* first = lowerBound(servers, prefix, "");
+    const ServerPtr* end = servers.data() + servers.size();
+    // Names with the prefix sort contiguously right after it
+    const ServerPtr* last = std::partition_point(first, end, [&prefix](const ServerPtr& entry) {
+        return entry->serverName.compare(0, prefix.size(), prefix) == 0;
+    });
+    return {first, last};
+}
+
+ServerDirectory::ServerPtr ServerDirectory::View::find(const std::string& serverId,
+                                                       const std::string& serverName) const {
+    const auto& servers = snapshot_->servers;
+    const ServerPtr* it = lowerBound(servers, serverName, serverId);
+    if (it != servers.data() + servers.size() && (*it)->serverName == serverName && (*it)->serverId == serverId) {
+        return *it;
+    }
+    return nullptr;
+}
+
+size_t ServerDirectory::View::size() const {
+    return snapshot_->servers.size();
+}
+
+uint64_t ServerDirectory::View::version() const {
+    return snapshot_->version;
+}
+
+// ServerDirectory
+
+ServerDirectory::ServerDirectory() : current_(new Snapshot()) {
+}
+
+ServerDirectory::~ServerDirectory() {
+    delete current_.load();
+}
+
+ServerDirectory::View ServerDirectory::read() const {
+    for (;;) {
+        uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+        size_t side = epoch & 1;
+        readers_[side].count.fetch_add(1, std::memory_order_seq_cst);
+        // Counted in the epoch a writer waits on, unless it moved on meanwhile
+        if (epoch_.load(std::memory_order_seq_cst) == epoch) {
+            return View(this, side, current_.load(std::memory_order_seq_cst));
+        }
+        readers_[side].count.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+std::vector<ServerDirectory::ServerPtr> ServerDirectory::findByName(const std::string& serverName) const {
+    View view = read();
+    Range range = view.withName(serverName);
+    return std::vector<ServerPtr>(range.begin(), range.end());
+}
+
+std::vector<ServerDirectory::ServerPtr> ServerDirectory::findByPrefix(const std::string& prefix) const {
+    View view = read();
+    Range range = view.withPrefix(prefix);
+    return std::vector<ServerPtr>(range.begin(), range.end());
+}
+
+ServerDirectory::ServerPtr ServerDirectory::find(const std::string& serverId,
+                                                 const std::string& serverName) const {
+    return read().find(serverId, serverName);
+}
+
+size_t ServerDirectory::size() const {
+    return read().size();
+}
+
+ServerDirectory::Change ServerDirectory::applyPresence(const MqttIncomingMessage& message,
+                                                       std::vector<ServerPtr>* servers) {
+    // Topic format: $mcp-server/presence/{server-id}/{server-name}
+    const std::string& topic = message.topic;
+    size_t idStart = std::char_traits<char>::length(MCP_PRESENCE_PREFIX);
+    if (topic.rfind(MCP_PRESENCE_PREFIX, 0) != 0 || topic.size() == idStart) {
+        MCP_LOG_WARN("Malformed server presence topic: " << topic);
+        return Change::NONE;
+    }
+    size_t idEnd = topic.find('/', idStart);
+    if (idEnd == std::string::npos) {
+        return applyHostPresence(topic.substr(idStart), message, servers);
+    }
+    if (idEnd == idStart || idEnd + 1 >= topic.size()) {
+        MCP_LOG_WARN("Malformed server presence topic: " << topic);
+        return Change::NONE;
+    }
+    std::string serverId = topic.substr(idStart, idEnd - idStart);
+    std::string serverName = topic.substr(idEnd + 1);
+
+    if (message.payload.empty()) {
+        ServerPtr removed = remove(serverId, serverName);
+        if (servers && removed) {
+            servers->push_back(removed);
+        }
+        return removed ? Change::OFFLINE : Change::NONE;
+    }
+
+    auto jsonOpt = JsonRpc::parse(message.payload);
+    if (!jsonOpt || !jsonOpt->is_object() || jsonOpt->value("method", "") != METHOD_SERVER_ONLINE) {
+        MCP_LOG_WARN("Unexpected server presence payload on " << topic);
+        return Change::NONE;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(hostsMutex_);
+        if (offlineHosts_.count(serverId)) {
+            MCP_LOG_DEBUG("Ignoring stale presence of offline host: " << topic);
+            return Change::NONE;
+        }
+    }
+
+    auto entry = std::make_shared<DiscoveredServer>();
+    entry->serverId = std::move(serverId);
+    entry->serverName = std::move(serverName);
+    auto params = jsonOpt->find("params");
+    if (params != jsonOpt->end() && params->is_object()) {
+        entry->description = params->value("description", "");
+        auto meta = params->find("meta");
+        if (meta != params->end()) {
+            entry->meta = std::move(*meta);
+        }
+    }
+    auto clientId = message.userProperties.find(USER_PROP_MQTT_CLIENT_ID);
+    if (clientId != message.userProperties.end()) {
+        entry->mqttClientId = clientId->second;
+    }
+    if (servers) {
+        servers->push_back(entry);
+    }
+    return insert(std::move(entry)) ? Change::ONLINE : Change::UPDATED;
+}
+
+ServerDirectory::Change ServerDirectory::applyHostPresence(const std::string& serverId,
+                                                           const MqttIncomingMessage& message,
+                                                           std::vector<ServerPtr>* servers) {
+    std::string method;
+    if (!message.payload.empty()) {
+        auto jsonOpt = JsonRpc::parse(message.payload);
+        if (jsonOpt && jsonOpt->is_object()) {
+            method = jsonOpt->value("method", "");
+        }
+    }
+
+    if (method != METHOD_SERVER_OFFLINE) {
+        // Online, or cleared by a host that stopped after removing its servers
+        std::lock_guard<std::mutex> lock(hostsMutex_);
+        offlineHosts_.erase(serverId);
+        return Change::NONE;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(hostsMutex_);
+        offlineHosts_.insert(serverId);
+    }
+    std::vector<ServerPtr> removed = removeServerId(serverId);
+    MCP_LOG_INFO("Server host offline: serverId=" << serverId << ", removed " << removed.size() << " server(s)");
+    if (removed.empty()) {
+        return Change::NONE;
+    }
+    if (servers) {
+        servers->insert(servers->end(), removed.begin(), removed.end());
+    }
+    return Change::OFFLINE;
+}
+
+bool ServerDirectory::upsert(DiscoveredServer server) {
+    return insert(std::make_shared<const DiscoveredServer>(std::move(server)));
+}
+
+bool ServerDirectory::insert(ServerPtr entry) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    const auto& servers = current_.load(std::memory_order_relaxed)->servers;
+    const ServerPtr* it = lowerBound(servers, entry->serverName, entry->serverId);
+    size_t index = static_cast<size_t>(it - servers.data());
+    bool added = index == servers.size() || (*it)->serverName != entry->serverName ||
+                 (*it)->serverId != entry->serverId;
+
+    std::vector<ServerPtr> next;
+    next.reserve(servers.size() + (added ? 1 : 0));
+    next.insert(next.end(), servers.begin(), servers.begin() + index);
+    next.push_back(std::move(entry));
+    next.insert(next.end(), servers.begin() + index + (added ? 0 : 1), servers.end());
+    publish(std::move(next));
+    return added;
+}
+
+ServerDirectory::ServerPtr ServerDirectory::remove(const std::string& serverId, const std::string& serverName) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    const auto& servers = current_.load(std::memory_order_relaxed)->servers;
+    const ServerPtr* it = lowerBound(servers, serverName, serverId);
+    size_t index = static_cast<size_t>(it - servers.data());
+    if (index == servers.size() || (*it)->serverName != serverName || (*it)->serverId != serverId) {
+        return nullptr;
+    }
+    ServerPtr removed = *it;
+
+    std::vector<ServerPtr> next;
+    next.reserve(servers.size() - 1);
+    next.insert(next.end(), servers.begin(), servers.begin() + index);
+    next.insert(next.end(), servers.begin() + index + 1, servers.end());
+    publish(std::move(next));
+    return removed;
+}
+
+std::vector<ServerDirectory::ServerPtr> ServerDirectory::removeServerId(const std::string& serverId) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    const auto& servers = current_.load(std::memory_order_relaxed)->servers;
+    std::vector<ServerPtr> removed;
+    std::vector<ServerPtr> next;
+    next.reserve(servers.size());
+    for (const auto& entry : servers) {
+        (entry->serverId == serverId ? removed : next).push_back(entry);
+    }
+    if (!removed.empty()) {
+        publish(std::move(next));
+    }
+    return removed;
+}
+
+void ServerDirectory::clear() {
+    {
+        std::lock_guard<std::mutex> lock(hostsMutex_);
+        offlineHosts_.clear();
+    }
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    publish({});
+}
+
+void ServerDirectory::publish(std::vector<ServerPtr> servers) {
+    auto* next = new Snapshot();
+    next->servers = std::move(servers);
+    const Snapshot* previous = current_.load(std::memory_order_relaxed);
+    next->version = previous->version + 1;
+
+    current_.store(next, std::memory_order_seq_cst);
+    // Readers counted from now on see the new snapshot; wait for the ones before
+    uint64_t epoch = epoch_.fetch_add(1, std::memory_order_seq_cst);
+    while (readers_[epoch & 1].count.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+    delete previous;
+}
+
+} // namespace mcp_mqtt
@@ -0,0 +1,360 @@
+#include "mcp_mqtt/shm_channel.h"
+#include "mcp_mqtt/logger.h"
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <ctime>
+#endif
+
+namespace mcp_mqtt {
+
+static constexpr uint32_t SHM_MAGIC = 0x4d435053;  // "MCPS"
+static constexpr uint32_t SHM_VERSION = 1;
+static constexpr int RING_CLIENT_TO_SERVER = 0;
+static constexpr int RING_SERVER_TO_CLIENT = 1;
+static constexpr int SPIN_ITERATIONS = 64;
+
+struct RingHeader {
+    alignas(64) std::atomic<uint64_t> head{0};      // Written by the producer
+    alignas(64) std::atomic<uint64_t> tail{0};      // Written by the consumer
+    alignas(64) std::atomic<uint32_t> seq{0};       // Futex word, bumped per frame
+    std::atomic<uint32_t> waiters{0};
+};
+
+struct ShmChannel::Segment {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    std::atomic<uint32_t> closed;
+    RingHeader rings[2];
+
+    // Takes the capacity validated at create()/open(), not the shared field
+    char* ringData(int ring, uint64_t ringCapacity) {
+        return reinterpret_cast<char*>(this + 1) + ring * ringCapacity;
+    }
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "futex word must be lock-free");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring positions must be lock-free");
+
+#if defined(__linux__)
+
+static void futexWake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static void futexWait(std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs) {
+    struct timespec ts;
+    struct timespec* tsp = nullptr;
+    if (timeoutMs >= 0) {
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = (timeoutMs % 1000) * 1000000L;
+        tsp = &ts;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, tsp, nullptr, 0);
+}
+
+static size_t roundUpPowerOfTwo(size_t n) {
+    size_t p = 4096;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+static void copyIn(char* data, uint64_t capacity, uint64_t pos, const char* src, size_t n) {
+    size_t off = pos & (capacity - 1);
+    size_t first = std::min<size_t>(n, capacity - off);
+    std::memcpy(data + off, src, first);
+    std::memcpy(data, src + first, n - first);
+}
+
+static void copyOut(const char* data, uint64_t capacity, uint64_t pos, char* dst, size_t n) {
+    size_t off = pos & (capacity - 1);
+    size_t first = std::min<size_t>(n, capacity - off);
+    std::memcpy(dst, data + off, first);
+    std::memcpy(dst + first, data, n - first);
+}
+
+ShmChannel::~ShmChannel() {
+    if (segment_) {
+        // Either side going away ends the channel for both
+        close();
+        munmap(segment_, mappedSize_);
+    }
+    if (owner_) {
+        shm_unlink(name_.c_str());
+    }
+}
+
+std::unique_ptr<ShmChannel> ShmChannel::create(const std::string& name, size_t ringCapacity) {
+    size_t capacity = roundUpPowerOfTwo(ringCapacity);
+    size_t size = sizeof(Segment) + 2 * capacity;
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        // Left behind by a server that crashed; its clients are gone with it
+        MCP_LOG_WARN("Removing stale shared memory segment: " << name);
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        MCP_LOG_ERROR("shm_open failed for " << name << ": " << std::strerror(errno));
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        MCP_LOG_ERROR("ftruncate failed for " << name << ": " << std::strerror(errno));
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        MCP_LOG_ERROR("mmap failed for " << name << ": " << std::strerror(errno));
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    std::unique_ptr<ShmChannel> channel(new ShmChannel());
+    channel->name_ = name;
+    channel->owner_ = true;
+    channel->mappedSize_ = size;
+    channel->segment_ = new (addr) Segment{SHM_MAGIC, SHM_VERSION, capacity, {0}, {}};
+    channel->capacity_ = capacity;
+    channel->txRing_ = RING_SERVER_TO_CLIENT;
+    channel->rxRing_ = RING_CLIENT_TO_SERVER;
+    MCP_LOG_DEBUG("Created shared memory channel: " << name << ", ring capacity=" << capacity);
+    return channel;
+}
+
+std::unique_ptr<ShmChannel> ShmChannel::open(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        MCP_LOG_ERROR("shm_open failed for " << name << ": " << std::strerror(errno));
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Segment)) {
+        MCP_LOG_ERROR("Invalid shared memory segment: " << name);
+        ::close(fd);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        MCP_LOG_ERROR("mmap failed for " << name << ": " << std::strerror(errno));
+        return nullptr;
+    }
+
+    auto* segment = static_cast<Segment*>(addr);
+    uint64_t capacity = segment->capacity;
+    if (segment->magic != SHM_MAGIC || segment->version != SHM_VERSION ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0 || capacity > size ||
+        sizeof(Segment) + 2 * capacity > size) {
+        MCP_LOG_ERROR("Shared memory segment has wrong format: " << name);
+        munmap(addr, size);
+        return nullptr;
+    }
+
+    std::unique_ptr<ShmChannel> channel(new ShmChannel());
+    channel->name_ = name;
+    channel->owner_ = false;
+    channel->mappedSize_ = size;
+    channel->segment_ = segment;
+    channel->capacity_ = capacity;
+    channel->txRing_ = RING_CLIENT_TO_SERVER;
+    channel->rxRing_ = RING_SERVER_TO_CLIENT;
+    return channel;
+}
+
+std::string ShmChannel::localHostId() {
+    std::ifstream in("/proc/sys/kernel/random/boot_id");
+    std::string id;
+    std::getline(in, id);
+    return id;
+}
+
+bool ShmChannel::send(const std::string& payload) {
+    if (isClosed()) return false;
+
+    RingHeader& ring = segment_->rings[txRing_];
+    uint64_t capacity = capacity_;
+    if (payload.size() > capacity - sizeof(uint32_t)) {
+        MCP_LOG_WARN("Message too large for shared memory ring: " << name_ << ", " << payload.size() << " bytes");
+        return false;
+    }
+    uint32_t len = static_cast<uint32_t>(payload.size());
+    uint64_t frameSize = sizeof(len) + len;
+
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    uint64_t tail = ring.tail.load(std::memory_order_acquire);
+    if (head - tail > capacity || frameSize > capacity - (head - tail)) {
+        MCP_LOG_WARN("Shared memory ring full: " << name_ << ", dropping " << len << " bytes");
+        return false;
+    }
+
+    char* data = segment_->ringData(txRing_, capacity);
+    copyIn(data, capacity, head, reinterpret_cast<const char*>(&len), sizeof(len));
+    copyIn(data, capacity, head + sizeof(len), payload.data(), len);
+    ring.head.store(head + frameSize, std::memory_order_release);
+
+    // Sequentially consistent so a reader registering as waiter cannot be missed
+    ring.seq.fetch_add(1);
+    if (ring.waiters.load() > 0) {
+        futexWake(&ring.seq);
+    }
+    return true;
+}
+
+bool ShmChannel::receive(std::string& payload, int timeoutMs) {
+    RingHeader& ring = segment_->rings[rxRing_];
+    uint64_t capacity = capacity_;
+    const char* data = segment_->ringData(rxRing_, capacity);
+
+    int spins = 0;
+    while (true) {
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        if (head != tail) {
+            // The segment is writable by the peer: never trust a length from it
+            uint64_t available = head - tail;
+            uint32_t len = 0;
+            if (available >= sizeof(len) && available <= capacity) {
+                copyOut(data, capacity, tail, reinterpret_cast<char*>(&len), sizeof(len));
+            }
+            if (available < sizeof(len) || available > capacity || len > available - sizeof(len)) {
+                MCP_LOG_ERROR("Corrupt frame in shared memory ring: " << name_ << ", length=" << len
+                          << ", available=" << available << "; closing the channel");
+                ring.tail.store(head, std::memory_order_release);
+                close();
+                return false;
+            }
+            payload.resize(len);
+            copyOut(data, capacity, tail + sizeof(len), &payload[0], len);
+            ring.tail.store(tail + sizeof(len) + len, std::memory_order_release);
+            return true;
+        }
+        if (isClosed()) {
+            return false;
+        }
+
+        // Spin briefly for low latency before sleeping on the futex; yield so
+        // the producer can run when both share a core
+        if (spins++ < SPIN_ITERATIONS) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint32_t seq = ring.seq.load(std::memory_order_acquire);
+        ring.waiters.fetch_add(1);
+        if (ring.head.load() == tail && !isClosed()) {
+            futexWait(&ring.seq, seq, timeoutMs);
+        }
+        ring.waiters.fetch_sub(1, std::memory_order_acq_rel);
+
+        if (timeoutMs >= 0 && ring.head.load(std::memory_order_acquire) == tail) {
+            return false;
+        }
+    }
+}
+
+void ShmChannel::close() {
+    if (!segment_) return;
+    segment_->closed.store(1, std::memory_order_release);
+    for (auto& ring : segment_->rings) {
+        ring.seq.fetch_add(1, std::memory_order_release);
+        futexWake(&ring.seq);
+    }
+}
+
+bool ShmChannel::isClosed() const {
+    return !segment_ || segment_->closed.load(std::memory_order_acquire) != 0;
+}
+
+#else
+
+ShmChannel::~ShmChannel() = default;
+
+std::unique_ptr<ShmChannel> ShmChannel::create(const std::string&, size_t) {
+    MCP_LOG_WARN("Shared memory channels are only supported on Linux");
+    return nullptr;
+}
+
+std::unique_ptr<ShmChannel> ShmChannel::open(const std::string&) {
+    MCP_LOG_WARN("Shared memory channels are only supported on Linux");
+    return nullptr;
+}
+
+std::string ShmChannel::localHostId() {
+    return "";
+}
+
+bool ShmChannel::send(const std::string&) {
+    return false;
+}
+
+bool ShmChannel::receive(std::string&, int) {
+    return false;
+}
+
+void ShmChannel::close() {}
+
+bool ShmChannel::isClosed() const {
+    return true;
+}
+
+#endif
+
+const std::string& ShmChannel::name() const {
+    return name_;
+}
+
+size_t ShmChannel::ringCapacity() const {
+    return static_cast<size_t>(capacity_);
+}
+
+// ShmSessionTransport implementation
+ShmSessionTransport::ShmSessionTransport(std::unique_ptr<ShmChannel> channel, FrameHandler handler)
+    : channel_(std::move(channel)) {
+    // The reader only touches its own copies, so it may outlive this object
+    // when the session is torn down from within the handler
+    reader_ = std::thread([channel = channel_, handler = std::move(handler)]() {
+        std::string payload;
+        while (channel->receive(payload, -1)) {
+            handler(payload);
+        }
+        MCP_LOG_DEBUG("Shared memory reader stopped: " << channel->name());
+    });
+}
+
+ShmSessionTransport::~ShmSessionTransport() {
+    close();
+}
+
+bool ShmSessionTransport::send(const std::string& payload) {
+    return channel_->send(payload);
+}
+
+void ShmSessionTransport::close() {
+    channel_->close();
+    if (reader_.joinable()) {
+        if (reader_.get_id() == std::this_thread::get_id()) {
+            reader_.detach();
+        } else {
+            reader_.join();
+        }
+    }
+}
+
+} // namespace mcp_mqtt
@@ -15,10 +15,10 @@ bool ToolManager::registerTool(const Tool& tool, ToolHandler handler) {
     return true;
 }
 
-void ToolManager::unregisterTool(const std::string& name) {
+bool ToolManager::unregisterTool(const std::string& name) {
     std::lock_guard<std::mutex> lock(mutex_);
-    tools_.erase(name);
     handlers_.erase(name);
+    return tools_.erase(name) > 0;
 }
 
 std::vector<Tool> ToolManager::getTools() const {
@@ -0,0 +1,354 @@
+#include "mcp_mqtt/traffic_recorder.h"
+#include "mcp_mqtt/logger.h"
+
+#include <cerrno>
+#include <cstring>
+
+namespace mcp_mqtt {
+
+static constexpr char TRAFFIC_MAGIC[8] = {'M', 'C', 'P', 'T', 'R', 'A', 'F', '1'};
+static constexpr size_t FILE_BUFFER_SIZE = 1 << 20;
+
+// Record layout: flags byte, varint time delta (us), topic, payload, user
+// property count and pairs, then the MQTT 5.0 metadata if FLAG_METADATA is
+// set. Strings are a varint length followed by the bytes.
+static constexpr uint8_t FLAG_QOS_MASK = 0x03;
+static constexpr uint8_t FLAG_RETAINED = 0x04;
+static constexpr uint8_t FLAG_METADATA = 0x08;
+static constexpr uint8_t FLAG_OUTGOING = 0x10;
+
+static void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static void putString(std::string& out, const std::string& value) {
+    putVarint(out, value.size());
+    out.append(value);
+}
+
+static bool hasMetadata(const MqttIncomingMessage& message) {
+    return message.messageExpiryInterval || !message.correlationData.empty() ||
+           !message.responseTopic.empty() || !message.contentType.empty() ||
+           message.payloadFormatIndicator != 0;
+}
+
+RecordingMqttClient::RecordingMqttClient(IMqttClient* client) : client_(client) {
+}
+
+RecordingMqttClient::~RecordingMqttClient() {
+    close();
+}
+
+bool RecordingMqttClient::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        MCP_LOG_ERROR("Traffic recording already open");
+        return false;
+    }
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        MCP_LOG_ERROR("Failed to open traffic recording " << path << ": " << std::strerror(errno));
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+    if (std::fwrite(TRAFFIC_MAGIC, sizeof(TRAFFIC_MAGIC), 1, file) != 1) {
+        MCP_LOG_ERROR("Failed to write traffic recording " << path);
+        std::fclose(file);
+        return false;
+    }
+
+    file_ = file;
+    start_ = std::chrono::steady_clock::now();
+    lastTimestamp_ = 0;
+    recordCount_ = 0;
+    MCP_LOG_INFO("Recording MQTT traffic to " << path);
+    return true;
+}
+
+void RecordingMqttClient::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) {
+        return;
+    }
+    std::fclose(file_);
+    file_ = nullptr;
+    MCP_LOG_INFO("Traffic recording closed after " << recordCount_ << " messages");
+}
+
+void RecordingMqttClient::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        std::fflush(file_);
+    }
+}
+
+bool RecordingMqttClient::isRecording() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_ != nullptr;
+}
+
+uint64_t RecordingMqttClient::getRecordCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return recordCount_;
+}
+
+void RecordingMqttClient::record(TrafficDirection direction, const MqttIncomingMessage& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) {
+        return;
+    }
+
+    // Taken under the lock, so deltas never go backwards
+    int64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start_).count();
+
+    bool metadata = hasMetadata(message);
+    uint8_t flags = static_cast<uint8_t>(message.qos) & FLAG_QOS_MASK;
+    if (message.retained) flags |= FLAG_RETAINED;
+    if (metadata) flags |= FLAG_METADATA;
+    if (direction == TrafficDirection::OUTGOING) flags |= FLAG_OUTGOING;
+
+    buffer_.clear();
+    buffer_.push_back(static_cast<char>(flags));
+    putVarint(buffer_, static_cast<uint64_t>(timestamp - lastTimestamp_));
+    putString(buffer_, message.topic);
+    putString(buffer_, message.payload);
+    putVarint(buffer_, message.userProperties.size());
+    for (const auto& [key, value] : message.userProperties) {
+        putString(buffer_, key);
+        putString(buffer_, value);
+    }
+    if (metadata) {
+        // 0 = no expiry interval, otherwise the interval plus one
+        putVarint(buffer_, message.messageExpiryInterval ? *message.messageExpiryInterval + 1ull : 0);
+        putString(buffer_, message.correlationData);
+        putString(buffer_, message.responseTopic);
+        putString(buffer_, message.contentType);
+        buffer_.push_back(static_cast<char>(message.payloadFormatIndicator));
+    }
+
+    if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+        MCP_LOG_ERROR("Traffic recording write failed, recording stopped: " << std::strerror(errno));
+        std::fclose(file_);
+        file_ = nullptr;
+        return;
+    }
+    lastTimestamp_ = timestamp;
+    ++recordCount_;
+}
+
+bool RecordingMqttClient::isConnected() const {
+    return client_->isConnected();
+}
+
+bool RecordingMqttClient::subscribe(const std::string& topic, int qos, bool noLocal) {
+    return client_->subscribe(topic, qos, noLocal);
+}
+
+bool RecordingMqttClient::unsubscribe(const std::string& topic) {
+    return client_->unsubscribe(topic);
+}
+
+bool RecordingMqttClient::publish(const std::string& topic,
+                                  const std::string& payload,
+                                  int qos,
+                                  bool retained,
+                                  const std::map<std::string, std::string>& userProps) {
+    if (isRecording()) {
+        MqttIncomingMessage message;
+        message.topic = topic;
+        message.payload = payload;
+        message.qos = qos;
+        message.retained = retained;
+        message.userProperties = userProps;
+        record(TrafficDirection::OUTGOING, message);
+    }
+    return client_->publish(topic, payload, qos, retained, userProps);
+}
+
+bool RecordingMqttClient::publishWithProperties(const std::string& topic,
+                                                const std::string& payload,
+                                                int qos,
+                                                bool retained,
+                                                const MqttPublishProperties& properties) {
+    if (isRecording()) {
+        MqttIncomingMessage message;
+        message.topic = topic;
+        message.payload = payload;
+        message.qos = qos;
+        message.retained = retained;
+        message.userProperties = properties.userProperties;
+        if (properties.messageExpiryInterval > 0) {
+            message.messageExpiryInterval = properties.messageExpiryInterval;
+        }
+        message.correlationData = properties.correlationData;
+        message.responseTopic = properties.responseTopic;
+        message.contentType = properties.contentType;
+        message.payloadFormatIndicator = properties.payloadFormatIndicator;
+        record(TrafficDirection::OUTGOING, message);
+    }
+    return client_->publishWithProperties(topic, payload, qos, retained, properties);
+}
+
+uint16_t RecordingMqttClient::getTopicAliasMaximum() const {
+    return client_->getTopicAliasMaximum();
+}
+
+std::string RecordingMqttClient::getClientId() const {
+    return client_->getClientId();
+}
+
+void RecordingMqttClient::setMessageHandler(MqttMessageHandler handler) {
+    client_->setMessageHandler([this, handler = std::move(handler)](const MqttIncomingMessage& message) {
+        record(TrafficDirection::INCOMING, message);
+        if (handler) {
+            handler(message);
+        }
+    });
+}
+
+void RecordingMqttClient::setConnectionLostCallback(std::function<void(const std::string& reason)> callback) {
+    client_->setConnectionLostCallback(std::move(callback));
+}
+
+bool RecordingMqttClient::setConnectionRestoredCallback(std::function<void()> callback) {
+    return client_->setConnectionRestoredCallback(std::move(callback));
+}
+
+void RecordingMqttClient::setConnectProperties(uint32_t sessionExpiryInterval,
+                                               const std::map<std::string, std::string>& userProperties) {
+    client_->setConnectProperties(sessionExpiryInterval, userProperties);
+}
+
+void RecordingMqttClient::setWill(const std::string& topic, const std::string& payload,
+                                  int qos, bool retained) {
+    client_->setWill(topic, payload, qos, retained);
+}
+
+// TrafficReader
+
+TrafficReader::~TrafficReader() {
+    close();
+}
+
+bool TrafficReader::open(const std::string& path) {
+    close();
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) {
+        MCP_LOG_ERROR("Failed to open traffic recording " << path << ": " << std::strerror(errno));
+        return false;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+
+    // Record lengths are checked against what the file can still hold
+    long size = -1;
+    if (std::fseek(file_, 0, SEEK_END) == 0) {
+        size = std::ftell(file_);
+    }
+    if (size < 0 || std::fseek(file_, 0, SEEK_SET) != 0) {
+        MCP_LOG_ERROR("Failed to size traffic recording " << path << ": " << std::strerror(errno));
+        close();
+        return false;
+    }
+    fileSize_ = static_cast<uint64_t>(size);
+
+    char magic[sizeof(TRAFFIC_MAGIC)];
+    if (std::fread(magic, sizeof(magic), 1, file_) != 1 ||
+        std::memcmp(magic, TRAFFIC_MAGIC, sizeof(magic)) != 0) {
+        MCP_LOG_ERROR("Not a traffic recording: " << path);
+        close();
+        return false;
+    }
+    lastTimestamp_ = 0;
+    return true;
+}
+
+void TrafficReader::close() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool TrafficReader::readVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = std::fgetc(file_);
+        if (c == EOF) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TrafficReader::readString(std::string& value) {
+    uint64_t length;
+    if (!readVarint(length)) {
+        return false;
+    }
+    long position = std::ftell(file_);
+    if (position < 0 || length > fileSize_ - static_cast<uint64_t>(position)) {
+        return false;
+    }
+    value.resize(static_cast<size_t>(length));
+    return length == 0 || std::fread(&value[0], 1, value.size(), file_) == value.size();
+}
+
+bool TrafficReader::next(TrafficRecord& record) {
+    if (!file_) {
+        return false;
+    }
+    int flags = std::fgetc(file_);
+    if (flags == EOF) {
+        return false;
+    }
+
+    record = TrafficRecord{};
+    MqttIncomingMessage& message = record.message;
+    record.direction = (flags & FLAG_OUTGOING) ? TrafficDirection::OUTGOING : TrafficDirection::INCOMING;
+    message.qos = flags & FLAG_QOS_MASK;
+    message.retained = (flags & FLAG_RETAINED) != 0;
+
+    uint64_t delta;
+    uint64_t count;
+    bool ok = readVarint(delta) && readString(message.topic) && readString(message.payload) &&
+              readVarint(count);
+    for (uint64_t i = 0; ok && i < count; ++i) {
+        std::string key;
+        std::string value;
+        ok = readString(key) && readString(value);
+        message.userProperties.emplace(std::move(key), std::move(value));
+    }
+    if (ok && (flags & FLAG_METADATA)) {
+        uint64_t expiry;
+        ok = readVarint(expiry) && readString(message.correlationData) &&
+             readString(message.responseTopic) && readString(message.contentType);
+        int format = ok ? std::fgetc(file_) : EOF;
+        ok = ok && format != EOF;
+        if (ok) {
+            if (expiry > 0) {
+                message.messageExpiryInterval = static_cast<uint32_t>(expiry - 1);
+            }
+            message.payloadFormatIndicator = static_cast<uint8_t>(format);
+        }
+    }
+    if (!ok) {
+        MCP_LOG_WARN("Traffic recording ends with a truncated record");
+        return false;
+    }
+
+    lastTimestamp_ += static_cast<int64_t>(delta);
+    record.timestamp = std::chrono::microseconds(lastTimestamp_);
+    return true;
+}
+
+} // namespace mcp_mqtt
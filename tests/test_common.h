@@ -0,0 +1,56 @@
+#ifndef MCP_MQTT_TEST_COMMON_H
+#define MCP_MQTT_TEST_COMMON_H
+
+/**
+ * @file test_common.h
+ * @brief Minimal check macros shared by the test programs
+ *
+ * Each test program is a plain executable registered with CTest; it returns
+ * non-zero if any check failed.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+/**
+ * @brief Poll a condition until it holds or the timeout passes
+ */
+inline bool waitFor(const std::function<bool()>& condition,
+                    std::chrono::milliseconds timeout = std::chrono::milliseconds(5000)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+} // namespace test
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++test::failures();                                                 \
+        }                                                                       \
+    } while (0)
+
+#define RUN_TEST(name)                                                          \
+    do {                                                                        \
+        int before = test::failures();                                          \
+        name();                                                                 \
+        std::printf("%s %s\n", test::failures() == before ? "PASS" : "FAIL", #name); \
+    } while (0)
+
+#endif // MCP_MQTT_TEST_COMMON_H
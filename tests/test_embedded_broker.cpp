@@ -0,0 +1,99 @@
+/**
+ * @file test_embedded_broker.cpp
+ * @brief EmbeddedBroker: in-process deliveries and oversized packets
+ */
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+
+#include <mcp_mqtt.h>
+#include <mcp_mqtt/epoll_mqtt_client.h>
+#include <mcp_mqtt/embedded_broker.h>
+
+#include "test_common.h"
+
+using namespace mcp_mqtt;
+
+static std::string socketPath() {
+    return "/tmp/mcp-mqtt-broker-test-" + std::to_string(::getpid()) + ".sock";
+}
+
+static EmbeddedBrokerOptions brokerOptions() {
+    EmbeddedBrokerOptions options;
+    options.listenTcp = false;
+    options.unixSocketPath = socketPath();
+    return options;
+}
+
+static EpollMqttClientOptions clientOptions() {
+    EpollMqttClientOptions options;
+    options.unixSocketPath = socketPath();
+    return options;
+}
+
+// An in-process handler that blocks (a long tool call) does not hold up the
+// network clients
+static void slowLocalHandlerDoesNotStallNetwork() {
+    EmbeddedBroker broker(brokerOptions());
+    CHECK(broker.start());
+
+    std::atomic<bool> inHandler{false};
+    std::atomic<bool> release{false};
+    auto local = broker.createClient("local");
+    local->setMessageHandler([&](const MqttIncomingMessage&) {
+        inHandler = true;
+        test::waitFor([&release]() { return release.load(); });
+    });
+    CHECK(local->subscribe("work", 1, false));
+
+    EpollMqttClient sender("sender", clientOptions());
+    EpollMqttClient receiver("receiver", clientOptions());
+    std::atomic<int> received{0};
+    receiver.setMessageHandler([&received](const MqttIncomingMessage&) { ++received; });
+    CHECK(sender.connect());
+    CHECK(receiver.connect());
+    CHECK(receiver.subscribe("status", 1, false));
+
+    CHECK(sender.publish("work", "slow", 1, false));
+    CHECK(test::waitFor([&inHandler]() { return inHandler.load(); }));
+
+    // SUBACK is not awaited; keep publishing until the subscription is in place
+    CHECK(test::waitFor([&]() {
+        sender.publish("status", "ok", 0, false);
+        return test::waitFor([&received]() { return received > 0; }, std::chrono::milliseconds(50));
+    }));
+
+    release = true;
+    sender.disconnect();
+    receiver.disconnect();
+    broker.stop();
+}
+
+// A packet announcing more than maxPacketSize closes the connection
+static void oversizedPacketClosesConnection() {
+    EmbeddedBrokerOptions options = brokerOptions();
+    options.maxPacketSize = 64 * 1024;
+    EmbeddedBroker broker(options);
+    CHECK(broker.start());
+
+    EpollMqttClient client("big", clientOptions());
+    std::atomic<bool> lost{false};
+    client.setConnectionLostCallback([&lost](const std::string&) { lost = true; });
+    CHECK(client.connect());
+    CHECK(client.publish("big", std::string(1 << 20, 'x'), 0, false));
+    CHECK(test::waitFor([&lost]() { return lost.load(); }));
+    CHECK(test::waitFor([&broker]() { return broker.getSessionCount() == 0; }));
+
+    client.disconnect();
+    broker.stop();
+}
+
+int main() {
+    Logger::setLevel(LogLevel::ERROR);
+    RUN_TEST(slowLocalHandlerDoesNotStallNetwork);
+    RUN_TEST(oversizedPacketClosesConnection);
+    return test::failures() == 0 ? 0 : 1;
+}
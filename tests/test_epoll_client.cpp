@@ -0,0 +1,256 @@
+/**
+ * @file test_epoll_client.cpp
+ * @brief EpollMqttClient against the embedded broker over a Unix domain socket
+ */
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include <mcp_mqtt.h>
+#include <mcp_mqtt/epoll_mqtt_client.h>
+#include <mcp_mqtt/embedded_broker.h>
+
+#include "test_common.h"
+
+using namespace mcp_mqtt;
+
+/**
+ * @brief Messages seen by a handler, which runs on a client's I/O thread
+ */
+class Inbox {
+public:
+    MqttMessageHandler handler() {
+        return [this](const MqttIncomingMessage& message) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            messages_.push_back(message);
+        };
+    }
+
+    std::vector<MqttIncomingMessage> onTopic(const std::string& topic) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<MqttIncomingMessage> matching;
+        for (const auto& message : messages_) {
+            if (message.topic == topic) {
+                matching.push_back(message);
+            }
+        }
+        return matching;
+    }
+
+    bool waitFor(const std::string& topic, size_t count) const {
+        return test::waitFor([&]() { return onTopic(topic).size() >= count; });
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<MqttIncomingMessage> messages_;
+};
+
+static std::string socketPath() {
+    return "/tmp/mcp-mqtt-test-" + std::to_string(::getpid()) + ".sock";
+}
+
+static EmbeddedBrokerOptions brokerOptions() {
+    EmbeddedBrokerOptions options;
+    options.listenTcp = false;
+    options.unixSocketPath = socketPath();
+    return options;
+}
+
+static EpollMqttClientOptions clientOptions() {
+    EpollMqttClientOptions options;
+    options.unixSocketPath = socketPath();
+    return options;
+}
+
+// SUBACK is not awaited; probe until the subscription is in place
+static bool waitSubscribed(IMqttClient& publisher, Inbox& inbox, const std::string& topic) {
+    return test::waitFor([&]() {
+        publisher.publish(topic, "probe", 0, false);
+        return test::waitFor([&]() { return !inbox.onTopic(topic).empty(); },
+                             std::chrono::milliseconds(50));
+    });
+}
+
+// Aliased publishes reach subscribers under their full topic, and large
+// payloads gathered behind their header arrive intact
+static void topicAliasesAndGatheredPayloads() {
+    EmbeddedBroker broker(brokerOptions());
+    CHECK(broker.start());
+
+    auto watcher = broker.createClient("watcher");
+    Inbox inbox;
+    watcher->setMessageHandler(inbox.handler());
+    CHECK(watcher->subscribe("alias/#", 1, false));
+
+    EpollMqttClient client("epoll", clientOptions());
+    CHECK(client.connect());
+    CHECK(client.getTopicAliasMaximum() == brokerOptions().topicAliasMaximum);
+
+    MqttPublishProperties properties;
+    properties.topicAlias = 1;
+    CHECK(client.publishWithProperties("alias/first", "1", 1, false, properties));
+    CHECK(client.publishWithProperties("alias/first", "2", 1, false, properties));
+    CHECK(client.publishWithProperties("alias/second", "3", 1, false, properties));
+    CHECK(client.publishWithProperties("alias/second", "4", 1, false, properties));
+
+    std::string large(256 * 1024, 'x');
+    for (size_t i = 0; i < large.size(); i += 7) {
+        large[i] = static_cast<char>('a' + i % 26);
+    }
+    for (int i = 0; i < 100; ++i) {
+        CHECK(client.publish("alias/small", std::to_string(i), 0, false));
+        CHECK(client.publish("alias/large", large, 0, false));
+    }
+
+    CHECK(inbox.waitFor("alias/first", 2));
+    CHECK(inbox.waitFor("alias/second", 2));
+    CHECK(inbox.waitFor("alias/large", 100));
+    auto first = inbox.onTopic("alias/first");
+    auto second = inbox.onTopic("alias/second");
+    CHECK(first.size() == 2 && first[0].payload == "1" && first[1].payload == "2");
+    CHECK(second.size() == 2 && second[0].payload == "3" && second[1].payload == "4");
+    auto small = inbox.onTopic("alias/small");
+    CHECK(small.size() == 100);
+    for (size_t i = 0; i < small.size(); ++i) {
+        CHECK(small[i].payload == std::to_string(i));
+    }
+    for (const auto& message : inbox.onTopic("alias/large")) {
+        CHECK(message.payload == large);
+    }
+
+    // And the other way: the epoll client receives from an in-process client
+    Inbox clientInbox;
+    client.setMessageHandler(clientInbox.handler());
+    CHECK(client.subscribe("to/epoll", 1, false));
+    CHECK(waitSubscribed(*watcher, clientInbox, "to/epoll"));
+
+    client.disconnect();
+    broker.stop();
+}
+
+// PINGREQ every keep-alive period holds the connection past the broker's
+// 1.5x grace period
+static void keepAliveHoldsConnection() {
+    EmbeddedBroker broker(brokerOptions());
+    CHECK(broker.start());
+
+    EpollMqttClientOptions options = clientOptions();
+    options.keepAliveSeconds = 1;
+    EpollMqttClient client("epoll", options);
+    std::atomic<bool> lost{false};
+    client.setConnectionLostCallback([&lost](const std::string&) { lost = true; });
+    CHECK(client.connect());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+    CHECK(client.isConnected());
+    CHECK(!lost);
+    CHECK(broker.getSessionCount() == 1);
+
+    client.disconnect();
+    broker.stop();
+}
+
+// setWill() reconnects without publishing the old Will, restores the
+// subscriptions, and the new Will is the one the broker holds
+static void setWillReconnects() {
+    EmbeddedBroker broker(brokerOptions());
+    CHECK(broker.start());
+
+    auto watcher = broker.createClient("watcher");
+    Inbox willInbox;
+    watcher->setMessageHandler(willInbox.handler());
+    CHECK(watcher->subscribe("will/epoll", 1, false));
+
+    EpollMqttClient client("epoll", clientOptions());
+    client.setWill("will/epoll", "old", 1, false);
+    CHECK(client.connect());
+
+    Inbox inbox;
+    client.setMessageHandler(inbox.handler());
+    CHECK(client.subscribe("cmd/epoll", 1, false));
+    CHECK(waitSubscribed(*watcher, inbox, "cmd/epoll"));
+
+    std::mutex mutex;
+    int restored = 0;
+    CHECK(client.setConnectionRestoredCallback([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++restored;
+    }));
+    client.setWill("will/epoll", "new", 1, false);
+    CHECK(test::waitFor([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return restored == 1;
+    }));
+    CHECK(client.isConnected());
+
+    // Subscriptions came back with the new connection
+    CHECK(watcher->publish("cmd/epoll", "after", 1, false));
+    CHECK(test::waitFor([&]() {
+        auto messages = inbox.onTopic("cmd/epoll");
+        return !messages.empty() && messages.back().payload == "after";
+    }));
+
+    // A second connection with the same client ID takes this one over, which
+    // publishes its Will
+    EpollMqttClient usurper("epoll", clientOptions());
+    CHECK(usurper.connect());
+    CHECK(willInbox.waitFor("will/epoll", 1));
+    auto wills = willInbox.onTopic("will/epoll");
+    CHECK(wills.size() == 1 && wills[0].payload == "new");
+
+    usurper.disconnect();
+    client.disconnect();
+    broker.stop();
+}
+
+// Packets larger than the receive buffer arrive intact; one larger than
+// maxPacketSize closes the connection from its fixed header
+static void receivePacketSizeLimit() {
+    EmbeddedBroker broker(brokerOptions());
+    CHECK(broker.start());
+    auto watcher = broker.createClient("watcher");
+
+    EpollMqttClientOptions options = clientOptions();
+    options.maxPacketSize = 192 * 1024;
+    EpollMqttClient client("epoll", options);
+    std::atomic<bool> lost{false};
+    client.setConnectionLostCallback([&lost](const std::string&) { lost = true; });
+    CHECK(client.connect());
+
+    Inbox inbox;
+    client.setMessageHandler(inbox.handler());
+    CHECK(client.subscribe("big/epoll", 1, false));
+    CHECK(waitSubscribed(*watcher, inbox, "big/epoll"));
+
+    std::string large(160 * 1024, 'x');
+    for (size_t i = 0; i < large.size(); i += 7) {
+        large[i] = static_cast<char>('a' + i % 26);
+    }
+    CHECK(watcher->publish("big/epoll", large, 1, false));
+    CHECK(test::waitFor([&]() {
+        auto messages = inbox.onTopic("big/epoll");
+        return !messages.empty() && messages.back().payload == large;
+    }));
+    CHECK(!lost);
+
+    CHECK(watcher->publish("big/epoll", std::string(256 * 1024, 'y'), 1, false));
+    CHECK(test::waitFor([&]() { return lost.load(); }));
+    CHECK(inbox.onTopic("big/epoll").back().payload == large);
+
+    client.disconnect();
+    broker.stop();
+}
+
+int main() {
+    Logger::setLevel(LogLevel::ERROR);
+    RUN_TEST(topicAliasesAndGatheredPayloads);
+    RUN_TEST(keepAliveHoldsConnection);
+    RUN_TEST(setWillReconnects);
+    RUN_TEST(receivePacketSizeLimit);
+    return test::failures() == 0 ? 0 : 1;
+}
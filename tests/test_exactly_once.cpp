@@ -0,0 +1,157 @@
+/**
+ * @file test_exactly_once.cpp
+ * @brief Exactly-once tools: execution keys and duplicates of running calls
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include <mcp_mqtt.h>
+
+#include "test_common.h"
+
+using namespace mcp_mqtt;
+
+/**
+ * @brief Local transport that keeps what the server sends
+ */
+class RecordingTransport : public ISessionTransport {
+public:
+    bool send(const std::string& payload) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sent_.push_back(nlohmann::json::parse(payload));
+        return true;
+    }
+    void close() override {}
+
+    std::vector<nlohmann::json> sent() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sent_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<nlohmann::json> sent_;
+};
+
+static std::string journalPath() {
+    return "/tmp/mcp-mqtt-test-" + std::to_string(::getpid()) + ".journal";
+}
+
+static McpServerConfig serverConfig() {
+    McpServerConfig config;
+    config.serverId = "server-1";
+    config.serverName = "tools/once";
+    return config;
+}
+
+static std::string toolCall(int64_t id, const nlohmann::json& arguments) {
+    nlohmann::json request = {
+        {"jsonrpc", "2.0"}, {"id", id}, {"method", "tools/call"},
+        {"params", {{"name", "actuate"}, {"arguments", arguments}}}
+    };
+    return request.dump();
+}
+
+static void openSession(McpServer& server, const std::shared_ptr<RecordingTransport>& transport) {
+    nlohmann::json initialize = {
+        {"jsonrpc", "2.0"}, {"id", 0}, {"method", "initialize"},
+        {"params", {{"protocolVersion", MCP_PROTOCOL_VERSION},
+                    {"clientInfo", {{"name", "test"}, {"version", "1.0"}}},
+                    {"capabilities", nlohmann::json::object()}}}
+    };
+    server.handleLocalMessage("client", initialize.dump(), transport);
+    server.handleLocalMessage("client", R"({"jsonrpc":"2.0","method":"notifications/initialized"})", transport);
+}
+
+// A request ID reused with other arguments (a later client session) is a new call
+static void argumentsArePartOfTheKey() {
+    std::remove(journalPath().c_str());
+    ExecutionJournal journal;
+    CHECK(journal.open(journalPath()));
+
+    McpServer server;
+    server.configure(ServerInfo{"exactly-once-test", "1.0"});
+    std::atomic<int> runs{0};
+    server.registerTool(Tool{"actuate", "Counts its runs", {}}, [&runs](const nlohmann::json&) {
+        return ToolCallResult::success(std::to_string(++runs));
+    });
+    server.setExecutionJournal(&journal);
+    server.setToolExactlyOnce("actuate");
+    CHECK(server.start(nullptr, serverConfig()));
+
+    auto transport = std::make_shared<RecordingTransport>();
+    openSession(server, transport);
+    server.handleLocalMessage("client", toolCall(1, {{"valve", 1}}), transport);
+    server.handleLocalMessage("client", toolCall(1, {{"valve", 2}}), transport);
+    server.handleLocalMessage("client", toolCall(1, {{"valve", 1}}), transport);
+    CHECK(runs == 2);
+
+    auto sent = transport->sent();
+    CHECK(sent.size() == 4);    // initialize and three results
+    if (sent.size() == 4) {
+        CHECK(sent[1]["result"]["content"][0]["text"] == "1");
+        CHECK(sent[2]["result"]["content"][0]["text"] == "2");
+        CHECK(sent[3]["result"]["content"][0]["text"] == "1");     // Replayed
+    }
+
+    server.stop();
+    journal.close();
+    std::remove(journalPath().c_str());
+}
+
+// A duplicate arriving while the call runs gets its result, not an error
+static void duplicateOfRunningCallSharesResult() {
+    std::remove(journalPath().c_str());
+    ExecutionJournal journal;
+    CHECK(journal.open(journalPath()));
+
+    McpServer server;
+    server.configure(ServerInfo{"exactly-once-test", "1.0"});
+    std::atomic<int> runs{0};
+    std::atomic<bool> release{false};
+    server.registerTool(Tool{"actuate", "Blocks until released", {}}, [&](const nlohmann::json&) {
+        ++runs;
+        test::waitFor([&release]() { return release.load(); });
+        return ToolCallResult::success("done");
+    });
+    server.setExecutionJournal(&journal);
+    server.setToolExactlyOnce("actuate");
+    CHECK(server.start(nullptr, serverConfig()));
+
+    auto transport = std::make_shared<RecordingTransport>();
+    openSession(server, transport);
+    std::thread first([&]() {
+        server.handleLocalMessage("client", toolCall(7, {{"valve", 1}}), transport);
+    });
+    CHECK(test::waitFor([&runs]() { return runs == 1; }));
+    server.handleLocalMessage("client", toolCall(7, {{"valve", 1}}), transport);
+    CHECK(transport->sent().size() == 1);   // Nothing until the call finishes
+
+    release = true;
+    first.join();
+    CHECK(runs == 1);
+    auto sent = transport->sent();
+    CHECK(sent.size() == 3);
+    for (size_t i = 1; i < sent.size(); ++i) {
+        CHECK(sent[i]["id"] == 7);
+        CHECK(sent[i].contains("result") && sent[i]["result"]["content"][0]["text"] == "done");
+    }
+
+    server.stop();
+    journal.close();
+    std::remove(journalPath().c_str());
+}
+
+int main() {
+    Logger::setLevel(LogLevel::ERROR);
+    RUN_TEST(argumentsArePartOfTheKey);
+    RUN_TEST(duplicateOfRunningCallSharesResult);
+    return test::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file test_list_changed.cpp
+ * @brief McpServer's debounced notifications/tools/list_changed timer
+ */
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <mcp_mqtt.h>
+
+#include "test_common.h"
+
+using namespace mcp_mqtt;
+
+/**
+ * @brief Local transport whose send of list_changed blocks until released
+ */
+class BlockingTransport : public ISessionTransport {
+public:
+    bool send(const std::string& payload) override {
+        if (payload.find("list_changed") != std::string::npos) {
+            sending = true;
+            test::waitFor([this]() { return release.load(); });
+            ++notified;
+        }
+        return true;
+    }
+    void close() override {}
+
+    std::atomic<bool> sending{false};
+    std::atomic<bool> release{false};
+    std::atomic<int> notified{0};
+};
+
+static std::unique_ptr<McpServer> startServer(VirtualClock& clock) {
+    auto server = std::make_unique<McpServer>();
+    ServerCapabilities capabilities;
+    capabilities.toolsListChanged = true;
+    server->configure(ServerInfo{"list-changed-test", "1.0"}, capabilities);
+    server->setClock(&clock);
+    McpServerConfig config;
+    config.serverId = "server-1";
+    config.serverName = "tools/changing";
+    CHECK(server->start(nullptr, config));
+    return server;
+}
+
+static void openSession(McpServer& server, const std::shared_ptr<BlockingTransport>& transport) {
+    nlohmann::json initialize = {
+        {"jsonrpc", "2.0"}, {"id", 0}, {"method", "initialize"},
+        {"params", {{"protocolVersion", MCP_PROTOCOL_VERSION},
+                    {"clientInfo", {{"name", "test"}, {"version", "1.0"}}},
+                    {"capabilities", nlohmann::json::object()}}}
+    };
+    server.handleLocalMessage("client", initialize.dump(), transport);
+    server.handleLocalMessage("client", R"({"jsonrpc":"2.0","method":"notifications/initialized"})", transport);
+}
+
+static Tool tool(const std::string& name) {
+    return Tool{name, "Does nothing", {}};
+}
+
+static ToolCallResult noop(const nlohmann::json&) {
+    return ToolCallResult::success("ok");
+}
+
+// Destroying the server waits for a list_changed broadcast already running
+static void destructionWaitsForRunningBroadcast() {
+    VirtualClock clock;
+    auto server = startServer(clock);
+    auto transport = std::make_shared<BlockingTransport>();
+    openSession(*server, transport);
+
+    server->registerTool(tool("first"), noop);
+    std::thread timers([&clock]() { clock.runFor(std::chrono::seconds(1)); });
+    CHECK(test::waitFor([&transport]() { return transport->sending.load(); }));
+
+    std::atomic<bool> destroyed{false};
+    std::thread destroyer([&]() {
+        server.reset();
+        destroyed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(!destroyed);
+
+    transport->release = true;
+    destroyer.join();
+    timers.join();
+    CHECK(destroyed);
+    CHECK(transport->notified == 1);
+}
+
+// A pending broadcast is cancelled with the server and never fires
+static void destructionCancelsPendingBroadcast() {
+    VirtualClock clock;
+    auto server = startServer(clock);
+    auto transport = std::make_shared<BlockingTransport>();
+    transport->release = true;
+    openSession(*server, transport);
+
+    server->registerTool(tool("first"), noop);
+    server.reset();
+    CHECK(clock.runUntilIdle() == 0);
+    CHECK(transport->notified == 0);
+}
+
+int main() {
+    Logger::setLevel(LogLevel::ERROR);
+    RUN_TEST(destructionWaitsForRunningBroadcast);
+    RUN_TEST(destructionCancelsPendingBroadcast);
+    return test::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file test_mcp_client.cpp
+ * @brief McpClient request slots and timeout timer
+ */
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <mcp_mqtt.h>
+
+#include "test_common.h"
+
+using namespace mcp_mqtt;
+
+static McpClientConfig clientConfig() {
+    McpClientConfig config;
+    config.clientId = "client-1";
+    return config;
+}
+
+// Answers with IDs the client never sends (0 marks a free slot, -1 converts
+// to a slot being filled) are ignored instead of completing a slot
+static void forgedAnswerIdsAreIgnored() {
+    LoopbackBroker broker;
+    auto clientMqtt = broker.createClient("client-1");
+    auto forger = broker.createClient("forger");
+
+    McpClient client;
+    CHECK(client.start(clientMqtt.get(), clientConfig()));
+    auto session = client.createSession("server-1", "tools/none");
+    CHECK(session != nullptr);
+
+    // No server: initialize stays in flight
+    auto initialized = session->initialize(60000);
+    CHECK(session->getInFlight() == 1);
+
+    for (const char* id : {"0", "0", "-1", "18446744073709551615", "1.0", "\"1\""}) {
+        std::string answer = std::string(R"({"jsonrpc":"2.0","id":)") + id + R"(,"result":{}})";
+        CHECK(forger->publish(session->getRpcTopic(), answer, 1, false));
+        CHECK(session->getInFlight() == 1);
+    }
+    CHECK(initialized.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+
+    // The real request ID still completes it
+    CHECK(forger->publish(session->getRpcTopic(), R"({"jsonrpc":"2.0","id":1,"error":{"code":-1}})", 1, false));
+    CHECK(session->getInFlight() == 0);
+    CHECK(initialized.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+
+    client.stop();
+}
+
+// Destroying the client waits for a timeout check that is already running
+static void destructionWaitsForRunningTimeoutCheck() {
+    LoopbackBroker broker;
+    auto clientMqtt = broker.createClient("client-1");
+    VirtualClock clock;
+
+    auto client = std::make_unique<McpClient>();
+    client->setClock(&clock);
+    CHECK(client->start(clientMqtt.get(), clientConfig()));
+    auto session = client->createSession("server-1", "tools/none");
+    CHECK(session != nullptr);
+
+    // No server: initialize times out, and its callback blocks the check
+    std::atomic<bool> inCallback{false};
+    std::atomic<bool> release{false};
+    std::atomic<int> timedOut{0};
+    session->initialize([&](const McpResponse& response) {
+        inCallback = true;
+        test::waitFor([&release]() { return release.load(); });
+        if (response.status == RequestStatus::TIMEOUT) {
+            ++timedOut;
+        }
+    }, 100);
+    std::thread timers([&clock]() { clock.runFor(std::chrono::seconds(1)); });
+    CHECK(test::waitFor([&inCallback]() { return inCallback.load(); }));
+
+    std::atomic<bool> destroyed{false};
+    std::thread destroyer([&]() {
+        client.reset();
+        destroyed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(!destroyed);
+
+    release = true;
+    destroyer.join();
+    timers.join();
+    CHECK(destroyed);
+    CHECK(timedOut == 1);
+    CHECK(clock.runUntilIdle() == 0);
+}
+
+int main() {
+    Logger::setLevel(LogLevel::ERROR);
+    RUN_TEST(forgedAnswerIdsAreIgnored);
+    RUN_TEST(destructionWaitsForRunningTimeoutCheck);
+    return test::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file test_message_expiry.cpp
+ * @brief MQTT 5.0 Message Expiry Interval, enforced by the broker in its own clock
+ *
+ * The EmbeddedBroker case is built when the broker is (Linux).
+ */
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include <mcp_mqtt.h>
+#ifdef MCP_MQTT_TEST_EMBEDDED_BROKER
+#include <mcp_mqtt/embedded_broker.h>
+#endif
+
+#include "test_common.h"
+
+using namespace mcp_mqtt;
+
+// Messages held longer than their expiry are dropped; the others arrive with
+// the time in transit deducted
+static void loopbackDropsExpiredInTransit() {
+    VirtualClock clock;
+    LoopbackBroker broker;
+    LoopbackLinkOptions link;
+    link.latency = std::chrono::seconds(3);
+    broker.setLink(&clock, link);
+
+    auto publisher = broker.createClient("publisher");
+    auto subscriber = broker.createClient("subscriber");
+    std::vector<MqttIncomingMessage> received;
+    subscriber->setMessageHandler([&received](const MqttIncomingMessage& message) {
+        received.push_back(message);
+    });
+    CHECK(subscriber->subscribe("expiry/#", 1, false));
+
+    MqttPublishProperties properties;
+    properties.messageExpiryInterval = 2;
+    CHECK(publisher->publishWithProperties("expiry/short", "stale", 1, false, properties));
+    properties.messageExpiryInterval = 10;
+    CHECK(publisher->publishWithProperties("expiry/long", "fresh", 1, false, properties));
+    CHECK(publisher->publish("expiry/none", "forever", 1, false));
+
+    clock.runFor(std::chrono::seconds(5));
+    CHECK(received.size() == 2);
+    for (const auto& message : received) {
+        CHECK(message.topic != "expiry/short");
+        if (message.topic == "expiry/long") {
+            CHECK(message.messageExpiryInterval && *message.messageExpiryInterval == 7);
+        } else {
+            CHECK(!message.messageExpiryInterval);
+        }
+    }
+}
+
+#ifdef MCP_MQTT_TEST_EMBEDDED_BROKER
+// In-process clients of the embedded broker get the remaining interval too;
+// retained messages show the time the broker held them
+static void embeddedBrokerDeductsForLocalClients() {
+    EmbeddedBrokerOptions options;
+    options.listenTcp = false;
+    options.unixSocketPath = "/tmp/mcp-mqtt-expiry-test-" + std::to_string(::getpid()) + ".sock";
+    EmbeddedBroker broker(options);
+    CHECK(broker.start());
+
+    auto publisher = broker.createClient("publisher");
+    MqttPublishProperties properties;
+    properties.messageExpiryInterval = 1;
+    CHECK(publisher->publishWithProperties("expiry/short", "stale", 1, true, properties));
+    properties.messageExpiryInterval = 10;
+    CHECK(publisher->publishWithProperties("expiry/long", "fresh", 1, true, properties));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+
+    auto subscriber = broker.createClient("subscriber");
+    std::mutex mutex;
+    std::vector<MqttIncomingMessage> received;
+    subscriber->setMessageHandler([&](const MqttIncomingMessage& message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(message);
+    });
+    CHECK(subscriber->subscribe("expiry/#", 1, false));
+    CHECK(test::waitFor([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return !received.empty();
+    }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK(received.size() == 1);
+    if (received.size() == 1) {
+        CHECK(received[0].topic == "expiry/long");
+        CHECK(received[0].messageExpiryInterval && *received[0].messageExpiryInterval == 9);
+    }
+    broker.stop();
+}
+#endif
+
+int main() {
+    Logger::setLevel(LogLevel::ERROR);
+    RUN_TEST(loopbackDropsExpiredInTransit);
+#ifdef MCP_MQTT_TEST_EMBEDDED_BROKER
+    RUN_TEST(embeddedBrokerDeductsForLocalClients);
+#endif
+    return test::failures() == 0 ? 0 : 1;
+}
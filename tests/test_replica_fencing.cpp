@@ -0,0 +1,217 @@
+/**
+ * @file test_replica_fencing.cpp
+ * @brief Hot standby: a primary reconnecting after its Will fired
+ */
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <mcp_mqtt.h>
+
+#include "test_common.h"
+
+using namespace mcp_mqtt;
+
+/**
+ * @brief Loopback client that can come back after LoopbackBroker::disconnectClient()
+ *
+ * reconnect() connects again under the same client ID, restores the
+ * subscriptions and Will, and reports the reconnect like a real client.
+ */
+class ReconnectingClient : public IMqttClient {
+public:
+    ReconnectingClient(LoopbackBroker& broker, std::string clientId)
+        : broker_(broker), clientId_(std::move(clientId)), client_(broker.createClient(clientId_)) {}
+
+    void reconnect() {
+        client_.reset();
+        client_ = broker_.createClient(clientId_);
+        client_->setMessageHandler(handler_);
+        if (!willTopic_.empty()) {
+            client_->setWill(willTopic_, willPayload_, willQos_, willRetained_);
+        }
+        for (const auto& [topic, subscription] : subscriptions_) {
+            client_->subscribe(topic, subscription.first, subscription.second);
+        }
+        if (restored_) {
+            restored_();
+        }
+    }
+
+    bool isConnected() const override { return client_->isConnected(); }
+    bool subscribe(const std::string& topic, int qos, bool noLocal) override {
+        subscriptions_[topic] = {qos, noLocal};
+        return client_->subscribe(topic, qos, noLocal);
+    }
+    bool unsubscribe(const std::string& topic) override {
+        subscriptions_.erase(topic);
+        return client_->unsubscribe(topic);
+    }
+    bool publish(const std::string& topic, const std::string& payload, int qos, bool retained,
+                 const std::map<std::string, std::string>& userProps = {}) override {
+        return client_->publish(topic, payload, qos, retained, userProps);
+    }
+    bool publishWithProperties(const std::string& topic, const std::string& payload, int qos, bool retained,
+                               const MqttPublishProperties& properties) override {
+        return client_->publishWithProperties(topic, payload, qos, retained, properties);
+    }
+    std::string getClientId() const override { return clientId_; }
+    void setMessageHandler(MqttMessageHandler handler) override {
+        handler_ = handler;
+        client_->setMessageHandler(handler);
+    }
+    void setConnectionLostCallback(std::function<void(const std::string&)> callback) override {
+        client_->setConnectionLostCallback(callback);
+    }
+    bool setConnectionRestoredCallback(std::function<void()> callback) override {
+        restored_ = std::move(callback);
+        return true;
+    }
+    void setConnectProperties(uint32_t sessionExpiryInterval,
+                              const std::map<std::string, std::string>& userProperties) override {
+        client_->setConnectProperties(sessionExpiryInterval, userProperties);
+    }
+    void setWill(const std::string& topic, const std::string& payload, int qos, bool retained) override {
+        willTopic_ = topic;
+        willPayload_ = payload;
+        willQos_ = qos;
+        willRetained_ = retained;
+        client_->setWill(topic, payload, qos, retained);
+    }
+
+private:
+    LoopbackBroker& broker_;
+    std::string clientId_;
+    std::unique_ptr<IMqttClient> client_;
+    MqttMessageHandler handler_;
+    std::function<void()> restored_;
+    std::map<std::string, std::pair<int, bool>> subscriptions_;
+    std::string willTopic_;
+    std::string willPayload_;
+    int willQos_ = 0;
+    bool willRetained_ = false;
+};
+
+static McpServerConfig replicaConfig(ReplicaRole role) {
+    McpServerConfig config;
+    config.serverId = "calc-1";
+    config.serverName = "tools/calc";
+    config.role = role;
+    return config;
+}
+
+static void registerCounter(McpServer& server, std::atomic<int>& calls) {
+    server.configure(ServerInfo{"fencing-test", "1.0"});
+    server.registerTool(Tool{"count", "Counts its calls", {}}, [&calls](const nlohmann::json&) {
+        return ToolCallResult::success(std::to_string(++calls));
+    });
+}
+
+static McpClientConfig clientConfig() {
+    McpClientConfig config;
+    config.clientId = "client-1";
+    return config;
+}
+
+// Sessions close when the server's presence is cleared, so open a new one
+static std::shared_ptr<McpClientSession> openSession(McpClient& client) {
+    auto session = client.createSession("calc-1", "tools/calc");
+    CHECK(session != nullptr);
+    if (session) {
+        CHECK(session->initialize().get().ok());
+    }
+    return session;
+}
+
+static bool callCount(const std::shared_ptr<McpClientSession>& session) {
+    return session && session->callTool("count", nlohmann::json::object()).get().ok();
+}
+
+// The standby took over while the primary was gone: the old primary demotes
+// itself instead of answering the same requests
+static void reconnectedPrimaryDemotesAfterTakeover() {
+    LoopbackBroker broker;
+    ReconnectingClient primaryMqtt(broker, "primary");
+    auto standbyMqtt = broker.createClient("standby");
+    auto clientMqtt = broker.createClient("client-1");
+
+    McpServer primary;
+    McpServer standby;
+    std::atomic<int> primaryCalls{0};
+    std::atomic<int> standbyCalls{0};
+    registerCounter(primary, primaryCalls);
+    registerCounter(standby, standbyCalls);
+    CHECK(primary.start(&primaryMqtt, replicaConfig(ReplicaRole::PRIMARY)));
+    CHECK(standby.start(standbyMqtt.get(), replicaConfig(ReplicaRole::STANDBY)));
+
+    McpClient client;
+    CHECK(client.start(clientMqtt.get(), clientConfig()));
+    CHECK(callCount(openSession(client)));
+    CHECK(primaryCalls == 1);
+
+    CHECK(broker.disconnectClient("primary"));
+    CHECK(!standby.isStandby());
+    auto session = openSession(client);
+    CHECK(callCount(session));
+    CHECK(standbyCalls == 1);
+    primaryMqtt.reconnect();
+    CHECK(primary.isStandby());
+    CHECK(!standby.isStandby());
+    CHECK(callCount(session));
+    CHECK(primaryCalls == 1);
+    CHECK(standbyCalls == 2);
+
+    // The retained presence still announces the server; a client that comes
+    // along later reaches the new primary
+    auto lateMqtt = broker.createClient("client-2");
+    McpClient late;
+    McpClientConfig lateConfig = clientConfig();
+    lateConfig.clientId = "client-2";
+    CHECK(late.start(lateMqtt.get(), lateConfig));
+    CHECK(late.getServers().size() == 1);
+    CHECK(callCount(openSession(late)));
+    CHECK(primaryCalls == 1);
+    CHECK(standbyCalls == 3);
+
+    late.stop();
+    client.stop();
+    standby.stop();
+    primary.stop();
+}
+
+// Nobody took over: the primary keeps serving and announces itself again
+static void reconnectedPrimaryResumesWithoutTakeover() {
+    LoopbackBroker broker;
+    ReconnectingClient primaryMqtt(broker, "primary");
+    auto clientMqtt = broker.createClient("client-1");
+
+    McpServer primary;
+    std::atomic<int> calls{0};
+    registerCounter(primary, calls);
+    CHECK(primary.start(&primaryMqtt, replicaConfig(ReplicaRole::PRIMARY)));
+
+    McpClient client;
+    CHECK(client.start(clientMqtt.get(), clientConfig()));
+    CHECK(client.getServers().size() == 1);
+
+    CHECK(broker.disconnectClient("primary"));
+    CHECK(client.getServers().empty());
+
+    primaryMqtt.reconnect();
+    CHECK(!primary.isStandby());
+    CHECK(client.getServers().size() == 1);
+    CHECK(callCount(openSession(client)));
+    CHECK(calls == 1);
+
+    client.stop();
+    primary.stop();
+}
+
+int main() {
+    Logger::setLevel(LogLevel::ERROR);
+    RUN_TEST(reconnectedPrimaryDemotesAfterTakeover);
+    RUN_TEST(reconnectedPrimaryResumesWithoutTakeover);
+    return test::failures() == 0 ? 0 : 1;
+}
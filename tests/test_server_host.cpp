@@ -0,0 +1,120 @@
+/**
+ * @file test_server_host.cpp
+ * @brief McpServerHost presence: one host Will for all hosted servers
+ */
+
+#include <memory>
+#include <string>
+
+#include <mcp_mqtt.h>
+
+#include "test_common.h"
+
+using namespace mcp_mqtt;
+
+static McpClientConfig watcherConfig(const std::string& clientId) {
+    McpClientConfig config;
+    config.clientId = clientId;
+    config.setWill = false;
+    return config;
+}
+
+// The host replaces serverId with its own
+static McpServerConfig hostedConfig(const std::string& serverName) {
+    McpServerConfig config;
+    config.serverId = "ignored";
+    config.serverName = serverName;
+    return config;
+}
+
+// A crashed host must take all its servers offline, not just the first one
+static void hostCrashTakesAllServersOffline() {
+    LoopbackBroker broker;
+    auto hostMqtt = broker.createClient("host");
+    auto watcherMqtt = broker.createClient("watcher");
+
+    McpServer first;
+    McpServer second;
+    McpServerHost host;
+    CHECK(host.start(hostMqtt.get(), "gw-1"));
+    CHECK(host.addServer(&first, hostedConfig("tools/first")));
+    CHECK(host.addServer(&second, hostedConfig("tools/second")));
+
+    McpClient watcher;
+    CHECK(watcher.start(watcherMqtt.get(), watcherConfig("watcher")));
+    CHECK(watcher.getServers().size() == 2);
+    for (const auto& server : watcher.getServers()) {
+        CHECK(server.serverId == "gw-1");
+    }
+
+    size_t offline = 0;
+    watcher.setServerOfflineCallback([&offline](const std::string&, const std::string&) { ++offline; });
+
+    CHECK(broker.disconnectClient("host"));
+    CHECK(watcher.getServers().empty());
+    CHECK(offline == 2);
+
+    // A client arriving later gets the stale retained presences, and ignores them
+    auto lateMqtt = broker.createClient("late");
+    McpClient late;
+    CHECK(late.start(lateMqtt.get(), watcherConfig("late")));
+    CHECK(late.getServers().empty());
+
+    watcher.stop();
+    late.stop();
+}
+
+// Retained messages of different topics arrive in any order
+static void stalePresenceAfterHostOffline() {
+    ServerDirectory directory;
+
+    MqttIncomingMessage presence;
+    presence.topic = "$mcp-server/presence/gw-1/tools/first";
+    presence.payload = R"({"jsonrpc":"2.0","method":"notifications/server/online","params":{}})";
+    MqttIncomingMessage hostOffline;
+    hostOffline.topic = "$mcp-server/presence/gw-1";
+    hostOffline.payload = R"({"jsonrpc":"2.0","method":"notifications/server/offline"})";
+    MqttIncomingMessage hostOnline;
+    hostOnline.topic = "$mcp-server/presence/gw-1";
+    hostOnline.payload = R"({"jsonrpc":"2.0","method":"notifications/server/online"})";
+
+    // Presence first: the host going offline removes it
+    CHECK(directory.applyPresence(presence) == ServerDirectory::Change::ONLINE);
+    std::vector<ServerDirectory::ServerPtr> removed;
+    CHECK(directory.applyPresence(hostOffline, &removed) == ServerDirectory::Change::OFFLINE);
+    CHECK(removed.size() == 1);
+    CHECK(directory.size() == 0);
+
+    // Presence after: ignored until the host is back
+    CHECK(directory.applyPresence(presence) == ServerDirectory::Change::NONE);
+    CHECK(directory.size() == 0);
+    CHECK(directory.applyPresence(hostOnline) == ServerDirectory::Change::NONE);
+    CHECK(directory.applyPresence(presence) == ServerDirectory::Change::ONLINE);
+    CHECK(directory.size() == 1);
+}
+
+// A clean stop clears every presence, the host's included
+static void hostStopClearsPresence() {
+    LoopbackBroker broker;
+    auto hostMqtt = broker.createClient("host");
+
+    McpServer first;
+    McpServer second;
+    {
+        McpServerHost host;
+        CHECK(host.start(hostMqtt.get(), "gw-1"));
+        CHECK(host.addServer(&first, hostedConfig("tools/first")));
+        CHECK(host.addServer(&second, hostedConfig("tools/second")));
+        CHECK(broker.getRetainedCount() == 3);
+        host.stop();
+    }
+    CHECK(broker.getRetainedCount() == 0);
+}
+
+int main() {
+    Logger::setLevel(LogLevel::ERROR);
+    RUN_TEST(hostCrashTakesAllServersOffline);
+    RUN_TEST(stalePresenceAfterHostOffline);
+    RUN_TEST(hostStopClearsPresence);
+    return test::failures() == 0 ? 0 : 1;
+}
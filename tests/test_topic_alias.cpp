@@ -0,0 +1,116 @@
+/**
+ * @file test_topic_alias.cpp
+ * @brief McpServer topic aliases for per-session RPC topics
+ */
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <mcp_mqtt.h>
+
+#include "test_common.h"
+
+using namespace mcp_mqtt;
+
+/**
+ * @brief Loopback client announcing a small broker Topic Alias Maximum
+ *
+ * The loopback broker ignores aliases; this records the ones the server uses.
+ */
+class AliasingClient : public IMqttClient {
+public:
+    AliasingClient(std::unique_ptr<IMqttClient> client, uint16_t topicAliasMaximum)
+        : client_(std::move(client)), topicAliasMaximum_(topicAliasMaximum) {}
+
+    bool isConnected() const override { return client_->isConnected(); }
+    bool subscribe(const std::string& topic, int qos, bool noLocal) override {
+        return client_->subscribe(topic, qos, noLocal);
+    }
+    bool unsubscribe(const std::string& topic) override { return client_->unsubscribe(topic); }
+    bool publish(const std::string& topic, const std::string& payload, int qos, bool retained,
+                 const std::map<std::string, std::string>& userProps = {}) override {
+        return client_->publish(topic, payload, qos, retained, userProps);
+    }
+    bool publishWithProperties(const std::string& topic, const std::string& payload, int qos, bool retained,
+                               const MqttPublishProperties& properties) override {
+        if (properties.topicAlias > 0) {
+            CHECK(properties.topicAlias <= topicAliasMaximum_);
+            ++aliased;
+        }
+        return client_->publishWithProperties(topic, payload, qos, retained, properties);
+    }
+    uint16_t getTopicAliasMaximum() const override { return topicAliasMaximum_; }
+    std::string getClientId() const override { return client_->getClientId(); }
+    void setMessageHandler(MqttMessageHandler handler) override { client_->setMessageHandler(handler); }
+    void setConnectionLostCallback(std::function<void(const std::string&)> callback) override {
+        client_->setConnectionLostCallback(callback);
+    }
+    void setConnectProperties(uint32_t sessionExpiryInterval,
+                              const std::map<std::string, std::string>& userProperties) override {
+        client_->setConnectProperties(sessionExpiryInterval, userProperties);
+    }
+    void setWill(const std::string& topic, const std::string& payload, int qos, bool retained) override {
+        client_->setWill(topic, payload, qos, retained);
+    }
+
+    std::atomic<int> aliased{0};
+
+private:
+    std::unique_ptr<IMqttClient> client_;
+    uint16_t topicAliasMaximum_;
+};
+
+static McpServerConfig serverConfig() {
+    McpServerConfig config;
+    config.serverId = "server-1";
+    config.serverName = "tools/alias";
+    return config;
+}
+
+// Stopping notifies every session, also those that found no alias free
+static void stopWithMoreSessionsThanAliases() {
+    LoopbackBroker broker;
+    AliasingClient serverMqtt(broker.createClient("server-1"), 1);
+
+    McpServer server;
+    server.configure(ServerInfo{"alias-test", "1.0"});
+    CHECK(server.start(&serverMqtt, serverConfig()));
+
+    std::vector<std::unique_ptr<IMqttClient>> clientMqtts;
+    std::vector<std::unique_ptr<McpClient>> clients;
+    std::vector<std::shared_ptr<McpClientSession>> sessions;
+    std::atomic<int> closed{0};
+    for (int i = 0; i < 3; ++i) {
+        std::string clientId = "client-" + std::to_string(i);
+        clientMqtts.push_back(broker.createClient(clientId));
+        clients.push_back(std::make_unique<McpClient>());
+        McpClientConfig config;
+        config.clientId = clientId;
+        CHECK(clients.back()->start(clientMqtts.back().get(), config));
+
+        auto session = clients.back()->createSession("server-1", "tools/alias");
+        CHECK(session != nullptr);
+        session->setClosedCallback([&closed](const std::string&) { ++closed; });
+        CHECK(session->initialize().get().ok());
+        sessions.push_back(session);
+    }
+    CHECK(server.getConnectedClients().size() == 3);
+    CHECK(serverMqtt.aliased > 0);
+
+    server.stop();
+    CHECK(test::waitFor([&closed]() { return closed == 3; }));
+    CHECK(server.getConnectedClients().empty());
+
+    for (auto& client : clients) {
+        client->stop();
+    }
+}
+
+int main() {
+    Logger::setLevel(LogLevel::ERROR);
+    RUN_TEST(stopWithMoreSessionsThanAliases);
+    return test::failures() == 0 ? 0 : 1;
+}
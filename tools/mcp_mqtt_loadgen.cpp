@@ -0,0 +1,620 @@
+/**
+ * @file mcp_mqtt_loadgen.cpp
+ * @brief Load generator simulating many MCP clients against an McpServer
+ *
+ * Every simulated client runs the client side of the protocol in a closed loop:
+ * initialize and notifications/initialized, then ping, tools/list and
+ * tools/call requests in a weighted mix with optional think time. It can also
+ * disconnect after a number of requests and start a new session. Clients are
+ * spread over worker threads and share MQTT connections, so thousands of them
+ * need neither thousands of threads nor thousands of sockets.
+ *
+ * Brokers:
+ * - loopback: in-process LoopbackBroker. The server runs on the publishing
+ *   thread, so this measures the SDK alone.
+ * - embedded: an EmbeddedBroker on a free local port, with clients connected
+ *   over TCP through EpollMqttClient.
+ * - HOST:PORT: an existing broker, through EpollMqttClient.
+ *
+ * The server under test runs in-process with stub tools, unless --target names
+ * a server that is already running behind the broker.
+ *
+ * Usage: mcp_mqtt_loadgen [--clients N] [--threads N] [--connections N]
+ *                         [--duration-s N] [--ramp-ms N] [--think-ms N]
+ *                         [--mix PING:LIST:CALL] [--session-requests N]
+ *                         [--timeout-ms N] [--broker loopback|embedded|HOST:PORT]
+ *                         [--target SERVER_ID/SERVER_NAME] [--tool NAME]
+ *                         [--tool-delay-us N]
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mcp_mqtt.h>
+#include <mcp_mqtt/loopback_broker.h>
+#ifdef MCP_MQTT_WITH_EPOLL_CLIENT
+#include <mcp_mqtt/epoll_mqtt_client.h>
+#endif
+#ifdef MCP_MQTT_WITH_EMBEDDED_BROKER
+#include <mcp_mqtt/embedded_broker.h>
+#endif
+
+using namespace mcp_mqtt;
+using Clock = std::chrono::steady_clock;
+
+static constexpr const char* CLIENT_PREFIX = "lg-";
+
+enum Op { INITIALIZE, PING, TOOLS_LIST, TOOLS_CALL, OP_COUNT };
+static const char* const OP_NAMES[OP_COUNT] = {"initialize", "ping", "tools/list", "tools/call"};
+
+struct Options {
+    int clients = 100;
+    int threads = 4;
+    int connections = 0;            // 0 = one per client on loopback, 32 on a socket broker
+    double durationSeconds = 10.0;
+    int rampMs = 1000;              // Spread the first initialize requests over this time
+    double thinkMs = 0.0;           // Mean of an exponential think time between requests
+    std::array<int, OP_COUNT> mix = {0, 1, 1, 8};
+    int sessionRequests = 0;        // Requests per session before reconnecting, 0 = never
+    int timeoutMs = 5000;
+    std::string broker = "loopback";
+    std::string targetId;
+    std::string targetName;
+    std::string tool = "echo";
+    int toolDelayUs = 0;
+};
+
+static void usage() {
+    std::cerr << "Usage: mcp_mqtt_loadgen [--clients N] [--threads N] [--connections N]\n"
+              << "                        [--duration-s N] [--ramp-ms N] [--think-ms N]\n"
+              << "                        [--mix PING:LIST:CALL] [--session-requests N]\n"
+              << "                        [--timeout-ms N] [--broker loopback|embedded|HOST:PORT]\n"
+              << "                        [--target SERVER_ID/SERVER_NAME] [--tool NAME]\n"
+              << "                        [--tool-delay-us N]\n";
+}
+
+static bool parseMix(const std::string& value, std::array<int, OP_COUNT>& mix) {
+    int ping = 0, list = 0, call = 0;
+    if (std::sscanf(value.c_str(), "%d:%d:%d", &ping, &list, &call) != 3 ||
+        ping < 0 || list < 0 || call < 0 || ping + list + call == 0) {
+        return false;
+    }
+    mix = {0, ping, list, call};
+    return true;
+}
+
+static bool parseArgs(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--clients") options.clients = std::atoi(value.c_str());
+        else if (arg == "--threads") options.threads = std::atoi(value.c_str());
+        else if (arg == "--connections") options.connections = std::atoi(value.c_str());
+        else if (arg == "--duration-s") options.durationSeconds = std::atof(value.c_str());
+        else if (arg == "--ramp-ms") options.rampMs = std::atoi(value.c_str());
+        else if (arg == "--think-ms") options.thinkMs = std::atof(value.c_str());
+        else if (arg == "--session-requests") options.sessionRequests = std::atoi(value.c_str());
+        else if (arg == "--timeout-ms") options.timeoutMs = std::atoi(value.c_str());
+        else if (arg == "--broker") options.broker = value;
+        else if (arg == "--tool") options.tool = value;
+        else if (arg == "--tool-delay-us") options.toolDelayUs = std::atoi(value.c_str());
+        else if (arg == "--mix") {
+            if (!parseMix(value, options.mix)) return false;
+        } else if (arg == "--target") {
+            size_t slash = value.find('/');
+            if (slash == std::string::npos || slash == 0 || slash + 1 == value.size()) return false;
+            options.targetId = value.substr(0, slash);
+            options.targetName = value.substr(slash + 1);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.clients > 0 && options.threads > 0 && options.connections >= 0 &&
+           options.durationSeconds > 0 && options.timeoutMs > 0;
+}
+
+struct LatencyStats {
+    std::vector<double> samples;    // Microseconds
+
+    void add(double us) { samples.push_back(us); }
+
+    void merge(const LatencyStats& other) {
+        samples.insert(samples.end(), other.samples.begin(), other.samples.end());
+    }
+
+    double percentile(double p) {
+        if (samples.empty()) return 0.0;
+        std::sort(samples.begin(), samples.end());
+        size_t index = static_cast<size_t>(p / 100.0 * (samples.size() - 1) + 0.5);
+        return samples[std::min(index, samples.size() - 1)];
+    }
+};
+
+/**
+ * @brief One simulated MCP client, owned by a single worker thread
+ */
+struct SimClient {
+    enum Phase { DISCONNECTED, INITIALIZING, IDLE, WAITING };
+
+    std::string clientId;
+    std::string rpcTopic;
+    IMqttClient* mqtt = nullptr;
+    Phase phase = DISCONNECTED;
+    int64_t nextId = 1;
+    int64_t pendingId = 0;
+    Op pendingOp = PING;
+    Clock::time_point sentAt;
+    int sessionRequests = 0;
+};
+
+/**
+ * @brief Worker thread driving a share of the clients
+ *
+ * Responses arrive on whatever thread the MQTT client delivers on and are
+ * queued as completions. Everything else is only touched by the worker.
+ */
+class Worker {
+public:
+    struct Stats {
+        std::array<LatencyStats, OP_COUNT> latencies;
+        std::array<uint64_t, OP_COUNT> errors{};
+        std::array<uint64_t, OP_COUNT> timeouts{};
+        uint64_t publishFailures = 0;
+        uint64_t disconnects = 0;
+    };
+
+    Worker(const Options& options, const std::string& controlTopic, uint64_t seed)
+        : options_(options), controlTopic_(controlTopic), random_(seed) {
+        for (int weight : options.mix) mixTotal_ += weight;
+    }
+
+    std::vector<SimClient>& clients() { return clients_; }
+    Stats& stats() { return stats_; }
+
+    /**
+     * @brief Queue a response for client slot 'slot' (any thread)
+     */
+    void complete(size_t slot, int64_t id, bool error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completions_.push_back({slot, id, Clock::now(), error});
+        cv_.notify_one();
+    }
+
+    void run(Clock::time_point start, const std::atomic<bool>& stop) {
+        for (size_t slot = 0; slot < clients_.size(); ++slot) {
+            timers_.push({start + rampOffset(slot), slot, 0});
+        }
+        std::vector<Completion> batch;
+        while (!stop) {
+            Clock::time_point wake = timers_.empty() ? Clock::now() + std::chrono::milliseconds(50)
+                                                     : timers_.top().at;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait_until(lock, std::min(wake, Clock::now() + std::chrono::milliseconds(50)),
+                               [&] { return !completions_.empty(); });
+                batch.swap(completions_);
+            }
+            for (const auto& completion : batch) {
+                onResponse(completion);
+            }
+            batch.clear();
+
+            Clock::time_point now = Clock::now();
+            while (!timers_.empty() && timers_.top().at <= now && !stop) {
+                Timer timer = timers_.top();
+                timers_.pop();
+                onTimer(timer, now);
+            }
+        }
+    }
+
+    /**
+     * @brief End every open session (after run() returned)
+     */
+    void disconnectAll() {
+        for (auto& client : clients_) {
+            if (client.phase == SimClient::IDLE || client.phase == SimClient::WAITING) {
+                client.mqtt->publish(client.rpcTopic, DISCONNECTED_NOTIFICATION, 1, false, {});
+            }
+        }
+    }
+
+    // Totals for the progress line, read by the main thread
+    std::atomic<uint64_t> answered{0};
+    std::atomic<uint64_t> failed{0};
+
+private:
+    static constexpr const char* DISCONNECTED_NOTIFICATION =
+        R"({"jsonrpc":"2.0","method":"notifications/disconnected"})";
+
+    struct Completion {
+        size_t slot;
+        int64_t id;
+        Clock::time_point at;
+        bool error;
+    };
+
+    // Next action of a client, or the timeout of request 'id' if id != 0
+    struct Timer {
+        Clock::time_point at;
+        size_t slot;
+        int64_t id;
+        bool operator>(const Timer& other) const { return at > other.at; }
+    };
+
+    const Options& options_;
+    const std::string& controlTopic_;
+    std::mt19937_64 random_;
+    int mixTotal_ = 0;
+    std::vector<SimClient> clients_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    Stats stats_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Completion> completions_;
+
+    Clock::duration rampOffset(size_t slot) const {
+        double share = static_cast<double>(slot) / static_cast<double>(std::max<size_t>(clients_.size(), 1));
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(options_.rampMs) * share);
+    }
+
+    double chance() {
+        return static_cast<double>(random_() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    Clock::duration thinkTime() {
+        if (options_.thinkMs <= 0.0) return Clock::duration::zero();
+        double ms = -std::log(1.0 - chance()) * options_.thinkMs;
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+    }
+
+    void scheduleNext(size_t slot, Clock::time_point now) {
+        timers_.push({now + thinkTime(), slot, 0});
+    }
+
+    void onTimer(const Timer& timer, Clock::time_point now) {
+        SimClient& client = clients_[timer.slot];
+        if (timer.id != 0) {
+            // Timeout; stale if the request was answered meanwhile
+            if ((client.phase == SimClient::WAITING || client.phase == SimClient::INITIALIZING) &&
+                client.pendingId == timer.id) {
+                ++stats_.timeouts[client.pendingOp];
+                failed.fetch_add(1, std::memory_order_relaxed);
+                client.phase = client.phase == SimClient::INITIALIZING ? SimClient::DISCONNECTED : SimClient::IDLE;
+                scheduleNext(timer.slot, now);
+            }
+            return;
+        }
+        if (client.phase == SimClient::DISCONNECTED) {
+            sendInitialize(timer.slot);
+        } else if (client.phase == SimClient::IDLE) {
+            if (options_.sessionRequests > 0 && client.sessionRequests >= options_.sessionRequests) {
+                client.mqtt->publish(client.rpcTopic, DISCONNECTED_NOTIFICATION, 1, false, {});
+                ++stats_.disconnects;
+                client.phase = SimClient::DISCONNECTED;
+                sendInitialize(timer.slot);
+            } else {
+                sendRequest(timer.slot);
+            }
+        }
+    }
+
+    void send(size_t slot, Op op, const std::string& topic, const std::string& payload,
+              const std::map<std::string, std::string>& userProperties) {
+        SimClient& client = clients_[slot];
+        client.pendingOp = op;
+        client.sentAt = Clock::now();
+        timers_.push({client.sentAt + std::chrono::milliseconds(options_.timeoutMs), slot, client.pendingId});
+        if (!client.mqtt->publish(topic, payload, 1, false, userProperties)) {
+            // Leave it to the timeout, as a lost request would be
+            ++stats_.publishFailures;
+        }
+    }
+
+    void sendInitialize(size_t slot) {
+        SimClient& client = clients_[slot];
+        client.phase = SimClient::INITIALIZING;
+        client.pendingId = client.nextId++;
+        client.sessionRequests = 0;
+        std::string request = "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(client.pendingId) +
+            ",\"method\":\"initialize\",\"params\":{\"protocolVersion\":\"" + MCP_PROTOCOL_VERSION +
+            "\",\"clientInfo\":{\"name\":\"mcp_mqtt_loadgen\",\"version\":\"1.0\"},\"capabilities\":{}}}";
+        send(slot, INITIALIZE, controlTopic_, request, {{USER_PROP_MQTT_CLIENT_ID, client.clientId}});
+    }
+
+    void sendRequest(size_t slot) {
+        SimClient& client = clients_[slot];
+        int pick = static_cast<int>(random_() % static_cast<uint64_t>(mixTotal_));
+        Op op = PING;
+        for (int candidate = PING; candidate < OP_COUNT; ++candidate) {
+            if (pick < options_.mix[candidate]) {
+                op = static_cast<Op>(candidate);
+                break;
+            }
+            pick -= options_.mix[candidate];
+        }
+
+        client.phase = SimClient::WAITING;
+        client.pendingId = client.nextId++;
+        ++client.sessionRequests;
+        std::string request = "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(client.pendingId) +
+                              ",\"method\":\"" + OP_NAMES[op] + "\"";
+        if (op == TOOLS_CALL) {
+            request += ",\"params\":{\"name\":" + nlohmann::json(options_.tool).dump() +
+                       ",\"arguments\":{\"text\":\"hello\"}}";
+        }
+        request += "}";
+        send(slot, op, client.rpcTopic, request, {});
+    }
+
+    void onResponse(const Completion& completion) {
+        SimClient& client = clients_[completion.slot];
+        bool waiting = client.phase == SimClient::WAITING || client.phase == SimClient::INITIALIZING;
+        if (!waiting || completion.id != client.pendingId) {
+            return;     // Late answer to a request that already timed out
+        }
+        double us = std::chrono::duration<double, std::micro>(completion.at - client.sentAt).count();
+        if (completion.error) {
+            ++stats_.errors[client.pendingOp];
+            failed.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            stats_.latencies[client.pendingOp].add(us);
+            answered.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (client.phase == SimClient::INITIALIZING) {
+            if (completion.error) {
+                client.phase = SimClient::DISCONNECTED;
+                timers_.push({completion.at + std::chrono::milliseconds(100), completion.slot, 0});
+                return;
+            }
+            client.mqtt->publish(client.rpcTopic, R"({"jsonrpc":"2.0","method":"notifications/initialized"})",
+                                 1, false, {});
+        }
+        client.phase = SimClient::IDLE;
+        scheduleNext(completion.slot, completion.at);
+    }
+};
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    Logger::setLevel(LogLevel::WARN);
+
+    bool loopback = options.broker == "loopback";
+    bool embedded = options.broker == "embedded";
+    if (loopback && !options.targetId.empty()) {
+        std::cerr << "--target needs a socket broker; a loopback broker has no other servers" << std::endl;
+        return 2;
+    }
+    int connectionCount = options.connections > 0 ? options.connections
+                                                   : (loopback ? options.clients : std::min(options.clients, 32));
+    connectionCount = std::min(connectionCount, options.clients);
+
+    // Broker and MQTT connections
+    LoopbackBroker loopbackBroker;
+#ifdef MCP_MQTT_WITH_EMBEDDED_BROKER
+    std::unique_ptr<EmbeddedBroker> embeddedBroker;
+#endif
+    std::unique_ptr<IMqttClient> serverMqtt;
+    std::vector<std::unique_ptr<IMqttClient>> connections;
+    std::string runId = std::to_string(static_cast<long long>(
+        std::chrono::system_clock::now().time_since_epoch().count() % 1000000));
+
+    if (loopback) {
+        serverMqtt = loopbackBroker.createClient("loadgen-server");
+        for (int i = 0; i < connectionCount; ++i) {
+            connections.push_back(loopbackBroker.createClient("loadgen-" + std::to_string(i)));
+        }
+    } else {
+#ifdef MCP_MQTT_WITH_EPOLL_CLIENT
+        EpollMqttClientOptions mqttOptions;
+        if (embedded) {
+#ifdef MCP_MQTT_WITH_EMBEDDED_BROKER
+            EmbeddedBrokerOptions brokerOptions;
+            brokerOptions.port = 0;
+            embeddedBroker = std::make_unique<EmbeddedBroker>(brokerOptions);
+            if (!embeddedBroker->start()) {
+                std::cerr << "Failed to start the embedded broker" << std::endl;
+                return 1;
+            }
+            mqttOptions.port = embeddedBroker->getPort();
+            serverMqtt = embeddedBroker->createClient("loadgen-server");
+#else
+            std::cerr << "This build has no embedded broker (BUILD_EMBEDDED_BROKER)" << std::endl;
+            return 2;
+#endif
+        } else {
+            size_t colon = options.broker.rfind(':');
+            if (colon == std::string::npos) {
+                usage();
+                return 2;
+            }
+            mqttOptions.host = options.broker.substr(0, colon);
+            mqttOptions.port = static_cast<uint16_t>(std::atoi(options.broker.c_str() + colon + 1));
+            if (options.targetId.empty()) {
+                auto client = std::make_unique<EpollMqttClient>("loadgen-server-" + runId, mqttOptions);
+                if (!client->connect()) {
+                    std::cerr << "Cannot connect to " << options.broker << std::endl;
+                    return 1;
+                }
+                serverMqtt = std::move(client);
+            }
+        }
+        for (int i = 0; i < connectionCount; ++i) {
+            auto client = std::make_unique<EpollMqttClient>("loadgen-" + runId + "-" + std::to_string(i),
+                                                            mqttOptions);
+            if (!client->connect()) {
+                std::cerr << "Cannot connect to " << options.broker << std::endl;
+                return 1;
+            }
+            connections.push_back(std::move(client));
+        }
+#else
+        std::cerr << "This build has no socket MQTT client (BUILD_EPOLL_CLIENT); use --broker loopback"
+                  << std::endl;
+        return 2;
+#endif
+    }
+
+    // Server under test
+    McpServer server;
+    McpServerConfig config;
+    if (options.targetId.empty()) {
+        server.configure({"LoadgenServer", "1.0.0"}, ServerCapabilities{});
+        Tool tool;
+        tool.name = options.tool;
+        tool.description = "Load generator stub";
+        tool.inputSchema.properties = {{"text", {{"type", "string"}}}};
+        int toolDelayUs = options.toolDelayUs;
+        server.registerTool(tool, [toolDelayUs](const nlohmann::json& args) -> ToolCallResult {
+            if (toolDelayUs > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(toolDelayUs));
+            }
+            return ToolCallResult::success(args.value("text", ""));
+        });
+        config.serverId = "loadgen-" + runId;
+        config.serverName = "loadgen/server";
+        if (!server.start(serverMqtt.get(), config)) {
+            std::cerr << "Failed to start the server" << std::endl;
+            return 1;
+        }
+    } else {
+        config.serverId = options.targetId;
+        config.serverName = options.targetName;
+    }
+    std::string controlTopic = "$mcp-server/" + config.serverId + "/" + config.serverName;
+    std::string rpcSuffix = "/" + config.serverId + "/" + config.serverName;
+
+    // Clients: client i belongs to worker i % threads and uses connection i % connections
+    int threads = std::min(options.threads, options.clients);
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.push_back(std::make_unique<Worker>(options, controlTopic, 0x9e3779b97f4a7c15ULL * (t + 1)));
+    }
+    for (auto& connection : connections) {
+        size_t clientCount = static_cast<size_t>(options.clients);
+        connection->setMessageHandler([&workers, threads, clientCount](const MqttIncomingMessage& message) {
+            // $mcp-rpc/lg-{i}/{server-id}/{server-name}
+            static const std::string prefix = std::string("$mcp-rpc/") + CLIENT_PREFIX;
+            if (message.topic.compare(0, prefix.size(), prefix) != 0) return;
+            size_t index = std::strtoull(message.topic.c_str() + prefix.size(), nullptr, 10);
+            auto json = nlohmann::json::parse(message.payload, nullptr, false);
+            if (index >= clientCount || !json.is_object() || json.contains("method") ||
+                !json.contains("id") || !json["id"].is_number_integer()) {
+                return;
+            }
+            workers[index % threads]->complete(index / threads, json["id"].get<int64_t>(), json.contains("error"));
+        });
+    }
+    for (int i = 0; i < options.clients; ++i) {
+        SimClient client;
+        client.clientId = CLIENT_PREFIX + std::to_string(i);
+        client.rpcTopic = "$mcp-rpc/" + client.clientId + rpcSuffix;
+        client.mqtt = connections[i % connectionCount].get();
+        client.mqtt->subscribe(client.rpcTopic, 1, true);
+        workers[i % threads]->clients().push_back(std::move(client));
+    }
+
+    std::printf("%d clients on %d %s connection(s), %d thread(s), mix ping:list:call = %d:%d:%d, "
+                "think %.1f ms, server %s/%s\n",
+                options.clients, connectionCount, options.broker.c_str(), threads,
+                options.mix[PING], options.mix[TOOLS_LIST], options.mix[TOOLS_CALL], options.thinkMs,
+                config.serverId.c_str(), config.serverName.c_str());
+
+    // Run, printing progress every second
+    std::atomic<bool> stop{false};
+    auto start = Clock::now();
+    std::vector<std::thread> threadsRunning;
+    for (auto& worker : workers) {
+        threadsRunning.emplace_back([&worker, start, &stop] { worker->run(start, stop); });
+    }
+    auto end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.durationSeconds));
+    uint64_t lastAnswered = 0;
+    uint64_t lastFailed = 0;
+    for (int second = 1; Clock::now() < end; ++second) {
+        std::this_thread::sleep_until(std::min(end, start + std::chrono::seconds(second)));
+        uint64_t answered = 0;
+        uint64_t failed = 0;
+        for (auto& worker : workers) {
+            answered += worker->answered.load(std::memory_order_relaxed);
+            failed += worker->failed.load(std::memory_order_relaxed);
+        }
+        std::printf("%6.1fs %10llu ok/s %8llu failed/s\n",
+                    std::chrono::duration<double>(Clock::now() - start).count(),
+                    static_cast<unsigned long long>(answered - lastAnswered),
+                    static_cast<unsigned long long>(failed - lastFailed));
+        std::fflush(stdout);
+        lastAnswered = answered;
+        lastFailed = failed;
+    }
+    stop = true;
+    for (auto& thread : threadsRunning) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto& worker : workers) {
+        worker->disconnectAll();
+    }
+    if (!loopback) {
+        // Let messages still in flight through the broker reach the server first
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    if (options.targetId.empty()) {
+        server.stop();
+    }
+    connections.clear();    // No more responses into the workers
+
+    // Report
+    Worker::Stats total;
+    for (auto& worker : workers) {
+        Worker::Stats& stats = worker->stats();
+        for (int op = 0; op < OP_COUNT; ++op) {
+            total.latencies[op].merge(stats.latencies[op]);
+            total.errors[op] += stats.errors[op];
+            total.timeouts[op] += stats.timeouts[op];
+        }
+        total.publishFailures += stats.publishFailures;
+        total.disconnects += stats.disconnects;
+    }
+
+    uint64_t requests = 0;
+    uint64_t failures = 0;
+    std::printf("\n%-11s %10s %10s %9s %9s %9s %9s %9s %8s %8s\n", "op", "ok", "ok/s", "p50 us", "p90 us",
+                "p99 us", "p99.9 us", "max us", "errors", "timeouts");
+    for (int op = 0; op < OP_COUNT; ++op) {
+        LatencyStats& latency = total.latencies[op];
+        if (op != INITIALIZE) requests += latency.samples.size();
+        failures += total.errors[op] + total.timeouts[op];
+        std::printf("%-11s %10zu %10.0f %9.1f %9.1f %9.1f %9.1f %9.1f %8llu %8llu\n", OP_NAMES[op],
+                    latency.samples.size(), latency.samples.size() / elapsed, latency.percentile(50),
+                    latency.percentile(90), latency.percentile(99), latency.percentile(99.9),
+                    latency.percentile(100), static_cast<unsigned long long>(total.errors[op]),
+                    static_cast<unsigned long long>(total.timeouts[op]));
+    }
+    std::printf("\nThroughput %.0f requests/s over %.1fs; %llu failed, %llu publish failures, "
+                "%llu session restarts\n",
+                requests / elapsed, elapsed, static_cast<unsigned long long>(failures),
+                static_cast<unsigned long long>(total.publishFailures),
+                static_cast<unsigned long long>(total.disconnects));
+    return requests > 0 ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+/**
+ * @file mcp_mqtt_replay.cpp
+ * @brief Replays a traffic recording into an McpServer and measures it
+ *
+ * Reads a recording made with RecordingMqttClient, starts an McpServer with
+ * the recorded server ID and name on a LoopbackBroker, and publishes the
+ * recorded incoming messages to it at their recorded pace, N times faster, or
+ * as fast as possible. Every tool the recording calls or lists is registered
+ * as a stub, so the numbers cover the SDK's dispatch path rather than the
+ * production tools. Reports throughput and request latency percentiles next
+ * to the latencies seen at recording time.
+ *
+ * Usage: mcp_mqtt_replay <recording> [--speed N|max] [--server-id ID]
+ *                        [--server-name NAME] [--tool-delay-us N]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <mcp_mqtt.h>
+#include <mcp_mqtt/loopback_broker.h>
+#include <mcp_mqtt/traffic_recorder.h>
+
+using namespace mcp_mqtt;
+using Clock = std::chrono::steady_clock;
+
+static constexpr const char* RPC_PREFIX = "$mcp-rpc/";
+static constexpr const char* SERVER_PREFIX = "$mcp-server/";
+
+struct Options {
+    std::string path;
+    double speed = 1.0;         // 0 = as fast as possible
+    std::string serverId;
+    std::string serverName;
+    int toolDelayUs = 0;
+};
+
+static void usage() {
+    std::cerr << "Usage: mcp_mqtt_replay <recording> [--speed N|max] [--server-id ID]\n"
+              << "                       [--server-name NAME] [--tool-delay-us N]\n";
+}
+
+static bool parseArgs(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--speed" && hasValue) {
+            std::string value = argv[++i];
+            options.speed = value == "max" ? 0.0 : std::atof(value.c_str());
+            if (value != "max" && options.speed <= 0.0) {
+                return false;
+            }
+        } else if (arg == "--server-id" && hasValue) {
+            options.serverId = argv[++i];
+        } else if (arg == "--server-name" && hasValue) {
+            options.serverName = argv[++i];
+        } else if (arg == "--tool-delay-us" && hasValue) {
+            options.toolDelayUs = std::atoi(argv[++i]);
+        } else if (!arg.empty() && arg[0] != '-' && options.path.empty()) {
+            options.path = arg;
+        } else {
+            return false;
+        }
+    }
+    return !options.path.empty();
+}
+
+// Segment 'index' of a '/' separated topic
+static std::string topicSegment(const std::string& topic, size_t index) {
+    size_t start = 0;
+    for (size_t i = 0; i < index; ++i) {
+        start = topic.find('/', start);
+        if (start == std::string::npos) return "";
+        ++start;
+    }
+    size_t end = topic.find('/', start);
+    return topic.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+// Everything after segment 'index' ("a/b/c/d", 1 -> "c/d")
+static std::string topicRest(const std::string& topic, size_t index) {
+    size_t start = 0;
+    for (size_t i = 0; i <= index; ++i) {
+        start = topic.find('/', start);
+        if (start == std::string::npos) return "";
+        ++start;
+    }
+    return topic.substr(start);
+}
+
+// Server ID and name from "$mcp-server/{id}/{name}" or "$mcp-rpc/{client}/{id}/{name}"
+static bool serverFromTopic(const std::string& topic, std::string& serverId, std::string& serverName) {
+    if (topic.rfind(RPC_PREFIX, 0) == 0) {
+        serverId = topicSegment(topic, 2);
+        serverName = topicRest(topic, 2);
+    } else if (topic.rfind(SERVER_PREFIX, 0) == 0) {
+        serverId = topicSegment(topic, 1);
+        if (serverId == "presence" || serverId == "mirror") return false;
+        serverName = topicRest(topic, 1);
+    } else {
+        return false;
+    }
+    return !serverId.empty() && !serverName.empty();
+}
+
+/**
+ * @brief Key matching a request to its response: MCP client ID and JSON-RPC id
+ */
+static std::string requestKey(const MqttIncomingMessage& message, const nlohmann::json& json) {
+    std::string clientId;
+    if (message.topic.rfind(RPC_PREFIX, 0) == 0) {
+        clientId = topicSegment(message.topic, 1);
+    } else {
+        auto it = message.userProperties.find(USER_PROP_MQTT_CLIENT_ID);
+        if (it != message.userProperties.end()) {
+            clientId = it->second;
+        } else if (json.contains("params") && json["params"].is_object()) {
+            clientId = json["params"].value("mcpClientId", "");
+        }
+    }
+    return clientId + "#" + json["id"].dump();
+}
+
+static bool isRequest(const nlohmann::json& json) {
+    return json.is_object() && json.contains("method") && json.contains("id");
+}
+
+static bool isResponse(const nlohmann::json& json) {
+    return json.is_object() && json.contains("id") && !json.contains("method") &&
+           (json.contains("result") || json.contains("error"));
+}
+
+struct LatencyStats {
+    std::vector<double> samples;    // Microseconds
+
+    void add(double us) { samples.push_back(us); }
+
+    double percentile(double p) {
+        if (samples.empty()) return 0.0;
+        std::sort(samples.begin(), samples.end());
+        size_t index = static_cast<size_t>(p / 100.0 * (samples.size() - 1) + 0.5);
+        return samples[std::min(index, samples.size() - 1)];
+    }
+
+    void print(const char* label) {
+        std::printf("%-10s n=%-8zu p50=%9.1fus  p90=%9.1fus  p99=%9.1fus  max=%9.1fus\n",
+                    label, samples.size(), percentile(50), percentile(90), percentile(99), percentile(100));
+    }
+};
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    Logger::setLevel(LogLevel::WARN);
+
+    // Load the recording; the server identity and tools come from its traffic
+    std::vector<TrafficRecord> incoming;
+    std::map<std::string, Tool> tools;
+    LatencyStats recorded;
+    {
+        TrafficReader reader;
+        if (!reader.open(options.path)) {
+            return 1;
+        }
+        std::unordered_map<std::string, std::chrono::microseconds> pending;
+        TrafficRecord record;
+        while (reader.next(record)) {
+            const MqttIncomingMessage& message = record.message;
+            auto json = nlohmann::json::parse(message.payload, nullptr, false);
+
+            if (record.direction == TrafficDirection::OUTGOING) {
+                if (isResponse(json) && message.topic.rfind(RPC_PREFIX, 0) == 0) {
+                    std::string key = topicSegment(message.topic, 1) + "#" + json["id"].dump();
+                    auto it = pending.find(key);
+                    if (it != pending.end()) {
+                        recorded.add(static_cast<double>((record.timestamp - it->second).count()));
+                        pending.erase(it);
+                    }
+                    // Tool definitions from tools/list results
+                    const auto& result = json.value("result", nlohmann::json::object());
+                    if (result.is_object() && result.contains("tools") && result["tools"].is_array()) {
+                        for (const auto& entry : result["tools"]) {
+                            Tool tool;
+                            tool.name = entry.value("name", "");
+                            tool.description = entry.value("description", "");
+                            if (entry.contains("inputSchema") && entry["inputSchema"].is_object()) {
+                                const auto& schema = entry["inputSchema"];
+                                tool.inputSchema.properties = schema.value("properties", nlohmann::json::object());
+                                tool.inputSchema.required =
+                                    schema.value("required", std::vector<std::string>{});
+                            }
+                            if (!tool.name.empty()) tools[tool.name] = tool;
+                        }
+                    }
+                }
+                continue;
+            }
+
+            if (options.serverId.empty()) {
+                serverFromTopic(message.topic, options.serverId, options.serverName);
+            }
+            if (isRequest(json)) {
+                pending[requestKey(message, json)] = record.timestamp;
+                if (json["method"] == "tools/call" && json.contains("params") && json["params"].is_object()) {
+                    std::string name = json["params"].value("name", "");
+                    if (!name.empty() && !tools.count(name)) {
+                        Tool tool;
+                        tool.name = name;
+                        tool.description = "Replay stub";
+                        tools[name] = tool;
+                    }
+                }
+            }
+            incoming.push_back(std::move(record));
+        }
+    }
+
+    if (incoming.empty() || options.serverId.empty() || options.serverName.empty()) {
+        std::cerr << "No replayable server traffic in " << options.path
+                  << " (use --server-id and --server-name if the topics do not tell)" << std::endl;
+        return 1;
+    }
+
+    // Server under test on a loopback broker
+    LoopbackBroker broker;
+    auto serverClient = broker.createClient("replay-server-" + options.serverId);
+    auto replayClient = broker.createClient("replay-driver");
+
+    McpServer server;
+    server.configure({"ReplayServer", "1.0.0"}, ServerCapabilities{});
+    int toolDelayUs = options.toolDelayUs;
+    for (const auto& [name, tool] : tools) {
+        server.registerTool(tool, [toolDelayUs](const nlohmann::json&) -> ToolCallResult {
+            if (toolDelayUs > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(toolDelayUs));
+            }
+            return ToolCallResult::success("replayed");
+        });
+    }
+
+    McpServerConfig config;
+    config.serverId = options.serverId;
+    config.serverName = options.serverName;
+    if (!server.start(serverClient.get(), config)) {
+        std::cerr << "Failed to start the server" << std::endl;
+        return 1;
+    }
+
+    // Responses come back synchronously, on the thread that published the request
+    std::unordered_map<std::string, Clock::time_point> pending;
+    LatencyStats replayed;
+    uint64_t responses = 0;
+    uint64_t errors = 0;
+    replayClient->setMessageHandler([&](const MqttIncomingMessage& message) {
+        auto json = nlohmann::json::parse(message.payload, nullptr, false);
+        if (!isResponse(json)) {
+            return;
+        }
+        ++responses;
+        if (json.contains("error")) ++errors;
+        auto it = pending.find(topicSegment(message.topic, 1) + "#" + json["id"].dump());
+        if (it != pending.end()) {
+            replayed.add(std::chrono::duration<double, std::micro>(Clock::now() - it->second).count());
+            pending.erase(it);
+        }
+    });
+    replayClient->subscribe(std::string(RPC_PREFIX) + "#", 1, true);
+
+    char pace[32] = "max speed";
+    if (options.speed > 0) {
+        std::snprintf(pace, sizeof(pace), "%gx", options.speed);
+    }
+    std::printf("Replaying %zu messages for server %s/%s at %s, %zu stub tools\n",
+                incoming.size(), options.serverId.c_str(), options.serverName.c_str(), pace, tools.size());
+
+    // Pace relative to the first replayed message; the recording may start
+    // long before the server's first incoming message
+    uint64_t requests = 0;
+    auto start = Clock::now();
+    auto firstTimestamp = incoming.front().timestamp;
+    for (const auto& record : incoming) {
+        const MqttIncomingMessage& message = record.message;
+        if (options.speed > 0) {
+            auto offset = record.timestamp - firstTimestamp;
+            auto due = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::micro>(offset.count() / options.speed));
+            std::this_thread::sleep_until(due);
+        }
+
+        auto json = nlohmann::json::parse(message.payload, nullptr, false);
+        if (isRequest(json)) {
+            pending[requestKey(message, json)] = Clock::now();
+            ++requests;
+        }
+
+        MqttPublishProperties properties;
+        properties.userProperties = message.userProperties;
+        properties.messageExpiryInterval = message.messageExpiryInterval.value_or(0);
+        properties.correlationData = message.correlationData;
+        properties.responseTopic = message.responseTopic;
+        properties.contentType = message.contentType;
+        properties.payloadFormatIndicator = message.payloadFormatIndicator;
+        replayClient->publishWithProperties(message.topic, message.payload, message.qos, message.retained,
+                                            properties);
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    double recordedSpan = (incoming.back().timestamp - firstTimestamp).count() / 1e6;
+
+    server.stop();
+
+    std::printf("\nMessages   %zu in %.3fs (recorded span %.3fs): %.0f msg/s\n",
+                incoming.size(), elapsed, recordedSpan, incoming.size() / std::max(elapsed, 1e-9));
+    std::printf("Requests   %llu, responses %llu (%llu errors), unanswered %zu\n",
+                static_cast<unsigned long long>(requests), static_cast<unsigned long long>(responses),
+                static_cast<unsigned long long>(errors), pending.size());
+    recorded.print("Recorded");
+    replayed.print("Replayed");
+    return 0;
+}